@@ -0,0 +1,111 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "andpostingiterator.h"
+#include "orpostingiterator.h"
+#include "vectorpostingiterator.h"
+
+#include <QTest>
+
+using namespace Baloo;
+
+class PostingIteratorBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void testAndNext();
+    void testAndBlocks();
+    void testOrNext();
+    void testOrBlocks();
+
+private:
+    QVector<PostingIterator*> iterators() const;
+
+    QVector<quint64> m_ids[4];
+};
+
+static const int s_numDocuments = 1000000;
+static const int s_blockSize = 256;
+
+void PostingIteratorBenchmark::initTestCase()
+{
+    qsrand(1);
+
+    // From a very common to a fairly rare term
+    const int frequency[4] = {2, 3, 10, 50};
+    for (quint64 id = 1; id <= s_numDocuments; id++) {
+        for (int t = 0; t < 4; t++) {
+            if (qrand() % frequency[t] == 0) {
+                m_ids[t] << id;
+            }
+        }
+    }
+}
+
+QVector<PostingIterator*> PostingIteratorBenchmark::iterators() const
+{
+    QVector<PostingIterator*> vec;
+    for (const QVector<quint64>& ids : m_ids) {
+        vec << new VectorPostingIterator(ids);
+    }
+    return vec;
+}
+
+void PostingIteratorBenchmark::testAndNext()
+{
+    QBENCHMARK {
+        AndPostingIterator it(iterators());
+        while (it.next()) {
+        }
+    }
+}
+
+void PostingIteratorBenchmark::testAndBlocks()
+{
+    quint64 ids[s_blockSize];
+    QBENCHMARK {
+        AndPostingIterator it(iterators());
+        while (it.nextBlock(ids, s_blockSize) == s_blockSize) {
+        }
+    }
+}
+
+void PostingIteratorBenchmark::testOrNext()
+{
+    QBENCHMARK {
+        OrPostingIterator it(iterators());
+        while (it.next()) {
+        }
+    }
+}
+
+void PostingIteratorBenchmark::testOrBlocks()
+{
+    quint64 ids[s_blockSize];
+    QBENCHMARK {
+        OrPostingIterator it(iterators());
+        while (it.nextBlock(ids, s_blockSize) == s_blockSize) {
+        }
+    }
+}
+
+QTEST_MAIN(PostingIteratorBenchmark)
+
+#include "postingiteratorbenchmark.moc"
@@ -0,0 +1,89 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "wandranker.h"
+#include "frequencypostingiterator.h"
+
+#include <QTest>
+
+using namespace Baloo;
+
+class RankingBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void testExhaustive();
+    void testTopK();
+
+private:
+    void rank(int k);
+
+    QVector<quint64> m_ids[3];
+    QVector<quint32> m_freqs[3];
+};
+
+static const int s_numDocuments = 100000;
+
+void RankingBenchmark::initTestCase()
+{
+    qsrand(1);
+
+    // A common, an average and a rare term
+    const int frequency[3] = {2, 10, 100};
+    for (quint64 id = 1; id <= s_numDocuments; id++) {
+        for (int t = 0; t < 3; t++) {
+            if (qrand() % frequency[t] == 0) {
+                m_ids[t] << id;
+                m_freqs[t] << 1 + qrand() % 10;
+            }
+        }
+    }
+}
+
+void RankingBenchmark::rank(int k)
+{
+    auto docLength = [](quint64 id) {
+        return static_cast<quint32>(50 + id % 100);
+    };
+
+    WandRanker ranker(s_numDocuments, 100, docLength);
+    for (int t = 0; t < 3; t++) {
+        ranker.addTerm(new FrequencyPostingIterator(m_ids[t], m_freqs[t]), m_ids[t].size());
+    }
+    ranker.topK(k);
+}
+
+void RankingBenchmark::testExhaustive()
+{
+    QBENCHMARK {
+        rank(-1);
+    }
+}
+
+void RankingBenchmark::testTopK()
+{
+    QBENCHMARK {
+        rank(10);
+    }
+}
+
+QTEST_MAIN(RankingBenchmark)
+
+#include "rankingbenchmark.moc"
@@ -0,0 +1,203 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "indexbuilder.h"
+#include "dbstate.h"
+#include "database.h"
+#include "document.h"
+#include "idutils.h"
+
+#include <QTest>
+#include <QTemporaryDir>
+#include <QDir>
+
+#include <unistd.h>
+
+using namespace Baloo;
+
+class IndexBuilderTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testSameAsTransaction();
+    void testHardLink();
+    void testIncomplete();
+private:
+    QVector<Document> createDocuments();
+
+    QTemporaryDir* dir;
+    Database* db;
+    Database* builtDb;
+};
+
+void IndexBuilderTest::init()
+{
+    dir = new QTemporaryDir();
+    QDir(dir->path()).mkpath(QStringLiteral("db"));
+    QDir(dir->path()).mkpath(QStringLiteral("builtdb"));
+    QDir(dir->path()).mkpath(QStringLiteral("files/a/b"));
+
+    db = new Database(dir->path() + QStringLiteral("/db"));
+    db->open(Database::CreateDatabase);
+    builtDb = new Database(dir->path() + QStringLiteral("/builtdb"));
+    builtDb->open(Database::CreateDatabase);
+}
+
+void IndexBuilderTest::cleanup()
+{
+    delete db;
+    delete builtDb;
+    delete dir;
+}
+
+static Document createDocument(const QString& path, quint32 mtime, const QVector<QByteArray>& terms,
+                               const QVector<QByteArray>& fileNameTerms, const QVector<QByteArray>& xattrTerms)
+{
+    QFile file(path);
+    file.open(QIODevice::WriteOnly);
+    file.write("data");
+    file.close();
+
+    const QByteArray url = QFile::encodeName(path);
+
+    Document doc;
+    doc.setId(filePathToId(url));
+    doc.setUrl(url);
+    for (int i = 0; i < terms.size(); i++) {
+        doc.addPositionTerm(terms[i], i);
+    }
+    for (const QByteArray& term : fileNameTerms) {
+        doc.addFileNameTerm(term);
+    }
+    for (const QByteArray& term : xattrTerms) {
+        doc.addXattrTerm(term);
+    }
+    doc.setMTime(mtime);
+    doc.setCTime(mtime);
+    doc.addProperty(1, mtime);
+
+    return doc;
+}
+
+QVector<Document> IndexBuilderTest::createDocuments()
+{
+    const QString files = dir->path() + QStringLiteral("/files");
+
+    QVector<Document> docs;
+    docs << createDocument(files + QStringLiteral("/a/b/file1"), 5, {"abc", "def", "abc"}, {"file1"}, {});
+    docs << createDocument(files + QStringLiteral("/a/file2"), 3, {"def"}, {"file2"}, {"abc"});
+    docs << createDocument(files + QStringLiteral("/file3"), 3, {}, {"file3", "abc"}, {"tag"});
+
+    docs[0].setContentIndexing(true);
+    docs[1].setData("data");
+
+    // A folder which is also the parent of other documents
+    Document folder;
+    const QByteArray url = QFile::encodeName(files + QStringLiteral("/a"));
+    folder.setId(filePathToId(url));
+    folder.setUrl(url);
+    folder.addFileNameTerm("a");
+    folder.setMTime(1);
+    folder.setCTime(1);
+    docs << folder;
+
+    return docs;
+}
+
+void IndexBuilderTest::testSameAsTransaction()
+{
+    const QVector<Document> docs = createDocuments();
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        for (const Document& doc : docs) {
+            tr.addDocument(doc);
+        }
+        tr.commit();
+    }
+
+    IndexBuilder builder(builtDb);
+    for (const Document& doc : docs) {
+        QVERIFY(builder.addDocument(doc));
+    }
+    QVERIFY(builder.finish());
+
+    Transaction tr(db, Transaction::ReadOnly);
+    Transaction builtTr(builtDb, Transaction::ReadOnly);
+
+    QVERIFY(DBState::debugCompare(DBState::fromTransaction(&builtTr), DBState::fromTransaction(&tr)));
+    QCOMPARE(builtTr.size(), tr.size());
+
+    for (const Document& doc : docs) {
+        QCOMPARE(builtTr.documentUrl(doc.id()), doc.url());
+    }
+}
+
+void IndexBuilderTest::testHardLink()
+{
+    const QString path = dir->path() + QStringLiteral("/files/file");
+    Document doc = createDocument(path, 1, {"abc"}, {"file"}, {});
+
+    const QString link = dir->path() + QStringLiteral("/files/link");
+    QVERIFY(::link(QFile::encodeName(path).constData(), QFile::encodeName(link).constData()) == 0);
+
+    Document linkDoc = createDocument(link, 1, {"abc"}, {"link"}, {});
+    QCOMPARE(linkDoc.id(), doc.id());
+
+    IndexBuilder builder(builtDb);
+    QVERIFY(builder.addDocument(doc));
+    QVERIFY(!builder.addDocument(linkDoc));
+    QVERIFY(builder.finish());
+
+    Transaction tr(builtDb, Transaction::ReadOnly);
+    QCOMPARE(tr.documentUrl(doc.id()), doc.url());
+}
+
+void IndexBuilderTest::testIncomplete()
+{
+    const QVector<Document> docs = createDocuments();
+
+    IndexBuilder builder(builtDb);
+    for (const Document& doc : docs) {
+        QVERIFY(builder.addDocument(doc));
+    }
+    QVERIFY(!IndexBuilder::isIncomplete(builtDb));
+    QVERIFY(builder.finish());
+    QVERIFY(!IndexBuilder::isIncomplete(builtDb));
+
+    // As if the build had been killed while writing the index
+    QFile marker(builtDb->path() + QStringLiteral("/index-building"));
+    QVERIFY(marker.open(QIODevice::WriteOnly));
+    marker.close();
+    QVERIFY(IndexBuilder::isIncomplete(builtDb));
+
+    QVERIFY(builtDb->write([](Transaction* tr) {
+        tr->clear();
+    }));
+
+    Transaction tr(builtDb, Transaction::ReadOnly);
+    QVERIFY(tr.isEmpty());
+}
+
+QTEST_MAIN(IndexBuilderTest)
+
+#include "indexbuildertest.moc"
@@ -54,6 +54,8 @@ private Q_SLOTS:
     void testTermAnd();
     void testTermOr();
     void testTermPhrase();
+    void testTermNot();
+    void testFilter();
 
 private:
     QTemporaryDir* dir;
@@ -162,6 +164,44 @@ void QueryTest::testTermPhrase()
     QCOMPARE(tr.exec(q), result);
 }
 
+void QueryTest::testTermNot()
+{
+    QVector<EngineQuery> queries;
+    queries << EngineQuery("the");
+    queries << EngineQuery({EngineQuery("crazy")}, EngineQuery::Not);
+
+    EngineQuery q(queries, EngineQuery::And);
+
+    QVector<quint64> result = {m_id2};
+    Transaction tr(db, Transaction::ReadOnly);
+    QCOMPARE(tr.exec(q), result);
+
+    // Without anything else, all the other documents match
+    q = EngineQuery({EngineQuery("the")}, EngineQuery::Not);
+    QCOMPARE(tr.exec(q), QVector<quint64>({m_id3}));
+
+    QVector<quint64> ids = {m_id1, m_id2, m_id3, m_id4};
+    QCOMPARE(tr.filter(ids, q), QVector<quint64>({m_id3}));
+}
+
+void QueryTest::testFilter()
+{
+    QVector<quint64> ids = {m_id1, m_id2, m_id3, m_id4};
+    Transaction tr(db, Transaction::ReadOnly);
+
+    EngineQuery q("for", EngineQuery::StartsWith);
+    QCOMPARE(tr.filter(ids, q), QVector<quint64>({m_id3, m_id4}));
+
+    QVector<EngineQuery> queries;
+    queries << EngineQuery("crazy");
+    queries << EngineQuery("dea", EngineQuery::StartsWith);
+
+    q = EngineQuery(queries, EngineQuery::And);
+    QCOMPARE(tr.filter(ids, q), QVector<quint64>({m_id4}));
+
+    // Only the given ids are considered
+    QCOMPARE(tr.filter({m_id1}, EngineQuery("only")), QVector<quint64>());
+}
 
 QTEST_MAIN(QueryTest)
 
@@ -0,0 +1,112 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "documentdatacodec.h"
+
+#include <QDateTime>
+#include <QObject>
+#include <QTest>
+
+using namespace Baloo;
+
+class DocumentDataCodecTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void test();
+    void testSingleProperty();
+    void testCompression();
+    void testLegacy();
+};
+
+namespace {
+QMap<int, QVariant> testProperties()
+{
+    QMap<int, QVariant> map;
+    map.insert(2, QStringLiteral("Some title"));
+    map.insert(5, 320);
+    map.insert(7, Q_INT64_C(1) << 40);
+    map.insert(9, 2.5);
+    map.insert(11, true);
+    map.insert(14, QDate(2015, 6, 21));
+    map.insert(16, QDateTime(QDate(2015, 6, 21), QTime(13, 5, 2), Qt::UTC));
+    map.insert(20, QVariantList() << QStringLiteral("first") << QStringLiteral("second"));
+    return map;
+}
+}
+
+void DocumentDataCodecTest::test()
+{
+    DocumentDataCodec codec;
+
+    const QMap<int, QVariant> map = testProperties();
+    const QByteArray data = codec.encode(map);
+    QVERIFY(!DocumentDataCodec::isLegacy(data));
+    QCOMPARE(codec.decode(data), map);
+
+    const QByteArray empty = codec.encode(QMap<int, QVariant>());
+    QVERIFY(!empty.isEmpty());
+    QVERIFY(codec.decode(empty).isEmpty());
+}
+
+void DocumentDataCodecTest::testSingleProperty()
+{
+    DocumentDataCodec codec;
+
+    const QMap<int, QVariant> map = testProperties();
+    const QByteArray data = codec.encode(map);
+
+    for (auto it = map.constBegin(); it != map.constEnd(); ++it) {
+        QCOMPARE(codec.decode(data, it.key()), it.value());
+    }
+    QVERIFY(!codec.decode(data, 1).isValid());
+    QVERIFY(!codec.decode(data, 6).isValid());
+    QVERIFY(!codec.decode(data, 100).isValid());
+}
+
+void DocumentDataCodecTest::testCompression()
+{
+    DocumentDataCodec codec;
+
+    const QString text = QStringLiteral("All work and no play makes Jack a dull boy. ").repeated(100);
+
+    QMap<int, QVariant> map;
+    map.insert(3, text);
+
+    const QByteArray data = codec.encode(map);
+    QVERIFY(data.size() < text.size());
+    QCOMPARE(codec.decode(data, 3), QVariant(text));
+}
+
+void DocumentDataCodecTest::testLegacy()
+{
+    DocumentDataCodec codec;
+
+    const QByteArray json = "{\n    \"2\": \"Some title\",\n    \"20\": [\"first\", \"second\"]\n}\n";
+    QVERIFY(DocumentDataCodec::isLegacy(json));
+
+    const QMap<int, QVariant> map = codec.decode(json);
+    QCOMPARE(map.size(), 2);
+    QCOMPARE(map.value(2), QVariant(QStringLiteral("Some title")));
+    QCOMPARE(codec.decode(json, 20).toStringList(), QStringList() << QStringLiteral("first") << QStringLiteral("second"));
+}
+
+QTEST_MAIN(DocumentDataCodecTest)
+
+#include "documentdatacodectest.moc"
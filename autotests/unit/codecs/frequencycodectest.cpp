@@ -0,0 +1,54 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "frequencycodec.h"
+
+#include <QObject>
+#include <QTest>
+
+using namespace Baloo;
+
+class FrequencyCodecTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void test() {
+        FrequencyCodec codec;
+
+        QVector<quint32> vec = {1, 5, 200, 3};
+        QByteArray arr = codec.encode(vec);
+        QVERIFY(!arr.isEmpty());
+
+        QVector<quint32> vec2 = codec.decode(arr);
+        QCOMPARE(vec2, vec);
+        QCOMPARE(codec.maxFrequency(arr), static_cast<quint32>(200));
+    }
+
+    void testEmpty() {
+        FrequencyCodec codec;
+
+        QByteArray arr = codec.encode(QVector<quint32>());
+        QCOMPARE(codec.decode(arr), QVector<quint32>());
+        QCOMPARE(codec.maxFrequency(arr), static_cast<quint32>(0));
+    }
+};
+
+QTEST_MAIN(FrequencyCodecTest)
+
+#include "frequencycodectest.moc"
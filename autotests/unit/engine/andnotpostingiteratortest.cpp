@@ -0,0 +1,88 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "andnotpostingiterator.h"
+#include "vectorpostingiterator.h"
+
+#include <QTest>
+
+using namespace Baloo;
+
+class AndNotPostingIteratorTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void test();
+    void testNullIterators();
+    void testEstimateSize();
+};
+
+void AndNotPostingIteratorTest::test()
+{
+    QVector<quint64> l1 = {1, 3, 4, 5, 7, 9, 11};
+    QVector<quint64> l2 = {3, 5, 6};
+    QVector<quint64> l3 = {2, 11};
+
+    VectorPostingIterator* it1 = new VectorPostingIterator(l1);
+    VectorPostingIterator* it2 = new VectorPostingIterator(l2);
+    VectorPostingIterator* it3 = new VectorPostingIterator(l3);
+
+    QVector<PostingIterator*> excluded = {it2, it3};
+    AndNotPostingIterator it(it1, excluded);
+    QCOMPARE(it.docId(), static_cast<quint64>(0));
+
+    QVector<quint64> result = {1, 4, 7, 9};
+    for (quint64 val : result) {
+        QCOMPARE(it.next(), static_cast<quint64>(val));
+        QCOMPARE(it.docId(), static_cast<quint64>(val));
+    }
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+    QCOMPARE(it.docId(), static_cast<quint64>(0));
+}
+
+void AndNotPostingIteratorTest::testNullIterators()
+{
+    QVector<quint64> l1 = {1, 3, 5};
+    QVector<quint64> l2 = {3};
+
+    QVector<PostingIterator*> excluded = {0, new VectorPostingIterator(l2)};
+    AndNotPostingIterator it(new VectorPostingIterator(l1), excluded);
+
+    QCOMPARE(it.next(), static_cast<quint64>(1));
+    QCOMPARE(it.next(), static_cast<quint64>(5));
+    QCOMPARE(it.next(), static_cast<quint64>(0));
+
+    AndNotPostingIterator emptyIt(0, {new VectorPostingIterator(l2)});
+    QCOMPARE(emptyIt.next(), static_cast<quint64>(0));
+    QCOMPARE(emptyIt.docId(), static_cast<quint64>(0));
+}
+
+void AndNotPostingIteratorTest::testEstimateSize()
+{
+    QVector<quint64> l1 = {1, 3, 5, 7, 9, 11, 13, 15, 17, 19};
+    QVector<quint64> l2 = {2, 4, 6, 8, 10};
+
+    AndNotPostingIterator it(new VectorPostingIterator(l1), {new VectorPostingIterator(l2)});
+    QCOMPARE(it.estimateSize(20), static_cast<uint>(8));
+    QCOMPARE(it.estimateSize(0), static_cast<uint>(0));
+}
+
+QTEST_MAIN(AndNotPostingIteratorTest)
+
+#include "andnotpostingiteratortest.moc"
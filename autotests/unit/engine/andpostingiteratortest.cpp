@@ -31,6 +31,8 @@ class AndPostingIteratorTest : public QObject
 private Q_SLOTS:
     void test();
     void testNullIterators();
+    void testEstimateSize();
+    void testBlocks();
 };
 
 void AndPostingIteratorTest::test()
@@ -72,6 +74,70 @@ void AndPostingIteratorTest::testNullIterators()
     QCOMPARE(it.docId(), static_cast<quint64>(0));
 }
 
+void AndPostingIteratorTest::testEstimateSize()
+{
+    QVector<quint64> l1 = {1, 3, 5, 7};
+    QVector<quint64> l2 = {3, 4, 5, 7, 9, 11, 13, 15, 17, 19};
+
+    QVector<PostingIterator*> vec = {new VectorPostingIterator(l1), new VectorPostingIterator(l2)};
+    AndPostingIterator it(vec);
+
+    QCOMPARE(it.estimateSize(20), static_cast<uint>(2));
+    QCOMPARE(it.estimateSize(4), static_cast<uint>(4));
+    QCOMPARE(it.estimateSize(0), static_cast<uint>(0));
+
+    QVector<PostingIterator*> nullVec = {new VectorPostingIterator(l1), 0};
+    AndPostingIterator nullIt(nullVec);
+    QCOMPARE(nullIt.estimateSize(20), static_cast<uint>(0));
+}
+
+void AndPostingIteratorTest::testBlocks()
+{
+    // Long enough to need several blocks from each iterator
+    QVector<quint64> l1, l2, l3, result;
+    for (quint64 id = 1; id <= 3000; id++) {
+        if (id % 2 == 0) {
+            l1 << id;
+        }
+        if (id % 3 == 0) {
+            l2 << id;
+        }
+        if (id % 5 == 0) {
+            l3 << id;
+        }
+        if (id % 30 == 0) {
+            result << id;
+        }
+    }
+
+    QVector<PostingIterator*> vec = {new VectorPostingIterator(l1), new VectorPostingIterator(l2),
+                                     new VectorPostingIterator(l3)};
+    AndPostingIterator it(vec);
+
+    QVector<quint64> ids;
+    quint64 block[7];
+    int count;
+    while ((count = it.nextBlock(block, 7)) == 7) {
+        QCOMPARE(it.docId(), block[6]);
+        for (quint64 id : block) {
+            ids << id;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        ids << block[i];
+    }
+    QCOMPARE(ids, result);
+    QCOMPARE(it.nextBlock(block, 7), 0);
+
+    // Blocks and single ids can be mixed
+    QVector<PostingIterator*> vec2 = {new VectorPostingIterator(l3), new VectorPostingIterator(l1)};
+    AndPostingIterator it2(vec2);
+    QCOMPARE(it2.next(), static_cast<quint64>(10));
+    QCOMPARE(it2.skipToBlock(1000, block, 2), 2);
+    QCOMPARE(block[0], static_cast<quint64>(1000));
+    QCOMPARE(block[1], static_cast<quint64>(1010));
+    QCOMPARE(it2.next(), static_cast<quint64>(1020));
+}
 
 QTEST_MAIN(AndPostingIteratorTest)
 
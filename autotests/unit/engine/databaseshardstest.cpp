@@ -0,0 +1,80 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "databaseshards.h"
+#include "database.h"
+#include "transaction.h"
+
+#include <QTest>
+#include <QTemporaryDir>
+#include <QFile>
+
+using namespace Baloo;
+
+class DatabaseShardsTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testOpen();
+    void testRemove();
+};
+
+void DatabaseShardsTest::testOpen()
+{
+    QTemporaryDir dir;
+    DatabaseShards* shards = DatabaseShards::instance();
+
+    QVERIFY(!shards->open(dir.path(), Database::OpenDatabase));
+    QVERIFY(!QFile::exists(DatabaseShards::shardPath(dir.path())));
+
+    QSharedPointer<Database> db = shards->open(dir.path(), Database::CreateDatabase);
+    QVERIFY(db);
+    QCOMPARE(db->path(), dir.path() + QStringLiteral("/.baloo"));
+    QVERIFY(QFile::exists(db->path() + QStringLiteral("/index")));
+
+    // An environment can only be opened once in a process
+    QCOMPARE(shards->open(dir.path(), Database::OpenDatabase), db);
+    QCOMPARE(shards->open(dir.path() + QLatin1Char('/'), Database::OpenDatabase), db);
+
+    // Nothing is kept open once it is no longer used
+    db.clear();
+    db = shards->open(dir.path(), Database::OpenDatabase);
+    QVERIFY(db);
+    QVERIFY(db->isOpen());
+}
+
+void DatabaseShardsTest::testRemove()
+{
+    QTemporaryDir dir;
+    DatabaseShards* shards = DatabaseShards::instance();
+
+    QSharedPointer<Database> db = shards->open(dir.path(), Database::CreateDatabase);
+    QVERIFY(db);
+
+    QVERIFY(shards->remove(dir.path()));
+    QVERIFY(!shards->open(dir.path(), Database::OpenDatabase));
+
+    // Those still using it can keep on reading
+    Transaction tr(db.data(), Transaction::ReadOnly);
+    QCOMPARE(tr.size(), 0u);
+}
+
+QTEST_MAIN(DatabaseShardsTest)
+
+#include "databaseshardstest.moc"
@@ -0,0 +1,61 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "documentlengthdb.h"
+#include "singledbtest.h"
+
+using namespace Baloo;
+
+class DocumentLengthDBTest : public SingleDBTest
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void test() {
+        DocumentLengthDB db(DocumentLengthDB::create(m_txn), m_txn);
+
+        db.put(1, 10);
+        db.put(2, 20);
+        QCOMPARE(db.get(1), static_cast<quint32>(10));
+        QCOMPARE(db.get(2), static_cast<quint32>(20));
+        QCOMPARE(db.count(), static_cast<quint64>(2));
+        QCOMPARE(db.averageLength(), 15.0);
+
+        db.del(1);
+        QCOMPARE(db.get(1), static_cast<quint32>(0));
+        QCOMPARE(db.count(), static_cast<quint64>(1));
+        QCOMPARE(db.averageLength(), 20.0);
+    }
+
+    void testReplace() {
+        DocumentLengthDB db(DocumentLengthDB::create(m_txn), m_txn);
+
+        db.put(1, 10);
+        db.put(1, 30);
+        QCOMPARE(db.get(1), static_cast<quint32>(30));
+        QCOMPARE(db.count(), static_cast<quint64>(1));
+        QCOMPARE(db.averageLength(), 30.0);
+
+        QMap<quint64, quint32> map = {{1, 30}};
+        QCOMPARE(db.toTestMap(), map);
+    }
+};
+
+QTEST_MAIN(DocumentLengthDBTest)
+
+#include "documentlengthdbtest.moc"
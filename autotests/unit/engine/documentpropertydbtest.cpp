@@ -0,0 +1,95 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "documentpropertydb.h"
+#include "singledbtest.h"
+
+using namespace Baloo;
+
+class DocumentPropertyDBTest : public SingleDBTest
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void test();
+    void testValues();
+    void testDel();
+};
+
+void DocumentPropertyDBTest::test()
+{
+    DocumentPropertyDB db(DocumentPropertyDB::create(m_txn), m_txn);
+
+    db.put(5, 1, -10);
+    db.put(5, 2, 300);
+    db.put(7, 1, Q_INT64_C(1) << 40);
+
+    qint64 value = 0;
+    QVERIFY(db.get(5, 1, &value));
+    QCOMPARE(value, Q_INT64_C(-10));
+    QVERIFY(db.get(7, 1, &value));
+    QCOMPARE(value, Q_INT64_C(1) << 40);
+    QVERIFY(!db.get(7, 2, &value));
+
+    QCOMPARE(db.properties(), QVector<quint32>() << 5 << 7);
+}
+
+void DocumentPropertyDBTest::testValues()
+{
+    DocumentPropertyDB db(DocumentPropertyDB::create(m_txn), m_txn);
+
+    db.put(3, 1, 10);
+    db.put(3, 4, 40);
+    db.put(3, 300, 3000);
+    db.put(4, 2, 20);
+    db.put(2, 5, 50);
+
+    const QVector<quint64> ids = {1, 2, 3, 4, 5, 300, 301};
+
+    QVector<QPair<quint64, qint64> > expected;
+    expected << qMakePair(Q_UINT64_C(1), Q_INT64_C(10));
+    expected << qMakePair(Q_UINT64_C(4), Q_INT64_C(40));
+    expected << qMakePair(Q_UINT64_C(300), Q_INT64_C(3000));
+    QCOMPARE(db.values(3, ids), expected);
+
+    expected.clear();
+    expected << qMakePair(Q_UINT64_C(2), Q_INT64_C(20));
+    QCOMPARE(db.values(4, ids), expected);
+
+    QVERIFY(db.values(4, QVector<quint64>() << 1 << 3).isEmpty());
+    QVERIFY(db.values(6, ids).isEmpty());
+}
+
+void DocumentPropertyDBTest::testDel()
+{
+    DocumentPropertyDB db(DocumentPropertyDB::create(m_txn), m_txn);
+
+    db.put(1, 1, 10);
+    db.put(2, 1, 20);
+    db.put(2, 2, 22);
+
+    db.del(1);
+
+    QMap<quint32, QMap<quint64, qint64> > expected;
+    expected[2].insert(2, 22);
+    QCOMPARE(db.toTestMap(), expected);
+}
+
+QTEST_MAIN(DocumentPropertyDBTest)
+
+#include "documentpropertydbtest.moc"
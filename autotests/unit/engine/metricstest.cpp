@@ -0,0 +1,100 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "metrics.h"
+
+#include <QTest>
+
+using namespace Baloo;
+
+class MetricsTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testBuckets();
+    void testHistogram();
+    void testMerge();
+};
+
+void MetricsTest::testBuckets()
+{
+    for (quint64 value : {0ull, 1ull, 7ull, 8ull, 9ull, 15ull, 16ull, 1000ull, 123456789ull, ~0ull}) {
+        const int bucket = MetricsHistogram::bucket(value);
+        QVERIFY(bucket >= 0);
+        QVERIFY(bucket < MetricsHistogram::BucketCount);
+        QVERIFY(MetricsHistogram::bucketLowerBound(bucket) <= value);
+        if (bucket + 1 < MetricsHistogram::BucketCount) {
+            QVERIFY(MetricsHistogram::bucketLowerBound(bucket + 1) > value);
+        }
+    }
+
+    for (int i = 0; i < MetricsHistogram::BucketCount; i++) {
+        QCOMPARE(MetricsHistogram::bucket(MetricsHistogram::bucketLowerBound(i)), i);
+    }
+}
+
+void MetricsTest::testHistogram()
+{
+    MetricsHistogram h;
+    QCOMPARE(h.percentile(50), static_cast<quint64>(0));
+
+    for (quint64 i = 1; i <= 100; i++) {
+        h.record(i);
+    }
+
+    QCOMPARE(h.count(), static_cast<quint64>(100));
+    QCOMPARE(h.sum(), static_cast<quint64>(5050));
+    QCOMPARE(h.max(), static_cast<quint64>(100));
+
+    // Within the precision of the buckets
+    QVERIFY(h.percentile(50) <= 50);
+    QVERIFY(h.percentile(50) >= 44);
+    QVERIFY(h.percentile(99) <= 99);
+    QVERIFY(h.percentile(99) >= 88);
+    QCOMPARE(h.percentile(100), static_cast<quint64>(96));
+}
+
+void MetricsTest::testMerge()
+{
+    Metrics* metrics = Metrics::instance();
+    metrics->reset();
+
+    metrics->counter(QStringLiteral("test.counter"))->add(3);
+    metrics->histogram(QStringLiteral("test.histogram"))->record(20);
+    metrics->histogram(QStringLiteral("test.histogram"))->record(300);
+
+    const QVariantMap map = metrics->toVariantMap();
+    metrics->merge(map);
+
+    QCOMPARE(metrics->counter(QStringLiteral("test.counter"))->value(), static_cast<quint64>(6));
+
+    MetricsHistogram* h = metrics->histogram(QStringLiteral("test.histogram"));
+    QCOMPARE(h->count(), static_cast<quint64>(4));
+    QCOMPARE(h->sum(), static_cast<quint64>(640));
+    QCOMPARE(h->max(), static_cast<quint64>(300));
+    QCOMPARE(h->percentile(50), static_cast<quint64>(20));
+
+    metrics->reset();
+    QCOMPARE(metrics->counter(QStringLiteral("test.counter"))->value(), static_cast<quint64>(0));
+    QCOMPARE(h->count(), static_cast<quint64>(0));
+}
+
+QTEST_MAIN(MetricsTest)
+
+#include "metricstest.moc"
@@ -31,6 +31,8 @@ class OrPostingIteratorTest : public QObject
 private Q_SLOTS:
     void test();
     void testNullIterators();
+    void testEstimateSize();
+    void testBlocks();
 };
 
 void OrPostingIteratorTest::test()
@@ -79,6 +81,58 @@ void OrPostingIteratorTest::testNullIterators()
     QCOMPARE(it.docId(), static_cast<quint64>(0));
 }
 
+void OrPostingIteratorTest::testEstimateSize()
+{
+    QVector<quint64> l1 = {1, 3, 5, 7};
+    QVector<quint64> l2 = {3, 4, 5, 7, 9, 11, 13, 15, 17, 19};
+
+    QVector<PostingIterator*> vec = {new VectorPostingIterator(l1), 0, new VectorPostingIterator(l2)};
+    OrPostingIterator it(vec);
+
+    QCOMPARE(it.estimateSize(20), static_cast<uint>(12));
+    QCOMPARE(it.estimateSize(10), static_cast<uint>(10));
+    QCOMPARE(it.estimateSize(0), static_cast<uint>(0));
+}
+
+void OrPostingIteratorTest::testBlocks()
+{
+    // Long enough to need several blocks from each iterator
+    QVector<quint64> l1, l2, l3, result;
+    for (quint64 id = 1; id <= 3000; id++) {
+        if (id % 7 == 0) {
+            l1 << id;
+        }
+        if (id % 11 == 0) {
+            l2 << id;
+        }
+        if (id > 2500 && id % 2 == 0) {
+            l3 << id;
+        }
+        if (id % 7 == 0 || id % 11 == 0 || (id > 2500 && id % 2 == 0)) {
+            result << id;
+        }
+    }
+
+    QVector<PostingIterator*> vec = {new VectorPostingIterator(l1), 0, new VectorPostingIterator(l2),
+                                     new VectorPostingIterator(l3)};
+    OrPostingIterator it(vec);
+
+    QVector<quint64> ids;
+    quint64 block[100];
+    int count;
+    while ((count = it.nextBlock(block, 100)) == 100) {
+        QCOMPARE(it.docId(), block[99]);
+        for (quint64 id : block) {
+            ids << id;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        ids << block[i];
+    }
+    QCOMPARE(ids, result);
+    QCOMPARE(it.nextBlock(block, 100), 0);
+    QCOMPARE(it.docId(), static_cast<quint64>(0));
+}
 
 QTEST_MAIN(OrPostingIteratorTest)
 
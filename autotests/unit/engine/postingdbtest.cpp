@@ -20,6 +20,7 @@
 
 #include "postingdb.h"
 #include "singledbtest.h"
+#include "orderedvalues.h"
 
 using namespace Baloo;
 
@@ -122,6 +123,49 @@ private Q_SLOTS:
         }
     }
 
+    void testRangeIter() {
+        PostingDB db(PostingDB::create(m_txn), m_txn);
+
+        db.put("X1-" + orderedValue(-5), {1, 2});
+        db.put("X1-" + orderedValue(9), {3});
+        db.put("X1-" + orderedValue(10), {4, 5});
+        db.put("X1-" + orderedValue(200), {6});
+        db.put("X1-word", {7});
+        db.put("X2-" + orderedValue(10), {8});
+
+        PostingIterator* it = db.rangeIter("X1-", orderedValue(9), orderedValue(100));
+        QVERIFY(it);
+
+        QVector<quint64> result = {3, 4, 5};
+        for (quint64 val : result) {
+            QCOMPARE(it->next(), static_cast<quint64>(val));
+        }
+        QCOMPARE(it->next(), static_cast<quint64>(0));
+        delete it;
+
+        it = db.rangeIter("X1-", minimumOrderedValue(), orderedValue(9));
+        QVERIFY(it);
+
+        result = {1, 2, 3};
+        for (quint64 val : result) {
+            QCOMPARE(it->next(), static_cast<quint64>(val));
+        }
+        QCOMPARE(it->next(), static_cast<quint64>(0));
+        delete it;
+
+        it = db.rangeIter("X1-", orderedValue(10), maximumOrderedValue());
+        QVERIFY(it);
+
+        result = {4, 5, 6};
+        for (quint64 val : result) {
+            QCOMPARE(it->next(), static_cast<quint64>(val));
+        }
+        QCOMPARE(it->next(), static_cast<quint64>(0));
+        delete it;
+
+        QVERIFY(!db.rangeIter("X1-", orderedValue(11), orderedValue(199)));
+    }
+
     void testFetchTermsStartingWith() {
         PostingDB db(PostingDB::create(m_txn), m_txn);
 
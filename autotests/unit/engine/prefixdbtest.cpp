@@ -0,0 +1,139 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "prefixdb.h"
+#include "postingdb.h"
+#include "singledbtest.h"
+
+using namespace Baloo;
+
+class PrefixDBTest : public SingleDBTest
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testPrefixes() {
+        QVERIFY(PrefixDB::contains("abc"));
+        QVERIFY(PrefixDB::contains("abcd"));
+        QVERIFY(!PrefixDB::contains("ab"));
+        QVERIFY(!PrefixDB::contains("abcde"));
+
+        // "aé" is three bytes, "ab" and half of an "é" is not a prefix
+        QVERIFY(PrefixDB::contains("a\xc3\xa9"));
+        QVERIFY(!PrefixDB::contains("ab\xc3"));
+
+        const QVector<QByteArray> prefixes = {"fir", "fire"};
+        QCOMPARE(PrefixDB::prefixes("fireman"), prefixes);
+        QCOMPARE(PrefixDB::prefixes("fi"), QVector<QByteArray>());
+        QCOMPARE(PrefixDB::prefixes("ab\xc3\xa9"), QVector<QByteArray>({"ab\xc3\xa9"}));
+    }
+
+    void testUpdate() {
+        PrefixDB db(PrefixDB::create(m_txn), m_txn);
+
+        QMap<quint64, int> delta = {{1, 2}, {5, 1}, {8, 1}};
+        db.update("fir", delta);
+
+        QVector<quint32> counts;
+        QCOMPARE(db.get("fir", &counts), PostingList({1, 5, 8}));
+        QCOMPARE(counts, QVector<quint32>({2, 1, 1}));
+
+        delta = {{1, -1}, {3, 1}, {5, -1}};
+        db.update("fir", delta);
+        QCOMPARE(db.get("fir", &counts), PostingList({1, 3, 8}));
+        QCOMPARE(counts, QVector<quint32>({1, 1, 1}));
+
+        QScopedPointer<PostingIterator> it(db.iter("fir"));
+        QVERIFY(it);
+        QCOMPARE(it->next(), static_cast<quint64>(1));
+        QCOMPARE(it->next(), static_cast<quint64>(3));
+        QCOMPARE(it->next(), static_cast<quint64>(8));
+        QCOMPARE(it->next(), static_cast<quint64>(0));
+
+        delta = {{1, -1}, {3, -1}, {8, -1}};
+        db.update("fir", delta);
+        QCOMPARE(db.get("fir"), PostingList());
+        QVERIFY(!db.iter("fir"));
+    }
+
+    void testBuilder() {
+        QMap<QByteArray, PostingList> unions;
+        QMap<QByteArray, QVector<quint32>> counts;
+        PrefixUnionBuilder builder([&](const QByteArray& prefix, const PostingList& list,
+                                       const QVector<quint32>& c) {
+            QVERIFY(!unions.contains(prefix));
+            unions.insert(prefix, list);
+            counts.insert(prefix, c);
+        });
+
+        builder.addTerm("fi", {9});
+        builder.addTerm("fir", {2, 4});
+        builder.addTerm("fire", {1, 4});
+        builder.addTerm("firm", {3});
+        builder.addTerm("fish", {4});
+        builder.finish();
+
+        QMap<QByteArray, PostingList> expected = {
+            {"fir", {1, 2, 3, 4}},
+            {"fire", {1, 4}},
+            {"firm", {3}},
+            {"fis", {4}},
+            {"fish", {4}}
+        };
+        QCOMPARE(unions, expected);
+        QCOMPARE(counts.value("fir"), QVector<quint32>({1, 1, 1, 2}));
+    }
+
+    void testRebuild() {
+        const MDB_dbi postingDbi = PostingDB::create(m_txn);
+        PostingDB postingDb(postingDbi, m_txn);
+        postingDb.put("fi", {9});
+        postingDb.put("fir", {2, 4});
+        postingDb.put("fire", {1, 4});
+        postingDb.put("firm", {3});
+        postingDb.put("fish", {4});
+
+        PrefixDB db(PrefixDB::create(m_txn), m_txn);
+        db.update("old", {{7, 1}});
+
+        db.beginRebuild(postingDbi);
+        QVERIFY(db.isRebuilding());
+        QVERIFY(db.toTestMap().isEmpty());
+
+        // The batch does not end within the terms starting with "fir"
+        db.continueRebuild(postingDbi, 2);
+        QVERIFY(db.isRebuilding());
+        QCOMPARE(db.toTestMap().keys(), QList<QByteArray>({"fir", "fire", "firm"}));
+
+        db.continueRebuild(postingDbi, 2);
+        QVERIFY(!db.isRebuilding());
+
+        QMap<QByteArray, PostingList> expected = {
+            {"fir", {1, 2, 3, 4}},
+            {"fire", {1, 4}},
+            {"firm", {3}},
+            {"fis", {4}},
+            {"fish", {4}}
+        };
+        QCOMPARE(db.toTestMap(), expected);
+    }
+};
+
+QTEST_MAIN(PrefixDBTest)
+
+#include "prefixdbtest.moc"
@@ -0,0 +1,95 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "queryprofile.h"
+#include "andpostingiterator.h"
+#include "vectorpostingiterator.h"
+
+#include <QTest>
+#include <QScopedPointer>
+
+using namespace Baloo;
+
+class QueryProfileTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void test();
+    void testUnwrappedChildren();
+};
+
+void QueryProfileTest::test()
+{
+    QueryProfile profile;
+
+    QVector<quint64> l1 = {1, 3, 5, 7};
+    QVector<quint64> l2 = {3, 4, 7, 9};
+
+    PostingIterator* it1 = profile.wrap(new VectorPostingIterator(l1), QStringLiteral("a"), 4);
+    PostingIterator* it2 = profile.wrap(new VectorPostingIterator(l2), QStringLiteral("b"), 4);
+    QScopedPointer<PostingIterator> it(profile.wrap(new AndPostingIterator({it1, it2}), QStringLiteral("AND"), 2));
+
+    // Wrapping twice does not add another node
+    QCOMPARE(profile.wrap(it.data(), QStringLiteral("AND"), 2), it.data());
+
+    QCOMPARE(it->next(), static_cast<quint64>(3));
+    QCOMPARE(it->next(), static_cast<quint64>(7));
+    QCOMPARE(it->next(), static_cast<quint64>(0));
+
+    const QVariantMap map = profile.toVariantMap();
+    QCOMPARE(map.value(QStringLiteral("name")).toString(), QStringLiteral("AND"));
+    QCOMPARE(map.value(QStringLiteral("estimated")).toUInt(), 2u);
+    QCOMPARE(map.value(QStringLiteral("actual")).toUInt(), 2u);
+    QCOMPARE(map.value(QStringLiteral("next")).toUInt(), 3u);
+    QCOMPARE(map.value(QStringLiteral("skipTo")).toUInt(), 0u);
+
+    const QVariantList children = map.value(QStringLiteral("children")).toList();
+    QCOMPARE(children.size(), 2);
+
+    const QVariantMap a = children[0].toMap();
+    QCOMPARE(a.value(QStringLiteral("name")).toString(), QStringLiteral("a"));
+    QCOMPARE(a.value(QStringLiteral("estimated")).toUInt(), 4u);
+    QVERIFY(a.value(QStringLiteral("actual")).toUInt() > 0);
+    QVERIFY(a.value(QStringLiteral("children")).toList().isEmpty());
+
+    const QVariantMap b = children[1].toMap();
+    QCOMPARE(b.value(QStringLiteral("name")).toString(), QStringLiteral("b"));
+    QVERIFY(b.value(QStringLiteral("next")).toUInt() + b.value(QStringLiteral("skipTo")).toUInt() > 0);
+}
+
+void QueryProfileTest::testUnwrappedChildren()
+{
+    QueryProfile profile;
+
+    QVector<quint64> l1 = {1, 2};
+    QVector<quint64> l2 = {2, 3};
+
+    PostingIterator* it1 = profile.wrap(new VectorPostingIterator(l1), QStringLiteral("a"), 2);
+    PostingIterator* inner = new AndPostingIterator({it1, new VectorPostingIterator(l2)});
+    QScopedPointer<PostingIterator> it(profile.wrap(new AndPostingIterator({inner}), QStringLiteral("AND"), 1));
+
+    // The wrapped iterator below an unwrapped one is still a child
+    const QVariantList children = profile.toVariantMap().value(QStringLiteral("children")).toList();
+    QCOMPARE(children.size(), 1);
+    QCOMPARE(children.first().toMap().value(QStringLiteral("name")).toString(), QStringLiteral("a"));
+}
+
+QTEST_MAIN(QueryProfileTest)
+
+#include "queryprofiletest.moc"
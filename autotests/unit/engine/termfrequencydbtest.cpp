@@ -0,0 +1,47 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "termfrequencydb.h"
+#include "singledbtest.h"
+
+using namespace Baloo;
+
+class TermFrequencyDBTest : public SingleDBTest
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void test() {
+        TermFrequencyDB db(TermFrequencyDB::create(m_txn), m_txn);
+
+        QByteArray word("fire");
+        QVector<quint32> list = {1, 5, 3};
+
+        db.put(word, list);
+        QCOMPARE(db.get(word), list);
+        QCOMPARE(db.maxFrequency(word), static_cast<quint32>(5));
+
+        db.del(word);
+        QCOMPARE(db.get(word), QVector<quint32>());
+        QCOMPARE(db.maxFrequency(word), static_cast<quint32>(0));
+    }
+};
+
+QTEST_MAIN(TermFrequencyDBTest)
+
+#include "termfrequencydbtest.moc"
@@ -0,0 +1,87 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "tracing.h"
+
+#include <QTest>
+
+using namespace Baloo;
+
+class TracingTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void testSpan();
+    void testRingBuffer();
+    void testMerge();
+};
+
+void TracingTest::init()
+{
+    Tracer::instance()->clear();
+}
+
+void TracingTest::testSpan()
+{
+    const qint64 before = Tracer::instance()->now();
+    {
+        TraceSpan span("test", "span");
+    }
+
+    const QVariantList events = Tracer::instance()->events();
+    QCOMPARE(events.size(), 1);
+
+    const QVariantMap event = events.first().toMap();
+    QCOMPARE(event.value(QStringLiteral("cat")).toString(), QStringLiteral("test"));
+    QCOMPARE(event.value(QStringLiteral("name")).toString(), QStringLiteral("span"));
+    QCOMPARE(event.value(QStringLiteral("ph")).toString(), QStringLiteral("X"));
+    QVERIFY(event.value(QStringLiteral("ts")).toLongLong() >= before);
+    QVERIFY(event.value(QStringLiteral("dur")).toLongLong() >= 0);
+}
+
+void TracingTest::testRingBuffer()
+{
+    Tracer* tracer = Tracer::instance();
+    for (int i = 0; i < Tracer::Capacity + 10; i++) {
+        tracer->record("test", "span", i, 1);
+    }
+
+    // Only the last events are kept, oldest first
+    const QVariantList events = tracer->events();
+    QCOMPARE(events.size(), static_cast<int>(Tracer::Capacity));
+    QCOMPARE(events.first().toMap().value(QStringLiteral("ts")).toLongLong(), 10ll);
+    QCOMPARE(events.last().toMap().value(QStringLiteral("ts")).toLongLong(), Tracer::Capacity + 9ll);
+}
+
+void TracingTest::testMerge()
+{
+    Tracer* tracer = Tracer::instance();
+    tracer->record("test", "local", 5, 2);
+
+    const QVariantList events = tracer->events();
+    tracer->clear();
+    tracer->merge(events);
+
+    QCOMPARE(tracer->events(), events);
+}
+
+QTEST_MAIN(TracingTest)
+
+#include "tracingtest.moc"
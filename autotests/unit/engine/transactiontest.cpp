@@ -20,10 +20,15 @@
 
 #include "transaction.h"
 #include "database.h"
+#include "enginequery.h"
 #include "idutils.h"
+#include "metrics.h"
 
 #include <QTest>
 #include <QTemporaryDir>
+#include <QDateTime>
+
+#include <algorithm>
 
 using namespace Baloo;
 
@@ -43,6 +48,12 @@ private Q_SLOTS:
     }
 
     void testTimeInfo();
+    void testTermCounts();
+    void testPrefixUnions();
+    void testMapGrowth();
+    void testMapAtMaximum();
+    void testCompact();
+    void testReadTransactionPool();
 private:
     QTemporaryDir* dir;
     Database* db;
@@ -87,6 +98,270 @@ void TransactionTest::testTimeInfo()
     QCOMPARE(tr2.documentTimeInfo(id), timeInfo);
 }
 
+void TransactionTest::testTermCounts()
+{
+    Transaction tr(db, Transaction::ReadWrite);
+
+    const QDateTime year2014(QDate(2014, 3, 1));
+    const QDateTime year2015(QDate(2015, 12, 31), QTime(23, 0));
+
+    QVector<quint64> ids;
+    quint64 secondId = 0;
+    for (int i = 0; i < 4; i++) {
+        const QByteArray url(dir->path().toUtf8() + "/file" + QByteArray::number(i));
+        quint64 id = touchFile(url);
+        ids << id;
+        if (i == 1) {
+            secondId = id;
+        }
+
+        Document doc;
+        doc.setId(id);
+        doc.setUrl(url);
+        doc.addBoolTerm(i % 2 ? "T1" : "T2");
+        if (i < 3) {
+            doc.addBoolTerm("T3");
+        }
+        doc.setMTime(i ? year2015.toTime_t() : year2014.toTime_t());
+        tr.addDocument(doc);
+    }
+    tr.commit();
+    std::sort(ids.begin(), ids.end());
+
+    Transaction tr2(db, Transaction::ReadOnly);
+
+    const QVector<QByteArray> terms = {"T1", "T2", "T3", "T4"};
+    QMap<QByteArray, uint> counts = {{"T1", 2}, {"T2", 2}, {"T3", 3}};
+    QCOMPARE(tr2.termCounts(ids, terms), counts);
+
+    bool complete = false;
+    counts = {{"T1", 1}, {"T3", 1}};
+    QCOMPARE(tr2.termCounts({secondId}, terms, 1000, &complete), counts);
+    QVERIFY(complete);
+
+    QVERIFY(tr2.termCounts(QVector<quint64>(), terms).isEmpty());
+
+    QMap<int, uint> years = {{2014, 1}, {2015, 3}};
+    QCOMPARE(tr2.yearCounts(ids), years);
+}
+
+void TransactionTest::testPrefixUnions()
+{
+    const QVector<QVector<QByteArray>> terms = {{"report", "repo"}, {"reply"}, {"rest"}};
+
+    QVector<quint64> ids;
+    Transaction tr(db, Transaction::ReadWrite);
+    for (int i = 0; i < terms.size(); i++) {
+        const QByteArray url(dir->path().toUtf8() + "/file" + QByteArray::number(i));
+        quint64 id = touchFile(url);
+        ids << id;
+
+        Document doc;
+        doc.setId(id);
+        doc.setUrl(url);
+        for (const QByteArray& term : terms[i]) {
+            doc.addTerm(term);
+        }
+        doc.setMTime(1);
+        tr.addDocument(doc);
+    }
+    tr.commit();
+
+    auto startsWith = [this](const QByteArray& prefix) {
+        Transaction tr(db, Transaction::ReadOnly);
+        QVector<quint64> results = tr.exec(EngineQuery(prefix, EngineQuery::StartsWith));
+        std::sort(results.begin(), results.end());
+        return results;
+    };
+    auto sorted = [](QVector<quint64> list) {
+        std::sort(list.begin(), list.end());
+        return list;
+    };
+
+    QCOMPARE(startsWith("rep"), sorted({ids[0], ids[1]}));
+    QCOMPARE(startsWith("repo"), sorted({ids[0]}));
+    QCOMPARE(startsWith("repor"), sorted({ids[0]}));
+    QCOMPARE(startsWith("re"), sorted(ids));
+    QCOMPARE(startsWith("xyz"), QVector<quint64>());
+
+    // The first document still has another term starting with "rep"
+    Transaction tr2(db, Transaction::ReadWrite);
+    tr2.removeDocument(ids[1]);
+    tr2.commit();
+
+    QCOMPARE(startsWith("rep"), sorted({ids[0]}));
+    QCOMPARE(startsWith("res"), sorted({ids[2]}));
+
+    Transaction tr3(db, Transaction::ReadWrite);
+    tr3.removeDocument(ids[0]);
+    tr3.commit();
+
+    QCOMPARE(startsWith("rep"), QVector<quint64>());
+    QCOMPARE(startsWith("repo"), QVector<quint64>());
+}
+
+static QVector<Document> manyDocuments(const QString& path)
+{
+    QVector<Document> docs;
+    for (int i = 0; i < 1000; i++) {
+        const QByteArray url(path.toUtf8() + "/file" + QByteArray::number(i));
+        quint64 id = touchFile(url);
+
+        Document doc;
+        doc.setId(id);
+        doc.setUrl(url);
+        for (int j = 0; j < 20; j++) {
+            doc.addTerm("term" + QByteArray::number(i * 20 + j));
+        }
+        doc.setMTime(1);
+        docs << doc;
+    }
+    return docs;
+}
+
+void TransactionTest::testMapGrowth()
+{
+    QTemporaryDir mapDir;
+    Database mapDb(mapDir.path());
+    mapDb.setMapSizeLimits(1024 * 1024, 1024 * 1024 * 1024);
+    QVERIFY(mapDb.open(Database::CreateDatabase));
+    const size_t initialSize = mapDb.mapSize();
+
+    // Far more than fits into the initial map
+    const QVector<Document> docs = manyDocuments(mapDir.path());
+    QVERIFY(mapDb.write([&](Transaction* tr) {
+        tr->addDocument(docs.first());
+    }));
+
+    // The writes depend on what is read, which is only reliable again
+    // in the new transaction
+    int runs = 0;
+    QVERIFY(mapDb.write([&](Transaction* tr) {
+        runs++;
+        for (const Document& doc : docs) {
+            if (tr->hasDocument(doc.id())) {
+                tr->replaceDocument(doc, DocumentTerms);
+            } else {
+                tr->addDocument(doc);
+            }
+        }
+        tr->setPhaseOne(touchFile(mapDir.path() + "/phaseone"));
+    }));
+    QVERIFY(runs > 1);
+
+    QVERIFY(mapDb.mapSize() > initialSize);
+    QVERIFY(mapDb.mapSize() <= mapDb.maximumMapSize());
+
+    Transaction tr2(mapDb, Transaction::ReadOnly);
+    QCOMPARE(tr2.size(), 1000u);
+    QCOMPARE(tr2.phaseOneSize(), 1u);
+    QCOMPARE(tr2.fetchTermsStartingWith("term1999").size(), 11);
+}
+
+void TransactionTest::testMapAtMaximum()
+{
+    QTemporaryDir mapDir;
+    Database mapDb(mapDir.path());
+    mapDb.setMapSizeLimits(1024 * 1024, 1024 * 1024);
+    QVERIFY(mapDb.open(Database::CreateDatabase));
+
+    const QVector<Document> docs = manyDocuments(mapDir.path());
+    {
+        Transaction tr(mapDb, Transaction::ReadWrite);
+        for (const Document& doc : docs) {
+            tr.addDocument(doc);
+        }
+        QCOMPARE(tr.commit(), MDB_MAP_FULL);
+    }
+
+    QVERIFY(!mapDb.write([&](Transaction* tr) {
+        for (const Document& doc : docs) {
+            tr->addDocument(doc);
+        }
+    }));
+
+    // Nothing of the dropped changes is left behind
+    Transaction tr(mapDb, Transaction::ReadOnly);
+    QCOMPARE(tr.size(), 0u);
+    QVERIFY(tr.isEmpty());
+}
+
+void TransactionTest::testCompact()
+{
+    QVector<quint64> ids;
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        for (int i = 0; i < 500; i++) {
+            const QByteArray url(dir->path().toUtf8() + "/file" + QByteArray::number(i));
+            quint64 id = touchFile(url);
+            ids << id;
+
+            Document doc;
+            doc.setId(id);
+            doc.setUrl(url);
+            for (int j = 0; j < 20; j++) {
+                doc.addTerm("term" + QByteArray::number(i * 20 + j));
+            }
+            doc.setMTime(1);
+            tr.addDocument(doc);
+        }
+        tr.commit();
+    }
+
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        for (int i = 1; i < ids.size(); i++) {
+            tr.removeDocument(ids[i]);
+        }
+        tr.commit();
+    }
+
+    quint64 generation;
+    {
+        Transaction tr(db, Transaction::ReadOnly);
+        generation = tr.generation();
+    }
+
+    QVERIFY(db->compact() > 0);
+    QVERIFY(db->isOpen());
+
+    // The compacted copy starts over with the transaction ids
+    Transaction tr(db, Transaction::ReadOnly);
+    QVERIFY(tr.generation() > generation);
+    QCOMPARE(tr.size(), 1u);
+    QVERIFY(tr.hasDocument(ids.first()));
+    QCOMPARE(tr.fetchTermsStartingWith("term1").size(), 11);
+}
+
+void TransactionTest::testReadTransactionPool()
+{
+    MetricsCounter* reused = Metrics::instance()->counter(QStringLiteral("database.readpool.reused"));
+
+    {
+        Transaction tr(db, Transaction::ReadOnly);
+        QCOMPARE(tr.size(), 0u);
+    }
+
+    const QByteArray url(dir->path().toUtf8() + "/file");
+    const quint64 id = touchFile(url);
+    {
+        Transaction tr(db, Transaction::ReadWrite);
+        Document doc;
+        doc.setId(id);
+        doc.setUrl(url);
+        doc.addTerm("term");
+        doc.setMTime(1);
+        tr.addDocument(doc);
+        tr.commit();
+    }
+
+    // The renewed transaction sees the latest commit
+    const quint64 reusedBefore = reused->value();
+    Transaction tr(db, Transaction::ReadOnly);
+    QCOMPARE(reused->value(), reusedBefore + 1);
+    QCOMPARE(tr.size(), 1u);
+    QVERIFY(tr.hasDocument(id));
+}
 
 QTEST_MAIN(TransactionTest)
 
@@ -0,0 +1,132 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "trigramdb.h"
+#include "idfilenamedb.h"
+#include "documenttimedb.h"
+#include "singledbtest.h"
+
+using namespace Baloo;
+
+class TrigramDBTest : public SingleDBTest
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testNormalize() {
+        QCOMPARE(TrigramDB::normalize("IMG_2019.JPG"), QByteArray("img_2019.jpg"));
+        QCOMPARE(TrigramDB::normalize("Caf\xc3\xa9.txt"), QByteArray("cafe.txt"));
+    }
+
+    void testTrigrams() {
+        const QVector<QByteArray> trigrams = {"aaa", "aab", "aba", "bab"};
+        QCOMPARE(TrigramDB::trigrams("aaababa"), trigrams);
+        QCOMPARE(TrigramDB::trigrams("ab"), QVector<QByteArray>());
+    }
+
+    void testUpdate() {
+        TrigramDB db(TrigramDB::create(m_txn), m_txn);
+
+        QMap<quint64, int> delta = {{1, 1}, {5, 1}, {8, 1}};
+        db.update("img", delta);
+        QCOMPARE(db.get("img"), PostingList({1, 5, 8}));
+
+        delta = {{1, -1}, {3, 1}};
+        db.update("img", delta);
+        QCOMPARE(db.get("img"), PostingList({3, 5, 8}));
+
+        delta = {{3, -1}, {5, -1}, {8, -1}};
+        db.update("img", delta);
+        QCOMPARE(db.get("img"), PostingList());
+        QCOMPARE(db.toTestMap(), (QMap<QByteArray, PostingList>()));
+    }
+
+    void testIter() {
+        TrigramDB db(TrigramDB::create(m_txn), m_txn);
+
+        auto add = [&](quint64 id, const QByteArray& name) {
+            for (const QByteArray& trigram : TrigramDB::trigrams(TrigramDB::normalize(name))) {
+                QMap<quint64, int> delta = {{id, 1}};
+                db.update(trigram, delta);
+            }
+        };
+        add(1, "IMG_20190503.jpg");
+        add(2, "IMG_20180503.jpg");
+        add(3, "notes-2019.txt");
+
+        QScopedPointer<PostingIterator> it(db.iter("2019"));
+        QVERIFY(it);
+        QCOMPARE(it->next(), static_cast<quint64>(1));
+        QCOMPARE(it->next(), static_cast<quint64>(3));
+        QCOMPARE(it->next(), static_cast<quint64>(0));
+
+        it.reset(db.iter("0503"));
+        QVERIFY(it);
+        QCOMPARE(it->next(), static_cast<quint64>(1));
+        QCOMPARE(it->next(), static_cast<quint64>(2));
+        QCOMPARE(it->next(), static_cast<quint64>(0));
+
+        QVERIFY(!db.iter("xyz"));
+    }
+
+    void testRebuild() {
+        const MDB_dbi idFilenameDbi = IdFilenameDB::create(m_txn);
+        const MDB_dbi docTimeDbi = DocumentTimeDB::create(m_txn);
+        IdFilenameDB idFilenameDb(idFilenameDbi, m_txn);
+        DocumentTimeDB docTimeDb(docTimeDbi, m_txn);
+
+        auto add = [&](quint64 id, const QByteArray& name, bool isDocument) {
+            IdFilenameDB::FilePath path;
+            path.name = name;
+            idFilenameDb.put(id, path);
+            if (isDocument) {
+                docTimeDb.put(id, DocumentTimeDB::TimeInfo(1, 1));
+            }
+        };
+        add(1, "abcd", true);
+        add(2, "abcz", false);
+        add(3, "bcde", true);
+
+        TrigramDB db(TrigramDB::create(m_txn), m_txn);
+        db.update("old", {{7, 1}});
+
+        db.beginRebuild();
+        QVERIFY(db.isRebuilding());
+        QVERIFY(db.toTestMap().isEmpty());
+
+        // Written meanwhile, as if by a transaction indexing the document
+        db.update("bcd", {{3, 1}});
+
+        db.continueRebuild(idFilenameDbi, docTimeDbi, 2);
+        QVERIFY(db.isRebuilding());
+
+        db.continueRebuild(idFilenameDbi, docTimeDbi, 2);
+        QVERIFY(!db.isRebuilding());
+
+        QMap<QByteArray, PostingList> expected = {
+            {"abc", {1}},
+            {"bcd", {1, 3}},
+            {"cde", {3}}
+        };
+        QCOMPARE(db.toTestMap(), expected);
+    }
+};
+
+QTEST_MAIN(TrigramDBTest)
+
+#include "trigramdbtest.moc"
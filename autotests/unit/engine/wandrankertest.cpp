@@ -0,0 +1,142 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "wandranker.h"
+#include "frequencypostingiterator.h"
+#include "vectorpostingiterator.h"
+#include "postingcodec.h"
+#include "frequencycodec.h"
+
+#include <QTest>
+
+using namespace Baloo;
+
+class WandRankerTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testFrequency();
+    void testEncoded();
+    void testRareTerm();
+    void testFilter();
+    void testTopK();
+};
+
+static quint32 constantLength(quint64)
+{
+    return 10;
+}
+
+void WandRankerTest::testFrequency()
+{
+    WandRanker ranker(10, 10, constantLength);
+    ranker.addTerm(new FrequencyPostingIterator({1, 2, 3}, {1, 5, 2}), 3);
+
+    QCOMPARE(ranker.topK(-1), QVector<quint64>({2, 3, 1}));
+}
+
+void WandRankerTest::testEncoded()
+{
+    const QByteArray ids = PostingCodec().encode({1, 2, 3});
+    const QByteArray freqs = FrequencyCodec().encode({1, 5, 2});
+
+    FrequencyPostingIterator* it = new FrequencyPostingIterator(ids, freqs);
+    QCOMPARE(it->size(), 3);
+    QCOMPARE(it->maxFrequency(), 5u);
+
+    WandRanker ranker(10, 10, constantLength);
+    ranker.addTerm(it, it->size());
+    QCOMPARE(ranker.topK(-1), QVector<quint64>({2, 3, 1}));
+
+    // Without any frequencies each one counts once
+    FrequencyPostingIterator plain(ids, QByteArray());
+    QCOMPARE(plain.maxFrequency(), 1u);
+    QCOMPARE(plain.skipTo(2), static_cast<quint64>(2));
+    QCOMPARE(plain.frequency(), 1u);
+}
+
+void WandRankerTest::testRareTerm()
+{
+    // Document 4 only contains the rare term, but that is worth more
+    // than the common term
+    WandRanker ranker(10, 10, constantLength);
+    ranker.addTerm(new FrequencyPostingIterator({1, 2, 3, 5, 6, 7, 8}, {1, 1, 1, 1, 1, 1, 1}), 7);
+    ranker.addTerm(new FrequencyPostingIterator({4}, {1}), 1);
+
+    QCOMPARE(ranker.topK(1), QVector<quint64>({4}));
+}
+
+void WandRankerTest::testFilter()
+{
+    WandRanker ranker(10, 10, constantLength);
+    ranker.addTerm(new FrequencyPostingIterator({1, 2, 3}, {1, 5, 2}), 3);
+
+    // Documents in the filter without the term are still returned
+    VectorPostingIterator filter({1, 3, 4});
+    QCOMPARE(ranker.topK(-1, &filter), QVector<quint64>({3, 1, 4}));
+}
+
+void WandRankerTest::testTopK()
+{
+    qsrand(1);
+
+    QVector<quint64> ids[3];
+    QVector<quint32> freqs[3];
+    QVector<quint64> filterIds;
+    for (quint64 id = 1; id <= 500; id++) {
+        for (int t = 0; t < 3; t++) {
+            if (qrand() % (t + 2) == 0) {
+                ids[t] << id;
+                freqs[t] << 1 + qrand() % 5;
+            }
+        }
+        if (qrand() % 3) {
+            filterIds << id;
+        }
+    }
+
+    auto docLength = [](quint64 id) {
+        return static_cast<quint32>(1 + id % 37);
+    };
+
+    auto rank = [&](int k, PostingIterator* filter) {
+        WandRanker ranker(500, 19, docLength);
+        for (int t = 0; t < 3; t++) {
+            ranker.addTerm(new FrequencyPostingIterator(ids[t], freqs[t]), ids[t].size());
+        }
+        return ranker.topK(k, filter);
+    };
+
+    // The pruned results should match the exhaustive ones
+    const QVector<quint64> all = rank(-1, 0);
+    for (int k : {1, 5, 20}) {
+        QCOMPARE(rank(k, 0), all.mid(0, k));
+    }
+
+    VectorPostingIterator filter(filterIds);
+    const QVector<quint64> allFiltered = rank(-1, &filter);
+    for (int k : {1, 5, 20}) {
+        VectorPostingIterator it(filterIds);
+        QCOMPARE(rank(k, &it), allFiltered.mid(0, k));
+    }
+}
+
+QTEST_MAIN(WandRankerTest)
+
+#include "wandrankertest.moc"
@@ -0,0 +1,183 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "indexwriter.h"
+
+#include "database.h"
+#include "transaction.h"
+#include "document.h"
+#include "idutils.h"
+
+#include <QTest>
+#include <QTemporaryDir>
+#include <QAtomicInt>
+
+using namespace Baloo;
+
+class IndexWriterTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testCoalesce();
+    void testOrder();
+    void testStop();
+    void testPause();
+
+private:
+    Document createDocument(const QString& name);
+
+    QTemporaryDir* m_dir;
+    Database* m_db;
+};
+
+void IndexWriterTest::init()
+{
+    m_dir = new QTemporaryDir();
+    m_db = new Database(m_dir->path());
+    m_db->open(Database::CreateDatabase);
+}
+
+void IndexWriterTest::cleanup()
+{
+    delete m_db;
+    delete m_dir;
+}
+
+Document IndexWriterTest::createDocument(const QString& name)
+{
+    const QString path = m_dir->path() + QLatin1Char('/') + name;
+    QFile file(path);
+    file.open(QIODevice::WriteOnly);
+    file.write("data");
+    file.close();
+
+    const QByteArray url = QFile::encodeName(path);
+
+    Document doc;
+    doc.setId(filePathToId(url));
+    doc.setUrl(url);
+    doc.addTerm("term");
+    doc.setMTime(1);
+    doc.setCTime(1);
+    return doc;
+}
+
+void IndexWriterTest::testCoalesce()
+{
+    IndexWriter writer(m_db);
+    writer.setCommitInterval(60 * 1000);
+    writer.setCommitBatchSize(3);
+
+    QAtomicInt commits;
+    connect(&writer, &IndexWriter::committed, this, [&commits]() {
+        commits.ref();
+    }, Qt::DirectConnection);
+    writer.start();
+
+    QVector<Document> docs;
+    for (int i = 0; i < 3; i++) {
+        docs << createDocument(QStringLiteral("file%1").arg(i));
+        const Document doc = docs.last();
+        writer.submit([doc](Transaction* tr) {
+            tr->addDocument(doc);
+        });
+    }
+
+    writer.flush();
+    QCOMPARE(commits.load(), 1);
+
+    Transaction tr(m_db, Transaction::ReadOnly);
+    for (const Document& doc : docs) {
+        QVERIFY(tr.hasDocument(doc.id()));
+    }
+}
+
+void IndexWriterTest::testOrder()
+{
+    IndexWriter writer(m_db);
+    writer.setSyncInterval(0);
+    writer.start();
+
+    const Document doc = createDocument(QStringLiteral("file"));
+    writer.submit([doc](Transaction* tr) {
+        tr->addDocument(doc);
+    });
+
+    // The second batch sees the changes of the first one
+    bool hadDocument = false;
+    writer.submit([doc, &hadDocument](Transaction* tr) {
+        hadDocument = tr->hasDocument(doc.id());
+        tr->removeDocument(doc.id());
+    });
+    writer.flush();
+
+    QVERIFY(hadDocument);
+    Transaction tr(m_db, Transaction::ReadOnly);
+    QVERIFY(!tr.hasDocument(doc.id()));
+}
+
+void IndexWriterTest::testStop()
+{
+    IndexWriter writer(m_db);
+    writer.setCommitInterval(60 * 1000);
+    writer.start();
+
+    const Document doc = createDocument(QStringLiteral("file"));
+    writer.submit([doc](Transaction* tr) {
+        tr->addDocument(doc);
+    });
+    writer.stop();
+
+    QVERIFY(!m_db->noSync());
+    Transaction tr(m_db, Transaction::ReadOnly);
+    QVERIFY(tr.hasDocument(doc.id()));
+}
+
+void IndexWriterTest::testPause()
+{
+    IndexWriter writer(m_db);
+    writer.setCommitInterval(0);
+    writer.setSyncInterval(0);
+    writer.start();
+    writer.pause();
+
+    const Document doc = createDocument(QStringLiteral("file"));
+    writer.submit([doc](Transaction* tr) {
+        tr->addDocument(doc);
+    });
+    QTest::qWait(200);
+
+    {
+        Transaction tr(m_db, Transaction::ReadOnly);
+        QVERIFY(!tr.hasDocument(doc.id()));
+    }
+
+    writer.resume();
+    writer.flush();
+
+    Transaction tr(m_db, Transaction::ReadOnly);
+    QVERIFY(tr.hasDocument(doc.id()));
+}
+
+QTEST_MAIN(IndexWriterTest)
+
+#include "indexwritertest.moc"
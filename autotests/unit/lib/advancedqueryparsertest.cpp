@@ -36,6 +36,7 @@ private Q_SLOTS:
     void testNesting();
     void testDateTime();
     void testOperators();
+    void testNegation();
 };
 
 void AdvancedQueryParserTest::testSimpleProperty()
@@ -188,6 +189,34 @@ void AdvancedQueryParserTest::testOperators()
     term = parser.parse(QStringLiteral("width>=500"));
     expectedTerm = Term(QStringLiteral("width"), 500, Term::GreaterEqual);
     QCOMPARE(term, expectedTerm);
+
+    term = parser.parse(QStringLiteral("size>9223372036854775807"));
+    expectedTerm = Term(QStringLiteral("size"), QVariant(Q_INT64_C(9223372036854775807)), Term::Greater);
+    QCOMPARE(term, expectedTerm);
+}
+
+void AdvancedQueryParserTest::testNegation()
+{
+    AdvancedQueryParser parser;
+    Term term;
+    Term expectedTerm;
+
+    term = parser.parse(QStringLiteral("-type:Folder"));
+    expectedTerm = !Term(QStringLiteral("type"), "Folder");
+    QCOMPARE(term, expectedTerm);
+
+    term = parser.parse(QStringLiteral("fire NOT artist:Coldplay"));
+    expectedTerm = Term(Term::And);
+    expectedTerm.addSubTerm(Term(QLatin1String(""), "fire"));
+    expectedTerm.addSubTerm(!Term(QStringLiteral("artist"), "Coldplay"));
+    QCOMPARE(term, expectedTerm);
+
+    // The terms after a negated group are not part of it
+    term = parser.parse(QStringLiteral("NOT (type:song OR stars) fire"));
+    expectedTerm = Term(Term::And);
+    expectedTerm.addSubTerm(!(Term(QStringLiteral("type"), "song") || Term(QLatin1String(""), "stars")));
+    expectedTerm.addSubTerm(Term(QLatin1String(""), "fire"));
+    QCOMPARE(term, expectedTerm);
 }
 
 QTEST_MAIN(AdvancedQueryParserTest)
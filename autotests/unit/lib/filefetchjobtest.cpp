@@ -19,6 +19,7 @@
  */
 
 #include "file.h"
+#include "filefetchjob.h"
 #include "document.h"
 #include "database.h"
 #include "transaction.h"
@@ -29,6 +30,8 @@
 #include <QTest>
 #include <QTemporaryFile>
 #include <QTemporaryDir>
+#include <QFileInfo>
+#include <QThreadPool>
 
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -45,6 +48,8 @@ class FileFetchJobTest : public QObject
 
 private Q_SLOTS:
     void test();
+    void testBatch();
+    void testDeleteWhileRunning();
 };
 
 void FileFetchJobTest::test()
@@ -90,6 +95,105 @@ void FileFetchJobTest::test()
     QCOMPARE(file.properties(), map);
 }
 
+void FileFetchJobTest::testBatch()
+{
+    using namespace KFileMetaData;
+
+    setenv("BALOO_DB_PATH", dir.path().toStdString().c_str(), 1);
+
+    PropertyMap map;
+    map.insert(Property::Album, QLatin1String("album"));
+    map.insert(Property::Title, QLatin1String("title"));
+
+    QJsonObject jo = QJsonObject::fromVariantMap(toVariantMap(map));
+    QJsonDocument jdoc;
+    jdoc.setObject(jo);
+
+    QTemporaryFile indexedFile;
+    indexedFile.open();
+    QTemporaryFile otherFile;
+    otherFile.open();
+
+    Document doc;
+    doc.setData(jdoc.toJson());
+    doc.setUrl(indexedFile.fileName().toUtf8());
+    doc.setId(filePathToId(doc.url()));
+    doc.addTerm("testterm");
+    doc.addFileNameTerm("filename");
+    doc.setMTime(1);
+    doc.setCTime(1);
+
+    {
+        Database* db = globalDatabaseInstance();
+        QVERIFY(db->open(Database::CreateDatabase));
+
+        Transaction tr(db, Transaction::ReadWrite);
+        tr.addDocument(doc);
+        tr.commit();
+    }
+
+    FileFetchJob* job = new FileFetchJob(QStringList() << otherFile.fileName() << indexedFile.fileName());
+    job->setAutoDelete(false);
+    job->setChunkSize(1);
+    job->setProperties(QList<Property::Property>() << Property::Title);
+
+    int chunks = 0;
+    connect(job, &FileFetchJob::filesFetched, [&chunks](const QList<Baloo::File>& files) {
+        QCOMPARE(files.size(), 1);
+        chunks++;
+    });
+    QVERIFY(job->exec());
+    QCOMPARE(chunks, 2);
+
+    const QList<File> files = job->files();
+    QCOMPARE(files.size(), 2);
+    for (const File& file : files) {
+        if (file.path() == QFileInfo(indexedFile.fileName()).canonicalFilePath()) {
+            PropertyMap expected;
+            expected.insert(Property::Title, QLatin1String("title"));
+            QCOMPARE(file.properties(), expected);
+        } else {
+            QVERIFY(file.properties().isEmpty());
+        }
+    }
+
+    delete job;
+}
+
+void FileFetchJobTest::testDeleteWhileRunning()
+{
+    setenv("BALOO_DB_PATH", dir.path().toStdString().c_str(), 1);
+    QVERIFY(globalDatabaseInstance()->open(Database::CreateDatabase));
+
+    QStringList paths;
+    for (int i = 0; i < 10000; i++) {
+        paths << dir.path() + QStringLiteral("/missing%1").arg(i);
+    }
+
+    FileFetchJob* job = new FileFetchJob(paths);
+    job->setAutoDelete(false);
+    job->setChunkSize(1);
+    job->start();
+    delete job;
+
+    // The runnable must not deliver anything to the deleted job
+    QThreadPool::globalInstance()->waitForDone();
+    QCoreApplication::processEvents();
+
+    FileFetchJob* killed = new FileFetchJob(paths);
+    killed->setChunkSize(1);
+
+    int chunks = 0;
+    connect(killed, &FileFetchJob::filesFetched, [&chunks](const QList<Baloo::File>&) {
+        chunks++;
+    });
+    killed->start();
+    QVERIFY(killed->kill());
+    QThreadPool::globalInstance()->waitForDone();
+    QCoreApplication::processEvents();
+    QVERIFY(chunks < paths.size());
+}
+
 QTEST_MAIN(FileFetchJobTest)
 
 #include "filefetchjobtest.moc"
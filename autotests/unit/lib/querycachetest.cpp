@@ -0,0 +1,119 @@
+/*
+ * This file is part of the KDE Baloo Project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "querycache.h"
+#include "term.h"
+#include "metrics.h"
+
+#include <QTest>
+
+using namespace Baloo;
+
+class QueryCacheTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testLookup();
+    void testGeneration();
+    void testEviction();
+    void testCanonicalKey();
+};
+
+void QueryCacheTest::testLookup()
+{
+    Metrics::instance()->reset();
+
+    QueryCache cache;
+    Term term(QStringLiteral("filename"), QStringLiteral("fire"));
+    QVector<quint64> ids = {1, 5, 9};
+
+    QVector<quint64> result;
+    QVERIFY(!cache.lookup(term, 1, &result));
+
+    cache.insert(term, 1, ids);
+    QVERIFY(cache.lookup(term, 1, &result));
+    QCOMPARE(result, ids);
+
+    QueryCache::Statistics stats = cache.statistics();
+    QCOMPARE(stats.hits, static_cast<quint64>(1));
+    QCOMPARE(stats.misses, static_cast<quint64>(1));
+    QCOMPARE(stats.entries, 1);
+
+    const QVariantMap counters = Metrics::instance()->toVariantMap().value(QStringLiteral("counters")).toMap();
+    QCOMPARE(counters.value(QStringLiteral("querycache.hits")).toULongLong(), static_cast<quint64>(1));
+    QCOMPARE(counters.value(QStringLiteral("querycache.misses")).toULongLong(), static_cast<quint64>(1));
+}
+
+void QueryCacheTest::testGeneration()
+{
+    QueryCache cache;
+    Term term(QStringLiteral("filename"), QStringLiteral("fire"));
+    Term term2(QStringLiteral("filename"), QStringLiteral("water"));
+
+    cache.insert(term, 1, {1, 2});
+    cache.insert(term2, 2, {3});
+
+    // Inserting the newer generation drops everything older
+    QVector<quint64> result;
+    QVERIFY(!cache.lookup(term, 1, &result));
+    QVERIFY(!cache.lookup(term, 2, &result));
+    QVERIFY(cache.lookup(term2, 2, &result));
+    QCOMPARE(cache.statistics().entries, 1);
+
+    // Results from an older snapshot are ignored
+    cache.insert(term, 1, {1, 2});
+    QCOMPARE(cache.statistics().entries, 1);
+}
+
+void QueryCacheTest::testEviction()
+{
+    QueryCache cache;
+    cache.setMaximumSize(1000);
+
+    QVector<quint64> ids(50, 1);
+    for (int i = 0; i < 10; i++) {
+        cache.insert(Term(QStringLiteral("tag"), QString::number(i)), 1, ids);
+    }
+
+    QVERIFY(cache.statistics().size <= 1000);
+
+    // The oldest entries go first
+    QVector<quint64> result;
+    QVERIFY(cache.lookup(Term(QStringLiteral("tag"), QStringLiteral("9")), 1, &result));
+    QVERIFY(!cache.lookup(Term(QStringLiteral("tag"), QStringLiteral("0")), 1, &result));
+}
+
+void QueryCacheTest::testCanonicalKey()
+{
+    Term a(QStringLiteral("filename"), QStringLiteral("fire"));
+    Term b(QStringLiteral("tag"), QStringLiteral("hot"));
+
+    QCOMPARE(QueryCache::canonicalKey(a && b), QueryCache::canonicalKey(b && a));
+    QVERIFY(QueryCache::canonicalKey(a && b) != QueryCache::canonicalKey(a || b));
+
+    Term c(a);
+    c.setNegation(true);
+    QVERIFY(QueryCache::canonicalKey(a) != QueryCache::canonicalKey(c));
+}
+
+QTEST_MAIN(QueryCacheTest)
+
+#include "querycachetest.moc"
@@ -0,0 +1,350 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "query.h"
+#include "resultiterator.h"
+#include "database.h"
+#include "databaseshards.h"
+#include "transaction.h"
+#include "document.h"
+#include "termgenerator.h"
+#include "idutils.h"
+#include "global.h"
+#include "orderedvalues.h"
+
+#include <QTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include <KConfig>
+#include <KConfigGroup>
+#include <KFileMetaData/Properties>
+
+using namespace Baloo;
+
+class QueryExecTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+
+    void testCount_data();
+    void testCount();
+
+    void testPaging_data();
+    void testPaging();
+    void testRelevancePagingAfterChange();
+    void testPropertyPaging();
+    void testShardPaging();
+    void testMovedFrom();
+
+private:
+    void addFile(const QString& name, const QString& text, quint32 mtime, qint64 width = -1);
+    void addFile(Database* db, const QString& path, const QString& text, quint32 mtime, qint64 width = -1);
+    QStringList fetchPage(Query query, QByteArray* token, bool* error = 0);
+
+    QTemporaryDir m_dir;
+};
+
+void QueryExecTest::initTestCase()
+{
+    setenv("BALOO_DB_PATH", m_dir.path().toStdString().c_str(), 1);
+    setenv("BALOO_QUERY_SERVER", "0", 1);
+    setenv("XDG_CONFIG_HOME", QFile::encodeName(m_dir.path() + QStringLiteral("/config")).constData(), 1);
+
+    QVERIFY(globalDatabaseInstance()->open(Database::CreateDatabase));
+
+    for (int i = 1; i <= 5; i++) {
+        addFile(QStringLiteral("file%1").arg(i), QStringLiteral("alpha"), i);
+    }
+    addFile(QStringLiteral("count1"), QStringLiteral("beta gamma"), 1);
+    addFile(QStringLiteral("count2"), QStringLiteral("beta"), 1);
+    addFile(QStringLiteral("count3"), QStringLiteral("gamma delta"), 1);
+    addFile(QStringLiteral("wide"), QStringLiteral("image"), 1, 640);
+
+    addFile(QStringLiteral("sized1"), QStringLiteral("sized"), 1, 300);
+    addFile(QStringLiteral("sized2"), QStringLiteral("sized"), 1, 100);
+    addFile(QStringLiteral("sized3"), QStringLiteral("sized"), 1, 200);
+    addFile(QStringLiteral("sized4"), QStringLiteral("sized"), 1, 400);
+    addFile(QStringLiteral("sized5"), QStringLiteral("sized"), 1);
+}
+
+void QueryExecTest::addFile(const QString& name, const QString& text, quint32 mtime, qint64 width)
+{
+    addFile(globalDatabaseInstance(), m_dir.path() + QLatin1Char('/') + name, text, mtime, width);
+}
+
+void QueryExecTest::addFile(Database* db, const QString& path, const QString& text, quint32 mtime, qint64 width)
+{
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.close();
+
+    Document doc;
+    doc.setUrl(QFile::encodeName(path));
+    doc.setId(filePathToId(doc.url()));
+    doc.setMTime(mtime);
+    doc.setCTime(mtime);
+
+    TermGenerator tg(&doc);
+    tg.indexText(text);
+    tg.indexFileNameText(QFileInfo(path).fileName());
+    if (width >= 0) {
+        const int property = static_cast<int>(KFileMetaData::Property::Width);
+        doc.addBoolTerm('X' + QByteArray::number(property) + '-' + orderedValue(width));
+        doc.addProperty(property, width);
+    }
+
+    Transaction tr(db, Transaction::ReadWrite);
+    tr.addDocument(doc);
+    tr.commit();
+}
+
+// Returns the file names of the page after \p token, which is then set to
+// the token of the last of them
+QStringList QueryExecTest::fetchPage(Query query, QByteArray* token, bool* error)
+{
+    query.setContinuationToken(*token);
+
+    QStringList names;
+    ResultIterator it = query.exec();
+    while (it.next()) {
+        names << QFileInfo(it.filePath()).fileName();
+        *token = it.continuationToken();
+    }
+    if (error) {
+        *error = it.hasError();
+    }
+    return names;
+}
+
+void QueryExecTest::testCount_data()
+{
+    QTest::addColumn<QString>("searchString");
+    QTest::addColumn<uint>("count");
+
+    QTest::newRow("term") << QStringLiteral("alpha") << 5u;
+    QTest::newRow("and") << QStringLiteral("beta gamma") << 1u;
+    QTest::newRow("or") << QStringLiteral("beta OR gamma") << 3u;
+    QTest::newRow("andNot") << QStringLiteral("beta -gamma") << 1u;
+    QTest::newRow("orAndNot") << QStringLiteral("(beta OR gamma) -delta") << 2u;
+    QTest::newRow("none") << QStringLiteral("epsilon") << 0u;
+    QTest::newRow("range") << QStringLiteral("width>=640") << 1u;
+    QTest::newRow("rangeAboveMaximum") << QStringLiteral("width>9223372036854775807") << 0u;
+    QTest::newRow("rangeUpToMaximum") << QStringLiteral("width<=9223372036854775807") << 5u;
+}
+
+void QueryExecTest::testCount()
+{
+    QFETCH(QString, searchString);
+    QFETCH(uint, count);
+
+    Query query;
+    query.setSearchString(searchString);
+    query.setLimit(1);
+
+    // The limit does not apply, and the count matches the results
+    QCOMPARE(query.count(), count);
+    QCOMPARE(query.estimatedCount(1000), count);
+
+    query.setLimit(static_cast<uint>(-1));
+    uint results = 0;
+    ResultIterator it = query.exec();
+    while (it.next()) {
+        results++;
+    }
+    QCOMPARE(results, count);
+}
+
+void QueryExecTest::testPaging_data()
+{
+    QTest::addColumn<int>("sortingOption");
+
+    QTest::newRow("none") << static_cast<int>(Query::SortNone);
+    QTest::newRow("auto") << static_cast<int>(Query::SortAuto);
+}
+
+void QueryExecTest::testPaging()
+{
+    QFETCH(int, sortingOption);
+
+    Query query;
+    query.setSearchString(QStringLiteral("alpha"));
+    query.setSortingOption(static_cast<Query::SortingOption>(sortingOption));
+    query.setLimit(2);
+
+    QByteArray token;
+    QStringList names = fetchPage(query, &token);
+    QCOMPARE(names.size(), 2);
+
+    // The index changes between the pages
+    addFile(QLatin1String("added-") + QLatin1String(QTest::currentDataTag()), QStringLiteral("alpha"), 3);
+
+    QStringList page;
+    do {
+        page = fetchPage(query, &token);
+        names += page;
+    } while (!page.isEmpty());
+
+    // The files which existed all along are neither skipped nor repeated
+    for (int i = 1; i <= 5; i++) {
+        QCOMPARE(names.count(QStringLiteral("file%1").arg(i)), 1);
+    }
+    QCOMPARE(names.toSet().size(), names.size());
+}
+
+void QueryExecTest::testRelevancePagingAfterChange()
+{
+    Query query;
+    query.setSearchString(QStringLiteral("alpha"));
+    query.setSortingOption(Query::SortRelevance);
+    query.setLimit(2);
+
+    QByteArray token;
+    QStringList names = fetchPage(query, &token);
+    QCOMPARE(names.size(), 2);
+
+    bool error = true;
+    QByteArray next = token;
+    QCOMPARE(fetchPage(query, &next, &error).size(), 2);
+    QVERIFY(!error);
+
+    // The position the token points to has moved, so it cannot be resumed from
+    addFile(QStringLiteral("relevant"), QStringLiteral("alpha alpha"), 1);
+
+    next = token;
+    QVERIFY(fetchPage(query, &next, &error).isEmpty());
+    QVERIFY(error);
+}
+
+void QueryExecTest::testPropertyPaging()
+{
+    Query query;
+    query.setSearchString(QStringLiteral("sized"));
+    query.setSortingProperty(QStringLiteral("width"));
+    query.setLimit(2);
+
+    QByteArray token;
+    QStringList names = fetchPage(query, &token);
+    QCOMPARE(names, QStringList({QStringLiteral("sized2"), QStringLiteral("sized3")}));
+
+    // Sorts before the last result, so it is not part of the next pages
+    addFile(QStringLiteral("sized6"), QStringLiteral("sized"), 1, 150);
+
+    QStringList page;
+    do {
+        page = fetchPage(query, &token);
+        names += page;
+    } while (!page.isEmpty());
+
+    const QStringList expected = {QStringLiteral("sized2"), QStringLiteral("sized3"), QStringLiteral("sized1"),
+                                  QStringLiteral("sized4"), QStringLiteral("sized5")};
+    QCOMPARE(names, expected);
+
+    // The token only continues the same sorting
+    query.setSortingProperty(QStringLiteral("height"));
+    bool error = false;
+    QVERIFY(fetchPage(query, &token, &error).isEmpty());
+    QVERIFY(error);
+}
+
+void QueryExecTest::testShardPaging()
+{
+    QTemporaryDir device;
+    DatabaseShards* shards = DatabaseShards::instance();
+    QSharedPointer<Database> shard = shards->open(device.path(), Database::CreateDatabase);
+    QVERIFY(shard);
+    shards->setMountPaths({device.path()});
+
+    for (int i = 1; i <= 3; i++) {
+        addFile(QStringLiteral("main%1").arg(i), QStringLiteral("omega"), 2 * i - 1);
+        addFile(shard.data(), device.path() + QStringLiteral("/shard%1").arg(i), QStringLiteral("omega"), 2 * i);
+    }
+
+    // Not on the device, so the shard is not trusted with it
+    addFile(shard.data(), m_dir.path() + QStringLiteral("/foreign"), QStringLiteral("omega"), 7);
+
+    Query query;
+    query.setSearchString(QStringLiteral("omega"));
+    query.setLimit(2);
+
+    // Shards are only searched when removable media are indexed
+    QByteArray token;
+    QCOMPARE(fetchPage(query, &token), QStringList({QStringLiteral("main3"), QStringLiteral("main2")}));
+
+    KConfig config(QStringLiteral("baloofilerc"));
+    config.group("General").writeEntry("index removable media", true);
+    config.sync();
+
+    // Newest first, whichever index the files are in
+    const QStringList expected = {QStringLiteral("shard3"), QStringLiteral("main3"), QStringLiteral("shard2"),
+                                  QStringLiteral("main2"), QStringLiteral("shard1"), QStringLiteral("main1")};
+
+    token.clear();
+    QStringList names;
+    QStringList page;
+    do {
+        page = fetchPage(query, &token);
+        names += page;
+    } while (!page.isEmpty());
+    QCOMPARE(names, expected);
+
+    // The offset counts the results of all the devices
+    query.setOffset(2);
+    token.clear();
+    QCOMPARE(fetchPage(query, &token), expected.mid(2, 2));
+    query.setOffset(0);
+
+    // Without any order each of the results still comes once
+    query.setSortingOption(Query::SortNone);
+    token.clear();
+    names.clear();
+    do {
+        page = fetchPage(query, &token);
+        names += page;
+    } while (!page.isEmpty());
+    QCOMPARE(names.size(), expected.size());
+    QCOMPARE(names.toSet(), expected.toSet());
+
+    shards->setMountPaths(QStringList());
+    config.group("General").writeEntry("index removable media", false);
+    config.sync();
+}
+
+void QueryExecTest::testMovedFrom()
+{
+    Query query;
+    query.setSearchString(QStringLiteral("alpha"));
+
+    ResultIterator it = query.exec();
+    ResultIterator moved(std::move(it));
+
+    QVERIFY(!it.next());
+    QVERIFY(!it.hasError());
+    QVERIFY(it.continuationToken().isEmpty());
+    it.close();
+
+    QVERIFY(moved.next());
+    QVERIFY(!moved.filePath().isEmpty());
+}
+
+QTEST_MAIN(QueryExecTest)
+
+#include "queryexectest.moc"
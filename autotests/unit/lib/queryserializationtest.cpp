@@ -37,6 +37,7 @@ private Q_SLOTS:
     void testDateTimeTerm();
 
     void testCustomOptions();
+    void testContinuationToken();
 };
 
 // Test a simple query with no terms
@@ -121,6 +122,20 @@ void QuerySerializationTest::testCustomOptions()
     QCOMPARE(query, q);
 }
 
+void QuerySerializationTest::testContinuationToken()
+{
+    Query query;
+    query.setSearchString(QStringLiteral("Bookie"));
+    query.setContinuationToken("1:1:52:1443000000:12:40");
+
+    Query q = Query::fromJSON(query.toJSON());
+    QCOMPARE(q.continuationToken(), QByteArray("1:1:52:1443000000:12:40"));
+    QCOMPARE(q, query);
+
+    q = Query::fromSearchUrl(query.toSearchUrl());
+    QCOMPARE(q.continuationToken(), QByteArray("1:1:52:1443000000:12:40"));
+}
+
 
 QTEST_MAIN(QuerySerializationTest)
 
@@ -0,0 +1,315 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "queryserver.h"
+#include "queryclient.h"
+#include "queryprotocol.h"
+
+#include "query.h"
+#include "resultiterator.h"
+#include "database.h"
+#include "transaction.h"
+#include "document.h"
+#include "termgenerator.h"
+#include "idutils.h"
+#include "global.h"
+
+#include <QTest>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QSemaphore>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QFile>
+#include <QFileInfo>
+#include <QScopedPointer>
+
+using namespace Baloo;
+
+namespace {
+
+// The client blocks while it waits for the server, so the server needs an
+// event loop of its own
+class ServerThread : public QThread
+{
+public:
+    // A server which drops every connection right away, instead of
+    // answering it
+    enum Mode {
+        Answer,
+        Drop
+    };
+
+    ServerThread(const QString& path, Mode mode)
+        : m_path(path)
+        , m_mode(mode)
+        , m_listening(false)
+    {
+        start();
+        m_ready.acquire();
+    }
+
+    ~ServerThread() {
+        quit();
+        wait();
+    }
+
+    bool isListening() const { return m_listening; }
+
+protected:
+    void run() Q_DECL_OVERRIDE {
+        if (m_mode == Answer) {
+            QueryServer server;
+            m_listening = server.listen(m_path);
+            m_ready.release();
+            exec();
+            return;
+        }
+
+        QLocalServer server;
+        QLocalServer::removeServer(m_path);
+        m_listening = server.listen(m_path);
+        QObject::connect(&server, &QLocalServer::newConnection, [&server]() {
+            while (QLocalSocket* socket = server.nextPendingConnection()) {
+                socket->abort();
+                delete socket;
+            }
+        });
+        m_ready.release();
+        exec();
+    }
+
+private:
+    QString m_path;
+    Mode m_mode;
+    bool m_listening;
+    QSemaphore m_ready;
+};
+
+}
+
+class QueryServerTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+
+    void testResults();
+    void testCount();
+    void testQueryError();
+    void testClientDisconnect();
+    void testServerDisconnect();
+
+private:
+    void addFile(const QString& name, const QString& text);
+    QStringList readAll(QueryClient* client);
+
+    QTemporaryDir m_dir;
+    QString m_socketPath;
+};
+
+void QueryServerTest::initTestCase()
+{
+    setenv("BALOO_DB_PATH", m_dir.path().toStdString().c_str(), 1);
+
+    // The queries of the server itself need to run in this process
+    setenv("BALOO_QUERY_SERVER", "0", 1);
+
+    QVERIFY(globalDatabaseInstance()->open(Database::CreateDatabase));
+
+    // More than a single batch of results
+    for (int i = 0; i < 300; i++) {
+        addFile(QStringLiteral("file%1").arg(i), QStringLiteral("alpha"));
+    }
+    addFile(QStringLiteral("other"), QStringLiteral("beta"));
+
+    m_socketPath = m_dir.path() + QStringLiteral("/socket");
+}
+
+void QueryServerTest::addFile(const QString& name, const QString& text)
+{
+    const QString path = m_dir.path() + QLatin1Char('/') + name;
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.close();
+
+    Document doc;
+    doc.setUrl(QFile::encodeName(path));
+    doc.setId(filePathToId(doc.url()));
+    doc.setMTime(1);
+    doc.setCTime(1);
+
+    TermGenerator tg(&doc);
+    tg.indexText(text);
+    tg.indexFileNameText(name);
+
+    Transaction tr(globalDatabaseInstance(), Transaction::ReadWrite);
+    tr.addDocument(doc);
+    tr.commit();
+}
+
+QStringList QueryServerTest::readAll(QueryClient* client)
+{
+    QStringList names;
+    QStringList filePaths;
+    QVector<QByteArray> tokens;
+    while (client->readResults(&filePaths, &tokens)) {
+        for (const QString& filePath : filePaths) {
+            names << QFileInfo(filePath).fileName();
+        }
+    }
+    return names;
+}
+
+void QueryServerTest::testResults()
+{
+    ServerThread server(m_socketPath, ServerThread::Answer);
+    QVERIFY(server.isListening());
+
+    Query query;
+    query.setSearchString(QStringLiteral("alpha"));
+
+    QScopedPointer<QueryClient> client(QueryClient::connectToServer(m_socketPath));
+    QVERIFY(client);
+    QVERIFY(client->exec(query.toJSON()));
+
+    QStringList names = readAll(client.data());
+    QVERIFY(!client->hasError());
+    QCOMPARE(names.size(), 300);
+
+    // The same results as running the query here
+    QStringList expected;
+    ResultIterator it = query.exec();
+    while (it.next()) {
+        expected << QFileInfo(it.filePath()).fileName();
+    }
+    names.sort();
+    expected.sort();
+    QCOMPARE(names, expected);
+}
+
+void QueryServerTest::testCount()
+{
+    ServerThread server(m_socketPath, ServerThread::Answer);
+    QVERIFY(server.isListening());
+
+    Query query;
+    query.setSearchString(QStringLiteral("alpha OR beta"));
+
+    QScopedPointer<QueryClient> client(QueryClient::connectToServer(m_socketPath));
+    QVERIFY(client);
+
+    uint count = 0;
+    QVERIFY(client->count(query.toJSON(), -1, &count));
+    QCOMPARE(count, 301u);
+}
+
+void QueryServerTest::testQueryError()
+{
+    ServerThread server(m_socketPath, ServerThread::Answer);
+    QVERIFY(server.isListening());
+
+    Query query;
+    query.setSearchString(QStringLiteral("alpha"));
+    query.setLimit(1);
+
+    ResultIterator it = query.exec();
+    QVERIFY(it.next());
+    query.setContinuationToken(it.continuationToken());
+    it.close();
+
+    // The token cannot be resumed from with another sorting option
+    query.setSortingOption(Query::SortNone);
+    QString expected;
+    {
+        ResultIterator it = query.exec();
+        QVERIFY(!it.next());
+        QVERIFY(it.hasError());
+        expected = it.errorString();
+    }
+
+    QScopedPointer<QueryClient> client(QueryClient::connectToServer(m_socketPath));
+    QVERIFY(client);
+    QVERIFY(client->exec(query.toJSON()));
+    QVERIFY(readAll(client.data()).isEmpty());
+
+    // Sent by the server, rather than the connection being lost
+    QVERIFY(!client->hasError());
+    QVERIFY(client->hasQueryError());
+    QCOMPARE(client->queryErrorString(), expected);
+}
+
+void QueryServerTest::testClientDisconnect()
+{
+    ServerThread server(m_socketPath, ServerThread::Answer);
+    QVERIFY(server.isListening());
+
+    Query query;
+    query.setSearchString(QStringLiteral("alpha"));
+
+    // Leaving in the middle of the results
+    {
+        QScopedPointer<QueryClient> client(QueryClient::connectToServer(m_socketPath));
+        QVERIFY(client);
+        QVERIFY(client->exec(query.toJSON()));
+
+        QStringList filePaths;
+        QVector<QByteArray> tokens;
+        QVERIFY(client->readResults(&filePaths, &tokens));
+    }
+
+    // The server keeps on answering the others
+    QScopedPointer<QueryClient> client(QueryClient::connectToServer(m_socketPath));
+    QVERIFY(client);
+    QVERIFY(client->exec(query.toJSON()));
+    QCOMPARE(readAll(client.data()).size(), 300);
+    QVERIFY(!client->hasError());
+}
+
+void QueryServerTest::testServerDisconnect()
+{
+    ServerThread server(QueryProtocol::socketPath(), ServerThread::Drop);
+    QVERIFY(server.isListening());
+
+    Query query;
+    query.setSearchString(QStringLiteral("alpha"));
+
+    // The server is gone before it sent anything, so the query is run here
+    setenv("BALOO_QUERY_SERVER", "1", 1);
+    int count = 0;
+    ResultIterator it = query.exec();
+    while (it.next()) {
+        count++;
+    }
+    setenv("BALOO_QUERY_SERVER", "0", 1);
+
+    QVERIFY(!it.hasError());
+    QCOMPARE(count, 300);
+
+    // Reading from it directly reports the lost connection
+    QScopedPointer<QueryClient> client(QueryClient::connectToServer(QueryProtocol::socketPath()));
+    QVERIFY(client);
+    client->exec(query.toJSON());
+    QVERIFY(readAll(client.data()).isEmpty());
+    QVERIFY(client->hasError());
+}
+
+QTEST_MAIN(QueryServerTest)
+
+#include "queryservertest.moc"
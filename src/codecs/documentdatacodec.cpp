@@ -0,0 +1,316 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "documentdatacodec.h"
+#include "coding.h"
+
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <limits>
+#include <string.h>
+
+using namespace Baloo;
+
+namespace {
+// The JSON of the older indexes always starts with '{'
+const char s_version = 2;
+
+// Property and offset as fixed32, followed by the type
+const int s_entrySize = 9;
+
+// Only strings longer than this are worth compressing
+const int s_compressionThreshold = 1024;
+
+enum ValueType {
+    BoolType = 1,
+    IntType,
+    DoubleType,
+    StringType,
+    DateType,
+    DateTimeType,
+    ListType
+};
+const quint8 s_compressedFlag = 0x80;
+
+quint8 encodeValue(QByteArray* out, const QVariant& value)
+{
+    switch (value.type()) {
+    case QVariant::Bool:
+        out->append(value.toBool() ? '\1' : '\0');
+        return BoolType;
+
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+        putFixed64(out, static_cast<quint64>(value.toLongLong()));
+        return IntType;
+
+    case QVariant::Double: {
+        const double d = value.toDouble();
+        quint64 bits;
+        memcpy(&bits, &d, sizeof(bits));
+        putFixed64(out, bits);
+        return DoubleType;
+    }
+
+    case QVariant::Date:
+        putFixed64(out, static_cast<quint64>(value.toDate().toJulianDay()));
+        return DateType;
+
+    case QVariant::DateTime:
+        putFixed64(out, static_cast<quint64>(value.toDateTime().toMSecsSinceEpoch()));
+        return DateTimeType;
+
+    case QVariant::List:
+    case QVariant::StringList: {
+        const QVariantList list = value.toList();
+        putVarint32(out, list.size());
+        for (const QVariant& item : list) {
+            QByteArray itemData;
+            const quint8 type = encodeValue(&itemData, item);
+            out->append(static_cast<char>(type));
+            putVarint32(out, itemData.size());
+            out->append(itemData);
+        }
+        return ListType;
+    }
+
+    default: {
+        const QByteArray str = value.toString().toUtf8();
+        if (str.size() > s_compressionThreshold) {
+            const QByteArray compressed = qCompress(str);
+            if (compressed.size() < str.size()) {
+                out->append(compressed);
+                return StringType | s_compressedFlag;
+            }
+        }
+        out->append(str);
+        return StringType;
+    }
+    }
+}
+
+QVariant decodeValue(quint8 type, const char* data, int size)
+{
+    if (type & s_compressedFlag) {
+        const QByteArray arr = qUncompress(reinterpret_cast<const uchar*>(data), size);
+        return decodeValue(type & ~s_compressedFlag, arr.constData(), arr.size());
+    }
+
+    const bool isFixed64 = type == IntType || type == DoubleType || type == DateType || type == DateTimeType;
+    if (isFixed64 && size < 8) {
+        return QVariant();
+    }
+
+    switch (type) {
+    case BoolType:
+        return QVariant(size > 0 && data[0]);
+
+    case IntType: {
+        const qint64 value = static_cast<qint64>(decodeFixed64(data));
+        if (value >= std::numeric_limits<int>::min() && value <= std::numeric_limits<int>::max()) {
+            return QVariant(static_cast<int>(value));
+        }
+        return QVariant(value);
+    }
+
+    case DoubleType: {
+        const quint64 bits = decodeFixed64(data);
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        return QVariant(d);
+    }
+
+    case DateType:
+        return QVariant(QDate::fromJulianDay(static_cast<qint64>(decodeFixed64(data))));
+
+    case DateTimeType:
+        return QVariant(QDateTime::fromMSecsSinceEpoch(static_cast<qint64>(decodeFixed64(data)), Qt::UTC));
+
+    case StringType:
+        return QVariant(QString::fromUtf8(data, size));
+
+    case ListType: {
+        const char* p = data;
+        const char* end = data + size;
+
+        quint32 count = 0;
+        p = getVarint32Ptr(p, end, &count);
+        if (!p) {
+            return QVariant();
+        }
+
+        QVariantList list;
+        for (quint32 i = 0; i < count && p < end; i++) {
+            const quint8 itemType = static_cast<quint8>(*p++);
+
+            quint32 itemSize = 0;
+            p = getVarint32Ptr(p, end, &itemSize);
+            if (!p || itemSize > static_cast<quint32>(end - p)) {
+                break;
+            }
+
+            list << decodeValue(itemType, p, itemSize);
+            p += itemSize;
+        }
+        return QVariant(list);
+    }
+
+    default:
+        return QVariant();
+    }
+}
+
+struct Header {
+    quint32 count;
+    const char* table;
+    const char* values;
+    const char* end;
+
+    int property(quint32 i) const {
+        return static_cast<int>(decodeFixed32(table + i * s_entrySize));
+    }
+
+    QVariant value(quint32 i) const {
+        const char* entry = table + i * s_entrySize;
+        const quint32 offset = decodeFixed32(entry + 4);
+        const quint32 nextOffset = i + 1 < count ? decodeFixed32(entry + s_entrySize + 4) : end - values;
+        if (offset > nextOffset || nextOffset > static_cast<quint32>(end - values)) {
+            return QVariant();
+        }
+
+        const quint8 type = static_cast<quint8>(entry[8]);
+        return decodeValue(type, values + offset, nextOffset - offset);
+    }
+};
+
+bool readHeader(const QByteArray& data, Header* header)
+{
+    if (data.isEmpty() || data[0] != s_version) {
+        return false;
+    }
+
+    const char* p = data.constData() + 1;
+    header->end = data.constData() + data.size();
+
+    p = getVarint32Ptr(p, header->end, &header->count);
+    if (!p || header->count > static_cast<quint32>(header->end - p) / s_entrySize) {
+        return false;
+    }
+
+    header->table = p;
+    header->values = p + header->count * s_entrySize;
+    return true;
+}
+
+QMap<int, QVariant> decodeJson(const QByteArray& data)
+{
+    const QJsonDocument jdoc = QJsonDocument::fromJson(data);
+    const QVariantMap varMap = jdoc.object().toVariantMap();
+
+    QMap<int, QVariant> properties;
+    for (auto it = varMap.constBegin(); it != varMap.constEnd(); ++it) {
+        properties.insert(it.key().toInt(), it.value());
+    }
+    return properties;
+}
+}
+
+DocumentDataCodec::DocumentDataCodec()
+{
+}
+
+QByteArray DocumentDataCodec::encode(const QMap<int, QVariant>& properties)
+{
+    QByteArray table;
+    QByteArray values;
+    for (auto it = properties.constBegin(); it != properties.constEnd(); ++it) {
+        const quint32 offset = values.size();
+        const quint8 type = encodeValue(&values, it.value());
+
+        putFixed32(&table, static_cast<quint32>(it.key()));
+        putFixed32(&table, offset);
+        table.append(static_cast<char>(type));
+    }
+
+    QByteArray data;
+    data.reserve(1 + 5 + table.size() + values.size());
+    data.append(s_version);
+    putVarint32(&data, properties.size());
+    data.append(table);
+    data.append(values);
+
+    return data;
+}
+
+QMap<int, QVariant> DocumentDataCodec::decode(const QByteArray& data)
+{
+    if (isLegacy(data)) {
+        return decodeJson(data);
+    }
+
+    QMap<int, QVariant> properties;
+
+    Header header;
+    if (!readHeader(data, &header)) {
+        return properties;
+    }
+
+    for (quint32 i = 0; i < header.count; i++) {
+        properties.insert(header.property(i), header.value(i));
+    }
+    return properties;
+}
+
+QVariant DocumentDataCodec::decode(const QByteArray& data, int property)
+{
+    if (isLegacy(data)) {
+        return decodeJson(data).value(property);
+    }
+
+    Header header;
+    if (!readHeader(data, &header)) {
+        return QVariant();
+    }
+
+    // The table is sorted by property
+    quint32 low = 0;
+    quint32 high = header.count;
+    while (low < high) {
+        const quint32 mid = low + (high - low) / 2;
+        if (header.property(mid) < property) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    if (low < header.count && header.property(low) == property) {
+        return header.value(low);
+    }
+    return QVariant();
+}
+
+bool DocumentDataCodec::isLegacy(const QByteArray& data)
+{
+    return data.startsWith('{');
+}
@@ -0,0 +1,65 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_DOCUMENTDATACODEC_H
+#define BALOO_DOCUMENTDATACODEC_H
+
+#include <QByteArray>
+#include <QMap>
+#include <QVariant>
+#include <QVector>
+
+namespace Baloo {
+
+/**
+ * Encodes the extracted properties of a document, keyed by their
+ * KFileMetaData::Property number.
+ *
+ * The data starts with a version byte and the number of properties,
+ * followed by a table with the property, the offset of its value and
+ * the type of the value for each property, sorted by property. The
+ * values follow the table. A single property can therefore be decoded
+ * by looking it up in the table, without touching the other values.
+ *
+ * Long strings are compressed. The data of older indexes is JSON, which
+ * is still decoded.
+ */
+class DocumentDataCodec
+{
+public:
+    DocumentDataCodec();
+
+    QByteArray encode(const QMap<int, QVariant>& properties);
+
+    QMap<int, QVariant> decode(const QByteArray& data);
+
+    /**
+     * Decodes only the value of \p property. An invalid QVariant is
+     * returned if the document does not have it.
+     */
+    QVariant decode(const QByteArray& data, int property);
+
+    /**
+     * Returns true if \p data is in the JSON format of older indexes
+     */
+    static bool isLegacy(const QByteArray& data);
+};
+}
+
+#endif // BALOO_DOCUMENTDATACODEC_H
@@ -0,0 +1,82 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "frequencycodec.h"
+#include "coding.h"
+
+using namespace Baloo;
+
+FrequencyCodec::FrequencyCodec()
+{
+}
+
+QByteArray FrequencyCodec::encode(const QVector<quint32>& list)
+{
+    quint32 maxFreq = 0;
+    for (quint32 freq : list) {
+        maxFreq = qMax(maxFreq, freq);
+    }
+
+    QByteArray data;
+    data.reserve(list.size() + 5);
+
+    putVarint32(&data, maxFreq);
+    for (quint32 freq : list) {
+        putVarint32(&data, freq);
+    }
+
+    return data;
+}
+
+QVector<quint32> FrequencyCodec::decode(const QByteArray& arr)
+{
+    char* data = const_cast<char*>(arr.data());
+    char* end = data + arr.size();
+
+    QVector<quint32> vec;
+    if (data >= end) {
+        return vec;
+    }
+
+    quint32 maxFreq;
+    data = getVarint32Ptr(data, end, &maxFreq);
+
+    vec.reserve(end - data);
+    while (data && data < end) {
+        quint32 freq;
+        data = getVarint32Ptr(data, end, &freq);
+        if (data) {
+            vec << freq;
+        }
+    }
+
+    return vec;
+}
+
+quint32 FrequencyCodec::maxFrequency(const QByteArray& arr)
+{
+    char* data = const_cast<char*>(arr.data());
+    char* end = data + arr.size();
+
+    quint32 maxFreq = 0;
+    if (data < end) {
+        getVarint32Ptr(data, end, &maxFreq);
+    }
+    return maxFreq;
+}
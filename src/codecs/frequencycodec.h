@@ -0,0 +1,47 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_FREQUENCYCODEC_H
+#define BALOO_FREQUENCYCODEC_H
+
+#include <QByteArray>
+#include <QVector>
+
+namespace Baloo {
+
+/**
+ * Encodes the within document frequencies of a term. The list is stored
+ * in the same order as the ids in the corresponding posting list and is
+ * prefixed with the largest frequency, so that the upper bound of a term
+ * can be looked up without decoding the entire list.
+ */
+class FrequencyCodec
+{
+public:
+    FrequencyCodec();
+
+    QByteArray encode(const QVector<quint32>& list);
+    QVector<quint32> decode(const QByteArray& arr);
+
+    quint32 maxFrequency(const QByteArray& arr);
+};
+
+}
+
+#endif // BALOO_FREQUENCYCODEC_H
@@ -0,0 +1,115 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "andnotpostingiterator.h"
+
+using namespace Baloo;
+
+AndNotPostingIterator::AndNotPostingIterator(PostingIterator* iterator, const QVector<PostingIterator*>& excluded)
+    : m_iterator(iterator)
+    , m_docId(0)
+{
+    for (PostingIterator* iter : excluded) {
+        if (iter) {
+            m_excluded << iter;
+        }
+    }
+}
+
+AndNotPostingIterator::~AndNotPostingIterator()
+{
+    delete m_iterator;
+    qDeleteAll(m_excluded);
+}
+
+quint64 AndNotPostingIterator::docId() const
+{
+    return m_docId;
+}
+
+uint AndNotPostingIterator::estimateSize(uint totalDocuments) const
+{
+    if (!m_iterator || !totalDocuments) {
+        return 0;
+    }
+
+    // Assume that the terms are independent of each other
+    double fraction = 1;
+    for (PostingIterator* iter : m_excluded) {
+        const uint size = qMin(iter->estimateSize(totalDocuments), totalDocuments);
+        fraction *= 1 - static_cast<double>(size) / totalDocuments;
+    }
+
+    return qRound(fraction * m_iterator->estimateSize(totalDocuments));
+}
+
+QVector<PostingIterator*> AndNotPostingIterator::subIterators() const
+{
+    QVector<PostingIterator*> iterators;
+    if (m_iterator) {
+        iterators << m_iterator;
+    }
+    return iterators + m_excluded;
+}
+
+bool AndNotPostingIterator::isExcluded(quint64 id)
+{
+    for (int i = 0; i < m_excluded.size(); i++) {
+        PostingIterator* iter = m_excluded[i];
+
+        // The exhausted iterators are dropped, so this one has not been started yet
+        if (iter->docId() == 0) {
+            iter->next();
+        }
+        if (iter->docId() && iter->docId() < id) {
+            iter->skipTo(id);
+        }
+
+        if (iter->docId() == 0) {
+            delete iter;
+            m_excluded.remove(i);
+            i--;
+            continue;
+        }
+
+        if (iter->docId() == id) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+quint64 AndNotPostingIterator::next()
+{
+    if (!m_iterator) {
+        m_docId = 0;
+        return 0;
+    }
+
+    while (m_iterator->next()) {
+        if (!isExcluded(m_iterator->docId())) {
+            m_docId = m_iterator->docId();
+            return m_docId;
+        }
+    }
+
+    m_docId = 0;
+    return 0;
+}
@@ -0,0 +1,56 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_ANDNOTPOSTINGITERATOR_H
+#define BALOO_ANDNOTPOSTINGITERATOR_H
+
+#include "postingiterator.h"
+#include <QVector>
+
+namespace Baloo {
+
+/**
+ * Returns the ids of \p iterator which are in none of the \p excluded
+ * iterators. The excluded iterators are only advanced up to the ids of
+ * \p iterator, so they are never read completely.
+ *
+ * A null \p iterator matches nothing, while null excluded iterators are
+ * ignored.
+ */
+class BALOO_ENGINE_EXPORT AndNotPostingIterator : public PostingIterator
+{
+public:
+    AndNotPostingIterator(PostingIterator* iterator, const QVector<PostingIterator*>& excluded);
+    ~AndNotPostingIterator();
+
+    quint64 next() Q_DECL_OVERRIDE;
+    quint64 docId() const Q_DECL_OVERRIDE;
+    uint estimateSize(uint totalDocuments) const Q_DECL_OVERRIDE;
+    QVector<PostingIterator*> subIterators() const Q_DECL_OVERRIDE;
+
+private:
+    bool isExcluded(quint64 id);
+
+    PostingIterator* m_iterator;
+    QVector<PostingIterator*> m_excluded;
+    quint64 m_docId;
+};
+}
+
+#endif // BALOO_ANDNOTPOSTINGITERATOR_H
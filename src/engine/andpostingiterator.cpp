@@ -24,12 +24,16 @@ using namespace Baloo;
 
 AndPostingIterator::AndPostingIterator(const QVector<PostingIterator*>& iterators)
     : m_iterators(iterators)
-    , m_docId(0)
+    , m_done(false)
 {
     if (m_iterators.contains(0)) {
         qDeleteAll(m_iterators);
         m_iterators.clear();
     }
+
+    if (!m_iterators.isEmpty()) {
+        m_blocks.resize(m_iterators.size() - 1);
+    }
 }
 
 AndPostingIterator::~AndPostingIterator()
@@ -37,38 +41,94 @@ AndPostingIterator::~AndPostingIterator()
     qDeleteAll(m_iterators);
 }
 
-quint64 AndPostingIterator::docId() const
+uint AndPostingIterator::estimateSize(uint totalDocuments) const
 {
-    return m_docId;
+    if (m_iterators.isEmpty() || !totalDocuments) {
+        return 0;
+    }
+
+    // Assume that the terms are independent of each other
+    double fraction = 1;
+    uint minSize = totalDocuments;
+    for (PostingIterator* iter : m_iterators) {
+        const uint size = iter->estimateSize(totalDocuments);
+        fraction *= static_cast<double>(size) / totalDocuments;
+        minSize = qMin(minSize, size);
+    }
+
+    return qMin(minSize, static_cast<uint>(qRound(fraction * totalDocuments)));
 }
 
-quint64 AndPostingIterator::next()
+QVector<PostingIterator*> AndPostingIterator::subIterators() const
 {
-    if (m_iterators.isEmpty()) {
-        m_docId = 0;
-        return 0;
-    }
+    return m_iterators;
+}
 
-    if (m_iterators[0]->next() == 0) {
-        m_docId = 0;
-        return 0;
+bool AndPostingIterator::fillBlock(QVector<quint64>& block)
+{
+    if (m_iterators.isEmpty() || m_done) {
+        return false;
     }
 
-    m_docId = m_iterators[0]->docId();
+    block.resize(BlockSize);
+    while (!m_done) {
+        // The ids of the first iterator are the candidates, which are
+        // narrowed down by each of the others in turn
+        int size = m_iterators[0]->nextBlock(block.data(), BlockSize);
+        if (size < BlockSize) {
+            m_done = true;
+        }
+
+        for (int i = 1; i < m_iterators.size() && size; i++) {
+            size = intersect(block.data(), size, i);
+        }
 
-    for (int i = 1; i < m_iterators.size(); i++) {
-        PostingIterator* iter = m_iterators[i];
-        if (iter->docId() == 0 && iter->next() == 0) {
-            m_docId = 0;
-            return 0;
+        if (size) {
+            block.resize(size);
+            return true;
         }
+    }
 
-        iter->skipTo(m_docId);
+    return false;
+}
+
+int AndPostingIterator::intersect(quint64* candidates, int size, int index)
+{
+    PostingIterator* iter = m_iterators[index];
+    Block& block = m_blocks[index - 1];
+
+    int out = 0;
+    int i = 0;
+    while (i < size) {
+        if (block.isEmpty()) {
+            if (block.finished) {
+                m_done = true;
+                break;
+            }
+
+            block.pos = 0;
+            block.size = iter->skipToBlock(candidates[i], block.ids.data(), BlockSize);
+            block.finished = block.size < BlockSize;
+            if (!block.size) {
+                m_done = true;
+                break;
+            }
+        }
 
-        if (m_docId != iter->docId()) {
-            return next();
+        // Merge without branching on the comparison. The candidates are
+        // compacted in place, which is safe as out never passes i
+        const quint64* ids = block.ids.constData();
+        int j = block.pos;
+        while (i < size && j < block.size) {
+            const quint64 a = candidates[i];
+            const quint64 b = ids[j];
+            candidates[out] = a;
+            out += (a == b);
+            i += (a <= b);
+            j += (b <= a);
         }
+        block.pos = j;
     }
 
-    return m_docId;
+    return out;
 }
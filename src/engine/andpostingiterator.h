@@ -21,23 +21,30 @@
 #ifndef BALOO_ANDPOSTINGITERATOR_H
 #define BALOO_ANDPOSTINGITERATOR_H
 
-#include "postingiterator.h"
+#include "blockpostingiterator.h"
 #include <QVector>
 
 namespace Baloo {
 
-class BALOO_ENGINE_EXPORT AndPostingIterator : public PostingIterator
+class BALOO_ENGINE_EXPORT AndPostingIterator : public BlockPostingIterator
 {
 public:
     explicit AndPostingIterator(const QVector<PostingIterator*>& iterators);
     ~AndPostingIterator();
 
-    quint64 next() Q_DECL_OVERRIDE;
-    quint64 docId() const Q_DECL_OVERRIDE;
+    uint estimateSize(uint totalDocuments) const Q_DECL_OVERRIDE;
+    QVector<PostingIterator*> subIterators() const Q_DECL_OVERRIDE;
+
+protected:
+    bool fillBlock(QVector<quint64>& block) Q_DECL_OVERRIDE;
 
 private:
+    int intersect(quint64* candidates, int size, int index);
+
     QVector<PostingIterator*> m_iterators;
-    quint64 m_docId;
+    // The ids read from each iterator but the first one
+    QVector<Block> m_blocks;
+    bool m_done;
 };
 
 }
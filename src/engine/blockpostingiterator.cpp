@@ -0,0 +1,76 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "blockpostingiterator.h"
+
+#include <algorithm>
+
+using namespace Baloo;
+
+BlockPostingIterator::BlockPostingIterator()
+    : m_pos(0)
+    , m_docId(0)
+{
+}
+
+quint64 BlockPostingIterator::docId() const
+{
+    return m_docId;
+}
+
+quint64 BlockPostingIterator::next()
+{
+    while (m_pos >= m_block.size()) {
+        m_pos = 0;
+        if (!fillBlock(m_block)) {
+            m_block.clear();
+            m_docId = 0;
+            return 0;
+        }
+    }
+
+    m_docId = m_block[m_pos++];
+    return m_docId;
+}
+
+int BlockPostingIterator::nextBlock(quint64* ids, int max)
+{
+    int count = 0;
+    while (count < max) {
+        if (m_pos >= m_block.size()) {
+            m_pos = 0;
+            if (!fillBlock(m_block)) {
+                m_block.clear();
+                m_docId = 0;
+                return count;
+            }
+            continue;
+        }
+
+        const int size = qMin(max - count, m_block.size() - m_pos);
+        std::copy(m_block.constBegin() + m_pos, m_block.constBegin() + m_pos + size, ids + count);
+        m_pos += size;
+        count += size;
+    }
+
+    if (count) {
+        m_docId = ids[count - 1];
+    }
+    return count;
+}
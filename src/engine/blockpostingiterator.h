@@ -0,0 +1,80 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_BLOCKPOSTINGITERATOR_H
+#define BALOO_BLOCKPOSTINGITERATOR_H
+
+#include "postingiterator.h"
+
+#include <QVector>
+
+namespace Baloo {
+
+/**
+ * A PostingIterator which produces its ids a block at a time in fillBlock,
+ * so that combining the ids of other iterators happens in tight loops over
+ * plain arrays. next() hands the ids out one at a time.
+ */
+class BALOO_ENGINE_EXPORT BlockPostingIterator : public PostingIterator
+{
+public:
+    BlockPostingIterator();
+
+    quint64 next() Q_DECL_OVERRIDE;
+    quint64 docId() const Q_DECL_OVERRIDE;
+    int nextBlock(quint64* ids, int max) Q_DECL_OVERRIDE;
+
+protected:
+    /**
+     * The number of ids which are read from the other iterators at once
+     */
+    enum { BlockSize = 256 };
+
+    /**
+     * Replaces the contents of \p block with the next ids. Returns false
+     * once there are none left.
+     */
+    virtual bool fillBlock(QVector<quint64>& block) = 0;
+
+    /**
+     * The ids which have been read from one of the combined iterators,
+     * but not used yet
+     */
+    struct Block {
+        Block() : ids(BlockSize), pos(0), size(0), finished(false) {}
+
+        bool isEmpty() const { return pos >= size; }
+        quint64 last() const { return ids[size - 1]; }
+
+        QVector<quint64> ids;
+        int pos;
+        int size;
+        // The iterator has no ids after these
+        bool finished;
+    };
+
+private:
+    QVector<quint64> m_block;
+    int m_pos;
+    quint64 m_docId;
+};
+
+}
+
+#endif // BALOO_BLOCKPOSTINGITERATOR_H
@@ -28,6 +28,11 @@
 #include "documenttimedb.h"
 #include "documentdatadb.h"
 #include "mtimedb.h"
+#include "termfrequencydb.h"
+#include "documentlengthdb.h"
+#include "documentpropertydb.h"
+#include "prefixdb.h"
+#include "trigramdb.h"
 
 #include "document.h"
 #include "enginequery.h"
@@ -38,32 +43,83 @@
 
 #include "writetransaction.h"
 #include "idutils.h"
+#include "metrics.h"
 
 #include <QFile>
 #include <QFileInfo>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QThread>
+
+#include <sys/stat.h>
+#include <stdio.h>
+#include <errno.h>
 
 using namespace Baloo;
 
+// Growing the map is cheap, and small indexes then do not reserve
+// address space they never use
+static const size_t s_initialMapSize = static_cast<size_t>(256) * 1024 * 1024;
+static const size_t s_maximumMapSize = sizeof(size_t) > 4 ? static_cast<size_t>(256) * 1024 * 1024 * 1024
+                                                          : static_cast<size_t>(1024) * 1024 * 1024;
+
+// Each pooled read transaction keeps one of the 126 reader slots of the
+// index, which are shared by all processes
+static const int s_maximumPooledTransactions = 8;
+static const qint64 s_maximumIdleTime = 60 * 1000;
+
+// Growing the map waits 10 seconds at a time for the other transactions
+static const int s_maximumGrowWaits = 30;
+
 Database::Database(const QString& path)
     : m_path(path)
     , m_env(0)
+    , m_initialMapSize(s_initialMapSize)
+    , m_maximumMapSize(s_maximumMapSize)
+    , m_noSync(false)
+    , m_syncedTxnId(0)
+    , m_epoch(0)
+    , m_fileNameTrigrams(KeepTrigrams)
 {
 }
 
 Database::~Database()
 {
+    clearReadTransactions();
     mdb_env_close(m_env);
 }
 
 bool Database::open(OpenMode mode)
 {
     if (isOpen()) {
-        return true;
+        // The index stays usable if it cannot be reopened yet
+        if (!isReplaced() || !lockEnvironment(0)) {
+            return true;
+        }
+
+        clearReadTransactions();
+        mdb_env_close(m_env);
+        m_env = 0;
+        const bool opened = openEnvironment(mode);
+        unlockEnvironment();
+        if (!opened) {
+            return false;
+        }
+    } else if (!openEnvironment(mode)) {
+        return false;
+    }
+
+    // Only once no other transaction can be waiting for the environment
+    if (mode == CreateDatabase) {
+        continueRebuilds();
     }
+    return true;
+}
 
+bool Database::openEnvironment(OpenMode mode)
+{
     QFileInfo dirInfo(m_path);
-    if (!dirInfo.exists()) {
+    if (!dirInfo.exists() && mode != ReadOnlyDatabase) {
         QDir().mkdir(m_path);
         dirInfo.refresh();
     }
@@ -78,12 +134,22 @@ bool Database::open(OpenMode mode)
         return false;
     }
 
-    mdb_env_set_maxdbs(m_env, 12);
-    mdb_env_set_mapsize(m_env, static_cast<size_t>(1024) * 1024 * 1024 * 5); // 5 gb
+    // A compacted copy of the index starts over with the transaction ids
+    m_epoch++;
+    m_syncedTxnId = 0;
 
-    // The directory needs to be created before opening the environment
+    mdb_env_set_maxdbs(m_env, 17);
+
+    // LMDB raises this to the size of the existing data on its own
+    mdb_env_set_mapsize(m_env, m_initialMapSize);
+
+    // The directory needs to be created before opening the environment.
+    // Read transactions can outlive a single call (see ResultIterator), so a thread
+    // can have more than one of them - MDB_NOTLS ties the reader slots to them.
+    // With MDB_RDONLY the lock file is left out on a read-only file system.
     QByteArray arr = QFile::encodeName(m_path) + "/index";
-    rc = mdb_env_open(m_env, arr.constData(), MDB_NOSUBDIR | MDB_NOMEMINIT, 0664);
+    const unsigned int flags = MDB_NOSUBDIR | MDB_NOMEMINIT | MDB_NOTLS | (mode == ReadOnlyDatabase ? MDB_RDONLY : 0);
+    rc = mdb_env_open(m_env, arr.constData(), flags, 0664);
     if (rc) {
         m_env = 0;
         return false;
@@ -92,11 +158,16 @@ bool Database::open(OpenMode mode)
     rc = mdb_reader_check(m_env, 0);
     Q_ASSERT_X(rc == 0, "Database::open reader_check", mdb_strerror(rc));
 
+    // Unlike MDB_NOSYNC this keeps the index intact after a system crash
+    if (m_noSync) {
+        mdb_env_set_flags(m_env, MDB_NOMETASYNC, 1);
+    }
+
     //
     // Individual Databases
     //
     MDB_txn* txn;
-    if (mode == OpenDatabase) {
+    if (mode != CreateDatabase) {
         int rc = mdb_txn_begin(m_env, NULL, MDB_RDONLY, &txn);
         Q_ASSERT_X(rc == 0, "Database::transaction ro begin", mdb_strerror(rc));
         m_dbis.postingDbi = PostingDB::open(txn);
@@ -117,6 +188,14 @@ bool Database::open(OpenMode mode)
 
         m_dbis.mtimeDbi = MTimeDB::open(txn);
 
+        m_dbis.termFrequencyDbi = TermFrequencyDB::open(txn);
+        m_dbis.docLengthDbi = DocumentLengthDB::open(txn);
+        m_dbis.docPropertyDbi = DocumentPropertyDB::open(txn);
+
+        // Older databases do not have one until they are opened for writing
+        m_dbis.prefixDbi = PrefixDB::open(txn);
+        m_dbis.trigramDbi = TrigramDB::open(txn);
+
         if (!m_dbis.isValid()) {
             mdb_txn_abort(txn);
             m_env = 0;
@@ -146,6 +225,28 @@ bool Database::open(OpenMode mode)
 
         m_dbis.mtimeDbi = MTimeDB::create(txn);
 
+        m_dbis.termFrequencyDbi = TermFrequencyDB::create(txn);
+        m_dbis.docLengthDbi = DocumentLengthDB::create(txn);
+        m_dbis.docPropertyDbi = DocumentPropertyDB::create(txn);
+
+        // Filled in from the terms which are already there, see continueRebuilds
+        const bool hasPrefixDb = PrefixDB::open(txn);
+        m_dbis.prefixDbi = PrefixDB::create(txn);
+        if (!hasPrefixDb) {
+            PrefixDB(m_dbis.prefixDbi, txn).beginRebuild(m_dbis.postingDbi);
+        }
+
+        // Left out unless asked for, as it takes about as much space as the names
+        m_dbis.trigramDbi = TrigramDB::open(txn);
+        if (m_fileNameTrigrams == CreateTrigrams && !m_dbis.trigramDbi) {
+            m_dbis.trigramDbi = TrigramDB::create(txn);
+            TrigramDB(m_dbis.trigramDbi, txn).beginRebuild();
+        } else if (m_fileNameTrigrams == RemoveTrigrams && m_dbis.trigramDbi) {
+            rc = mdb_drop(txn, m_dbis.trigramDbi, 1);
+            Q_ASSERT_X(rc == 0, "Database::open drop", mdb_strerror(rc));
+            m_dbis.trigramDbi = 0;
+        }
+
         Q_ASSERT(m_dbis.isValid());
         if (!m_dbis.isValid()) {
             mdb_txn_abort(txn);
@@ -159,7 +260,383 @@ bool Database::open(OpenMode mode)
     return true;
 }
 
+void Database::continueRebuilds()
+{
+    // Each batch is a transaction of its own, which can grow the map
+    bool rebuilding = true;
+    while (rebuilding) {
+        const bool written = write([&rebuilding](Transaction* tr) {
+            rebuilding = tr->isRebuilding();
+            if (rebuilding) {
+                tr->continueRebuild();
+            }
+        });
+        if (!written) {
+            qWarning() << "Could not finish rebuilding the index, it is continued when it is opened again";
+            return;
+        }
+    }
+}
+
 QString Database::path() const
 {
     return m_path;
 }
+
+void Database::setFileNameTrigrams(bool enabled)
+{
+    Q_ASSERT_X(!isOpen(), "Database::setFileNameTrigrams", "The database is already open");
+
+    m_fileNameTrigrams = enabled ? CreateTrigrams : RemoveTrigrams;
+}
+
+void Database::setMapSizeLimits(size_t initial, size_t maximum)
+{
+    Q_ASSERT_X(!isOpen(), "Database::setMapSizeLimits", "The database is already open");
+    Q_ASSERT(initial > 0);
+
+    m_initialMapSize = initial;
+    m_maximumMapSize = qMax(initial, maximum);
+}
+
+size_t Database::mapSize() const
+{
+    Q_ASSERT(m_env);
+
+    MDB_envinfo info;
+    mdb_env_info(m_env, &info);
+    return info.me_mapsize;
+}
+
+size_t Database::usedSize() const
+{
+    Q_ASSERT(m_env);
+
+    MDB_envinfo info;
+    mdb_env_info(m_env, &info);
+
+    MDB_stat stat;
+    mdb_env_stat(m_env, &stat);
+
+    return (info.me_last_pgno + 1) * stat.ms_psize;
+}
+
+bool Database::growMapSize() const
+{
+    Q_ASSERT(m_env);
+
+    clearReadTransactions();
+
+    // Another process might already have grown the map
+    int rc = mdb_env_set_mapsize(m_env, 0);
+    Q_ASSERT_X(rc == 0, "Database::growMapSize", mdb_strerror(rc));
+
+    const size_t size = mapSize();
+    if (size >= m_maximumMapSize) {
+        return false;
+    }
+
+    const size_t newSize = size > m_maximumMapSize / 2 ? m_maximumMapSize : size * 2;
+    rc = mdb_env_set_mapsize(m_env, newSize);
+    if (rc) {
+        qWarning() << "Could not grow the index to" << newSize << "bytes:" << mdb_strerror(rc);
+        return false;
+    }
+
+    return true;
+}
+
+bool Database::write(const std::function<void(Transaction*)>& fn)
+{
+    // The readers renew their snapshots every now and then, so they are
+    // waited for, but not forever
+    int waits = 0;
+    while (true) {
+        int rc;
+        {
+            Transaction tr(this, Transaction::ReadWrite);
+            fn(&tr);
+            rc = tr.commit();
+        }
+        if (rc != MDB_MAP_FULL) {
+            return true;
+        }
+
+        GrowResult result;
+        while ((result = growMap(10000)) == MapInUse) {
+            if (++waits >= s_maximumGrowWaits) {
+                qCritical() << m_openTransactions.load() << "other transactions kept the index from growing."
+                            << "Dropping the changes";
+                return false;
+            }
+            qWarning() << "Waiting for" << m_openTransactions.load() << "other transactions"
+                       << "to finish before growing the index";
+        }
+        if (result == MapAtMaximum) {
+            qCritical() << "The index has reached its maximum size of" << m_maximumMapSize
+                        << "bytes. Dropping the changes";
+            return false;
+        }
+    }
+}
+
+Database::GrowResult Database::growMap(int msecs)
+{
+    static MetricsCounter* resizes = Metrics::instance()->counter(QStringLiteral("database.map.resizes"));
+    static MetricsCounter* waits = Metrics::instance()->counter(QStringLiteral("database.map.waits"));
+
+    // The map cannot be resized while other threads are using it
+    if (!lockEnvironment(msecs)) {
+        waits->add();
+        return MapInUse;
+    }
+
+    const bool grown = growMapSize();
+    unlockEnvironment();
+    if (!grown) {
+        return MapAtMaximum;
+    }
+
+    resizes->add();
+    qDebug() << "Grew the index to" << mapSize() << "bytes";
+    return MapGrown;
+}
+
+bool Database::adoptMapSize() const
+{
+    // The map cannot be resized while other threads are using it
+    int waits = 0;
+    while (!lockEnvironment(10000)) {
+        if (++waits >= s_maximumGrowWaits) {
+            qCritical() << m_openTransactions.load() << "other transactions kept the index from being resized";
+            return false;
+        }
+    }
+
+    clearReadTransactions();
+    const int rc = mdb_env_set_mapsize(m_env, 0);
+    unlockEnvironment();
+    if (rc) {
+        qWarning() << "Could not take over the size of the index:" << mdb_strerror(rc);
+        return false;
+    }
+    return true;
+}
+
+bool Database::lockEnvironment(int msecs) const
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!m_environmentLocked.testAndSetOrdered(0, 1)) {
+        if (timer.elapsed() >= msecs) {
+            return false;
+        }
+        QThread::msleep(10);
+    }
+
+    while (m_openTransactions.loadAcquire()) {
+        if (timer.elapsed() >= msecs) {
+            m_environmentLocked.storeRelease(0);
+            return false;
+        }
+        QThread::msleep(10);
+    }
+
+    return true;
+}
+
+void Database::unlockEnvironment() const
+{
+    m_environmentLocked.storeRelease(0);
+}
+
+void Database::registerTransaction() const
+{
+    // Counting first means that lockEnvironment either sees this
+    // transaction, or the transaction sees the lock
+    while (true) {
+        m_openTransactions.ref();
+        if (!m_environmentLocked.loadAcquire()) {
+            return;
+        }
+        m_openTransactions.deref();
+        QThread::msleep(10);
+    }
+}
+
+void Database::unregisterTransaction() const
+{
+    m_openTransactions.deref();
+}
+
+void Database::setNoSync(bool noSync)
+{
+    m_noSync = noSync;
+    if (m_env) {
+        mdb_env_set_flags(m_env, MDB_NOMETASYNC, noSync ? 1 : 0);
+    }
+}
+
+bool Database::sync()
+{
+    Q_ASSERT(m_env);
+
+    // Keeps the environment from being reopened meanwhile, see compact
+    registerTransaction();
+
+    MDB_envinfo info;
+    int rc = mdb_env_info(m_env, &info);
+    if (rc == 0 && info.me_last_txnid != m_syncedTxnId) {
+        rc = mdb_env_sync(m_env, 1);
+        if (rc == 0) {
+            m_syncedTxnId = info.me_last_txnid;
+        }
+    }
+
+    unregisterTransaction();
+
+    if (rc) {
+        qWarning() << "Could not sync the index" << mdb_strerror(rc);
+        return false;
+    }
+    return true;
+}
+
+int Database::beginReadTransaction(MDB_txn** txn) const
+{
+    static MetricsCounter* reused = Metrics::instance()->counter(QStringLiteral("database.readpool.reused"));
+    static MetricsCounter* created = Metrics::instance()->counter(QStringLiteral("database.readpool.created"));
+
+    QMutexLocker lock(&m_readPoolMutex);
+    while (!m_readPool.isEmpty()) {
+        MDB_txn* pooled = m_readPool.takeLast().txn;
+        lock.unlock();
+
+        int rc = mdb_txn_renew(pooled);
+        if (rc == 0) {
+            reused->add();
+            *txn = pooled;
+            return 0;
+        }
+
+        // The map may have been resized by another process, which
+        // mdb_txn_begin has to deal with
+        mdb_txn_abort(pooled);
+        lock.relock();
+    }
+    lock.unlock();
+
+    created->add();
+    return mdb_txn_begin(m_env, NULL, MDB_RDONLY, txn);
+}
+
+void Database::endReadTransaction(MDB_txn* txn) const
+{
+    mdb_txn_reset(txn);
+
+    QVector<MDB_txn*> expired;
+    {
+        QMutexLocker lock(&m_readPoolMutex);
+
+        // The readers which have not been needed for a while give up
+        // their reader slots, the oldest are at the front
+        while (!m_readPool.isEmpty() && m_readPool.first().idleTime.elapsed() > s_maximumIdleTime) {
+            expired << m_readPool.takeFirst().txn;
+        }
+
+        if (m_readPool.size() < s_maximumPooledTransactions) {
+            PooledTransaction pooled;
+            pooled.txn = txn;
+            pooled.idleTime.start();
+            m_readPool.append(pooled);
+        } else {
+            expired << txn;
+        }
+    }
+
+    for (MDB_txn* t : expired) {
+        mdb_txn_abort(t);
+    }
+}
+
+void Database::clearReadTransactions() const
+{
+    QMutexLocker lock(&m_readPoolMutex);
+    for (const PooledTransaction& pooled : m_readPool) {
+        mdb_txn_abort(pooled.txn);
+    }
+    m_readPool.clear();
+}
+
+bool Database::isReplaced() const
+{
+    mdb_filehandle_t fd;
+    if (mdb_env_get_fd(m_env, &fd)) {
+        return false;
+    }
+
+    const QByteArray indexPath = QFile::encodeName(m_path) + "/index";
+    struct stat openedStat;
+    struct stat currentStat;
+    if (fstat(fd, &openedStat) || stat(indexPath.constData(), &currentStat)) {
+        return false;
+    }
+
+    return openedStat.st_ino != currentStat.st_ino || openedStat.st_dev != currentStat.st_dev;
+}
+
+qint64 Database::compact()
+{
+    Q_ASSERT(m_env);
+
+    if (!lockEnvironment(10000)) {
+        qWarning() << "Could not compact the index as other transactions are still open";
+        return -1;
+    }
+
+    const QString indexPath = m_path + QStringLiteral("/index");
+    const QString compactPath = indexPath + QStringLiteral(".compact");
+    const qint64 size = QFileInfo(indexPath).size();
+    QFile::remove(compactPath);
+
+    // The copy is made from the last commit, so nothing may be committed
+    // until it has replaced the index, not even by other processes
+    MDB_txn* txn;
+    int rc = mdb_txn_begin(m_env, NULL, 0, &txn);
+    if (rc) {
+        qWarning() << "Could not compact the index:" << mdb_strerror(rc);
+        unlockEnvironment();
+        return -1;
+    }
+
+    rc = mdb_env_copy2(m_env, QFile::encodeName(compactPath).constData(), MDB_CP_COMPACT);
+    if (rc == 0 && ::rename(QFile::encodeName(compactPath).constData(), QFile::encodeName(indexPath).constData())) {
+        rc = errno;
+    }
+    if (rc == 0) {
+        // The processes which still have the old file open keep its lock
+        // file, while the new file gets a fresh one
+        QFile::remove(m_path + QStringLiteral("/index-lock"));
+    }
+    mdb_txn_abort(txn);
+
+    if (rc) {
+        qWarning() << "Could not compact the index:" << mdb_strerror(rc);
+        QFile::remove(compactPath);
+        unlockEnvironment();
+        return -1;
+    }
+
+    clearReadTransactions();
+    mdb_env_close(m_env);
+    m_env = 0;
+    const bool opened = open(OpenDatabase);
+    unlockEnvironment();
+
+    if (!opened) {
+        qCritical() << "Could not open the compacted index";
+        return -1;
+    }
+
+    return size - QFileInfo(indexPath).size();
+}
@@ -24,9 +24,17 @@
 #include "document.h"
 #include "databasedbis.h"
 
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QVector>
+
+#include <functional>
+
 namespace Baloo {
 
 class DatabaseTest;
+class Transaction;
 
 class BALOO_ENGINE_EXPORT Database
 {
@@ -38,19 +46,197 @@ public:
 
     enum OpenMode {
         CreateDatabase,
-        OpenDatabase
+        OpenDatabase,
+        /**
+         * Opens an existing index without ever writing to the file system,
+         * for one on a read-only mount. Nothing can be written to it then.
+         */
+        ReadOnlyDatabase
     };
     bool open(OpenMode mode);
 
     bool isOpen() const { return m_env != 0; }
 
+    /**
+     * The index starts out with a map of \p initial bytes, and the map is
+     * doubled whenever a write transaction runs out of space, up to
+     * \p maximum bytes. This needs to be called before open.
+     */
+    void setMapSizeLimits(size_t initial, size_t maximum);
+
+    /**
+     * Returns the size of the memory map, which is the most the index can
+     * currently grow to without being resized.
+     */
+    size_t mapSize() const;
+    size_t maximumMapSize() const { return m_maximumMapSize; }
+
+    /**
+     * Returns the number of bytes of the map which are in use
+     */
+    size_t usedSize() const;
+
+    /**
+     * Rewrites the index without its free pages into a new file, which
+     * then replaces the index, and reopens it. Nothing can be written to
+     * the index meanwhile, while the other processes keep reading from the
+     * old file until they open the index again.
+     *
+     * This waits for the other transactions of this process to finish.
+     * Returns the number of bytes reclaimed, or -1 on failure.
+     */
+    qint64 compact();
+
+    /**
+     * If \p noSync is set, commits only wait for their data pages to be
+     * written to disk. The meta page which points to them is written along
+     * with the next commit, or by sync(). A system crash can undo the last
+     * commit before the sync, but the index stays consistent.
+     */
+    void setNoSync(bool noSync);
+    bool noSync() const { return m_noSync; }
+
+    /**
+     * Sets whether the file names are indexed for searching any part of
+     * them, see TrigramDB. This needs to be called before opening with
+     * CreateDatabase, which then adds or removes that index. By default an
+     * index keeps it if it already has one.
+     */
+    void setFileNameTrigrams(bool enabled);
+
+    /**
+     * Writes the commits since the last sync to disk. Returns false if
+     * that failed.
+     */
+    bool sync();
+
+    /**
+     * Runs \p fn in a write transaction and commits it. If the map runs
+     * out of space meanwhile, the transaction is aborted, the map is grown
+     * and \p fn is run again in a new transaction. So it may only depend
+     * on what it reads from the transaction, and anything else it does can
+     * happen more than once.
+     *
+     * Returns false if the changes were dropped, as the index has reached
+     * its maximum size or the other transactions did not let it grow.
+     */
+    bool write(const std::function<void(Transaction*)>& fn);
+
 private:
+    /**
+     * Opens the environment and its databases, which are created for
+     * CreateDatabase
+     */
+    bool openEnvironment(OpenMode mode);
+
+    /**
+     * Continues the rebuilds begun when opening the index, and left
+     * unfinished by an earlier process, until they are done. The database
+     * is already usable meanwhile, see Transaction::isRebuilding.
+     */
+    void continueRebuilds();
+
+    /**
+     * Doubles the size of the map, without going over the maximum. This may
+     * only be called when there are no open transactions in this process.
+     * Returns false if the map is already as large as it may get.
+     */
+    bool growMapSize() const;
+
+    enum GrowResult {
+        MapGrown,
+        MapAtMaximum,
+
+        // Other transactions of this process were open for too long
+        MapInUse
+    };
+
+    /**
+     * Waits for up to \p msecs milliseconds for the other transactions of
+     * this process to finish, and then grows the map
+     */
+    GrowResult growMap(int msecs);
+
+    /**
+     * Takes over the size of the map from another process which has grown
+     * it, once the other transactions of this process have finished. This
+     * needs to be called without an open transaction. Returns false if the
+     * others did not finish in time, or the map could not be resized.
+     */
+    bool adoptMapSize() const;
+
+    /**
+     * Keeps new transactions from being started in this process, and waits
+     * for up to \p msecs for the open ones to finish. Returns false if they
+     * did not, in which case the environment is not locked.
+     */
+    bool lockEnvironment(int msecs) const;
+    void unlockEnvironment() const;
+
+    /**
+     * Called by each Transaction before it begins and after it has ended
+     */
+    void registerTransaction() const;
+    void unregisterTransaction() const;
+
+    /**
+     * Begins a read transaction. The read transactions which have ended
+     * are kept in a pool, reset so that they do not keep any pages from
+     * being reused, and are renewed for the next reader. This saves
+     * setting up a new transaction and reader slot each time.
+     */
+    int beginReadTransaction(MDB_txn** txn) const;
+    void endReadTransaction(MDB_txn* txn) const;
+
+    /**
+     * Aborts the pooled read transactions, which needs to happen before
+     * the environment is closed or resized
+     */
+    void clearReadTransactions() const;
+
+    /**
+     * Returns true if the index file has been replaced since it was opened,
+     * which happens when another process compacts it
+     */
+    bool isReplaced() const;
+
     QString m_path;
 
     MDB_env* m_env;
     DatabaseDbis m_dbis;
 
+    size_t m_initialMapSize;
+    size_t m_maximumMapSize;
+
+    bool m_noSync;
+    size_t m_syncedTxnId;
+
+    // Counts the times the environment was opened, as the transaction ids
+    // start over in a file which was replaced by a compacted copy. See
+    // Transaction::generation.
+    quint64 m_epoch;
+
+    enum FileNameTrigrams {
+        KeepTrigrams,
+        CreateTrigrams,
+        RemoveTrigrams
+    };
+    FileNameTrigrams m_fileNameTrigrams;
+
+    // The transactions of this process which have not been committed or
+    // aborted yet. The map cannot be resized while there are any.
+    mutable QAtomicInt m_openTransactions;
+    mutable QAtomicInt m_environmentLocked;
+
+    struct PooledTransaction {
+        MDB_txn* txn;
+        QElapsedTimer idleTime;
+    };
+    mutable QMutex m_readPoolMutex;
+    mutable QVector<PooledTransaction> m_readPool;
+
     friend class Transaction;
+    friend class IndexBuilder;
     friend class DatabaseTest;
 
 };
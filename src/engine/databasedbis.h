@@ -22,6 +22,7 @@
 #define BALOO_DATABASE_DBIS_H
 
 #include <lmdb.h>
+#include <QVector>
 
 namespace Baloo {
 
@@ -44,6 +45,14 @@ public:
     MDB_dbi mtimeDbi;
     MDB_dbi failedIdDbi;
 
+    MDB_dbi termFrequencyDbi;
+    MDB_dbi docLengthDbi;
+    MDB_dbi docPropertyDbi;
+
+    // Optional, see PrefixDB and TrigramDB
+    MDB_dbi prefixDbi;
+    MDB_dbi trigramDbi;
+
     DatabaseDbis()
         : postingDbi(0)
         , positionDBi(0)
@@ -57,12 +66,27 @@ public:
         , contentIndexingDbi(0)
         , mtimeDbi(0)
         , failedIdDbi(0)
+        , termFrequencyDbi(0)
+        , docLengthDbi(0)
+        , docPropertyDbi(0)
+        , prefixDbi(0)
+        , trigramDbi(0)
     {}
 
     bool isValid() {
         return postingDbi && positionDBi && docTermsDbi && docFilenameTermsDbi && docXattrTermsDbi &&
                idTreeDbi && idFilenameDbi && docTimeDbi && docDataDbi && contentIndexingDbi && mtimeDbi
-               && failedIdDbi;
+               && failedIdDbi && termFrequencyDbi && docLengthDbi && docPropertyDbi;
+    }
+
+    /**
+     * Returns all of the databases, with a 0 for the optional ones which
+     * were not opened
+     */
+    QVector<MDB_dbi> all() const {
+        return {postingDbi, positionDBi, docTermsDbi, docFilenameTermsDbi, docXattrTermsDbi,
+                idTreeDbi, idFilenameDbi, docTimeDbi, docDataDbi, contentIndexingDbi, mtimeDbi,
+                failedIdDbi, termFrequencyDbi, docLengthDbi, docPropertyDbi, prefixDbi, trigramDbi};
     }
 };
 
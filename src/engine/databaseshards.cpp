@@ -0,0 +1,214 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "databaseshards.h"
+#include "global.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QStorageInfo>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <poll.h>
+#endif
+
+using namespace Baloo;
+
+Q_GLOBAL_STATIC(DatabaseShards, s_shards)
+
+DatabaseShards::DatabaseShards()
+    : m_fixedMounts(false)
+    , m_mountsFd(-1)
+{
+}
+
+DatabaseShards::~DatabaseShards()
+{
+#ifdef Q_OS_LINUX
+    if (m_mountsFd >= 0) {
+        ::close(m_mountsFd);
+    }
+#endif
+}
+
+DatabaseShards* DatabaseShards::instance()
+{
+    return s_shards;
+}
+
+QString DatabaseShards::shardPath(const QString& mountPath)
+{
+    QString path = mountPath;
+    if (!path.endsWith(QLatin1Char('/'))) {
+        path += QLatin1Char('/');
+    }
+    return path + QLatin1String(".baloo");
+}
+
+QSharedPointer<Database> DatabaseShards::open(const QString& mountPath, Database::OpenMode mode)
+{
+    const QString path = shardPath(mountPath);
+    if (mode != Database::CreateDatabase && !QFile::exists(path + QLatin1String("/index"))) {
+        return QSharedPointer<Database>();
+    }
+
+    QMutexLocker lock(&m_mutex);
+
+    QSharedPointer<Database> db = m_shards.value(path).toStrongRef();
+    if (db) {
+        return db;
+    }
+
+    // The main index could have been placed on the device as well
+    if (path == fileIndexDbPath()) {
+        return QSharedPointer<Database>();
+    }
+
+    db = QSharedPointer<Database>::create(path);
+    if (!db->open(mode)) {
+        qWarning() << "Could not open the index of" << mountPath;
+        return QSharedPointer<Database>();
+    }
+
+    m_shards.insert(path, db);
+    if (mode == Database::CreateDatabase) {
+        QMutexLocker mountLock(&m_mountMutex);
+        m_mountsAge.invalidate();
+    }
+    return db;
+}
+
+bool DatabaseShards::isOwnShard(const QString& mountPath)
+{
+#ifdef Q_OS_UNIX
+    const QString path = shardPath(mountPath);
+    const uint uid = ::getuid();
+    const QFileInfo index(path + QLatin1String("/index"));
+    return QFileInfo(path).ownerId() == uid && index.exists() && index.ownerId() == uid;
+#else
+    return QFile::exists(shardPath(mountPath) + QLatin1String("/index"));
+#endif
+}
+
+bool DatabaseShards::mountsChanged()
+{
+    // The shards created by the indexer on a device which was already mounted
+    if (!m_mountsAge.isValid() || m_mountsAge.hasExpired(60 * 1000)) {
+        return true;
+    }
+
+#ifdef Q_OS_LINUX
+    if (m_mountsFd < 0) {
+        return true;
+    }
+
+    // The file is flagged on every mount and unmount since it was last polled
+    pollfd fd;
+    fd.fd = m_mountsFd;
+    fd.events = POLLPRI;
+    fd.revents = 0;
+    return poll(&fd, 1, 0) != 0;
+#else
+    return m_mountsAge.hasExpired(5 * 1000);
+#endif
+}
+
+QVector<QSharedPointer<Database> > DatabaseShards::openMounted()
+{
+    QStringList mountPaths;
+    QStringList readOnlyMounts;
+    {
+        QMutexLocker lock(&m_mountMutex);
+        if (!m_fixedMounts && mountsChanged()) {
+#ifdef Q_OS_LINUX
+            // Opened before looking at the mounts, so that none of the changes are missed
+            if (m_mountsFd < 0) {
+                m_mountsFd = ::open("/proc/self/mounts", O_RDONLY | O_CLOEXEC);
+            }
+#endif
+            m_mountPaths.clear();
+            m_readOnlyMounts.clear();
+            for (const QStorageInfo& storage : QStorageInfo::mountedVolumes()) {
+                if (!storage.isValid() || !storage.isReady()) {
+                    continue;
+                }
+                if (isOwnShard(storage.rootPath())) {
+                    m_mountPaths << storage.rootPath();
+                    if (storage.isReadOnly()) {
+                        m_readOnlyMounts << storage.rootPath();
+                    }
+                }
+            }
+            m_mountsAge.start();
+        }
+        mountPaths = m_mountPaths;
+        readOnlyMounts = m_readOnlyMounts;
+    }
+
+    QVector<QSharedPointer<Database> > shards;
+    for (const QString& mountPath : mountPaths) {
+        const Database::OpenMode mode = readOnlyMounts.contains(mountPath) ? Database::ReadOnlyDatabase
+                                                                           : Database::OpenDatabase;
+        QSharedPointer<Database> db = open(mountPath, mode);
+        if (db) {
+            shards << db;
+        }
+    }
+
+    return shards;
+}
+
+void DatabaseShards::setMountPaths(const QStringList& mountPaths)
+{
+    QMutexLocker lock(&m_mountMutex);
+    m_mountPaths.clear();
+    m_readOnlyMounts.clear();
+    for (const QString& mountPath : mountPaths) {
+        if (isOwnShard(mountPath)) {
+            m_mountPaths << mountPath;
+        }
+    }
+    m_fixedMounts = true;
+}
+
+bool DatabaseShards::remove(const QString& mountPath)
+{
+    const QString path = shardPath(mountPath);
+
+    QMutexLocker lock(&m_mutex);
+    m_shards.remove(path);
+    {
+        QMutexLocker mountLock(&m_mountMutex);
+        m_mountsAge.invalidate();
+    }
+
+    // The environment stays usable for those who have it open
+    QDir dir(path);
+    dir.remove(QStringLiteral("index"));
+    dir.remove(QStringLiteral("index-lock"));
+    return !dir.exists(QStringLiteral("index"));
+}
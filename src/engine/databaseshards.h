@@ -0,0 +1,125 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_DATABASESHARDS_H
+#define BALOO_DATABASESHARDS_H
+
+#include "engine_export.h"
+#include "database.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace Baloo {
+
+/**
+ * The indexes kept on removable media, one per device.
+ *
+ * A shard lives on the device itself in a ".baloo" folder at the root of
+ * the mount point, so it leaves along with the device and nothing needs to
+ * be cleaned up when the device is unmounted. Each shard is a separate
+ * environment with its own writer lock.
+ *
+ * The shards are only kept open while someone holds on to them, otherwise
+ * the open index files would prevent the device from being unmounted.
+ */
+class BALOO_ENGINE_EXPORT DatabaseShards
+{
+public:
+    DatabaseShards();
+    ~DatabaseShards();
+
+    static DatabaseShards* instance();
+
+    /**
+     * Returns the shard of the device mounted at \p mountPath, which is
+     * created if \p mode is Database::CreateDatabase. Returns a null pointer
+     * if it could not be opened.
+     *
+     * Opening a shard which is already open returns the same Database, as
+     * an environment cannot be opened twice in a single process.
+     */
+    QSharedPointer<Database> open(const QString& mountPath, Database::OpenMode mode);
+
+    /**
+     * Opens the shards of all the mounted devices which have one. Only the
+     * shards created by the current user are opened, as anyone can put an
+     * index on a device. The ones on read-only mounts are opened with
+     * Database::ReadOnlyDatabase.
+     *
+     * The devices with a shard are only looked for again once something
+     * was mounted or unmounted, or a minute later for the shards created
+     * by another process meanwhile.
+     */
+    QVector<QSharedPointer<Database> > openMounted();
+
+    /**
+     * Makes openMounted() only look at the devices mounted at \p mountPaths,
+     * instead of at all the mounted ones. Used by the tests.
+     */
+    void setMountPaths(const QStringList& mountPaths);
+
+    /**
+     * Deletes the shard of the device mounted at \p mountPath. Anyone still
+     * holding on to it keeps reading the old index.
+     */
+    bool remove(const QString& mountPath);
+
+    /**
+     * Returns the folder in which the shard of the device mounted at
+     * \p mountPath is kept
+     */
+    static QString shardPath(const QString& mountPath);
+
+private:
+    DatabaseShards(const DatabaseShards&) = delete;
+
+    /**
+     * Returns true if the device mounted at \p mountPath has a shard
+     * which is owned by the current user
+     */
+    static bool isOwnShard(const QString& mountPath);
+
+    /**
+     * Returns true if the mounted devices may have changed since the
+     * last call. Needs to be called with m_mountMutex held.
+     */
+    bool mountsChanged();
+
+    QMutex m_mutex;
+    QHash<QString, QWeakPointer<Database> > m_shards;
+
+    QMutex m_mountMutex;
+    QStringList m_mountPaths;
+    QStringList m_readOnlyMounts;
+    QElapsedTimer m_mountsAge;
+    bool m_fixedMounts;
+
+    // Flagged by the kernel whenever the mounts change
+    int m_mountsFd;
+};
+
+}
+
+#endif // BALOO_DATABASESHARDS_H
@@ -55,6 +55,12 @@ public:
     uint failedIds;
 
     uint mtimeDb;
+
+    uint termFrequencyDb;
+    uint docLength;
+    uint docProperty;
+    uint prefixDb;
+    uint trigramDb;
 };
 
 }
@@ -120,3 +120,10 @@ void Document::setData(const QByteArray& data)
 {
     m_data = data;
 }
+
+void Document::addProperty(quint32 property, qint64 value)
+{
+    if (!m_properties.contains(property)) {
+        m_properties.insert(property, value);
+    }
+}
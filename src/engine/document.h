@@ -29,6 +29,7 @@
 namespace Baloo {
 
 class WriteTransaction;
+class IndexBuilder;
 class TermGeneratorTest;
 
 /**
@@ -74,6 +75,13 @@ public:
 
     void setData(const QByteArray& data);
 
+    /**
+     * Sets the value of the numeric, date or time \p property, which is
+     * used for sorting and aggregating results. Dates and times are
+     * seconds since the epoch. Only the first value of a property is kept.
+     */
+    void addProperty(quint32 property, qint64 value);
+
 private:
     quint64 m_id;
 
@@ -93,8 +101,10 @@ private:
     quint32 m_mTime;
     quint32 m_cTime;
     QByteArray m_data;
+    QMap<quint32, qint64> m_properties;
 
     friend class WriteTransaction;
+    friend class IndexBuilder;
     friend class TermGeneratorTest;
 };
 
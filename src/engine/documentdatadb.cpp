@@ -18,6 +18,7 @@
  */
 
 #include "documentdatadb.h"
+#include "mapfull.h"
 
 using namespace Baloo;
 
@@ -54,7 +55,7 @@ MDB_dbi DocumentDataDB::open(MDB_txn* txn)
     return dbi;
 }
 
-void DocumentDataDB::put(quint64 docId, const QByteArray& url)
+void DocumentDataDB::put(quint64 docId, const QByteArray& url, uint flags)
 {
     Q_ASSERT(docId > 0);
     Q_ASSERT(!url.isEmpty());
@@ -67,7 +68,10 @@ void DocumentDataDB::put(quint64 docId, const QByteArray& url)
     val.mv_size = url.size();
     val.mv_data = static_cast<void*>(const_cast<char*>(url.constData()));
 
-    int rc = mdb_put(m_txn, m_dbi, &key, &val, 0);
+    int rc = mdb_put(m_txn, m_dbi, &key, &val, flags);
+    if (isMapFull(rc)) {
+        return;
+    }
     Q_ASSERT_X(rc == 0, "DocumentDataDB::put", mdb_strerror(rc));
 }
 
@@ -81,7 +85,7 @@ QByteArray DocumentDataDB::get(quint64 docId)
 
     MDB_val val;
     int rc = mdb_get(m_txn, m_dbi, &key, &val);
-    if (rc == MDB_NOTFOUND) {
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
         return QByteArray();
     }
     Q_ASSERT_X(rc == 0, "DocumentDataDB::get", mdb_strerror(rc));
@@ -98,7 +102,7 @@ void DocumentDataDB::del(quint64 docId)
     key.mv_data = static_cast<void*>(&docId);
 
     int rc = mdb_del(m_txn, m_dbi, &key, 0);
-    if (rc == MDB_NOTFOUND) {
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
         return;
     }
     Q_ASSERT_X(rc == 0, "DocumentUrlDB::del", mdb_strerror(rc));
@@ -114,7 +118,7 @@ bool DocumentDataDB::contains(quint64 docId)
 
     MDB_val val;
     int rc = mdb_get(m_txn, m_dbi, &key, &val);
-    if (rc == MDB_NOTFOUND) {
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
         return false;
     }
     Q_ASSERT_X(rc == 0, "DocumentDataDB::contains", mdb_strerror(rc));
@@ -122,6 +126,41 @@ bool DocumentDataDB::contains(quint64 docId)
     return true;
 }
 
+QMap<quint64, QByteArray> DocumentDataDB::fetchItems(quint64 afterId, int size) const
+{
+    Q_ASSERT(size > 0);
+
+    MDB_cursor* cursor;
+    int rc = mdb_cursor_open(m_txn, m_dbi, &cursor);
+    if (isMapFull(rc)) {
+        return QMap<quint64, QByteArray>();
+    }
+
+    quint64 startId = afterId + 1;
+    MDB_val key;
+    key.mv_size = sizeof(quint64);
+    key.mv_data = static_cast<void*>(&startId);
+
+    MDB_val val;
+    MDB_cursor_op op = MDB_SET_RANGE;
+
+    QMap<quint64, QByteArray> map;
+    while (map.size() < size) {
+        rc = mdb_cursor_get(cursor, &key, &val, op);
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+            break;
+        }
+        Q_ASSERT_X(rc == 0, "DocumentDataDB::fetchItems", mdb_strerror(rc));
+        op = MDB_NEXT;
+
+        const quint64 id = *(static_cast<quint64*>(key.mv_data));
+        map.insert(id, QByteArray(static_cast<char*>(val.mv_data), val.mv_size));
+    }
+
+    mdb_cursor_close(cursor);
+    return map;
+}
+
 QMap<quint64, QByteArray> DocumentDataDB::toTestMap() const
 {
     MDB_cursor* cursor;
@@ -133,7 +172,7 @@ QMap<quint64, QByteArray> DocumentDataDB::toTestMap() const
     QMap<quint64, QByteArray> map;
     while (1) {
         int rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
-        if (rc == MDB_NOTFOUND) {
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
             break;
         }
         Q_ASSERT_X(rc == 0, "DocumentDataDB::toTestMap", mdb_strerror(rc));
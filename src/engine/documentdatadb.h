@@ -36,12 +36,18 @@ public:
     static MDB_dbi create(MDB_txn* txn);
     static MDB_dbi open(MDB_txn* txn);
 
-    void put(quint64 docId, const QByteArray& data);
+    void put(quint64 docId, const QByteArray& data, uint flags = 0);
     QByteArray get(quint64 docId);
 
     void del(quint64 docId);
     bool contains(quint64 docId);
 
+    /**
+     * Returns the data of up to \p size documents with an id larger
+     * than \p afterId, in the order of their ids
+     */
+    QMap<quint64, QByteArray> fetchItems(quint64 afterId, int size) const;
+
     QMap<quint64, QByteArray> toTestMap() const;
 private:
     MDB_txn* m_txn;
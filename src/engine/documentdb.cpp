@@ -19,7 +19,9 @@
  */
 
 #include "documentdb.h"
+#include "mapfull.h"
 #include "doctermscodec.h"
+#include "vectorpostingiterator.h"
 
 #include <QDebug>
 
@@ -58,7 +60,7 @@ MDB_dbi DocumentDB::open(const char* name, MDB_txn* txn)
     return dbi;
 }
 
-void DocumentDB::put(quint64 docId, const QVector<QByteArray>& list)
+void DocumentDB::put(quint64 docId, const QVector<QByteArray>& list, uint flags)
 {
     Q_ASSERT(docId > 0);
     Q_ASSERT(!list.isEmpty());
@@ -74,7 +76,10 @@ void DocumentDB::put(quint64 docId, const QVector<QByteArray>& list)
     val.mv_size = arr.size();
     val.mv_data = static_cast<void*>(arr.data());
 
-    int rc = mdb_put(m_txn, m_dbi, &key, &val, 0);
+    int rc = mdb_put(m_txn, m_dbi, &key, &val, flags);
+    if (isMapFull(rc)) {
+        return;
+    }
     Q_ASSERT_X(rc == 0, "DocumentDB::put", mdb_strerror(rc));
 }
 
@@ -88,7 +93,7 @@ QVector<QByteArray> DocumentDB::get(quint64 docId)
 
     MDB_val val;
     int rc = mdb_get(m_txn, m_dbi, &key, &val);
-    if (rc == MDB_NOTFOUND) {
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
         return QVector<QByteArray>();
     }
     Q_ASSERT_X(rc == 0, "DocumentDB::get", mdb_strerror(rc));
@@ -108,7 +113,7 @@ void DocumentDB::del(quint64 docId)
     key.mv_data = static_cast<void*>(&docId);
 
     int rc = mdb_del(m_txn, m_dbi, &key, 0);
-    if (rc == MDB_NOTFOUND) {
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
         return;
     }
     Q_ASSERT_X(rc == 0, "DocumentDB::del", mdb_strerror(rc));
@@ -124,7 +129,7 @@ bool DocumentDB::contains(quint64 docId)
 
     MDB_val val;
     int rc = mdb_get(m_txn, m_dbi, &key, &val);
-    if (rc == MDB_NOTFOUND) {
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
         return false;
     }
     Q_ASSERT_X(rc == 0, "DocumentDB::contains", mdb_strerror(rc));
@@ -141,6 +146,28 @@ uint DocumentDB::size()
     return stat.ms_entries;
 }
 
+PostingIterator* DocumentDB::iter()
+{
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    MDB_val key = {0, 0};
+
+    QVector<quint64> ids;
+    while (1) {
+        int rc = mdb_cursor_get(cursor, &key, 0, MDB_NEXT);
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+            break;
+        }
+        Q_ASSERT_X(rc == 0, "DocumentDB::iter", mdb_strerror(rc));
+
+        ids << *(static_cast<quint64*>(key.mv_data));
+    }
+
+    mdb_cursor_close(cursor);
+    return new VectorPostingIterator(ids);
+}
+
 QMap<quint64, QVector<QByteArray>> DocumentDB::toTestMap() const
 {
     MDB_cursor* cursor;
@@ -152,7 +179,7 @@ QMap<quint64, QVector<QByteArray>> DocumentDB::toTestMap() const
     QMap<quint64, QVector<QByteArray>> map;
     while (1) {
         int rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
-        if (rc == MDB_NOTFOUND) {
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
             break;
         }
         Q_ASSERT_X(rc == 0, "PostingDB::toTestMap", mdb_strerror(rc));
@@ -28,6 +28,8 @@
 
 namespace Baloo {
 
+class PostingIterator;
+
 class BALOO_ENGINE_EXPORT DocumentDB
 {
 public:
@@ -37,13 +39,18 @@ public:
     static MDB_dbi create(const char* name, MDB_txn* txn);
     static MDB_dbi open(const char* name, MDB_txn* txn);
 
-    void put(quint64 docId, const QVector< QByteArray >& list);
+    void put(quint64 docId, const QVector< QByteArray >& list, uint flags = 0);
     QVector<QByteArray> get(quint64 docId);
 
     bool contains(quint64 docId);
     void del(quint64 docId);
     uint size();
 
+    /**
+     * Iterates over the ids of all the documents
+     */
+    PostingIterator* iter();
+
     QMap<quint64, QVector<QByteArray>> toTestMap() const;
 private:
     MDB_txn* m_txn;
@@ -19,6 +19,7 @@
  */
 
 #include "documentiddb.h"
+#include "mapfull.h"
 
 #include <QDebug>
 
@@ -57,7 +58,7 @@ MDB_dbi DocumentIdDB::open(const char* name, MDB_txn* txn)
     return dbi;
 }
 
-void DocumentIdDB::put(quint64 docId)
+void DocumentIdDB::put(quint64 docId, uint flags)
 {
     Q_ASSERT(docId > 0);
 
@@ -69,7 +70,10 @@ void DocumentIdDB::put(quint64 docId)
     val.mv_size = 0;
     val.mv_data = 0;
 
-    int rc = mdb_put(m_txn, m_dbi, &key, &val, 0);
+    int rc = mdb_put(m_txn, m_dbi, &key, &val, flags);
+    if (isMapFull(rc)) {
+        return;
+    }
     Q_ASSERT_X(rc == 0, "DocumentIdDB::put", mdb_strerror(rc));
 }
 
@@ -83,7 +87,7 @@ bool DocumentIdDB::contains(quint64 docId)
 
     MDB_val val;
     int rc = mdb_get(m_txn, m_dbi, &key, &val);
-    if (rc == MDB_NOTFOUND) {
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
         return false;
     }
     Q_ASSERT_X(rc == 0, "DocumentIdDB::contains", mdb_strerror(rc));
@@ -100,7 +104,7 @@ void DocumentIdDB::del(quint64 docId)
     key.mv_data = static_cast<void*>(&docId);
 
     int rc = mdb_del(m_txn, m_dbi, &key, 0);
-    if (rc == MDB_NOTFOUND) {
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
         return;
     }
     Q_ASSERT_X(rc == 0, "DocumentIdDB::del", mdb_strerror(rc));
@@ -118,7 +122,7 @@ QVector<quint64> DocumentIdDB::fetchItems(int size)
     for (int i = 0; i < size; i++) {
         MDB_val key;
         int rc = mdb_cursor_get(cursor, &key, 0, MDB_NEXT);
-        if (rc == MDB_NOTFOUND) {
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
             break;
         }
         Q_ASSERT_X(rc == 0, "DocumentIdDB::fetchItems", mdb_strerror(rc));
@@ -151,7 +155,7 @@ QVector<quint64> DocumentIdDB::toTestVector() const
     QVector<quint64> vec;
     while (1) {
         int rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
-        if (rc == MDB_NOTFOUND) {
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
             break;
         }
         Q_ASSERT_X(rc == 0, "DocumentTimeDB::toTestMap", mdb_strerror(rc));
@@ -37,7 +37,7 @@ public:
     static MDB_dbi create(const char* name, MDB_txn* txn);
     static MDB_dbi open(const char* name, MDB_txn* txn);
 
-    void put(quint64 docId);
+    void put(quint64 docId, uint flags = 0);
     bool contains(quint64 docId);
     void del(quint64 docID);
 
@@ -0,0 +1,218 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "documentlengthdb.h"
+#include "mapfull.h"
+
+#include <QDebug>
+
+using namespace Baloo;
+
+// Document ids are never 0, so this key is used to store the totals
+static const quint64 s_totalsKey = 0;
+
+DocumentLengthDB::DocumentLengthDB(MDB_dbi dbi, MDB_txn* txn)
+    : m_txn(txn)
+    , m_dbi(dbi)
+{
+    Q_ASSERT(txn != 0);
+    Q_ASSERT(dbi != 0);
+}
+
+DocumentLengthDB::~DocumentLengthDB()
+{
+}
+
+MDB_dbi DocumentLengthDB::create(MDB_txn* txn)
+{
+    MDB_dbi dbi;
+    int rc = mdb_dbi_open(txn, "documentlengthdb", MDB_CREATE | MDB_INTEGERKEY, &dbi);
+    Q_ASSERT_X(rc == 0, "DocumentLengthDB::create", mdb_strerror(rc));
+
+    return dbi;
+}
+
+MDB_dbi DocumentLengthDB::open(MDB_txn* txn)
+{
+    MDB_dbi dbi;
+    int rc = mdb_dbi_open(txn, "documentlengthdb", MDB_INTEGERKEY, &dbi);
+    if (rc == MDB_NOTFOUND) {
+        return 0;
+    }
+    Q_ASSERT_X(rc == 0, "DocumentLengthDB::open", mdb_strerror(rc));
+
+    return dbi;
+}
+
+void DocumentLengthDB::put(quint64 docId, quint32 length, uint flags)
+{
+    Q_ASSERT(docId > 0);
+
+    MDB_val key;
+    key.mv_size = sizeof(quint64);
+    key.mv_data = static_cast<void*>(&docId);
+
+    Totals t = totals();
+
+    MDB_val val;
+    int rc = mdb_get(m_txn, m_dbi, &key, &val);
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+        t.count++;
+    } else {
+        Q_ASSERT_X(rc == 0, "DocumentLengthDB::put", mdb_strerror(rc));
+        t.length -= *(static_cast<quint32*>(val.mv_data));
+    }
+    t.length += length;
+
+    val.mv_size = sizeof(quint32);
+    val.mv_data = static_cast<void*>(&length);
+
+    rc = mdb_put(m_txn, m_dbi, &key, &val, flags);
+    if (isMapFull(rc)) {
+        return;
+    }
+    Q_ASSERT_X(rc == 0, "DocumentLengthDB::put", mdb_strerror(rc));
+
+    putTotals(t);
+}
+
+quint32 DocumentLengthDB::get(quint64 docId)
+{
+    Q_ASSERT(docId > 0);
+
+    MDB_val key;
+    key.mv_size = sizeof(quint64);
+    key.mv_data = static_cast<void*>(&docId);
+
+    MDB_val val;
+    int rc = mdb_get(m_txn, m_dbi, &key, &val);
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+        return 0;
+    }
+    Q_ASSERT_X(rc == 0, "DocumentLengthDB::get", mdb_strerror(rc));
+
+    return *(static_cast<quint32*>(val.mv_data));
+}
+
+void DocumentLengthDB::del(quint64 docId)
+{
+    Q_ASSERT(docId > 0);
+
+    MDB_val key;
+    key.mv_size = sizeof(quint64);
+    key.mv_data = static_cast<void*>(&docId);
+
+    MDB_val val;
+    int rc = mdb_get(m_txn, m_dbi, &key, &val);
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+        return;
+    }
+    Q_ASSERT_X(rc == 0, "DocumentLengthDB::del", mdb_strerror(rc));
+
+    Totals t = totals();
+    t.length -= *(static_cast<quint32*>(val.mv_data));
+    t.count--;
+
+    rc = mdb_del(m_txn, m_dbi, &key, 0);
+    if (isMapFull(rc)) {
+        return;
+    }
+    Q_ASSERT_X(rc == 0, "DocumentLengthDB::del", mdb_strerror(rc));
+
+    putTotals(t);
+}
+
+quint64 DocumentLengthDB::count()
+{
+    return totals().count;
+}
+
+double DocumentLengthDB::averageLength()
+{
+    Totals t = totals();
+    if (!t.count) {
+        return 0;
+    }
+    return static_cast<double>(t.length) / t.count;
+}
+
+DocumentLengthDB::Totals DocumentLengthDB::totals()
+{
+    quint64 docId = s_totalsKey;
+
+    MDB_val key;
+    key.mv_size = sizeof(quint64);
+    key.mv_data = static_cast<void*>(&docId);
+
+    MDB_val val;
+    int rc = mdb_get(m_txn, m_dbi, &key, &val);
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+        return Totals();
+    }
+    Q_ASSERT_X(rc == 0, "DocumentLengthDB::totals", mdb_strerror(rc));
+
+    return *(static_cast<Totals*>(val.mv_data));
+}
+
+void DocumentLengthDB::putTotals(const Totals& totals)
+{
+    quint64 docId = s_totalsKey;
+
+    MDB_val key;
+    key.mv_size = sizeof(quint64);
+    key.mv_data = static_cast<void*>(&docId);
+
+    MDB_val val;
+    val.mv_size = sizeof(Totals);
+    val.mv_data = static_cast<void*>(const_cast<Totals*>(&totals));
+
+    int rc = mdb_put(m_txn, m_dbi, &key, &val, 0);
+    if (isMapFull(rc)) {
+        return;
+    }
+    Q_ASSERT_X(rc == 0, "DocumentLengthDB::putTotals", mdb_strerror(rc));
+}
+
+QMap<quint64, quint32> DocumentLengthDB::toTestMap() const
+{
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    MDB_val key = {0, 0};
+    MDB_val val;
+
+    QMap<quint64, quint32> map;
+    while (1) {
+        int rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+            break;
+        }
+        Q_ASSERT_X(rc == 0, "DocumentLengthDB::toTestMap", mdb_strerror(rc));
+
+        const quint64 id = *(static_cast<quint64*>(key.mv_data));
+        if (id == s_totalsKey) {
+            continue;
+        }
+        const quint32 length = *(static_cast<quint32*>(val.mv_data));
+        map.insert(id, length);
+    }
+
+    mdb_cursor_close(cursor);
+    return map;
+}
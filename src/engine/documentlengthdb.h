@@ -0,0 +1,78 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_DOCUMENTLENGTHDB_H
+#define BALOO_DOCUMENTLENGTHDB_H
+
+#include "engine_export.h"
+
+#include <QMap>
+#include <lmdb.h>
+
+namespace Baloo {
+
+/**
+ * Maps <docId> -> <length>, where the length is the sum of the frequencies of
+ * all the terms of the document. This is used for length normalization
+ * when ranking results.
+ *
+ * The database also keeps a running total of all the lengths, so that the
+ * average document length can be computed without iterating over it.
+ */
+class BALOO_ENGINE_EXPORT DocumentLengthDB
+{
+public:
+    DocumentLengthDB(MDB_dbi dbi, MDB_txn* txn);
+    ~DocumentLengthDB();
+
+    static MDB_dbi create(MDB_txn* txn);
+    static MDB_dbi open(MDB_txn* txn);
+
+    void put(quint64 docId, quint32 length, uint flags = 0);
+    quint32 get(quint64 docId);
+    void del(quint64 docId);
+
+    /**
+     * The number of documents which have a length
+     */
+    quint64 count();
+
+    /**
+     * The average length of all the documents
+     */
+    double averageLength();
+
+    QMap<quint64, quint32> toTestMap() const;
+private:
+    struct Totals {
+        quint64 length;
+        quint64 count;
+
+        Totals() : length(0), count(0) {}
+    };
+    Totals totals();
+    void putTotals(const Totals& totals);
+
+    MDB_txn* m_txn;
+    MDB_dbi m_dbi;
+};
+
+}
+
+#endif // BALOO_DOCUMENTLENGTHDB_H
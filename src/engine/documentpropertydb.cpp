@@ -0,0 +1,257 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "documentpropertydb.h"
+#include "mapfull.h"
+
+#include <QtEndian>
+
+#include <algorithm>
+
+using namespace Baloo;
+
+namespace {
+struct PropertyKey {
+    quint32 property;
+    quint64 docId;
+} Q_PACKED;
+
+PropertyKey makeKey(quint32 property, quint64 docId)
+{
+    PropertyKey key;
+    key.property = qToBigEndian(property);
+    key.docId = qToBigEndian(docId);
+    return key;
+}
+
+void readKey(const MDB_val& key, quint32* property, quint64* docId)
+{
+    Q_ASSERT(key.mv_size == sizeof(PropertyKey));
+    const PropertyKey* k = static_cast<const PropertyKey*>(key.mv_data);
+    *property = qFromBigEndian(k->property);
+    *docId = qFromBigEndian(k->docId);
+}
+}
+
+DocumentPropertyDB::DocumentPropertyDB(MDB_dbi dbi, MDB_txn* txn)
+    : m_txn(txn)
+    , m_dbi(dbi)
+{
+    Q_ASSERT(txn != 0);
+    Q_ASSERT(dbi != 0);
+}
+
+DocumentPropertyDB::~DocumentPropertyDB()
+{
+}
+
+MDB_dbi DocumentPropertyDB::create(MDB_txn* txn)
+{
+    MDB_dbi dbi;
+    int rc = mdb_dbi_open(txn, "documentpropertydb", MDB_CREATE, &dbi);
+    Q_ASSERT_X(rc == 0, "DocumentPropertyDB::create", mdb_strerror(rc));
+
+    return dbi;
+}
+
+MDB_dbi DocumentPropertyDB::open(MDB_txn* txn)
+{
+    MDB_dbi dbi;
+    int rc = mdb_dbi_open(txn, "documentpropertydb", 0, &dbi);
+    if (rc == MDB_NOTFOUND) {
+        return 0;
+    }
+    Q_ASSERT_X(rc == 0, "DocumentPropertyDB::open", mdb_strerror(rc));
+
+    return dbi;
+}
+
+void DocumentPropertyDB::put(quint32 property, quint64 docId, qint64 value, uint flags)
+{
+    Q_ASSERT(docId > 0);
+
+    PropertyKey k = makeKey(property, docId);
+
+    MDB_val key;
+    key.mv_size = sizeof(PropertyKey);
+    key.mv_data = static_cast<void*>(&k);
+
+    MDB_val val;
+    val.mv_size = sizeof(qint64);
+    val.mv_data = static_cast<void*>(&value);
+
+    int rc = mdb_put(m_txn, m_dbi, &key, &val, flags);
+    if (isMapFull(rc)) {
+        return;
+    }
+    Q_ASSERT_X(rc == 0, "DocumentPropertyDB::put", mdb_strerror(rc));
+}
+
+bool DocumentPropertyDB::get(quint32 property, quint64 docId, qint64* value) const
+{
+    Q_ASSERT(docId > 0);
+    Q_ASSERT(value);
+
+    PropertyKey k = makeKey(property, docId);
+
+    MDB_val key;
+    key.mv_size = sizeof(PropertyKey);
+    key.mv_data = static_cast<void*>(&k);
+
+    MDB_val val;
+    int rc = mdb_get(m_txn, m_dbi, &key, &val);
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+        return false;
+    }
+    Q_ASSERT_X(rc == 0, "DocumentPropertyDB::get", mdb_strerror(rc));
+
+    *value = *(static_cast<qint64*>(val.mv_data));
+    return true;
+}
+
+QVector<QPair<quint64, qint64> > DocumentPropertyDB::values(quint32 property, const QVector<quint64>& ids) const
+{
+    QVector<QPair<quint64, qint64> > results;
+    if (ids.isEmpty()) {
+        return results;
+    }
+
+    MDB_cursor* cursor;
+    int rc = mdb_cursor_open(m_txn, m_dbi, &cursor);
+    if (isMapFull(rc)) {
+        return results;
+    }
+
+    auto it = ids.constBegin();
+    while (it != ids.constEnd()) {
+        PropertyKey k = makeKey(property, *it);
+
+        MDB_val key;
+        key.mv_size = sizeof(PropertyKey);
+        key.mv_data = static_cast<void*>(&k);
+
+        MDB_val val;
+        rc = mdb_cursor_get(cursor, &key, &val, MDB_SET_RANGE);
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+            break;
+        }
+        Q_ASSERT_X(rc == 0, "DocumentPropertyDB::values", mdb_strerror(rc));
+
+        quint32 prop;
+        quint64 docId;
+        readKey(key, &prop, &docId);
+        if (prop != property) {
+            break;
+        }
+
+        // Skip the ids without a value in one go, as the column may be
+        // much sparser than the ids
+        it = std::lower_bound(it, ids.constEnd(), docId);
+        if (it != ids.constEnd() && *it == docId) {
+            results << qMakePair(docId, *(static_cast<qint64*>(val.mv_data)));
+            ++it;
+        }
+    }
+
+    mdb_cursor_close(cursor);
+    return results;
+}
+
+QVector<quint32> DocumentPropertyDB::properties() const
+{
+    MDB_cursor* cursor;
+    int rc = mdb_cursor_open(m_txn, m_dbi, &cursor);
+    if (isMapFull(rc)) {
+        return QVector<quint32>();
+    }
+
+    // Jump from one column to the next instead of reading all the values
+    QVector<quint32> props;
+    quint64 nextProperty = 0;
+    while (nextProperty <= 0xffffffff) {
+        PropertyKey k = makeKey(static_cast<quint32>(nextProperty), 0);
+
+        MDB_val key;
+        key.mv_size = sizeof(PropertyKey);
+        key.mv_data = static_cast<void*>(&k);
+
+        MDB_val val;
+        rc = mdb_cursor_get(cursor, &key, &val, MDB_SET_RANGE);
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+            break;
+        }
+        Q_ASSERT_X(rc == 0, "DocumentPropertyDB::properties", mdb_strerror(rc));
+
+        quint32 prop;
+        quint64 docId;
+        readKey(key, &prop, &docId);
+
+        props << prop;
+        nextProperty = static_cast<quint64>(prop) + 1;
+    }
+
+    mdb_cursor_close(cursor);
+    return props;
+}
+
+void DocumentPropertyDB::del(quint64 docId)
+{
+    Q_ASSERT(docId > 0);
+
+    const QVector<quint32> props = properties();
+    for (quint32 property : props) {
+        PropertyKey k = makeKey(property, docId);
+
+        MDB_val key;
+        key.mv_size = sizeof(PropertyKey);
+        key.mv_data = static_cast<void*>(&k);
+
+        int rc = mdb_del(m_txn, m_dbi, &key, 0);
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+            continue;
+        }
+        Q_ASSERT_X(rc == 0, "DocumentPropertyDB::del", mdb_strerror(rc));
+    }
+}
+
+QMap<quint32, QMap<quint64, qint64> > DocumentPropertyDB::toTestMap() const
+{
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    MDB_val key = {0, 0};
+    MDB_val val;
+
+    QMap<quint32, QMap<quint64, qint64> > map;
+    while (1) {
+        int rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+            break;
+        }
+        Q_ASSERT_X(rc == 0, "DocumentPropertyDB::toTestMap", mdb_strerror(rc));
+
+        quint32 prop;
+        quint64 docId;
+        readKey(key, &prop, &docId);
+        map[prop].insert(docId, *(static_cast<qint64*>(val.mv_data)));
+    }
+
+    mdb_cursor_close(cursor);
+    return map;
+}
@@ -0,0 +1,81 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_DOCUMENTPROPERTYDB_H
+#define BALOO_DOCUMENTPROPERTYDB_H
+
+#include "engine_export.h"
+
+#include <QMap>
+#include <QPair>
+#include <QVector>
+#include <lmdb.h>
+
+namespace Baloo {
+
+/**
+ * Stores the numeric, date and time properties of each document as
+ * one fixed width value per property, so that results can be sorted
+ * and aggregated without decoding the document data.
+ *
+ * The keys are the property followed by the document id, both big
+ * endian, so all the values of a property are next to each other
+ * and sorted by document id, like the results of a query.
+ */
+class BALOO_ENGINE_EXPORT DocumentPropertyDB
+{
+public:
+    DocumentPropertyDB(MDB_dbi dbi, MDB_txn* txn);
+    ~DocumentPropertyDB();
+
+    static MDB_dbi create(MDB_txn* txn);
+    static MDB_dbi open(MDB_txn* txn);
+
+    void put(quint32 property, quint64 docId, qint64 value, uint flags = 0);
+
+    /**
+     * Returns false if the document \p docId has no value for \p property
+     */
+    bool get(quint32 property, quint64 docId, qint64* value) const;
+
+    /**
+     * Returns the id and value of each of the \p ids which has a value
+     * for \p property. The \p ids need to be sorted.
+     */
+    QVector<QPair<quint64, qint64> > values(quint32 property, const QVector<quint64>& ids) const;
+
+    /**
+     * Returns all the properties which have a value for any document
+     */
+    QVector<quint32> properties() const;
+
+    /**
+     * Removes all the property values of the document \p docId
+     */
+    void del(quint64 docId);
+
+    QMap<quint32, QMap<quint64, qint64> > toTestMap() const;
+private:
+    MDB_txn* m_txn;
+    MDB_dbi m_dbi;
+};
+
+}
+
+#endif // BALOO_DOCUMENTPROPERTYDB_H
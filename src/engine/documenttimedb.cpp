@@ -19,6 +19,7 @@
  */
 
 #include "documenttimedb.h"
+#include "mapfull.h"
 
 using namespace Baloo;
 
@@ -55,7 +56,7 @@ MDB_dbi DocumentTimeDB::open(MDB_txn* txn)
     return dbi;
 }
 
-void DocumentTimeDB::put(quint64 docId, const TimeInfo& info)
+void DocumentTimeDB::put(quint64 docId, const TimeInfo& info, uint flags)
 {
     Q_ASSERT(docId > 0);
     Q_ASSERT(info.mTime);
@@ -69,7 +70,10 @@ void DocumentTimeDB::put(quint64 docId, const TimeInfo& info)
     val.mv_size = sizeof(TimeInfo);
     val.mv_data = static_cast<void*>(const_cast<TimeInfo*>(&info));
 
-    int rc = mdb_put(m_txn, m_dbi, &key, &val, 0);
+    int rc = mdb_put(m_txn, m_dbi, &key, &val, flags);
+    if (isMapFull(rc)) {
+        return;
+    }
     Q_ASSERT_X(rc == 0, "DocumentTimeDB::put", mdb_strerror(rc));
 }
 
@@ -83,7 +87,7 @@ DocumentTimeDB::TimeInfo DocumentTimeDB::get(quint64 docId)
 
     MDB_val val;
     int rc = mdb_get(m_txn, m_dbi, &key, &val);
-    if (rc == MDB_NOTFOUND) {
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
         return TimeInfo();
     }
     Q_ASSERT_X(rc == 0, "DocumentTimeDB::get", mdb_strerror(rc));
@@ -100,7 +104,7 @@ void DocumentTimeDB::del(quint64 docId)
     key.mv_data = static_cast<void*>(&docId);
 
     int rc = mdb_del(m_txn, m_dbi, &key, 0);
-    if (rc == MDB_NOTFOUND) {
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
         return;
     }
     Q_ASSERT_X(rc == 0, "DocumentTimeDB::del", mdb_strerror(rc));
@@ -116,7 +120,7 @@ bool DocumentTimeDB::contains(quint64 docId)
 
     MDB_val val;
     int rc = mdb_get(m_txn, m_dbi, &key, &val);
-    if (rc == MDB_NOTFOUND) {
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
         return false;
     }
     Q_ASSERT_X(rc == 0, "DocumentTimeDB::contains", mdb_strerror(rc));
@@ -135,7 +139,7 @@ QMap<quint64, DocumentTimeDB::TimeInfo> DocumentTimeDB::toTestMap() const
     QMap<quint64, TimeInfo> map;
     while (1) {
         int rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
-        if (rc == MDB_NOTFOUND) {
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
             break;
         }
         Q_ASSERT_X(rc == 0, "DocumentTimeDB::toTestMap", mdb_strerror(rc));
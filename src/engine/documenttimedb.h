@@ -49,7 +49,7 @@ public:
             return mTime == rhs.mTime && cTime == rhs.cTime;
         }
     };
-    void put(quint64 docId, const TimeInfo& info);
+    void put(quint64 docId, const TimeInfo& info, uint flags = 0);
     TimeInfo get(quint64 docId);
 
     void del(quint64 docId);
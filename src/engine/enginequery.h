@@ -37,7 +37,12 @@ public:
         StartsWith,
         And,
         Or,
-        Phrase
+        Phrase,
+
+        /**
+         * Matches the documents which are not matched by its only sub query
+         */
+        Not
     };
 
     EngineQuery();
@@ -93,6 +98,8 @@ inline QDebug operator << (QDebug d, const Baloo::EngineQuery& q) {
         d << "[OR " << q.subQueries() << "]";
     } else if (q.op() == Baloo::EngineQuery::Phrase) {
         d << "[PHRASE " << q.subQueries() << "]";
+    } else if (q.op() == Baloo::EngineQuery::Not) {
+        d << "[NOT " << q.subQueries() << "]";
     } else {
         Q_ASSERT(q.subQueries().isEmpty());
         d << "(" << q.term() << q.pos() << q.op() << ")";
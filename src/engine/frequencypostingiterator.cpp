@@ -0,0 +1,141 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "frequencypostingiterator.h"
+#include "postingcodec.h"
+#include "frequencycodec.h"
+
+#include <algorithm>
+
+using namespace Baloo;
+
+FrequencyPostingIterator::FrequencyPostingIterator(const QVector<quint64>& ids, const QVector<quint32>& frequencies)
+    : m_ids(ids)
+    , m_frequencies(frequencies)
+    , m_decodedFrequencies(true)
+    , m_size(ids.size())
+    , m_maxFrequency(0)
+    , m_pos(-1)
+{
+    // Older databases might not have any frequencies stored. Treat
+    // every occurrence as a single one in that case
+    if (m_frequencies.size() != m_ids.size()) {
+        m_frequencies.fill(1, m_ids.size());
+    }
+
+    for (quint32 freq : m_frequencies) {
+        m_maxFrequency = qMax(m_maxFrequency, freq);
+    }
+}
+
+FrequencyPostingIterator::FrequencyPostingIterator(const QByteArray& ids, const QByteArray& frequencies)
+    : m_encodedIds(ids)
+    , m_encodedFrequencies(frequencies)
+    , m_decodedFrequencies(false)
+    , m_size(ids.size() / sizeof(quint64))
+    , m_pos(-1)
+{
+    // Stored in front of the frequencies, see FrequencyCodec. Without any
+    // frequencies every occurrence counts as a single one.
+    m_maxFrequency = qMax<quint32>(FrequencyCodec().maxFrequency(frequencies), 1);
+}
+
+void FrequencyPostingIterator::decodeIds()
+{
+    if (m_ids.size() != m_size) {
+        m_ids = PostingCodec().decode(m_encodedIds);
+        m_encodedIds.clear();
+    }
+}
+
+void FrequencyPostingIterator::decodeFrequencies() const
+{
+    if (m_decodedFrequencies) {
+        return;
+    }
+
+    m_frequencies = FrequencyCodec().decode(m_encodedFrequencies);
+    if (m_frequencies.size() != m_size) {
+        m_frequencies.fill(1, m_size);
+    }
+    m_encodedFrequencies.clear();
+    m_decodedFrequencies = true;
+}
+
+quint64 FrequencyPostingIterator::docId() const
+{
+    if (m_pos < 0 || m_pos >= m_size) {
+        return 0;
+    }
+
+    return m_ids[m_pos];
+}
+
+quint64 FrequencyPostingIterator::next()
+{
+    if (m_pos >= m_size - 1) {
+        m_pos = m_size;
+        return 0;
+    }
+
+    decodeIds();
+    m_pos++;
+    return m_ids[m_pos];
+}
+
+quint64 FrequencyPostingIterator::skipTo(quint64 id)
+{
+    if (m_pos >= m_size) {
+        return 0;
+    }
+
+    decodeIds();
+    const int start = qMax(m_pos, 0);
+    auto it = std::lower_bound(m_ids.constBegin() + start, m_ids.constEnd(), id);
+    m_pos = it - m_ids.constBegin();
+
+    return docId();
+}
+
+int FrequencyPostingIterator::nextBlock(quint64* ids, int max)
+{
+    decodeIds();
+    const int start = qMin(m_pos + 1, m_size);
+    const int count = qMin(max, m_size - start);
+    std::copy(m_ids.constBegin() + start, m_ids.constBegin() + start + count, ids);
+
+    // Stay on the last id copied, unless there are no more
+    m_pos = count < max ? m_size : start + count - 1;
+    return count;
+}
+
+quint32 FrequencyPostingIterator::frequency() const
+{
+    if (m_pos < 0 || m_pos >= m_size) {
+        return 0;
+    }
+
+    decodeFrequencies();
+    return m_frequencies[m_pos];
+}
+
+uint FrequencyPostingIterator::estimateSize(uint) const
+{
+    return m_size;
+}
@@ -0,0 +1,84 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_FREQUENCYPOSTINGITERATOR_H
+#define BALOO_FREQUENCYPOSTINGITERATOR_H
+
+#include "postingiterator.h"
+#include <QByteArray>
+#include <QVector>
+
+namespace Baloo {
+
+/**
+ * Iterates over the posting list of a term, while also providing the
+ * frequency of the term in the current document.
+ *
+ * The \p frequencies must be in the same order as the \p ids.
+ */
+class BALOO_ENGINE_EXPORT FrequencyPostingIterator : public PostingIterator
+{
+public:
+    FrequencyPostingIterator(const QVector<quint64>& ids, const QVector<quint32>& frequencies);
+
+    /**
+     * Iterates over the encoded \p ids and \p frequencies, as returned by
+     * PostingDB::getEncoded and TermFrequencyDB::getEncoded. The ids are
+     * only decoded once the iterator is advanced, and the frequencies
+     * once the first of them is asked for, so a term whose documents are
+     * never scored costs little more than the lookup.
+     */
+    FrequencyPostingIterator(const QByteArray& ids, const QByteArray& frequencies);
+
+    quint64 docId() const Q_DECL_OVERRIDE;
+    quint64 next() Q_DECL_OVERRIDE;
+    quint64 skipTo(quint64 docId) Q_DECL_OVERRIDE;
+    int nextBlock(quint64* ids, int max) Q_DECL_OVERRIDE;
+    uint estimateSize(uint totalDocuments) const Q_DECL_OVERRIDE;
+
+    /**
+     * The frequency of the term in the current document
+     */
+    quint32 frequency() const;
+
+    /**
+     * The largest frequency of the term in any document
+     */
+    quint32 maxFrequency() const { return m_maxFrequency; }
+
+    int size() const { return m_size; }
+
+private:
+    void decodeIds();
+    void decodeFrequencies() const;
+
+    QByteArray m_encodedIds;
+    mutable QByteArray m_encodedFrequencies;
+
+    QVector<quint64> m_ids;
+    mutable QVector<quint32> m_frequencies;
+    mutable bool m_decodedFrequencies;
+    int m_size;
+    quint32 m_maxFrequency;
+    int m_pos;
+};
+
+}
+
+#endif // BALOO_FREQUENCYPOSTINGITERATOR_H
@@ -19,6 +19,7 @@
  */
 
 #include "idfilenamedb.h"
+#include "mapfull.h"
 
 using namespace Baloo;
 
@@ -55,7 +56,7 @@ MDB_dbi IdFilenameDB::open(MDB_txn* txn)
     return dbi;
 }
 
-void IdFilenameDB::put(quint64 docId, const FilePath& path)
+void IdFilenameDB::put(quint64 docId, const FilePath& path, uint flags)
 {
     Q_ASSERT(docId > 0);
     Q_ASSERT(!path.name.isEmpty());
@@ -72,7 +73,10 @@ void IdFilenameDB::put(quint64 docId, const FilePath& path)
     val.mv_size = data.size();
     val.mv_data = static_cast<void*>(data.data());
 
-    int rc = mdb_put(m_txn, m_dbi, &key, &val, 0);
+    int rc = mdb_put(m_txn, m_dbi, &key, &val, flags);
+    if (isMapFull(rc)) {
+        return;
+    }
     Q_ASSERT_X(rc == 0, "IdFilenameDB::put", mdb_strerror(rc));
 }
 
@@ -88,7 +92,7 @@ IdFilenameDB::FilePath IdFilenameDB::get(quint64 docId)
 
     MDB_val val;
     int rc = mdb_get(m_txn, m_dbi, &key, &val);
-    if (rc == MDB_NOTFOUND) {
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
         return path;
     }
     Q_ASSERT_X(rc == 0, "IdfilenameDB::get", mdb_strerror(rc));
@@ -109,7 +113,7 @@ bool IdFilenameDB::contains(quint64 docId)
 
     MDB_val val;
     int rc = mdb_get(m_txn, m_dbi, &key, &val);
-    if (rc == MDB_NOTFOUND) {
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
         return false;
     }
     Q_ASSERT_X(rc == 0, "IdfilenameDB::contains", mdb_strerror(rc));
@@ -125,9 +129,45 @@ void IdFilenameDB::del(quint64 docId)
     key.mv_data = static_cast<void*>(&docId);
 
     int rc = mdb_del(m_txn, m_dbi, &key, 0);
+    if (isMapFull(rc)) {
+        return;
+    }
     Q_ASSERT_X(rc == 0, "IdfilenameDB::del", mdb_strerror(rc));
 }
 
+void IdFilenameDB::forEach(quint64 fromId, const std::function<bool(quint64, const FilePath&)>& fn) const
+{
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    MDB_val key;
+    key.mv_size = sizeof(quint64);
+    key.mv_data = static_cast<void*>(&fromId);
+    MDB_val val;
+
+    MDB_cursor_op op = MDB_SET_RANGE;
+    while (1) {
+        int rc = mdb_cursor_get(cursor, &key, &val, op);
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+            break;
+        }
+        Q_ASSERT_X(rc == 0, "IdFilenameDB::forEach", mdb_strerror(rc));
+        op = MDB_NEXT;
+
+        const quint64 id = *(static_cast<quint64*>(key.mv_data));
+
+        FilePath path;
+        path.parentId = static_cast<quint64*>(val.mv_data)[0];
+        path.name = QByteArray(static_cast<char*>(val.mv_data) + 8, val.mv_size - 8);
+
+        if (!fn(id, path)) {
+            break;
+        }
+    }
+
+    mdb_cursor_close(cursor);
+}
+
 QMap<quint64, IdFilenameDB::FilePath> IdFilenameDB::toTestMap() const
 {
     MDB_cursor* cursor;
@@ -139,7 +179,7 @@ QMap<quint64, IdFilenameDB::FilePath> IdFilenameDB::toTestMap() const
     QMap<quint64, FilePath> map;
     while (1) {
         int rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
-        if (rc == MDB_NOTFOUND) {
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
             break;
         }
         Q_ASSERT_X(rc == 0, "IdFilenameDB::toTestMap", mdb_strerror(rc));
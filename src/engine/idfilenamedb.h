@@ -26,6 +26,8 @@
 #include <QByteArray>
 #include <QMap>
 
+#include <functional>
+
 namespace Baloo {
 
 class BALOO_ENGINE_EXPORT IdFilenameDB
@@ -46,11 +48,17 @@ public:
             return parentId == fp.parentId && name == fp.name;
         }
     };
-    void put(quint64 docId, const FilePath& path);
+    void put(quint64 docId, const FilePath& path, uint flags = 0);
     FilePath get(quint64 docId);
     bool contains(quint64 docId);
     void del(quint64 docId);
 
+    /**
+     * Calls \p fn with the id and the path of each entry from \p fromId
+     * on, in the order of the ids, until it returns false
+     */
+    void forEach(quint64 fromId, const std::function<bool(quint64, const FilePath&)>& fn) const;
+
     QMap<quint64, FilePath> toTestMap() const;
 private:
     MDB_txn* m_txn;
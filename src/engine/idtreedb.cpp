@@ -19,6 +19,7 @@
  */
 
 #include "idtreedb.h"
+#include "mapfull.h"
 #include "postingiterator.h"
 
 #include <QDebug>
@@ -55,7 +56,7 @@ MDB_dbi IdTreeDB::open(MDB_txn* txn)
     return dbi;
 }
 
-void IdTreeDB::put(quint64 docId, const QVector<quint64> subDocIds)
+void IdTreeDB::put(quint64 docId, const QVector<quint64> subDocIds, uint flags)
 {
     Q_ASSERT(!subDocIds.isEmpty());
     Q_ASSERT(!subDocIds.contains(0));
@@ -68,7 +69,10 @@ void IdTreeDB::put(quint64 docId, const QVector<quint64> subDocIds)
     val.mv_size = subDocIds.size() * sizeof(quint64);
     val.mv_data = static_cast<void*>(const_cast<quint64*>(subDocIds.constData()));
 
-    int rc = mdb_put(m_txn, m_dbi, &key, &val, 0);
+    int rc = mdb_put(m_txn, m_dbi, &key, &val, flags);
+    if (isMapFull(rc)) {
+        return;
+    }
     Q_ASSERT_X(rc == 0, "IdTreeDB::put", mdb_strerror(rc));
 }
 
@@ -80,7 +84,7 @@ QVector<quint64> IdTreeDB::get(quint64 docId)
 
     MDB_val val;
     int rc = mdb_get(m_txn, m_dbi, &key, &val);
-    if (rc == MDB_NOTFOUND) {
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
         return QVector<quint64>();
     }
     Q_ASSERT_X(rc == 0, "IdTreeeDB::get", mdb_strerror(rc));
@@ -99,6 +103,9 @@ void IdTreeDB::del(quint64 docId)
     key.mv_data = static_cast<void*>(&docId);
 
     int rc = mdb_del(m_txn, m_dbi, &key, 0);
+    if (isMapFull(rc)) {
+        return;
+    }
     Q_ASSERT_X(rc == 0, "IdTreeDB::del", mdb_strerror(rc));
 }
 
@@ -169,7 +176,7 @@ QMap<quint64, QVector<quint64>> IdTreeDB::toTestMap() const
     QMap<quint64, QVector<quint64>> map;
     while (1) {
         int rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
-        if (rc == MDB_NOTFOUND) {
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
             break;
         }
         Q_ASSERT_X(rc == 0, "PostingDB::toTestMap", mdb_strerror(rc));
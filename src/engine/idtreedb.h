@@ -38,7 +38,7 @@ public:
     static MDB_dbi create(MDB_txn* txn);
     static MDB_dbi open(MDB_txn* txn);
 
-    void put(quint64 docId, const QVector<quint64> subDocIds);
+    void put(quint64 docId, const QVector<quint64> subDocIds, uint flags = 0);
     QVector<quint64> get(quint64 docId);
     void del(quint64 docId);
 
@@ -0,0 +1,746 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "indexbuilder.h"
+#include "database.h"
+#include "transaction.h"
+#include "document.h"
+#include "idutils.h"
+
+#include "postingdb.h"
+#include "positiondb.h"
+#include "termfrequencydb.h"
+#include "documentdb.h"
+#include "documentiddb.h"
+#include "documentdatadb.h"
+#include "documenttimedb.h"
+#include "documentlengthdb.h"
+#include "documentpropertydb.h"
+#include "prefixdb.h"
+#include "trigramdb.h"
+#include "idfilenamedb.h"
+#include "idtreedb.h"
+#include "mtimedb.h"
+#include "tracing.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QTemporaryFile>
+#include <QSet>
+#include <QDebug>
+
+#include <algorithm>
+#include <queue>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace Baloo;
+
+namespace {
+
+// The records kept in memory before they are sorted and written to a run
+const int s_runSize = 256 * 1024;
+
+// The operations run in a single write transaction
+const int s_batchSize = 10000;
+
+QString markerPath(Database* db)
+{
+    return db->path() + QStringLiteral("/index-building");
+}
+
+enum TermSource {
+    ContentTerm = 0,
+    XattrTerm,
+    FileNameTerm
+};
+
+struct TermRecord {
+    QByteArray term;
+    quint64 docId;
+    quint8 source;
+    quint32 wdf;
+    QVector<uint> positions;
+
+    bool operator <(const TermRecord& rhs) const {
+        if (term != rhs.term) {
+            return term < rhs.term;
+        }
+        if (docId != rhs.docId) {
+            return docId < rhs.docId;
+        }
+        return source < rhs.source;
+    }
+};
+
+QDataStream& operator <<(QDataStream& out, const TermRecord& r)
+{
+    return out << r.term << r.docId << r.source << r.wdf << r.positions;
+}
+
+QDataStream& operator >>(QDataStream& in, TermRecord& r)
+{
+    return in >> r.term >> r.docId >> r.source >> r.wdf >> r.positions;
+}
+
+struct DocumentRecord {
+    quint64 id;
+    quint64 parentId;
+    QByteArray name;
+
+    // Folders which are only added as parents just have a file name
+    bool isDocument;
+    QVector<QByteArray> terms;
+    QVector<QByteArray> xattrTerms;
+    QVector<QByteArray> fileNameTerms;
+    quint32 length;
+    quint32 mTime;
+    quint32 cTime;
+    QByteArray data;
+    bool contentIndexing;
+
+    DocumentRecord()
+        : id(0), parentId(0), isDocument(false), length(0), mTime(0), cTime(0), contentIndexing(false) {}
+
+    bool operator <(const DocumentRecord& rhs) const {
+        return id < rhs.id;
+    }
+};
+
+QDataStream& operator <<(QDataStream& out, const DocumentRecord& r)
+{
+    return out << r.id << r.parentId << r.name << r.isDocument << r.terms << r.xattrTerms
+               << r.fileNameTerms << r.length << r.mTime << r.cTime << r.data << r.contentIndexing;
+}
+
+QDataStream& operator >>(QDataStream& in, DocumentRecord& r)
+{
+    return in >> r.id >> r.parentId >> r.name >> r.isDocument >> r.terms >> r.xattrTerms
+              >> r.fileNameTerms >> r.length >> r.mTime >> r.cTime >> r.data >> r.contentIndexing;
+}
+
+// A (parent, child) pair of the id tree, a (mtime, id) pair or a
+// (trigram, id) pair, with the three bytes of the trigram in that order
+struct PairRecord {
+    quint64 first;
+    quint64 second;
+
+    bool operator <(const PairRecord& rhs) const {
+        if (first != rhs.first) {
+            return first < rhs.first;
+        }
+        return second < rhs.second;
+    }
+};
+
+QDataStream& operator <<(QDataStream& out, const PairRecord& r)
+{
+    return out << r.first << r.second;
+}
+
+QDataStream& operator >>(QDataStream& in, PairRecord& r)
+{
+    return in >> r.first >> r.second;
+}
+
+struct PropertyRecord {
+    quint32 property;
+    quint64 docId;
+    qint64 value;
+
+    // The same order as the big endian keys of the DocumentPropertyDB
+    bool operator <(const PropertyRecord& rhs) const {
+        if (property != rhs.property) {
+            return property < rhs.property;
+        }
+        return docId < rhs.docId;
+    }
+};
+
+QDataStream& operator <<(QDataStream& out, const PropertyRecord& r)
+{
+    return out << r.property << r.docId << r.value;
+}
+
+QDataStream& operator >>(QDataStream& in, PropertyRecord& r)
+{
+    return in >> r.property >> r.docId >> r.value;
+}
+
+/**
+ * Sorts more records than fit into memory. Every s_runSize records are
+ * sorted and written to a temporary file, and these runs are merged
+ * again when reading the records back.
+ */
+template <typename T>
+class ExternalSorter
+{
+public:
+    explicit ExternalSorter(const QString& dir)
+        : m_dir(dir) {}
+    ~ExternalSorter() {
+        qDeleteAll(m_runs);
+    }
+
+    bool add(const T& record) {
+        m_records.append(record);
+        if (m_records.size() >= s_runSize) {
+            return spill();
+        }
+        return true;
+    }
+
+    /**
+     * Calls \p fn with each of the records, in order
+     */
+    template <typename Fn>
+    bool merge(Fn fn);
+
+private:
+    bool spill();
+
+    QString m_dir;
+    QVector<T> m_records;
+    QList<QTemporaryFile*> m_runs;
+};
+
+template <typename T>
+bool ExternalSorter<T>::spill()
+{
+    std::sort(m_records.begin(), m_records.end());
+
+    QTemporaryFile* file = new QTemporaryFile(m_dir + QStringLiteral("/indexbuilder-XXXXXX"));
+    if (!file->open()) {
+        qWarning() << "IndexBuilder: Could not create" << file->fileTemplate() << file->errorString();
+        delete file;
+        return false;
+    }
+
+    QDataStream stream(file);
+    for (const T& record : m_records) {
+        stream << record;
+    }
+    if (stream.status() != QDataStream::Ok || !file->flush()) {
+        qWarning() << "IndexBuilder: Could not write" << file->fileName() << file->errorString();
+        delete file;
+        return false;
+    }
+
+    m_runs.append(file);
+    m_records.clear();
+    return true;
+}
+
+template <typename T>
+template <typename Fn>
+bool ExternalSorter<T>::merge(Fn fn)
+{
+    if (m_runs.isEmpty()) {
+        std::sort(m_records.begin(), m_records.end());
+        for (const T& record : m_records) {
+            fn(record);
+        }
+        m_records.clear();
+        return true;
+    }
+
+    if (!m_records.isEmpty() && !spill()) {
+        return false;
+    }
+
+    QVector<QDataStream*> streams;
+    QVector<T> heads(m_runs.size());
+
+    auto greater = [&heads](int a, int b) {
+        return heads[b] < heads[a];
+    };
+    std::priority_queue<int, std::vector<int>, decltype(greater)> queue(greater);
+
+    for (int i = 0; i < m_runs.size(); i++) {
+        m_runs[i]->seek(0);
+        streams.append(new QDataStream(m_runs[i]));
+        if (!streams[i]->atEnd()) {
+            *streams[i] >> heads[i];
+            queue.push(i);
+        }
+    }
+
+    while (!queue.empty()) {
+        const int i = queue.top();
+        queue.pop();
+
+        fn(heads[i]);
+        if (!streams[i]->atEnd()) {
+            *streams[i] >> heads[i];
+            queue.push(i);
+        }
+    }
+
+    bool ok = true;
+    for (QDataStream* stream : streams) {
+        ok = ok && stream->status() == QDataStream::Ok;
+    }
+    qDeleteAll(streams);
+    qDeleteAll(m_runs);
+    m_runs.clear();
+
+    return ok;
+}
+
+}
+
+class IndexBuilder::Private
+{
+public:
+    explicit Private(Database* database)
+        : db(database)
+        , failed(false)
+        , documents(database->path())
+        , terms(database->path())
+        , tree(database->path())
+        , mtimes(database->path())
+        , properties(database->path())
+        , trigrams(database->path())
+    {
+    }
+
+    /**
+     * Adds the folders of \p url which have not been seen yet. This
+     * mirrors DocumentUrlDB::put.
+     */
+    void addParents(const QByteArray& url);
+
+    Database* db;
+    bool failed;
+
+    // The writes since the last commit
+    QVector<std::function<void(Transaction*)> > ops;
+
+    ExternalSorter<DocumentRecord> documents;
+    ExternalSorter<TermRecord> terms;
+    ExternalSorter<PairRecord> tree;
+    ExternalSorter<PairRecord> mtimes;
+    ExternalSorter<PropertyRecord> properties;
+    ExternalSorter<PairRecord> trigrams;
+
+    QSet<quint64> documentIds;
+    QSet<quint64> folderIds;
+};
+
+void IndexBuilder::Private::addParents(const QByteArray& url)
+{
+    QByteArray arr = url;
+    while (!arr.isEmpty()) {
+        const quint64 id = filePathToId(arr);
+        if (!id || documentIds.contains(id) || folderIds.contains(id)) {
+            return;
+        }
+
+        const int pos = arr.lastIndexOf('/');
+
+        DocumentRecord record;
+        record.id = id;
+        record.name = arr.mid(pos + 1);
+
+        arr.resize(pos);
+        record.parentId = arr.isEmpty() ? 0 : filePathToId(arr);
+
+        folderIds.insert(id);
+        failed |= !documents.add(record);
+        failed |= !tree.add({record.parentId, id});
+    }
+}
+
+IndexBuilder::IndexBuilder(Database* db)
+    : d(new Private(db))
+{
+}
+
+IndexBuilder::~IndexBuilder()
+{
+    delete d;
+}
+
+bool IndexBuilder::addDocument(const Document& doc)
+{
+    const quint64 id = doc.id();
+    Q_ASSERT(id > 0);
+    Q_ASSERT(doc.m_mTime);
+
+    if (d->documentIds.contains(id)) {
+        return false;
+    }
+
+    const QByteArray& url = doc.m_url;
+    const int pos = url.lastIndexOf('/');
+
+    DocumentRecord record;
+    record.id = id;
+    record.parentId = filePathToId(url.left(pos));
+    record.name = url.mid(pos + 1);
+    record.isDocument = true;
+    record.mTime = doc.m_mTime;
+    record.cTime = doc.m_cTime;
+    record.data = doc.m_data;
+    record.contentIndexing = doc.m_contentIndexing;
+
+    // The document may already have been added as the parent of another one
+    if (!d->folderIds.contains(id)) {
+        d->failed |= !d->tree.add({record.parentId, id});
+    }
+    d->documentIds.insert(id);
+    d->addParents(url.left(pos));
+
+    if (d->db->m_dbis.trigramDbi) {
+        for (const QByteArray& trigram : TrigramDB::trigrams(TrigramDB::normalize(record.name))) {
+            const quint64 key = (static_cast<quint64>(static_cast<uchar>(trigram[0])) << 16)
+                                | (static_cast<uchar>(trigram[1]) << 8) | static_cast<uchar>(trigram[2]);
+            d->failed |= !d->trigrams.add({key, id});
+        }
+    }
+
+    const QMap<QByteArray, Document::TermData>* sources[] = {
+        &doc.m_terms, &doc.m_xattrTerms, &doc.m_fileNameTerms
+    };
+    QVector<QByteArray>* termLists[] = {
+        &record.terms, &record.xattrTerms, &record.fileNameTerms
+    };
+
+    for (int source = ContentTerm; source <= FileNameTerm; source++) {
+        const QMap<QByteArray, Document::TermData>& terms = *sources[source];
+        termLists[source]->reserve(terms.size());
+
+        for (auto it = terms.constBegin(); it != terms.constEnd(); ++it) {
+            termLists[source]->append(it.key());
+
+            TermRecord term;
+            term.term = it.key();
+            term.docId = id;
+            term.source = source;
+            term.wdf = it.value().wdf;
+            term.positions = it.value().positions;
+            d->failed |= !d->terms.add(term);
+
+            if (source == ContentTerm) {
+                record.length += it.value().wdf;
+            }
+        }
+    }
+
+    d->failed |= !d->documents.add(record);
+    d->failed |= !d->mtimes.add({doc.m_mTime, id});
+
+    for (auto it = doc.m_properties.constBegin(); it != doc.m_properties.constEnd(); ++it) {
+        d->failed |= !d->properties.add({it.key(), id, it.value()});
+    }
+
+    return true;
+}
+
+bool IndexBuilder::finish()
+{
+    BALOO_TRACE_SPAN("engine", "IndexBuilder::finish");
+
+    if (d->failed) {
+        return false;
+    }
+
+    // Kept until the index is complete, as each batch is committed on its own
+    QFile marker(markerPath(d->db));
+    if (!marker.open(QIODevice::WriteOnly) || ::fsync(marker.handle())) {
+        qWarning() << "Could not create" << marker.fileName();
+        return false;
+    }
+    marker.close();
+
+    // The meta pages need not be synced until the index is complete
+    const bool noSync = d->db->noSync();
+    d->db->setNoSync(true);
+
+    bool ok = writeDocuments() && writeTree() && writeModificationTimes()
+              && writeProperties() && writeTerms() && writeTrigrams();
+
+    // A batch may have been dropped along the way
+    ok = commit() && !d->failed && ok;
+
+    d->db->setNoSync(noSync);
+    ok = d->db->sync() && ok;
+
+    if (ok) {
+        marker.remove();
+    }
+    return ok;
+}
+
+bool IndexBuilder::isIncomplete(Database* db)
+{
+    return QFile::exists(markerPath(db));
+}
+
+void IndexBuilder::write(const std::function<void(Transaction*)>& op)
+{
+    d->ops << op;
+    if (d->ops.size() >= s_batchSize) {
+        d->failed |= !commit();
+    }
+}
+
+bool IndexBuilder::commit()
+{
+    // The ops only write, so they can all be run again if the map has
+    // to be grown, see Database::write
+    const bool ok = d->ops.isEmpty() || d->db->write([this](Transaction* tr) {
+        for (const auto& op : d->ops) {
+            op(tr);
+        }
+    });
+    d->ops.clear();
+    return ok;
+}
+
+bool IndexBuilder::writeDocuments()
+{
+    DocumentRecord current;
+
+    auto flush = [this, &current]() {
+        if (!current.id) {
+            return;
+        }
+
+        const DocumentRecord record = current;
+        write([record](Transaction* tr) {
+            const DatabaseDbis& dbis = tr->m_dbis;
+
+            IdFilenameDB idFilenameDB(dbis.idFilenameDbi, tr->m_txn);
+            IdFilenameDB::FilePath path;
+            path.parentId = record.parentId;
+            path.name = record.name;
+            idFilenameDB.put(record.id, path, MDB_APPEND);
+
+            if (!record.isDocument) {
+                return;
+            }
+
+            DocumentDB documentTermsDB(dbis.docTermsDbi, tr->m_txn);
+            DocumentDB documentXattrTermsDB(dbis.docXattrTermsDbi, tr->m_txn);
+            DocumentDB documentFileNameTermsDB(dbis.docFilenameTermsDbi, tr->m_txn);
+            DocumentLengthDB docLengthDB(dbis.docLengthDbi, tr->m_txn);
+            DocumentIdDB contentIndexingDB(dbis.contentIndexingDbi, tr->m_txn);
+            DocumentTimeDB docTimeDB(dbis.docTimeDbi, tr->m_txn);
+            DocumentDataDB docDataDB(dbis.docDataDbi, tr->m_txn);
+
+            if (!record.terms.isEmpty()) {
+                documentTermsDB.put(record.id, record.terms, MDB_APPEND);
+            }
+            // The totals are kept under the smallest key, so appending is fine
+            docLengthDB.put(record.id, record.length, MDB_APPEND);
+
+            if (!record.xattrTerms.isEmpty()) {
+                documentXattrTermsDB.put(record.id, record.xattrTerms, MDB_APPEND);
+            }
+            if (!record.fileNameTerms.isEmpty()) {
+                documentFileNameTermsDB.put(record.id, record.fileNameTerms, MDB_APPEND);
+            }
+            if (record.contentIndexing) {
+                contentIndexingDB.put(record.id, MDB_APPEND);
+            }
+
+            DocumentTimeDB::TimeInfo info;
+            info.mTime = record.mTime;
+            info.cTime = record.cTime;
+            docTimeDB.put(record.id, info, MDB_APPEND);
+
+            if (!record.data.isEmpty()) {
+                docDataDB.put(record.id, record.data, MDB_APPEND);
+            }
+        });
+    };
+
+    // A document may also have been added as a folder
+    bool ok = d->documents.merge([&](const DocumentRecord& record) {
+        if (record.id != current.id) {
+            flush();
+            current = record;
+        } else if (record.isDocument) {
+            current = record;
+        }
+    });
+    flush();
+
+    return ok;
+}
+
+bool IndexBuilder::writeTree()
+{
+    quint64 parentId = 0;
+    QVector<quint64> children;
+
+    auto flush = [this, &parentId, &children]() {
+        if (children.isEmpty()) {
+            return;
+        }
+
+        const quint64 id = parentId;
+        const QVector<quint64> list = children;
+        write([id, list](Transaction* tr) {
+            IdTreeDB idTreeDB(tr->m_dbis.idTreeDbi, tr->m_txn);
+            idTreeDB.put(id, list, MDB_APPEND);
+        });
+        children.clear();
+    };
+
+    bool ok = d->tree.merge([&](const PairRecord& record) {
+        if (record.first != parentId) {
+            flush();
+            parentId = record.first;
+        }
+        children.append(record.second);
+    });
+    flush();
+
+    return ok;
+}
+
+bool IndexBuilder::writeTrigrams()
+{
+    quint64 key = 0;
+    PostingList list;
+
+    auto flush = [this, &key, &list]() {
+        if (list.isEmpty()) {
+            return;
+        }
+
+        QByteArray trigram(3, Qt::Uninitialized);
+        trigram[0] = static_cast<char>(key >> 16);
+        trigram[1] = static_cast<char>(key >> 8);
+        trigram[2] = static_cast<char>(key);
+
+        const PostingList l = list;
+        write([trigram, l](Transaction* tr) {
+            TrigramDB trigramDB(tr->m_dbis.trigramDbi, tr->m_txn);
+            trigramDB.put(trigram, l, MDB_APPEND);
+        });
+        list.clear();
+    };
+
+    bool ok = d->trigrams.merge([&](const PairRecord& record) {
+        if (record.first != key) {
+            flush();
+            key = record.first;
+        }
+        list.append(record.second);
+    });
+    flush();
+
+    return ok;
+}
+
+bool IndexBuilder::writeModificationTimes()
+{
+    return d->mtimes.merge([this](const PairRecord& record) {
+        const quint32 mtime = record.first;
+        const quint64 id = record.second;
+        write([mtime, id](Transaction* tr) {
+            MTimeDB mtimeDB(tr->m_dbis.mtimeDbi, tr->m_txn);
+            mtimeDB.put(mtime, id, MDB_APPENDDUP);
+        });
+    });
+}
+
+bool IndexBuilder::writeProperties()
+{
+    return d->properties.merge([this](const PropertyRecord& record) {
+        write([record](Transaction* tr) {
+            DocumentPropertyDB docPropertyDB(tr->m_dbis.docPropertyDbi, tr->m_txn);
+            docPropertyDB.put(record.property, record.docId, record.value, MDB_APPEND);
+        });
+    });
+}
+
+bool IndexBuilder::writeTerms()
+{
+    QByteArray term;
+    PostingList list;
+    QVector<quint32> freqList;
+    QVector<PositionInfo> positionList;
+
+    // The terms come in order, so the unions of their prefixes can be
+    // written along with them
+    PrefixUnionBuilder prefixes([this](const QByteArray& prefix, const PostingList& l,
+                                       const QVector<quint32>& c) {
+        write([prefix, l, c](Transaction* tr) {
+            PrefixDB prefixDB(tr->m_dbis.prefixDbi, tr->m_txn);
+            prefixDB.put(prefix, l, c);
+        });
+    });
+
+    auto flush = [&]() {
+        if (list.isEmpty()) {
+            return;
+        }
+        prefixes.addTerm(term, list);
+
+        const QByteArray t = term;
+        const PostingList l = list;
+        const QVector<quint32> f = freqList;
+        const QVector<PositionInfo> p = positionList;
+        write([t, l, f, p](Transaction* tr) {
+            PostingDB postingDB(tr->m_dbis.postingDbi, tr->m_txn);
+            TermFrequencyDB termFrequencyDB(tr->m_dbis.termFrequencyDbi, tr->m_txn);
+            PositionDB positionDB(tr->m_dbis.positionDBi, tr->m_txn);
+
+            postingDB.put(t, l, MDB_APPEND);
+            termFrequencyDB.put(t, f, MDB_APPEND);
+            if (!p.isEmpty()) {
+                positionDB.put(t, p, MDB_APPEND);
+            }
+        });
+
+        list.clear();
+        freqList.clear();
+        positionList.clear();
+    };
+
+    // A term may be in the contents, xattrs and file name of the same document.
+    // Like WriteTransaction::commit the last frequency and the first positions win.
+    bool ok = d->terms.merge([&](const TermRecord& record) {
+        if (record.term != term) {
+            flush();
+            term = record.term;
+        }
+
+        if (!list.isEmpty() && list.last() == record.docId) {
+            freqList.last() = record.wdf;
+        } else {
+            list.append(record.docId);
+            freqList.append(record.wdf);
+        }
+
+        if (!record.positions.isEmpty()
+            && (positionList.isEmpty() || positionList.last().docId != record.docId)) {
+            positionList.append(PositionInfo(record.docId, record.positions));
+        }
+    });
+    flush();
+    prefixes.finish();
+
+    return ok;
+}
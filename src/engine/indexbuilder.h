@@ -0,0 +1,95 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#ifndef BALOO_INDEXBUILDER_H
+#define BALOO_INDEXBUILDER_H
+
+#include "engine_export.h"
+
+#include <functional>
+
+namespace Baloo {
+
+class Database;
+class Document;
+class Transaction;
+
+/**
+ * Builds a new index much faster than adding its documents one at a time
+ * with a Transaction.
+ *
+ * The documents are kept in sorted runs, which are written to temporary
+ * files next to the index once they get too large. finish() merges the
+ * runs, and writes each of the databases in the order of its keys with
+ * MDB_APPEND, only syncing the index to disk at the very end.
+ *
+ * This may only be used for an empty index, see Transaction::isEmpty, as
+ * the keys could not be appended otherwise. Nothing else may write to the
+ * index until finish() has returned.
+ */
+class BALOO_ENGINE_EXPORT IndexBuilder
+{
+public:
+    explicit IndexBuilder(Database* db);
+    ~IndexBuilder();
+
+    /**
+     * Returns false if a document with the same id has already been added,
+     * which is the case for hard links.
+     */
+    bool addDocument(const Document& doc);
+
+    /**
+     * Writes all of the documents to the index. Returns false if that
+     * failed, in which case the index is incomplete.
+     */
+    bool finish();
+
+    /**
+     * Returns true if finish() was interrupted or failed for the index of
+     * \p db. Its documents may then be missing their terms, or anything
+     * else written after them, so the index needs to be emptied with
+     * Transaction::clear and built again.
+     */
+    static bool isIncomplete(Database* db);
+
+private:
+    IndexBuilder(const IndexBuilder&) = delete;
+
+    bool writeDocuments();
+    bool writeTree();
+    bool writeModificationTimes();
+    bool writeProperties();
+    bool writeTerms();
+    bool writeTrigrams();
+
+    /**
+     * Queues \p op for the next write transaction. The ops are committed
+     * every few thousand of them, as LMDB limits the number of pages a
+     * single transaction may change.
+     */
+    void write(const std::function<void(Transaction*)>& op);
+    bool commit();
+
+    class Private;
+    Private* d;
+};
+
+}
+
+#endif // BALOO_INDEXBUILDER_H
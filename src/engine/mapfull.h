@@ -0,0 +1,48 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_MAPFULL_H
+#define BALOO_MAPFULL_H
+
+#include "engine_export.h"
+
+namespace Baloo {
+
+/**
+ * Once a write runs out of space in the map with MDB_MAP_FULL, LMDB
+ * refuses every other call in the transaction with MDB_BAD_TXN. That is
+ * not a bug: Database::write grows the map and makes the changes again in
+ * a new transaction, so the databases only have to stop using it. What
+ * they read meanwhile is not found, and is not relied upon.
+ *
+ * Returns true if \p rc is one of those errors, which are remembered
+ * for the current thread, as write transactions are bound to it.
+ */
+BALOO_ENGINE_EXPORT bool isMapFull(int rc);
+
+/**
+ * Returns true if a write transaction of the current thread ran out of
+ * space since the last resetMapFull()
+ */
+BALOO_ENGINE_EXPORT bool mapFullOccurred();
+BALOO_ENGINE_EXPORT void resetMapFull();
+
+}
+
+#endif // BALOO_MAPFULL_H
@@ -0,0 +1,252 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "metrics.h"
+
+#include <QMutexLocker>
+#include <QVariantList>
+
+using namespace Baloo;
+
+MetricsCounter::MetricsCounter()
+    : m_value(0)
+{
+}
+
+MetricsHistogram::MetricsHistogram()
+    : m_count(0)
+    , m_sum(0)
+    , m_max(0)
+{
+    for (int i = 0; i < BucketCount; i++) {
+        m_buckets[i].store(0);
+    }
+}
+
+int MetricsHistogram::bucket(quint64 value)
+{
+    if (value < SubBuckets) {
+        return value;
+    }
+
+    int exponent = 63;
+    while (!(value & (Q_UINT64_C(1) << exponent))) {
+        exponent--;
+    }
+
+    // The 3 bits below the highest one select the sub bucket
+    const int sub = (value >> (exponent - 3)) & (SubBuckets - 1);
+    return SubBuckets + (exponent - 3) * SubBuckets + sub;
+}
+
+quint64 MetricsHistogram::bucketLowerBound(int bucket)
+{
+    if (bucket < SubBuckets) {
+        return bucket;
+    }
+
+    const int exponent = (bucket - SubBuckets) / SubBuckets + 3;
+    const quint64 sub = (bucket - SubBuckets) % SubBuckets;
+    return (SubBuckets + sub) << (exponent - 3);
+}
+
+void MetricsHistogram::record(quint64 value)
+{
+    m_buckets[bucket(value)].fetchAndAddRelaxed(1);
+    m_count.fetchAndAddRelaxed(1);
+    m_sum.fetchAndAddRelaxed(value);
+    updateMax(value);
+}
+
+void MetricsHistogram::updateMax(quint64 value)
+{
+    quint64 max = m_max.load();
+    while (value > max && !m_max.testAndSetRelaxed(max, value)) {
+        max = m_max.load();
+    }
+}
+
+quint64 MetricsHistogram::count() const
+{
+    return m_count.load();
+}
+
+quint64 MetricsHistogram::sum() const
+{
+    return m_sum.load();
+}
+
+quint64 MetricsHistogram::max() const
+{
+    return m_max.load();
+}
+
+quint64 MetricsHistogram::percentile(double percent) const
+{
+    const quint64 total = count();
+    if (!total) {
+        return 0;
+    }
+
+    const quint64 rank = qMax<quint64>(1, qRound64(total * percent / 100.0));
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount; i++) {
+        seen += m_buckets[i].load();
+        if (seen >= rank) {
+            return qMin(bucketLowerBound(i), max());
+        }
+    }
+
+    return max();
+}
+
+MetricsTimer::MetricsTimer(MetricsHistogram* histogram)
+    : m_histogram(histogram)
+{
+    m_timer.start();
+}
+
+MetricsTimer::~MetricsTimer()
+{
+    m_histogram->record(m_timer.nsecsElapsed() / 1000);
+}
+
+Metrics::Metrics()
+{
+    m_uptime.start();
+}
+
+Metrics::~Metrics()
+{
+    qDeleteAll(m_counters);
+    qDeleteAll(m_histograms);
+}
+
+Metrics* Metrics::instance()
+{
+    static Metrics metrics;
+    return &metrics;
+}
+
+MetricsCounter* Metrics::counter(const QString& name)
+{
+    QMutexLocker lock(&m_mutex);
+
+    MetricsCounter*& counter = m_counters[name];
+    if (!counter) {
+        counter = new MetricsCounter;
+    }
+    return counter;
+}
+
+MetricsHistogram* Metrics::histogram(const QString& name)
+{
+    QMutexLocker lock(&m_mutex);
+
+    MetricsHistogram*& histogram = m_histograms[name];
+    if (!histogram) {
+        histogram = new MetricsHistogram;
+    }
+    return histogram;
+}
+
+QVariantMap Metrics::toVariantMap() const
+{
+    QMutexLocker lock(&m_mutex);
+
+    QVariantMap counters;
+    for (auto it = m_counters.constBegin(); it != m_counters.constEnd(); ++it) {
+        counters.insert(it.key(), it.value()->value());
+    }
+
+    QVariantMap histograms;
+    for (auto it = m_histograms.constBegin(); it != m_histograms.constEnd(); ++it) {
+        const MetricsHistogram* h = it.value();
+
+        // Pairs of the lower bound and the count, to keep the JSON small
+        QVariantList buckets;
+        for (int i = 0; i < MetricsHistogram::BucketCount; i++) {
+            const quint64 count = h->m_buckets[i].load();
+            if (count) {
+                buckets << QVariant(QVariantList() << MetricsHistogram::bucketLowerBound(i) << count);
+            }
+        }
+
+        QVariantMap map;
+        map.insert(QStringLiteral("count"), h->count());
+        map.insert(QStringLiteral("sum"), h->sum());
+        map.insert(QStringLiteral("max"), h->max());
+        map.insert(QStringLiteral("p50"), h->percentile(50));
+        map.insert(QStringLiteral("p90"), h->percentile(90));
+        map.insert(QStringLiteral("p99"), h->percentile(99));
+        map.insert(QStringLiteral("buckets"), buckets);
+        histograms.insert(it.key(), map);
+    }
+
+    QVariantMap map;
+    map.insert(QStringLiteral("uptime"), m_uptime.elapsed() / 1000);
+    map.insert(QStringLiteral("counters"), counters);
+    map.insert(QStringLiteral("histograms"), histograms);
+    return map;
+}
+
+void Metrics::merge(const QVariantMap& map)
+{
+    const QVariantMap counters = map.value(QStringLiteral("counters")).toMap();
+    for (auto it = counters.constBegin(); it != counters.constEnd(); ++it) {
+        counter(it.key())->add(it.value().toULongLong());
+    }
+
+    const QVariantMap histograms = map.value(QStringLiteral("histograms")).toMap();
+    for (auto it = histograms.constBegin(); it != histograms.constEnd(); ++it) {
+        const QVariantMap values = it.value().toMap();
+        MetricsHistogram* h = histogram(it.key());
+
+        for (const QVariant& var : values.value(QStringLiteral("buckets")).toList()) {
+            const QVariantList pair = var.toList();
+            if (pair.size() != 2) {
+                continue;
+            }
+
+            const int bucket = MetricsHistogram::bucket(pair[0].toULongLong());
+            h->m_buckets[bucket].fetchAndAddRelaxed(pair[1].toULongLong());
+        }
+        h->m_count.fetchAndAddRelaxed(values.value(QStringLiteral("count")).toULongLong());
+        h->m_sum.fetchAndAddRelaxed(values.value(QStringLiteral("sum")).toULongLong());
+        h->updateMax(values.value(QStringLiteral("max")).toULongLong());
+    }
+}
+
+void Metrics::reset()
+{
+    QMutexLocker lock(&m_mutex);
+
+    for (MetricsCounter* counter : m_counters) {
+        counter->m_value.store(0);
+    }
+
+    for (MetricsHistogram* h : m_histograms) {
+        for (int i = 0; i < MetricsHistogram::BucketCount; i++) {
+            h->m_buckets[i].store(0);
+        }
+        h->m_count.store(0);
+        h->m_sum.store(0);
+        h->m_max.store(0);
+    }
+}
@@ -0,0 +1,163 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_METRICS_H
+#define BALOO_METRICS_H
+
+#include "engine_export.h"
+
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QVariantMap>
+
+namespace Baloo {
+
+/**
+ * A counter which can be increased from any thread without locking
+ */
+class BALOO_ENGINE_EXPORT MetricsCounter
+{
+public:
+    MetricsCounter();
+
+    void add(quint64 value = 1) {
+        m_value.fetchAndAddRelaxed(value);
+    }
+
+    quint64 value() const {
+        return m_value.load();
+    }
+
+private:
+    QAtomicInteger<quint64> m_value;
+
+    friend class Metrics;
+};
+
+/**
+ * A histogram of positive values, such as durations in microseconds or
+ * sizes in bytes, which can be recorded from any thread without locking.
+ *
+ * Like an HDR histogram, each power of two is split into a fixed number
+ * of buckets, so that the percentiles are accurate to about 12%
+ * whatever the magnitude of the values.
+ */
+class BALOO_ENGINE_EXPORT MetricsHistogram
+{
+public:
+    MetricsHistogram();
+
+    void record(quint64 value);
+
+    quint64 count() const;
+    quint64 sum() const;
+    quint64 max() const;
+
+    /**
+     * Returns the smallest value which is larger than \p percent percent
+     * of the recorded values, rounded to the bucket it is in
+     */
+    quint64 percentile(double percent) const;
+
+    enum {
+        SubBuckets = 8,
+        BucketCount = SubBuckets + (64 - 3) * SubBuckets
+    };
+
+    static int bucket(quint64 value);
+    static quint64 bucketLowerBound(int bucket);
+
+private:
+    void updateMax(quint64 value);
+
+    QAtomicInteger<quint64> m_buckets[BucketCount];
+    QAtomicInteger<quint64> m_count;
+    QAtomicInteger<quint64> m_sum;
+    QAtomicInteger<quint64> m_max;
+
+    friend class Metrics;
+};
+
+/**
+ * Records the time from its construction to its destruction, in
+ * microseconds, in a histogram
+ */
+class BALOO_ENGINE_EXPORT MetricsTimer
+{
+public:
+    explicit MetricsTimer(MetricsHistogram* histogram);
+    ~MetricsTimer();
+
+private:
+    MetricsHistogram* m_histogram;
+    QElapsedTimer m_timer;
+};
+
+/**
+ * The counters and histograms of the current process, by name.
+ *
+ * Only looking up a metric by its name takes a lock, so the callers
+ * should keep the pointer, which stays valid for the lifetime of the
+ * process.
+ */
+class BALOO_ENGINE_EXPORT Metrics
+{
+public:
+    static Metrics* instance();
+
+    MetricsCounter* counter(const QString& name);
+    MetricsHistogram* histogram(const QString& name);
+
+    /**
+     * Returns the current values. The map has the keys "uptime" in
+     * seconds, "counters" mapping each name to its value, and
+     * "histograms" mapping each name to a map with the "count", "sum",
+     * "max", "p50", "p90", "p99" and the non empty "buckets".
+     */
+    QVariantMap toVariantMap() const;
+
+    /**
+     * Adds the counters and histograms of \p map, as returned by
+     * toVariantMap, to the ones of this process. This is used to
+     * collect the metrics of the extractor process.
+     */
+    void merge(const QVariantMap& map);
+
+    /**
+     * Sets all the counters and histograms back to 0
+     */
+    void reset();
+
+private:
+    Metrics();
+    ~Metrics();
+    Metrics(const Metrics&) = delete;
+
+    mutable QMutex m_mutex;
+    QMap<QString, MetricsCounter*> m_counters;
+    QMap<QString, MetricsHistogram*> m_histograms;
+    QElapsedTimer m_uptime;
+};
+
+}
+
+#endif // BALOO_METRICS_H
@@ -19,6 +19,7 @@
  */
 
 #include "mtimedb.h"
+#include "mapfull.h"
 #include "vectorpostingiterator.h"
 
 using namespace Baloo;
@@ -56,7 +57,7 @@ MDB_dbi MTimeDB::open(MDB_txn* txn)
     return dbi;
 }
 
-void MTimeDB::put(quint32 mtime, quint64 docId)
+void MTimeDB::put(quint32 mtime, quint64 docId, uint flags)
 {
     Q_ASSERT(mtime > 0);
     Q_ASSERT(docId > 0);
@@ -69,7 +70,10 @@ void MTimeDB::put(quint32 mtime, quint64 docId)
     val.mv_size = sizeof(quint64);
     val.mv_data = static_cast<void*>(&docId);
 
-    int rc = mdb_put(m_txn, m_dbi, &key, &val, 0);
+    int rc = mdb_put(m_txn, m_dbi, &key, &val, flags);
+    if (isMapFull(rc)) {
+        return;
+    }
     Q_ASSERT_X(rc == 0, "MTimeDB::put", mdb_strerror(rc));
 }
 
@@ -88,7 +92,7 @@ QVector<quint64> MTimeDB::get(quint64 mtime)
 
     MDB_val val;
     int rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
-    if (rc == MDB_NOTFOUND) {
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
         mdb_cursor_close(cursor);
         return values;
     }
@@ -98,7 +102,7 @@ QVector<quint64> MTimeDB::get(quint64 mtime)
 
     while (1) {
         rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT_DUP);
-        if (rc == MDB_NOTFOUND) {
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
             break;
         }
         Q_ASSERT_X(rc == 0, "MTimeDB::get while", mdb_strerror(rc));
@@ -124,7 +128,7 @@ void MTimeDB::del(quint32 mtime, quint64 docId)
     val.mv_data = static_cast<void*>(&docId);
 
     int rc = mdb_del(m_txn, m_dbi, &key, &val);
-    if (rc == MDB_NOTFOUND) {
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
         return;
     }
     Q_ASSERT_X(rc == 0, "DocumentDB::del", mdb_strerror(rc));
@@ -149,7 +153,7 @@ PostingIterator* MTimeDB::iter(quint32 mtime, MTimeDB::Comparator com)
 
     MDB_val val;
     int rc = mdb_cursor_get(cursor, &key, &val, MDB_SET_RANGE);
-    if (rc == MDB_NOTFOUND) {
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
         mdb_cursor_close(cursor);
         return 0;
     }
@@ -161,7 +165,7 @@ PostingIterator* MTimeDB::iter(quint32 mtime, MTimeDB::Comparator com)
     if (com == GreaterEqual) {
         while (1) {
             rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
-            if (rc == MDB_NOTFOUND) {
+            if (rc == MDB_NOTFOUND || isMapFull(rc)) {
                 break;
             }
             Q_ASSERT_X(rc == 0, "MTimeDB::iter >=", mdb_strerror(rc));
@@ -172,7 +176,7 @@ PostingIterator* MTimeDB::iter(quint32 mtime, MTimeDB::Comparator com)
     else {
         while (1) {
             rc = mdb_cursor_get(cursor, &key, &val, MDB_PREV);
-            if (rc == MDB_NOTFOUND) {
+            if (rc == MDB_NOTFOUND || isMapFull(rc)) {
                 break;
             }
             Q_ASSERT_X(rc == 0, "MTimeDB::iter >=", mdb_strerror(rc));
@@ -200,7 +204,7 @@ PostingIterator* MTimeDB::iterRange(quint32 beginTime, quint32 endTime)
 
     MDB_val val;
     int rc = mdb_cursor_get(cursor, &key, &val, MDB_SET_RANGE);
-    if (rc == MDB_NOTFOUND) {
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
         mdb_cursor_close(cursor);
         return 0;
     }
@@ -211,7 +215,7 @@ PostingIterator* MTimeDB::iterRange(quint32 beginTime, quint32 endTime)
 
     while (1) {
         rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
-        if (rc == MDB_NOTFOUND) {
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
             break;
         }
         Q_ASSERT_X(rc == 0, "MTimeDB::iter >=", mdb_strerror(rc));
@@ -238,7 +242,7 @@ QMap<quint32, quint64> MTimeDB::toTestMap() const
     QMap<quint32, quint64> map;
     while (1) {
         int rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
-        if (rc == MDB_NOTFOUND) {
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
             break;
         }
         Q_ASSERT_X(rc == 0, "MTimeDB::toTestMap", mdb_strerror(rc));
@@ -43,7 +43,7 @@ public:
     static MDB_dbi create(MDB_txn* txn);
     static MDB_dbi open(MDB_txn* txn);
 
-    void put(quint32 mtime, quint64 docId);
+    void put(quint32 mtime, quint64 docId, uint flags = 0);
     QVector<quint64> get(quint64 mtime);
 
     void del(quint32 mtime, quint64 docId);
@@ -0,0 +1,83 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_ORDEREDVALUES_H
+#define BALOO_ORDEREDVALUES_H
+
+#include <QByteArray>
+#include <QDateTime>
+
+#include <limits>
+
+namespace Baloo {
+
+/**
+ * Numbers, dates and times are indexed as fixed width big endian hex
+ * strings, so that the terms of a property are sorted in the order of
+ * their values. Range queries can then seek straight to their bounds.
+ * Plain binary cannot be used, as the terms of a document are stored
+ * separated by '\0'.
+ *
+ * The values start with '#', which keeps them apart from the words of
+ * the same property.
+ */
+inline QByteArray orderedValue(qint64 value)
+{
+    // Flipping the sign bit sorts the negative values first
+    const quint64 val = static_cast<quint64>(value) ^ (Q_UINT64_C(1) << 63);
+    return '#' + QByteArray::number(val, 16).rightJustified(16, '0');
+}
+
+/**
+ * Dates and times are both stored as seconds since the epoch, so that
+ * they can be compared with each other. A date starts at midnight UTC.
+ */
+inline qint64 secondsSinceEpoch(const QDateTime& dateTime)
+{
+    return dateTime.toMSecsSinceEpoch() / 1000;
+}
+
+inline qint64 secondsSinceEpoch(const QDate& date)
+{
+    return secondsSinceEpoch(QDateTime(date, QTime(0, 0), Qt::UTC));
+}
+
+inline QByteArray orderedValue(const QDateTime& dateTime)
+{
+    return orderedValue(secondsSinceEpoch(dateTime));
+}
+
+inline QByteArray orderedValue(const QDate& date)
+{
+    return orderedValue(secondsSinceEpoch(date));
+}
+
+inline QByteArray minimumOrderedValue()
+{
+    return orderedValue(std::numeric_limits<qint64>::min());
+}
+
+inline QByteArray maximumOrderedValue()
+{
+    return orderedValue(std::numeric_limits<qint64>::max());
+}
+
+}
+
+#endif // BALOO_ORDEREDVALUES_H
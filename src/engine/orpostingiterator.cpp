@@ -20,11 +20,14 @@
 
 #include "orpostingiterator.h"
 
+#include <algorithm>
+#include <limits>
+
 using namespace Baloo;
 
 OrPostingIterator::OrPostingIterator(const QVector<PostingIterator*>& iterators)
     : m_iterators(iterators)
-    , m_docId(0)
+    , m_blocks(iterators.size())
 {
 }
 
@@ -33,42 +36,85 @@ OrPostingIterator::~OrPostingIterator()
     qDeleteAll(m_iterators);
 }
 
-quint64 OrPostingIterator::docId() const
+uint OrPostingIterator::estimateSize(uint totalDocuments) const
 {
-    return m_docId;
+    if (!totalDocuments) {
+        return 0;
+    }
+
+    // Assume that the terms are independent of each other
+    double missing = 1;
+    uint maxSize = 0;
+    for (PostingIterator* iter : m_iterators) {
+        if (!iter) {
+            continue;
+        }
+        const uint size = qMin(iter->estimateSize(totalDocuments), totalDocuments);
+        missing *= 1 - static_cast<double>(size) / totalDocuments;
+        maxSize = qMax(maxSize, size);
+    }
+
+    return qMax(maxSize, static_cast<uint>(qRound((1 - missing) * totalDocuments)));
 }
 
-quint64 OrPostingIterator::next()
+QVector<PostingIterator*> OrPostingIterator::subIterators() const
 {
-    m_docId = 0;
-    if (m_iterators.isEmpty()) {
-        return 0;
+    // The exhausted iterators have been deleted
+    QVector<PostingIterator*> iterators;
+    for (PostingIterator* iter : m_iterators) {
+        if (iter) {
+            iterators << iter;
+        }
     }
+    return iterators;
+}
 
-    for (auto it = m_iterators.begin(), end = m_iterators.end(); it != end; it++) {
-        PostingIterator* iter = *it;
+bool OrPostingIterator::fillBlock(QVector<quint64>& block)
+{
+    block.clear();
+
+    // Only the ids up to the smallest last id of the blocks are known to
+    // be complete, unless that iterator has no more ids
+    quint64 bound = std::numeric_limits<quint64>::max();
+    for (int i = 0; i < m_iterators.size(); i++) {
+        PostingIterator* iter = m_iterators[i];
         if (!iter) {
             continue;
         }
 
-        // First or last element
-        if (iter->docId() == 0 && iter->next() == 0) {
-            delete iter;
-            *it = Q_NULLPTR;
-            continue;
+        Block& b = m_blocks[i];
+        if (b.isEmpty()) {
+            b.pos = 0;
+            b.size = b.finished ? 0 : iter->nextBlock(b.ids.data(), BlockSize);
+            b.finished = b.size < BlockSize;
+            if (!b.size) {
+                delete iter;
+                m_iterators[i] = Q_NULLPTR;
+                continue;
+            }
         }
 
-        if (iter->docId() < m_docId || m_docId == 0) {
-            m_docId = iter->docId();
+        if (!b.finished) {
+            bound = qMin(bound, b.last());
         }
     }
 
-    for (auto it = m_iterators.cbegin(), end = m_iterators.cend(); it != end; it++) {
-        PostingIterator* iter = *it;
-        if (iter && iter->docId() <= m_docId) {
-            iter->next();
+    for (int i = 0; i < m_iterators.size(); i++) {
+        if (!m_iterators[i]) {
+            continue;
+        }
+
+        Block& b = m_blocks[i];
+        auto begin = b.ids.constBegin() + b.pos;
+        auto end = std::upper_bound(begin, b.ids.constBegin() + b.size, bound);
+        for (auto it = begin; it != end; it++) {
+            block << *it;
         }
+        b.pos += end - begin;
     }
 
-    return m_docId;
+    std::sort(block.begin(), block.end());
+    block.erase(std::unique(block.begin(), block.end()), block.end());
+
+    return !block.isEmpty();
 }
@@ -21,23 +21,27 @@
 #ifndef BALOO_ORPOSTINGITERATOR_H
 #define BALOO_ORPOSTINGITERATOR_H
 
-#include "postingiterator.h"
+#include "blockpostingiterator.h"
 #include <QVector>
 
 namespace Baloo {
 
-class BALOO_ENGINE_EXPORT OrPostingIterator : public PostingIterator
+class BALOO_ENGINE_EXPORT OrPostingIterator : public BlockPostingIterator
 {
 public:
     explicit OrPostingIterator(const QVector<PostingIterator*>& iterators);
     ~OrPostingIterator();
 
-    quint64 next() Q_DECL_OVERRIDE;
-    quint64 docId() const Q_DECL_OVERRIDE;
+    uint estimateSize(uint totalDocuments) const Q_DECL_OVERRIDE;
+    QVector<PostingIterator*> subIterators() const Q_DECL_OVERRIDE;
+
+protected:
+    bool fillBlock(QVector<quint64>& block) Q_DECL_OVERRIDE;
 
 private:
     QVector<PostingIterator*> m_iterators;
-    quint64 m_docId;
+    // The ids read from each iterator
+    QVector<Block> m_blocks;
 };
 }
 
@@ -44,6 +44,22 @@ quint64 PhraseAndIterator::docId() const
     return m_docId;
 }
 
+uint PhraseAndIterator::estimateSize(uint totalDocuments) const
+{
+    // Every document with all the terms is counted, irrespective of their positions
+    uint size = m_iterators.isEmpty() ? 0 : totalDocuments;
+    for (PostingIterator* iter : m_iterators) {
+        size = qMin(size, iter->estimateSize(totalDocuments));
+    }
+
+    return size;
+}
+
+QVector<PostingIterator*> PhraseAndIterator::subIterators() const
+{
+    return m_iterators;
+}
+
 bool PhraseAndIterator::checkIfPositionsMatch()
 {
     QVector< QVector<uint> > positionList;
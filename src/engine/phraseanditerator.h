@@ -35,6 +35,8 @@ public:
 
     quint64 next();
     quint64 docId() const;
+    uint estimateSize(uint totalDocuments) const;
+    QVector<PostingIterator*> subIterators() const;
 
 private:
     QVector<PostingIterator*> m_iterators;
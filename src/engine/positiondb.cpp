@@ -19,12 +19,16 @@
  */
 
 #include "positiondb.h"
+#include "mapfull.h"
 #include "positioncodec.h"
 #include "positioninfo.h"
 #include "postingiterator.h"
+#include "metrics.h"
 
 #include <QDebug>
 
+#include <algorithm>
+
 using namespace Baloo;
 
 PositionDB::PositionDB(MDB_dbi dbi, MDB_txn* txn)
@@ -60,7 +64,7 @@ MDB_dbi PositionDB::open(MDB_txn* txn)
     return dbi;
 }
 
-void PositionDB::put(const QByteArray& term, const QVector<PositionInfo>& list)
+int PositionDB::put(const QByteArray& term, const QVector<PositionInfo>& list, uint flags)
 {
     Q_ASSERT(!term.isEmpty());
     Q_ASSERT(!list.isEmpty());
@@ -76,8 +80,15 @@ void PositionDB::put(const QByteArray& term, const QVector<PositionInfo>& list)
     val.mv_size = data.size();
     val.mv_data = static_cast<void*>(data.data());
 
-    int rc = mdb_put(m_txn, m_dbi, &key, &val, 0);
+    int rc = mdb_put(m_txn, m_dbi, &key, &val, flags);
+    if (isMapFull(rc)) {
+        return 0;
+    }
     Q_ASSERT_X(rc == 0, "PositionDB::put", mdb_strerror(rc));
+
+    static MetricsCounter* written = Metrics::instance()->counter(QStringLiteral("positiondb.write.bytes"));
+    written->add(data.size());
+    return data.size();
 }
 
 QVector<PositionInfo> PositionDB::get(const QByteArray& term)
@@ -90,13 +101,16 @@ QVector<PositionInfo> PositionDB::get(const QByteArray& term)
 
     MDB_val val;
     int rc = mdb_get(m_txn, m_dbi, &key, &val);
-    if (rc == MDB_NOTFOUND) {
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
         return QVector<PositionInfo>();
     }
     Q_ASSERT_X(rc == 0, "PositionDB::get", mdb_strerror(rc));
 
     QByteArray data = QByteArray::fromRawData(static_cast<char*>(val.mv_data), val.mv_size);
 
+    static MetricsCounter* decoded = Metrics::instance()->counter(QStringLiteral("positiondb.decode.bytes"));
+    decoded->add(val.mv_size);
+
     PositionCodec codec;
     return codec.decode(data);
 }
@@ -110,7 +124,7 @@ void PositionDB::del(const QByteArray& term)
     key.mv_data = static_cast<void*>(const_cast<char*>(term.constData()));
 
     int rc = mdb_del(m_txn, m_dbi, &key, 0);
-    if (rc == MDB_NOTFOUND) {
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
         return;
     }
     Q_ASSERT_X(rc == 0, "PositionDB::del", mdb_strerror(rc));
@@ -124,7 +138,11 @@ class DBPositionIterator : public PostingIterator {
 public:
     DBPositionIterator(char* data, uint size)
         : m_pos(-1)
+        , m_size(size)
     {
+        static MetricsCounter* decoded = Metrics::instance()->counter(QStringLiteral("positiondb.decode.bytes"));
+        decoded->add(size);
+
         PositionCodec codec;
         m_vec = codec.decode(QByteArray(static_cast<char*>(data), size));
     }
@@ -145,6 +163,17 @@ public:
         return m_vec[m_pos].docId;
     }
 
+    quint64 skipTo(quint64 docId) Q_DECL_OVERRIDE {
+        if (m_pos < 0 || m_pos >= m_vec.size()) {
+            return 0;
+        }
+
+        auto it = std::lower_bound(m_vec.constBegin() + m_pos, m_vec.constEnd(), docId,
+                                   [](const PositionInfo& info, quint64 id) { return info.docId < id; });
+        m_pos = it - m_vec.constBegin();
+        return this->docId();
+    }
+
     QVector<uint> positions() Q_DECL_OVERRIDE {
         if (m_pos < 0 || m_pos >= m_vec.size()) {
             return QVector<uint>();
@@ -152,9 +181,18 @@ public:
         return m_vec[m_pos].positions;
     }
 
+    uint estimateSize(uint) const Q_DECL_OVERRIDE {
+        return m_vec.size();
+    }
+
+    uint readSize() const Q_DECL_OVERRIDE {
+        return m_size;
+    }
+
 private:
     QVector<PositionInfo> m_vec;
     int m_pos;
+    uint m_size;
 };
 
 PostingIterator* PositionDB::iter(const QByteArray& term)
@@ -167,7 +205,7 @@ PostingIterator* PositionDB::iter(const QByteArray& term)
 
     MDB_val val;
     int rc = mdb_get(m_txn, m_dbi, &key, &val);
-    if (rc == MDB_NOTFOUND) {
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
         return 0;
     }
     Q_ASSERT_X(rc == 0, "PositionDB::iter", mdb_strerror(rc));
@@ -186,7 +224,7 @@ QMap<QByteArray, QVector<PositionInfo>> PositionDB::toTestMap() const
     QMap<QByteArray, QVector<PositionInfo>> map;
     while (1) {
         int rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
-        if (rc == MDB_NOTFOUND) {
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
             break;
         }
         Q_ASSERT_X(rc == 0, "PostingDB::toTestMap", mdb_strerror(rc));
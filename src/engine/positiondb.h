@@ -42,7 +42,10 @@ public:
     static MDB_dbi create(MDB_txn* txn);
     static MDB_dbi open(MDB_txn* txn);
 
-    void put(const QByteArray& term, const QVector<PositionInfo>& list);
+    /**
+     * Returns the number of bytes written, which is 0 if the map is full
+     */
+    int put(const QByteArray& term, const QVector<PositionInfo>& list, uint flags = 0);
     QVector<PositionInfo> get(const QByteArray& term);
     void del(const QByteArray& term);
 
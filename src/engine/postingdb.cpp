@@ -19,8 +19,11 @@
  */
 
 #include "postingdb.h"
+#include "mapfull.h"
 #include "orpostingiterator.h"
+#include "vectorpostingiterator.h"
 #include "postingcodec.h"
+#include "metrics.h"
 
 #include <QDebug>
 
@@ -59,7 +62,7 @@ MDB_dbi PostingDB::open(MDB_txn* txn)
     return dbi;
 }
 
-void PostingDB::put(const QByteArray& term, const PostingList& list)
+int PostingDB::put(const QByteArray& term, const PostingList& list, uint flags)
 {
     Q_ASSERT(!term.isEmpty());
     Q_ASSERT(!list.isEmpty());
@@ -75,8 +78,33 @@ void PostingDB::put(const QByteArray& term, const PostingList& list)
     val.mv_size = arr.size();
     val.mv_data = static_cast<void*>(arr.data());
 
-    int rc = mdb_put(m_txn, m_dbi, &key, &val, 0);
+    int rc = mdb_put(m_txn, m_dbi, &key, &val, flags);
+    if (isMapFull(rc)) {
+        return 0;
+    }
     Q_ASSERT_X(rc == 0, "PostingDB::put", mdb_strerror(rc));
+
+    static MetricsCounter* written = Metrics::instance()->counter(QStringLiteral("postingdb.write.bytes"));
+    written->add(arr.size());
+    return arr.size();
+}
+
+QByteArray PostingDB::getEncoded(const QByteArray& term)
+{
+    Q_ASSERT(!term.isEmpty());
+
+    MDB_val key;
+    key.mv_size = term.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(term.constData()));
+
+    MDB_val val;
+    int rc = mdb_get(m_txn, m_dbi, &key, &val);
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+        return QByteArray();
+    }
+    Q_ASSERT_X(rc == 0, "PostingDB::getEncoded", mdb_strerror(rc));
+
+    return QByteArray::fromRawData(static_cast<char*>(val.mv_data), val.mv_size);
 }
 
 PostingList PostingDB::get(const QByteArray& term)
@@ -89,13 +117,16 @@ PostingList PostingDB::get(const QByteArray& term)
 
     MDB_val val;
     int rc = mdb_get(m_txn, m_dbi, &key, &val);
-    if (rc == MDB_NOTFOUND) {
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
         return PostingList();
     }
     Q_ASSERT_X(rc == 0, "PostingDB::get", mdb_strerror(rc));
 
     QByteArray arr = QByteArray::fromRawData(static_cast<char*>(val.mv_data), val.mv_size);
 
+    static MetricsCounter* decoded = Metrics::instance()->counter(QStringLiteral("postingdb.decode.bytes"));
+    decoded->add(val.mv_size);
+
     PostingCodec codec;
     return codec.decode(arr);
 }
@@ -109,7 +140,7 @@ void PostingDB::del(const QByteArray& term)
     key.mv_data = static_cast<void*>(const_cast<char*>(term.constData()));
 
     int rc = mdb_del(m_txn, m_dbi, &key, 0);
-    if (rc == MDB_NOTFOUND) {
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
         return;
     }
     Q_ASSERT_X(rc == 0, "PostingDB::del", mdb_strerror(rc));
@@ -142,15 +173,18 @@ QVector< QByteArray > PostingDB::fetchTermsStartingWith(const QByteArray& term)
     return terms;
 }
 
-class DBPostingIterator : public PostingIterator {
+// The decoded ids are iterated over like any other vector, which also
+// gives the native block and skipping support
+class DBPostingIterator : public VectorPostingIterator {
 public:
     DBPostingIterator(void* data, uint size);
-    quint64 docId() const Q_DECL_OVERRIDE;
-    quint64 next() Q_DECL_OVERRIDE;
+
+    uint readSize() const Q_DECL_OVERRIDE {
+        return m_size;
+    }
 
 private:
-    const QVector<quint64> m_vec;
-    int m_pos;
+    uint m_size;
 };
 
 PostingIterator* PostingDB::iter(const QByteArray& term)
@@ -161,7 +195,7 @@ PostingIterator* PostingDB::iter(const QByteArray& term)
 
     MDB_val val;
     int rc = mdb_get(m_txn, m_dbi, &key, &val);
-    if (rc == MDB_NOTFOUND) {
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
         return 0;
     }
     Q_ASSERT_X(rc == 0, "PostingDB::iter", mdb_strerror(rc));
@@ -173,29 +207,11 @@ PostingIterator* PostingDB::iter(const QByteArray& term)
 // Posting Iterator
 //
 DBPostingIterator::DBPostingIterator(void* data, uint size)
-    : m_vec(PostingCodec().decode(QByteArray(static_cast<char*>(data), size)))
-    , m_pos(-1)
+    : VectorPostingIterator(PostingCodec().decode(QByteArray(static_cast<char*>(data), size)))
+    , m_size(size)
 {
-}
-
-quint64 DBPostingIterator::docId() const
-{
-    if (m_pos < 0 || m_pos >= m_vec.size()) {
-        return 0;
-    }
-
-    return m_vec[m_pos];
-}
-
-quint64 DBPostingIterator::next()
-{
-    if (m_pos >= m_vec.size() - 1) {
-        m_pos = m_vec.size();
-        return 0;
-    }
-
-    m_pos++;
-    return m_vec[m_pos];
+    static MetricsCounter* decoded = Metrics::instance()->counter(QStringLiteral("postingdb.decode.bytes"));
+    decoded->add(size);
 }
 
 template <typename Validator>
@@ -258,12 +274,47 @@ PostingIterator* PostingDB::regexpIter(const QRegularExpression& regexp, const Q
 PostingIterator* PostingDB::compIter(const QByteArray& prefix, const QByteArray& comVal, PostingDB::Comparator com)
 {
     Q_ASSERT(!comVal.isEmpty());
-    int prefixLen = prefix.length();
-    auto validate = [prefixLen, &comVal, com] (const QByteArray& arr) {
-        QByteArray term(arr.constData() + prefixLen, arr.length() - prefixLen);
-        return ((com == LessEqual && term <= comVal) || (com == GreaterEqual && term >= comVal));
-    };
-    return iter(prefix, validate);
+
+    if (com == LessEqual) {
+        return rangeIter(prefix, QByteArray(), comVal);
+    }
+    return rangeIter(prefix, comVal, QByteArray());
+}
+
+PostingIterator* PostingDB::rangeIter(const QByteArray& prefix, const QByteArray& lower, const QByteArray& upper)
+{
+    Q_ASSERT(!prefix.isEmpty());
+
+    const QByteArray begin = prefix + lower;
+    const QByteArray end = prefix + upper;
+
+    MDB_val key;
+    key.mv_size = begin.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(begin.constData()));
+
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    QVector<PostingIterator*> termIterators;
+
+    MDB_val val;
+    int rc = mdb_cursor_get(cursor, &key, &val, MDB_SET_RANGE);
+    while (rc != MDB_NOTFOUND) {
+        Q_ASSERT_X(rc == 0, "PostingDB::rangeIter", mdb_strerror(rc));
+
+        const QByteArray arr(static_cast<char*>(key.mv_data), key.mv_size);
+        if (!arr.startsWith(prefix) || (!upper.isEmpty() && arr > end)) {
+            break;
+        }
+        termIterators << new DBPostingIterator(val.mv_data, val.mv_size);
+        rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
+    }
+
+    mdb_cursor_close(cursor);
+    if (termIterators.isEmpty()) {
+        return 0;
+    }
+    return new OrPostingIterator(termIterators);
 }
 
 QMap<QByteArray, PostingList> PostingDB::toTestMap() const
@@ -277,7 +328,7 @@ QMap<QByteArray, PostingList> PostingDB::toTestMap() const
     QMap<QByteArray, PostingList> map;
     while (1) {
         int rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
-        if (rc == MDB_NOTFOUND) {
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
             break;
         }
         Q_ASSERT_X(rc == 0, "PostingDB::toTestMap", mdb_strerror(rc));
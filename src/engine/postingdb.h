@@ -46,10 +46,20 @@ public:
     static MDB_dbi create(MDB_txn* txn);
     static MDB_dbi open(MDB_txn* txn);
 
-    void put(const QByteArray& term, const PostingList& list);
+    /**
+     * Returns the number of bytes written, which is 0 if the map is full
+     */
+    int put(const QByteArray& term, const PostingList& list, uint flags = 0);
     PostingList get(const QByteArray& term);
     void del(const QByteArray& term);
 
+    /**
+     * Returns the encoded posting list of \p term without decoding it.
+     * It points into the database, so it is only valid until the
+     * transaction ends.
+     */
+    QByteArray getEncoded(const QByteArray& term);
+
     PostingIterator* iter(const QByteArray& term);
     PostingIterator* prefixIter(const QByteArray& term);
     PostingIterator* regexpIter(const QRegularExpression& regexp, const QByteArray& prefix);
@@ -60,6 +70,13 @@ public:
     };
     PostingIterator* compIter(const QByteArray& prefix, const QByteArray& val, Comparator com);
 
+    /**
+     * Iterates over the documents of all the terms \p prefix + value, where
+     * \p lower <= value <= \p upper. An empty bound is not checked. Only the
+     * terms within the range are read.
+     */
+    PostingIterator* rangeIter(const QByteArray& prefix, const QByteArray& lower, const QByteArray& upper);
+
     QVector<QByteArray> fetchTermsStartingWith(const QByteArray& term);
 
     QMap<QByteArray, PostingList> toTestMap() const;
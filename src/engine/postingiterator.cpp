@@ -34,7 +34,51 @@ quint64 PostingIterator::skipTo(quint64 id)
     return docId();
 }
 
+int PostingIterator::nextBlock(quint64* ids, int max)
+{
+    int count = 0;
+    while (count < max) {
+        const quint64 id = next();
+        if (!id) {
+            break;
+        }
+        ids[count++] = id;
+    }
+    return count;
+}
+
+int PostingIterator::skipToBlock(quint64 docId, quint64* ids, int max)
+{
+    Q_ASSERT(max > 0);
+
+    // Not started yet
+    if (!this->docId() && !next()) {
+        return 0;
+    }
+    if (!skipTo(docId)) {
+        return 0;
+    }
+
+    ids[0] = this->docId();
+    return 1 + nextBlock(ids + 1, max - 1);
+}
+
+uint PostingIterator::estimateSize(uint totalDocuments) const
+{
+    return totalDocuments;
+}
+
 QVector<uint> PostingIterator::positions()
 {
     return QVector<uint>();
 }
+
+QVector<PostingIterator*> PostingIterator::subIterators() const
+{
+    return QVector<PostingIterator*>();
+}
+
+uint PostingIterator::readSize() const
+{
+    return 0;
+}
@@ -41,7 +41,45 @@ public:
     virtual quint64 docId() const = 0;
     virtual quint64 skipTo(quint64 docId);
 
+    /**
+     * Moves past the next ids and copies up to \p max of them into \p ids,
+     * like calling next() up to \p max times, but with a single virtual
+     * call. Returns how many ids were copied. If that is less than \p max
+     * the iterator is done, otherwise docId() is the last of them.
+     */
+    virtual int nextBlock(quint64* ids, int max);
+
+    /**
+     * Moves to the first id which is not less than \p docId and copies up
+     * to \p max ids from there on into \p ids, starting with that one.
+     * Unlike skipTo, this also works on an iterator which has not been
+     * started yet. Returns the same as nextBlock.
+     */
+    virtual int skipToBlock(quint64 docId, quint64* ids, int max);
+
+    /**
+     * Returns an estimate of the number of ids this iterator will return
+     * in total, when there are \p totalDocuments in the index. This should
+     * be called before iterating.
+     *
+     * By default every document is assumed to match.
+     */
+    virtual uint estimateSize(uint totalDocuments) const;
+
     virtual QVector<uint> positions();
+
+    /**
+     * Returns the iterators this iterator combines, if any. Iterators
+     * which have been exhausted may already be gone.
+     */
+    virtual QVector<PostingIterator*> subIterators() const;
+
+    /**
+     * Returns the number of bytes this iterator itself read from the
+     * database, not counting its sub iterators. This is only used for
+     * profiling queries.
+     */
+    virtual uint readSize() const;
 };
 }
 
@@ -0,0 +1,496 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "prefixdb.h"
+#include "mapfull.h"
+#include "vectorpostingiterator.h"
+#include "postingcodec.h"
+#include "frequencycodec.h"
+#include "coding.h"
+#include "metrics.h"
+
+#include <QDebug>
+
+#include <algorithm>
+
+using namespace Baloo;
+
+PrefixDB::PrefixDB(MDB_dbi dbi, MDB_txn* txn)
+    : m_txn(txn)
+    , m_dbi(dbi)
+{
+    Q_ASSERT(txn != 0);
+    Q_ASSERT(dbi != 0);
+}
+
+PrefixDB::~PrefixDB()
+{
+}
+
+MDB_dbi PrefixDB::create(MDB_txn* txn)
+{
+    MDB_dbi dbi;
+    int rc = mdb_dbi_open(txn, "prefixdb", MDB_CREATE, &dbi);
+    Q_ASSERT_X(rc == 0, "PrefixDB::create", mdb_strerror(rc));
+
+    return dbi;
+}
+
+MDB_dbi PrefixDB::open(MDB_txn* txn)
+{
+    MDB_dbi dbi;
+    int rc = mdb_dbi_open(txn, "prefixdb", 0, &dbi);
+    if (rc == MDB_NOTFOUND) {
+        return 0;
+    }
+    Q_ASSERT_X(rc == 0, "PrefixDB::open", mdb_strerror(rc));
+
+    return dbi;
+}
+
+// Returns false if \p str ends with an incomplete UTF-8 sequence
+static bool endsInCharacter(const QByteArray& str)
+{
+    int continuation = 0;
+    int pos = str.size() - 1;
+    while (pos >= 0 && (static_cast<uchar>(str[pos]) & 0xC0) == 0x80 && continuation < 3) {
+        continuation++;
+        pos--;
+    }
+    if (pos < 0) {
+        return false;
+    }
+
+    const uchar lead = static_cast<uchar>(str[pos]);
+    int length = 1;
+    if (lead >= 0xF0) {
+        length = 4;
+    } else if (lead >= 0xE0) {
+        length = 3;
+    } else if (lead >= 0xC0) {
+        length = 2;
+    } else if (lead >= 0x80) {
+        return false;
+    }
+
+    return length == continuation + 1;
+}
+
+bool PrefixDB::contains(const QByteArray& prefix)
+{
+    return prefix.size() >= MinLength && prefix.size() <= MaxLength && endsInCharacter(prefix);
+}
+
+QVector<QByteArray> PrefixDB::prefixes(const QByteArray& term)
+{
+    QVector<QByteArray> list;
+    for (int length = MinLength; length <= qMin<int>(MaxLength, term.size()); length++) {
+        const QByteArray prefix = term.left(length);
+        if (endsInCharacter(prefix)) {
+            list << prefix;
+        }
+    }
+    return list;
+}
+
+void PrefixDB::put(const QByteArray& prefix, const PostingList& list, const QVector<quint32>& counts)
+{
+    Q_ASSERT(!prefix.isEmpty());
+    Q_ASSERT(!list.isEmpty());
+    Q_ASSERT(list.size() == counts.size());
+
+    MDB_val key;
+    key.mv_size = prefix.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(prefix.constData()));
+
+    // The ids come first, so that a query does not have to decode the counts
+    const QByteArray ids = PostingCodec().encode(list);
+    QByteArray arr;
+    putVarint32(&arr, ids.size());
+    arr += ids;
+    arr += FrequencyCodec().encode(counts);
+
+    MDB_val val;
+    val.mv_size = arr.size();
+    val.mv_data = static_cast<void*>(arr.data());
+
+    int rc = mdb_put(m_txn, m_dbi, &key, &val, 0);
+    if (isMapFull(rc)) {
+        return;
+    }
+    Q_ASSERT_X(rc == 0, "PrefixDB::put", mdb_strerror(rc));
+}
+
+// Splits a value into the encoded ids and counts
+static bool split(const MDB_val& val, QByteArray* ids, QByteArray* counts)
+{
+    const char* begin = static_cast<const char*>(val.mv_data);
+    const char* end = begin + val.mv_size;
+
+    quint32 size;
+    const char* p = getVarint32Ptr(begin, end, &size);
+    if (!p || size > static_cast<quint32>(end - p)) {
+        return false;
+    }
+
+    *ids = QByteArray::fromRawData(p, size);
+    if (counts) {
+        *counts = QByteArray::fromRawData(p + size, end - p - size);
+    }
+    return true;
+}
+
+PostingList PrefixDB::get(const QByteArray& prefix, QVector<quint32>* counts)
+{
+    Q_ASSERT(!prefix.isEmpty());
+
+    MDB_val key;
+    key.mv_size = prefix.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(prefix.constData()));
+
+    MDB_val val;
+    int rc = mdb_get(m_txn, m_dbi, &key, &val);
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+        return PostingList();
+    }
+    Q_ASSERT_X(rc == 0, "PrefixDB::get", mdb_strerror(rc));
+
+    QByteArray ids;
+    QByteArray countArr;
+    if (!split(val, &ids, &countArr)) {
+        return PostingList();
+    }
+
+    const PostingList list = PostingCodec().decode(ids);
+    if (counts) {
+        *counts = FrequencyCodec().decode(countArr);
+        if (counts->size() != list.size()) {
+            counts->fill(1, list.size());
+        }
+    }
+    return list;
+}
+
+void PrefixDB::del(const QByteArray& prefix)
+{
+    Q_ASSERT(!prefix.isEmpty());
+
+    MDB_val key;
+    key.mv_size = prefix.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(prefix.constData()));
+
+    int rc = mdb_del(m_txn, m_dbi, &key, 0);
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+        return;
+    }
+    Q_ASSERT_X(rc == 0, "PrefixDB::del", mdb_strerror(rc));
+}
+
+void PrefixDB::update(const QByteArray& prefix, const QMap<quint64, int>& delta)
+{
+    QVector<quint32> counts;
+    const PostingList list = get(prefix, &counts);
+
+    // Both are sorted by id, so they are merged in a single pass
+    PostingList merged;
+    QVector<quint32> mergedCounts;
+    merged.reserve(list.size() + delta.size());
+    mergedCounts.reserve(list.size() + delta.size());
+
+    int i = 0;
+    auto it = delta.constBegin();
+    while (i < list.size() || it != delta.constEnd()) {
+        if (it == delta.constEnd() || (i < list.size() && list[i] < it.key())) {
+            merged << list[i];
+            mergedCounts << counts[i];
+            i++;
+            continue;
+        }
+
+        int count = it.value();
+        if (i < list.size() && list[i] == it.key()) {
+            count += static_cast<int>(counts[i]);
+            i++;
+        }
+        if (count > 0) {
+            merged << it.key();
+            mergedCounts << count;
+        }
+        ++it;
+    }
+
+    if (!merged.isEmpty()) {
+        put(prefix, merged, mergedCounts);
+    } else {
+        del(prefix);
+    }
+}
+
+// The position of a rebuild is kept under this key, which is too short
+// to be one of the prefixes
+static MDB_val rebuildKey()
+{
+    static char key = 0;
+
+    MDB_val val;
+    val.mv_size = 1;
+    val.mv_data = &key;
+    return val;
+}
+
+bool PrefixDB::rebuildPosition(QByteArray* term)
+{
+    MDB_val key = rebuildKey();
+    MDB_val val;
+    int rc = mdb_get(m_txn, m_dbi, &key, &val);
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+        return false;
+    }
+    Q_ASSERT_X(rc == 0, "PrefixDB::rebuildPosition", mdb_strerror(rc));
+
+    *term = QByteArray(static_cast<char*>(val.mv_data), val.mv_size);
+    return true;
+}
+
+void PrefixDB::setRebuildPosition(const QByteArray& term)
+{
+    MDB_val key = rebuildKey();
+    int rc;
+    if (term.isEmpty()) {
+        rc = mdb_del(m_txn, m_dbi, &key, 0);
+        if (rc == MDB_NOTFOUND) {
+            return;
+        }
+    } else {
+        MDB_val val;
+        val.mv_size = term.size();
+        val.mv_data = static_cast<void*>(const_cast<char*>(term.constData()));
+        rc = mdb_put(m_txn, m_dbi, &key, &val, 0);
+    }
+    if (isMapFull(rc)) {
+        return;
+    }
+    Q_ASSERT_X(rc == 0, "PrefixDB::setRebuildPosition", mdb_strerror(rc));
+}
+
+void PrefixDB::beginRebuild(MDB_dbi postingDbi)
+{
+    int rc = mdb_drop(m_txn, m_dbi, 0);
+    Q_ASSERT_X(rc == 0, "PrefixDB::beginRebuild", mdb_strerror(rc));
+
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, postingDbi, &cursor);
+
+    MDB_val key = {0, 0};
+    MDB_val val;
+    rc = mdb_cursor_get(cursor, &key, &val, MDB_FIRST);
+    mdb_cursor_close(cursor);
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+        return;
+    }
+    Q_ASSERT_X(rc == 0, "PrefixDB::beginRebuild", mdb_strerror(rc));
+
+    setRebuildPosition(QByteArray(static_cast<char*>(key.mv_data), key.mv_size));
+}
+
+bool PrefixDB::isRebuilding()
+{
+    QByteArray term;
+    return rebuildPosition(&term);
+}
+
+void PrefixDB::continueRebuild(MDB_dbi postingDbi, int maxTerms)
+{
+    QByteArray from;
+    if (!rebuildPosition(&from)) {
+        return;
+    }
+
+    PrefixUnionBuilder builder([this](const QByteArray& prefix, const PostingList& list,
+                                      const QVector<quint32>& counts) {
+        put(prefix, list, counts);
+    });
+
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, postingDbi, &cursor);
+
+    MDB_val key;
+    key.mv_size = from.size();
+    key.mv_data = static_cast<void*>(from.data());
+    MDB_val val;
+
+    // All the terms of a union start with the same MinLength bytes
+    QByteArray start;
+    QByteArray next;
+    int terms = 0;
+    MDB_cursor_op op = MDB_SET_RANGE;
+    while (1) {
+        int rc = mdb_cursor_get(cursor, &key, &val, op);
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+            break;
+        }
+        Q_ASSERT_X(rc == 0, "PrefixDB::continueRebuild", mdb_strerror(rc));
+        op = MDB_NEXT;
+
+        const QByteArray term(static_cast<char*>(key.mv_data), key.mv_size);
+        if (terms >= maxTerms && !term.startsWith(start)) {
+            next = term;
+            break;
+        }
+        start = term.left(MinLength);
+        terms++;
+
+        const QByteArray arr = QByteArray::fromRawData(static_cast<char*>(val.mv_data), val.mv_size);
+        builder.addTerm(term, PostingCodec().decode(arr));
+    }
+    builder.finish();
+
+    mdb_cursor_close(cursor);
+
+    // Done once there are no terms left
+    setRebuildPosition(next);
+}
+
+//
+// Query
+//
+
+class DBPrefixIterator : public VectorPostingIterator {
+public:
+    explicit DBPrefixIterator(const QByteArray& ids)
+        : VectorPostingIterator(PostingCodec().decode(ids))
+        , m_size(ids.size())
+    {
+        static MetricsCounter* decoded = Metrics::instance()->counter(QStringLiteral("prefixdb.decode.bytes"));
+        decoded->add(ids.size());
+    }
+
+    uint readSize() const Q_DECL_OVERRIDE {
+        return m_size;
+    }
+
+private:
+    uint m_size;
+};
+
+PostingIterator* PrefixDB::iter(const QByteArray& prefix)
+{
+    Q_ASSERT(contains(prefix));
+
+    MDB_val key;
+    key.mv_size = prefix.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(prefix.constData()));
+
+    MDB_val val;
+    int rc = mdb_get(m_txn, m_dbi, &key, &val);
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+        return 0;
+    }
+    Q_ASSERT_X(rc == 0, "PrefixDB::iter", mdb_strerror(rc));
+
+    QByteArray ids;
+    if (!split(val, &ids, 0)) {
+        return 0;
+    }
+    return new DBPrefixIterator(ids);
+}
+
+QMap<QByteArray, PostingList> PrefixDB::toTestMap() const
+{
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    MDB_val key = {0, 0};
+    MDB_val val;
+
+    QMap<QByteArray, PostingList> map;
+    while (1) {
+        int rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+            break;
+        }
+        Q_ASSERT_X(rc == 0, "PrefixDB::toTestMap", mdb_strerror(rc));
+
+        // The position of a rebuild
+        if (key.mv_size < MinLength) {
+            continue;
+        }
+
+        QByteArray ids;
+        if (split(val, &ids, 0)) {
+            const QByteArray prefix(static_cast<char*>(key.mv_data), key.mv_size);
+            map.insert(prefix, PostingCodec().decode(ids));
+        }
+    }
+
+    mdb_cursor_close(cursor);
+    return map;
+}
+
+//
+// Building
+//
+
+PrefixUnionBuilder::PrefixUnionBuilder(const Writer& writer)
+    : m_writer(writer)
+{
+}
+
+void PrefixUnionBuilder::addTerm(const QByteArray& term, const PostingList& list)
+{
+    // The terms of a prefix are next to each other, so a union is
+    // complete once a term with another prefix of the same length comes
+    for (const QByteArray& prefix : PrefixDB::prefixes(term)) {
+        Union& u = m_unions[prefix.size() - PrefixDB::MinLength];
+        if (u.prefix != prefix) {
+            flush(u);
+            u.prefix = prefix;
+        }
+
+        for (quint64 id : list) {
+            u.counts[id]++;
+        }
+    }
+}
+
+void PrefixUnionBuilder::finish()
+{
+    for (Union& u : m_unions) {
+        flush(u);
+    }
+}
+
+void PrefixUnionBuilder::flush(Union& u)
+{
+    if (u.counts.isEmpty()) {
+        return;
+    }
+
+    PostingList list = u.counts.keys().toVector();
+    std::sort(list.begin(), list.end());
+
+    QVector<quint32> counts;
+    counts.reserve(list.size());
+    for (quint64 id : list) {
+        counts << u.counts.value(id);
+    }
+
+    m_writer(u.prefix, list, counts);
+    u.counts.clear();
+}
@@ -0,0 +1,140 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_PREFIXDB_H
+#define BALOO_PREFIXDB_H
+
+#include "postingdb.h"
+
+#include <QHash>
+#include <QMap>
+
+#include <functional>
+
+namespace Baloo {
+
+/**
+ * The PrefixDB maps the short prefixes of the terms to the union of their
+ * posting lists, <prefix> -> <id1> <id2> <id3> ..., so that the common
+ * prefix searches read a single list instead of one list per term.
+ *
+ * Each id is stored together with the number of terms of the prefix which
+ * contain it, so that ids can be removed without looking at the other
+ * terms. The prefixes are the first MinLength to MaxLength bytes of each
+ * term, which do not end in the middle of a character.
+ */
+class BALOO_ENGINE_EXPORT PrefixDB
+{
+public:
+    PrefixDB(MDB_dbi dbi, MDB_txn* txn);
+    ~PrefixDB();
+
+    enum {
+        MinLength = 3,
+        MaxLength = 4
+    };
+
+    static MDB_dbi create(MDB_txn* txn);
+    static MDB_dbi open(MDB_txn* txn);
+
+    /**
+     * Returns true if the union of the terms starting with \p prefix is
+     * stored in this database
+     */
+    static bool contains(const QByteArray& prefix);
+
+    /**
+     * Returns the prefixes of \p term which are stored
+     */
+    static QVector<QByteArray> prefixes(const QByteArray& term);
+
+    void put(const QByteArray& prefix, const PostingList& list, const QVector<quint32>& counts);
+    PostingList get(const QByteArray& prefix, QVector<quint32>* counts = 0);
+    void del(const QByteArray& prefix);
+
+    PostingIterator* iter(const QByteArray& prefix);
+
+    /**
+     * Adds \p delta to the number of terms of \p prefix which contain each
+     * id, and removes the ids which are left without any.
+     */
+    void update(const QByteArray& prefix, const QMap<quint64, int>& delta);
+
+    /**
+     * Empties the database and starts filling it again with the unions of
+     * all the terms in the PostingDB \p postingDbi, which is then done a
+     * batch at a time with continueRebuild. Nothing needs to be done if
+     * there are no terms.
+     *
+     * Meanwhile the database holds the term to continue from, and the
+     * unions must not be used for queries, see isRebuilding.
+     */
+    void beginRebuild(MDB_dbi postingDbi);
+    bool isRebuilding();
+
+    /**
+     * Writes the unions of about the next \p maxTerms terms. A batch only
+     * ends between two terms which start differently, so that none of the
+     * unions is split between batches.
+     */
+    void continueRebuild(MDB_dbi postingDbi, int maxTerms);
+
+    QMap<QByteArray, PostingList> toTestMap() const;
+
+private:
+    /**
+     * Returns false if the database is not being rebuilt
+     */
+    bool rebuildPosition(QByteArray* term);
+    void setRebuildPosition(const QByteArray& term);
+
+    MDB_txn* m_txn;
+    MDB_dbi m_dbi;
+};
+
+/**
+ * Collects the unions of the prefixes of terms, which need to be added
+ * in sorted order. Each union is passed to the writer as soon as all of
+ * its terms have been seen.
+ */
+class BALOO_ENGINE_EXPORT PrefixUnionBuilder
+{
+public:
+    typedef std::function<void(const QByteArray& prefix, const PostingList& list,
+                               const QVector<quint32>& counts)> Writer;
+
+    explicit PrefixUnionBuilder(const Writer& writer);
+
+    void addTerm(const QByteArray& term, const PostingList& list);
+    void finish();
+
+private:
+    struct Union {
+        QByteArray prefix;
+        QHash<quint64, quint32> counts;
+    };
+    void flush(Union& u);
+
+    Writer m_writer;
+    Union m_unions[PrefixDB::MaxLength - PrefixDB::MinLength + 1];
+};
+
+}
+
+#endif // BALOO_PREFIXDB_H
@@ -0,0 +1,243 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "queryprofile.h"
+#include "postingiterator.h"
+
+#include <QElapsedTimer>
+#include <QVariantList>
+
+using namespace Baloo;
+
+struct QueryProfile::Node {
+    QString name;
+    uint estimated;
+    uint actual;
+    uint nextCalls;
+    uint skipToCalls;
+    uint bytes;
+    uint gets;
+    qint64 nsecs;
+
+    QVector<Node*> children;
+    bool hasParent;
+
+    Node()
+        : estimated(0)
+        , actual(0)
+        , nextCalls(0)
+        , skipToCalls(0)
+        , bytes(0)
+        , gets(0)
+        , nsecs(0)
+        , hasParent(false)
+    {}
+};
+
+namespace Baloo {
+
+class ProfilingPostingIterator : public PostingIterator
+{
+public:
+    ProfilingPostingIterator(PostingIterator* it, QueryProfile::Node* node)
+        : m_it(it)
+        , m_node(node)
+        , m_lastId(0)
+    {}
+
+    ~ProfilingPostingIterator() {
+        delete m_it;
+    }
+
+    quint64 next() Q_DECL_OVERRIDE {
+        QElapsedTimer timer;
+        timer.start();
+
+        const quint64 id = m_it->next();
+
+        m_node->nextCalls++;
+        record(id, timer.nsecsElapsed());
+        return id;
+    }
+
+    quint64 skipTo(quint64 docId) Q_DECL_OVERRIDE {
+        QElapsedTimer timer;
+        timer.start();
+
+        const quint64 id = m_it->skipTo(docId);
+
+        m_node->skipToCalls++;
+        record(id, timer.nsecsElapsed());
+        return id;
+    }
+
+    int nextBlock(quint64* ids, int max) Q_DECL_OVERRIDE {
+        QElapsedTimer timer;
+        timer.start();
+
+        const int count = m_it->nextBlock(ids, max);
+
+        m_node->nextCalls++;
+        recordBlock(ids, count, timer.nsecsElapsed());
+        return count;
+    }
+
+    int skipToBlock(quint64 docId, quint64* ids, int max) Q_DECL_OVERRIDE {
+        QElapsedTimer timer;
+        timer.start();
+
+        const int count = m_it->skipToBlock(docId, ids, max);
+
+        m_node->skipToCalls++;
+        recordBlock(ids, count, timer.nsecsElapsed());
+        return count;
+    }
+
+    quint64 docId() const Q_DECL_OVERRIDE {
+        return m_it->docId();
+    }
+
+    uint estimateSize(uint totalDocuments) const Q_DECL_OVERRIDE {
+        return m_it->estimateSize(totalDocuments);
+    }
+
+    QVector<uint> positions() Q_DECL_OVERRIDE {
+        return m_it->positions();
+    }
+
+    QVector<PostingIterator*> subIterators() const Q_DECL_OVERRIDE {
+        return {m_it};
+    }
+
+    QueryProfile::Node* node() const {
+        return m_node;
+    }
+
+private:
+    void record(quint64 id, qint64 nsecs) {
+        m_node->nsecs += nsecs;
+
+        // skipTo may stay on the current id
+        if (id && id != m_lastId) {
+            m_node->actual++;
+            m_lastId = id;
+        }
+    }
+
+    void recordBlock(const quint64* ids, int count, qint64 nsecs) {
+        m_node->nsecs += nsecs;
+        if (!count) {
+            return;
+        }
+
+        m_node->actual += count;
+        if (ids[0] == m_lastId) {
+            m_node->actual--;
+        }
+        m_lastId = ids[count - 1];
+    }
+
+    PostingIterator* m_it;
+    QueryProfile::Node* m_node;
+    quint64 m_lastId;
+};
+
+}
+
+QueryProfile::QueryProfile()
+{
+}
+
+QueryProfile::~QueryProfile()
+{
+    qDeleteAll(m_nodes);
+}
+
+PostingIterator* QueryProfile::wrap(PostingIterator* it, const QString& name, uint estimate)
+{
+    if (!it || dynamic_cast<ProfilingPostingIterator*>(it)) {
+        return it;
+    }
+
+    Node* node = new Node;
+    node->name = name;
+    node->estimated = estimate;
+    m_nodes << node;
+
+    if (it->readSize()) {
+        node->bytes += it->readSize();
+        node->gets++;
+    }
+    addSubIterators(it, node);
+
+    return new ProfilingPostingIterator(it, node);
+}
+
+void QueryProfile::addSubIterators(PostingIterator* it, Node* node)
+{
+    for (PostingIterator* sub : it->subIterators()) {
+        if (!sub) {
+            continue;
+        }
+
+        if (ProfilingPostingIterator* profiled = dynamic_cast<ProfilingPostingIterator*>(sub)) {
+            node->children << profiled->node();
+            profiled->node()->hasParent = true;
+            continue;
+        }
+
+        if (sub->readSize()) {
+            node->bytes += sub->readSize();
+            node->gets++;
+        }
+        addSubIterators(sub, node);
+    }
+}
+
+QVariantMap QueryProfile::toVariantMap() const
+{
+    for (int i = m_nodes.size() - 1; i >= 0; i--) {
+        if (!m_nodes[i]->hasParent) {
+            return toVariantMap(m_nodes[i]);
+        }
+    }
+
+    return QVariantMap();
+}
+
+QVariantMap QueryProfile::toVariantMap(const Node* node)
+{
+    QVariantList children;
+    for (const Node* child : node->children) {
+        children << toVariantMap(child);
+    }
+
+    QVariantMap map;
+    map.insert(QStringLiteral("name"), node->name);
+    map.insert(QStringLiteral("estimated"), node->estimated);
+    map.insert(QStringLiteral("actual"), node->actual);
+    map.insert(QStringLiteral("next"), node->nextCalls);
+    map.insert(QStringLiteral("skipTo"), node->skipToCalls);
+    map.insert(QStringLiteral("bytes"), node->bytes);
+    map.insert(QStringLiteral("gets"), node->gets);
+    map.insert(QStringLiteral("usecs"), node->nsecs / 1000);
+    map.insert(QStringLiteral("children"), children);
+
+    return map;
+}
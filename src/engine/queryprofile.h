@@ -0,0 +1,80 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_QUERYPROFILE_H
+#define BALOO_QUERYPROFILE_H
+
+#include "engine_export.h"
+
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+
+namespace Baloo {
+
+class PostingIterator;
+class ProfilingPostingIterator;
+
+/**
+ * Records how each node of a tree of PostingIterators is used while a
+ * query runs: how many ids it returned compared to its estimate, how
+ * often it was advanced, how much it read from the database and how
+ * long it took, including its children.
+ *
+ * Only the iterators which are wrapped are recorded, so a query which
+ * is not being profiled does not pay for any of it.
+ */
+class BALOO_ENGINE_EXPORT QueryProfile
+{
+public:
+    QueryProfile();
+    ~QueryProfile();
+
+    /**
+     * Returns an iterator which forwards to \p it and records its use
+     * under \p name. The iterators among the sub iterators of \p it which
+     * were wrapped before become its children.
+     *
+     * The bytes read by the sub iterators which were not wrapped are
+     * added to this node.
+     */
+    PostingIterator* wrap(PostingIterator* it, const QString& name, uint estimate);
+
+    /**
+     * Returns the tree of the iterator which was wrapped last. Each node
+     * has the keys "name", "estimated", "actual", "next", "skipTo",
+     * "bytes", "gets", "usecs" and "children".
+     */
+    QVariantMap toVariantMap() const;
+
+private:
+    QueryProfile(const QueryProfile&) = delete;
+
+    struct Node;
+    void addSubIterators(PostingIterator* it, Node* node);
+    static QVariantMap toVariantMap(const Node* node);
+
+    QVector<Node*> m_nodes;
+
+    friend class ProfilingPostingIterator;
+};
+
+}
+
+#endif // BALOO_QUERYPROFILE_H
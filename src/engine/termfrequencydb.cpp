@@ -0,0 +1,182 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "termfrequencydb.h"
+#include "mapfull.h"
+#include "frequencycodec.h"
+
+#include <QDebug>
+
+using namespace Baloo;
+
+TermFrequencyDB::TermFrequencyDB(MDB_dbi dbi, MDB_txn* txn)
+    : m_txn(txn)
+    , m_dbi(dbi)
+{
+    Q_ASSERT(txn != 0);
+    Q_ASSERT(dbi != 0);
+}
+
+TermFrequencyDB::~TermFrequencyDB()
+{
+}
+
+MDB_dbi TermFrequencyDB::create(MDB_txn* txn)
+{
+    MDB_dbi dbi;
+    int rc = mdb_dbi_open(txn, "termfrequencydb", MDB_CREATE, &dbi);
+    Q_ASSERT_X(rc == 0, "TermFrequencyDB::create", mdb_strerror(rc));
+
+    return dbi;
+}
+
+MDB_dbi TermFrequencyDB::open(MDB_txn* txn)
+{
+    MDB_dbi dbi;
+    int rc = mdb_dbi_open(txn, "termfrequencydb", 0, &dbi);
+    if (rc == MDB_NOTFOUND) {
+        return 0;
+    }
+    Q_ASSERT_X(rc == 0, "TermFrequencyDB::open", mdb_strerror(rc));
+
+    return dbi;
+}
+
+void TermFrequencyDB::put(const QByteArray& term, const QVector<quint32>& list, uint flags)
+{
+    Q_ASSERT(!term.isEmpty());
+    Q_ASSERT(!list.isEmpty());
+
+    MDB_val key;
+    key.mv_size = term.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(term.constData()));
+
+    FrequencyCodec codec;
+    QByteArray arr = codec.encode(list);
+
+    MDB_val val;
+    val.mv_size = arr.size();
+    val.mv_data = static_cast<void*>(arr.data());
+
+    int rc = mdb_put(m_txn, m_dbi, &key, &val, flags);
+    if (isMapFull(rc)) {
+        return;
+    }
+    Q_ASSERT_X(rc == 0, "TermFrequencyDB::put", mdb_strerror(rc));
+}
+
+QVector<quint32> TermFrequencyDB::get(const QByteArray& term)
+{
+    Q_ASSERT(!term.isEmpty());
+
+    MDB_val key;
+    key.mv_size = term.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(term.constData()));
+
+    MDB_val val;
+    int rc = mdb_get(m_txn, m_dbi, &key, &val);
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+        return QVector<quint32>();
+    }
+    Q_ASSERT_X(rc == 0, "TermFrequencyDB::get", mdb_strerror(rc));
+
+    QByteArray arr = QByteArray::fromRawData(static_cast<char*>(val.mv_data), val.mv_size);
+
+    FrequencyCodec codec;
+    return codec.decode(arr);
+}
+
+QByteArray TermFrequencyDB::getEncoded(const QByteArray& term)
+{
+    Q_ASSERT(!term.isEmpty());
+
+    MDB_val key;
+    key.mv_size = term.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(term.constData()));
+
+    MDB_val val;
+    int rc = mdb_get(m_txn, m_dbi, &key, &val);
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+        return QByteArray();
+    }
+    Q_ASSERT_X(rc == 0, "TermFrequencyDB::getEncoded", mdb_strerror(rc));
+
+    return QByteArray::fromRawData(static_cast<char*>(val.mv_data), val.mv_size);
+}
+
+quint32 TermFrequencyDB::maxFrequency(const QByteArray& term)
+{
+    Q_ASSERT(!term.isEmpty());
+
+    MDB_val key;
+    key.mv_size = term.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(term.constData()));
+
+    MDB_val val;
+    int rc = mdb_get(m_txn, m_dbi, &key, &val);
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+        return 0;
+    }
+    Q_ASSERT_X(rc == 0, "TermFrequencyDB::maxFrequency", mdb_strerror(rc));
+
+    QByteArray arr = QByteArray::fromRawData(static_cast<char*>(val.mv_data), val.mv_size);
+
+    FrequencyCodec codec;
+    return codec.maxFrequency(arr);
+}
+
+void TermFrequencyDB::del(const QByteArray& term)
+{
+    Q_ASSERT(!term.isEmpty());
+
+    MDB_val key;
+    key.mv_size = term.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(term.constData()));
+
+    int rc = mdb_del(m_txn, m_dbi, &key, 0);
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+        return;
+    }
+    Q_ASSERT_X(rc == 0, "TermFrequencyDB::del", mdb_strerror(rc));
+}
+
+QMap<QByteArray, QVector<quint32>> TermFrequencyDB::toTestMap() const
+{
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    MDB_val key = {0, 0};
+    MDB_val val;
+
+    QMap<QByteArray, QVector<quint32>> map;
+    while (1) {
+        int rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+            break;
+        }
+        Q_ASSERT_X(rc == 0, "TermFrequencyDB::toTestMap", mdb_strerror(rc));
+
+        const QByteArray ba(static_cast<char*>(key.mv_data), key.mv_size);
+        const QVector<quint32> list = FrequencyCodec().decode(QByteArray(static_cast<char*>(val.mv_data), val.mv_size));
+        map.insert(ba, list);
+    }
+
+    mdb_cursor_close(cursor);
+    return map;
+}
@@ -0,0 +1,70 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_TERMFREQUENCYDB_H
+#define BALOO_TERMFREQUENCYDB_H
+
+#include "engine_export.h"
+
+#include <QByteArray>
+#include <QVector>
+#include <QMap>
+
+#include <lmdb.h>
+
+namespace Baloo {
+
+/**
+ * The TermFrequencyDB maps <term> -> <wdf1> <wdf2> <wdf3> ...
+ *
+ * The frequencies are stored in the same order as the ids of the
+ * term in the PostingDB, so both lists need to be updated together.
+ */
+class BALOO_ENGINE_EXPORT TermFrequencyDB
+{
+public:
+    TermFrequencyDB(MDB_dbi dbi, MDB_txn* txn);
+    ~TermFrequencyDB();
+
+    static MDB_dbi create(MDB_txn* txn);
+    static MDB_dbi open(MDB_txn* txn);
+
+    void put(const QByteArray& term, const QVector<quint32>& list, uint flags = 0);
+    QVector<quint32> get(const QByteArray& term);
+    void del(const QByteArray& term);
+
+    /**
+     * Returns the encoded frequencies of \p term, see PostingDB::getEncoded
+     */
+    QByteArray getEncoded(const QByteArray& term);
+
+    /**
+     * Returns the largest frequency the \p term has in any document
+     */
+    quint32 maxFrequency(const QByteArray& term);
+
+    QMap<QByteArray, QVector<quint32>> toTestMap() const;
+private:
+    MDB_txn* m_txn;
+    MDB_dbi m_dbi;
+};
+
+}
+
+#endif // BALOO_TERMFREQUENCYDB_H
@@ -55,24 +55,7 @@ QStringList TermGenerator::termList(const QString& text_)
         else if (bf.boundaryReasons() & QTextBoundaryFinder::EndOfItem) {
             end = bf.position();
 
-            QString str = text.mid(start, end - start);
-
-            // Get the string ready for saving
-            str = str.toLower();
-
-            // Remove all accents
-            const QString denormalized = str.normalized(QString::NormalizationForm_KD);
-
-            QString cleanString;
-            cleanString.reserve(denormalized.size());
-            Q_FOREACH (const QChar& ch, denormalized) {
-                auto cat = ch.category();
-                if (cat != QChar::Mark_NonSpacing && cat != QChar::Mark_SpacingCombining && cat != QChar::Mark_Enclosing) {
-                    cleanString.append(ch);
-                }
-            }
-
-            str = cleanString.normalized(QString::NormalizationForm_KC);
+            const QString str = normalize(text.mid(start, end - start));
             if (!str.isEmpty()) {
                 list << str;
             }
@@ -82,6 +65,26 @@ QStringList TermGenerator::termList(const QString& text_)
     return list;
 }
 
+QString TermGenerator::normalize(const QString& text)
+{
+    // Get the string ready for saving
+    const QString str = text.toLower();
+
+    // Remove all accents
+    const QString denormalized = str.normalized(QString::NormalizationForm_KD);
+
+    QString cleanString;
+    cleanString.reserve(denormalized.size());
+    Q_FOREACH (const QChar& ch, denormalized) {
+        auto cat = ch.category();
+        if (cat != QChar::Mark_NonSpacing && cat != QChar::Mark_SpacingCombining && cat != QChar::Mark_Enclosing) {
+            cleanString.append(ch);
+        }
+    }
+
+    return cleanString.normalized(QString::NormalizationForm_KC);
+}
+
 void TermGenerator::indexText(const QString& text, const QByteArray& prefix, int wdfInc)
 {
     QStringList terms = termList(text);
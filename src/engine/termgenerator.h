@@ -49,6 +49,11 @@ public:
 
     static QStringList termList(const QString& text);
 
+    /**
+     * Lower cases \p text and removes its accents, as is done for each term
+     */
+    static QString normalize(const QString& text);
+
     // Trim all terms to this size
     const static int maxTermSize = 25;
 private:
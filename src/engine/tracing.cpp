@@ -0,0 +1,140 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "tracing.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QMutexLocker>
+#include <QThread>
+#include <QVariantMap>
+
+using namespace Baloo;
+
+Tracer::Tracer()
+    : m_next(0)
+{
+    m_events.reserve(Capacity);
+    m_epoch = QDateTime::currentMSecsSinceEpoch() * 1000;
+    m_timer.start();
+}
+
+Tracer* Tracer::instance()
+{
+    static Tracer tracer;
+    return &tracer;
+}
+
+qint64 Tracer::now() const
+{
+    return m_epoch + m_timer.nsecsElapsed() / 1000;
+}
+
+void Tracer::record(const QByteArray& category, const QByteArray& name, qint64 start, qint64 duration)
+{
+    Event event;
+    event.category = category;
+    event.name = name;
+    event.start = start;
+    event.duration = duration;
+    event.pid = QCoreApplication::applicationPid();
+    event.tid = reinterpret_cast<quintptr>(QThread::currentThreadId());
+
+    append(event);
+}
+
+void Tracer::append(const Event& event)
+{
+    QMutexLocker lock(&m_mutex);
+
+    if (m_events.size() < Capacity) {
+        m_events.append(event);
+    } else {
+        m_events[m_next] = event;
+    }
+    m_next = (m_next + 1) % Capacity;
+}
+
+QVariantList Tracer::events() const
+{
+    QMutexLocker lock(&m_mutex);
+
+    QVariantList list;
+    list.reserve(m_events.size());
+
+    // Once the buffer is full, the oldest event is the next one to be overwritten
+    const int first = m_events.size() < Capacity ? 0 : m_next;
+    for (int i = 0; i < m_events.size(); i++) {
+        const Event& event = m_events[(first + i) % m_events.size()];
+
+        QVariantMap map;
+        map.insert(QStringLiteral("cat"), QString::fromUtf8(event.category));
+        map.insert(QStringLiteral("name"), QString::fromUtf8(event.name));
+        map.insert(QStringLiteral("ph"), QStringLiteral("X"));
+        map.insert(QStringLiteral("ts"), event.start);
+        map.insert(QStringLiteral("dur"), event.duration);
+        map.insert(QStringLiteral("pid"), event.pid);
+        map.insert(QStringLiteral("tid"), event.tid);
+        list << map;
+    }
+
+    return list;
+}
+
+void Tracer::merge(const QVariantList& events)
+{
+    for (const QVariant& var : events) {
+        const QVariantMap map = var.toMap();
+
+        Event event;
+        event.category = map.value(QStringLiteral("cat")).toString().toUtf8();
+        event.name = map.value(QStringLiteral("name")).toString().toUtf8();
+        event.start = map.value(QStringLiteral("ts")).toLongLong();
+        event.duration = map.value(QStringLiteral("dur")).toLongLong();
+        event.pid = map.value(QStringLiteral("pid")).toLongLong();
+        event.tid = map.value(QStringLiteral("tid")).toULongLong();
+
+        append(event);
+    }
+}
+
+void Tracer::clear()
+{
+    QMutexLocker lock(&m_mutex);
+
+    m_events.clear();
+    m_next = 0;
+}
+
+TraceSpan::TraceSpan(const char* category, const char* name)
+    : m_category(category)
+    , m_name(name)
+    , m_start(Tracer::instance()->now())
+{
+}
+
+TraceSpan::~TraceSpan()
+{
+    Tracer* tracer = Tracer::instance();
+
+    // The names are literals, which do not need to be copied
+    tracer->record(QByteArray::fromRawData(m_category, qstrlen(m_category)),
+                   QByteArray::fromRawData(m_name, qstrlen(m_name)),
+                   m_start, tracer->now() - m_start);
+}
@@ -0,0 +1,123 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_TRACING_H
+#define BALOO_TRACING_H
+
+#include "engine_export.h"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QVariantList>
+#include <QVector>
+
+namespace Baloo {
+
+/**
+ * Keeps the last spans of work done by this process in a ring buffer,
+ * so that they can be exported in the trace event format of
+ * chrome://tracing and Perfetto.
+ *
+ * The spans are recorded with BALOO_TRACE_SPAN, which does nothing
+ * unless Baloo is built with BALOO_ENABLE_TRACING.
+ */
+class BALOO_ENGINE_EXPORT Tracer
+{
+public:
+    static Tracer* instance();
+
+    /**
+     * Records a span which started \p start microseconds after the epoch
+     * and took \p duration microseconds on the current thread
+     */
+    void record(const QByteArray& category, const QByteArray& name, qint64 start, qint64 duration);
+
+    /**
+     * Returns the spans in the buffer as "X" trace events, oldest first
+     */
+    QVariantList events() const;
+
+    /**
+     * Adds the trace \p events of another process, as returned by
+     * events(), to the buffer
+     */
+    void merge(const QVariantList& events);
+
+    void clear();
+
+    /**
+     * Returns the number of microseconds since the epoch, which is used
+     * so that the spans of different processes line up
+     */
+    qint64 now() const;
+
+    enum {
+        Capacity = 16384
+    };
+
+private:
+    Tracer();
+    Tracer(const Tracer&) = delete;
+
+    struct Event {
+        QByteArray category;
+        QByteArray name;
+        qint64 start;
+        qint64 duration;
+        qint64 pid;
+        quint64 tid;
+    };
+
+    void append(const Event& event);
+
+    mutable QMutex m_mutex;
+    QVector<Event> m_events;
+    int m_next;
+
+    qint64 m_epoch;
+    QElapsedTimer m_timer;
+};
+
+/**
+ * Records the time from its construction to its destruction as a span
+ */
+class BALOO_ENGINE_EXPORT TraceSpan
+{
+public:
+    TraceSpan(const char* category, const char* name);
+    ~TraceSpan();
+
+private:
+    const char* m_category;
+    const char* m_name;
+    qint64 m_start;
+};
+
+}
+
+#ifdef BALOO_ENABLE_TRACING
+#define BALOO_TRACE_CONCAT_(a, b) a##b
+#define BALOO_TRACE_CONCAT(a, b) BALOO_TRACE_CONCAT_(a, b)
+#define BALOO_TRACE_SPAN(category, name) Baloo::TraceSpan BALOO_TRACE_CONCAT(traceSpan, __LINE__)(category, name)
+#else
+#define BALOO_TRACE_SPAN(category, name) do {} while (0)
+#endif
+
+#endif // BALOO_TRACING_H
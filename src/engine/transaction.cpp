@@ -26,31 +26,65 @@
 #include "positiondb.h"
 #include "documentdatadb.h"
 #include "mtimedb.h"
+#include "termfrequencydb.h"
+#include "documentlengthdb.h"
+#include "documentpropertydb.h"
+#include "prefixdb.h"
+#include "trigramdb.h"
+#include "idfilenamedb.h"
+#include "documentdatacodec.h"
 
 #include "document.h"
 #include "enginequery.h"
 
 #include "andpostingiterator.h"
+#include "andnotpostingiterator.h"
 #include "orpostingiterator.h"
 #include "phraseanditerator.h"
+#include "frequencypostingiterator.h"
+#include "wandranker.h"
+#include "queryprofile.h"
+#include "metrics.h"
+#include "mapfull.h"
 
 #include "writetransaction.h"
 #include "idutils.h"
 #include "database.h"
 #include "databasesize.h"
 
+#include <QDateTime>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
 
+#include <algorithm>
+
 using namespace Baloo;
 
 Transaction::Transaction(const Database& db, Transaction::TransactionType type)
-    : m_dbis(db.m_dbis)
-    , m_env(db.m_env)
+    : m_db(db)
+    , m_dbis(db.m_dbis)
+    , m_env(0)
     , m_writeTrans(0)
+    , m_profile(0)
 {
-    uint flags = type == ReadOnly ? MDB_RDONLY : 0;
-    int rc = mdb_txn_begin(db.m_env, NULL, flags, &m_txn);
+    // The environment may be reopened until then, see Database::compact
+    db.registerTransaction();
+    m_env = db.m_env;
+
+    int rc = type == ReadOnly ? db.beginReadTransaction(&m_txn) : mdb_txn_begin(m_env, NULL, 0, &m_txn);
+    if (rc == MDB_MAP_RESIZED) {
+        // Another process has grown the map, so adopt its size. This one
+        // must not count as open meanwhile, or it would wait for itself.
+        db.unregisterTransaction();
+        const bool adopted = db.adoptMapSize();
+        db.registerTransaction();
+        m_env = db.m_env;
+
+        if (adopted) {
+            rc = type == ReadOnly ? db.beginReadTransaction(&m_txn) : mdb_txn_begin(m_env, NULL, 0, &m_txn);
+        }
+    }
     Q_ASSERT_X(rc == 0, "Transaction", mdb_strerror(rc));
 
     if (type == ReadWrite) {
@@ -160,6 +194,32 @@ QVector<quint64> Transaction::fetchPhaseOneIds(int size) const
     return contentIndexingDb.fetchItems(size);
 }
 
+quint32 Transaction::documentLength(quint64 id) const
+{
+    Q_ASSERT(m_txn);
+    Q_ASSERT(id > 0);
+
+    DocumentLengthDB docLengthDb(m_dbis.docLengthDbi, m_txn);
+    return docLengthDb.get(id);
+}
+
+bool Transaction::documentProperty(quint64 id, quint32 property, qint64* value) const
+{
+    Q_ASSERT(m_txn);
+    Q_ASSERT(id > 0);
+
+    DocumentPropertyDB docPropertyDb(m_dbis.docPropertyDbi, m_txn);
+    return docPropertyDb.get(property, id, value);
+}
+
+QVector<QPair<quint64, qint64> > Transaction::propertyValues(quint32 property, const QVector<quint64>& ids) const
+{
+    Q_ASSERT(m_txn);
+
+    DocumentPropertyDB docPropertyDb(m_dbis.docPropertyDbi, m_txn);
+    return docPropertyDb.values(property, ids);
+}
+
 QVector<QByteArray> Transaction::fetchTermsStartingWith(const QByteArray& term) const
 {
     Q_ASSERT(term.size() > 0);
@@ -168,6 +228,15 @@ QVector<QByteArray> Transaction::fetchTermsStartingWith(const QByteArray& term)
     return postingDb.fetchTermsStartingWith(term);
 }
 
+quint64 Transaction::generation() const
+{
+    Q_ASSERT(m_txn);
+
+    // For read transactions this is the id of the snapshot. The ids of a
+    // compacted index start over, so those of an earlier epoch come first.
+    return (m_db.m_epoch << 48) | mdb_txn_id(m_txn);
+}
+
 uint Transaction::phaseOneSize() const
 {
     Q_ASSERT(m_txn);
@@ -184,9 +253,48 @@ uint Transaction::size() const
     return docTermsDb.size();
 }
 
+bool Transaction::isEmpty() const
+{
+    Q_ASSERT(m_txn);
+
+    for (MDB_dbi dbi : m_dbis.all()) {
+        // The optional databases which were not opened
+        if (!dbi) {
+            continue;
+        }
+
+        MDB_stat stat;
+        int rc = mdb_stat(m_txn, dbi, &stat);
+        Q_ASSERT_X(rc == 0, "Transaction::isEmpty", mdb_strerror(rc));
+        if (rc || stat.ms_entries) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 //
 // Write Operations
 //
+void Transaction::clear()
+{
+    Q_ASSERT(m_txn);
+    Q_ASSERT(m_writeTrans);
+
+    for (MDB_dbi dbi : m_dbis.all()) {
+        if (!dbi) {
+            continue;
+        }
+
+        int rc = mdb_drop(m_txn, dbi, 0);
+        if (isMapFull(rc)) {
+            return;
+        }
+        Q_ASSERT_X(rc == 0, "Transaction::clear", mdb_strerror(rc));
+    }
+}
+
 void Transaction::setPhaseOne(quint64 id)
 {
     Q_ASSERT(m_txn);
@@ -249,42 +357,165 @@ void Transaction::replaceDocument(const Document& doc, DocumentOperations operat
     Q_ASSERT(m_txn);
     Q_ASSERT(doc.id() > 0);
     Q_ASSERT(m_writeTrans);
-    Q_ASSERT_X(hasDocument(doc.id()), "Transaction::replaceDocument", "Document does not exist");
 
+    Q_ASSERT_X(hasDocument(doc.id()), "Transaction::replaceDocument", "Document does not exist");
     m_writeTrans->replaceDocument(doc, operations);
 }
 
-void Transaction::commit()
+quint64 Transaction::convertDocumentData(quint64 lastId, int size)
 {
     Q_ASSERT(m_txn);
     Q_ASSERT(m_writeTrans);
 
-    m_writeTrans->commit();
-    delete m_writeTrans;
-    m_writeTrans = 0;
+    DocumentDataDB docDataDb(m_dbis.docDataDbi, m_txn);
+    const QMap<quint64, QByteArray> items = docDataDb.fetchItems(lastId, size);
+
+    DocumentDataCodec codec;
+    for (auto it = items.constBegin(); it != items.constEnd(); ++it) {
+        if (DocumentDataCodec::isLegacy(it.value())) {
+            docDataDb.put(it.key(), codec.encode(codec.decode(it.value())));
+        }
+    }
 
-    int rc = mdb_txn_commit(m_txn);
-    Q_ASSERT_X(rc == 0, "Transaction::commit", mdb_strerror(rc));
+    return items.isEmpty() ? 0 : items.lastKey();
+}
 
-    m_txn = 0;
+int Transaction::commit()
+{
+    Q_ASSERT(m_txn);
+    Q_ASSERT(m_writeTrans);
+
+    Metrics* metrics = Metrics::instance();
+    static MetricsHistogram* commitTime = metrics->histogram(QStringLiteral("transaction.commit.usecs"));
+    static MetricsHistogram* commitBytes = metrics->histogram(QStringLiteral("transaction.commit.bytes"));
+    MetricsTimer timer(commitTime);
+
+    // When the map is full LMDB refuses to do anything more with the
+    // transaction, so it is dropped, and the caller makes the changes
+    // again once the map has been grown
+    quint64 bytes = 0;
+    int rc = finishWrite(&bytes);
+    resetMapFull();
+    Q_ASSERT_X(rc == 0 || rc == MDB_MAP_FULL, "Transaction::commit", mdb_strerror(rc));
+
+    // Counted by each transaction, as the shards are written in parallel
+    if (rc == 0) {
+        commitBytes->record(bytes);
+    }
+    return rc;
 }
 
 void Transaction::abort()
 {
     Q_ASSERT(m_txn);
 
-    mdb_txn_abort(m_txn);
+    // Read transactions are kept around to be renewed, see Database::beginReadTransaction
+    if (m_writeTrans) {
+        mdb_txn_abort(m_txn);
+    } else {
+        m_db.endReadTransaction(m_txn);
+    }
     m_txn = 0;
+    m_db.unregisterTransaction();
+
+    if (m_writeTrans) {
+        resetMapFull();
+    }
+    delete m_writeTrans;
+    m_writeTrans = 0;
+}
 
+bool Transaction::isRebuilding() const
+{
+    Q_ASSERT(m_txn);
+
+    return (m_dbis.prefixDbi && PrefixDB(m_dbis.prefixDbi, m_txn).isRebuilding())
+        || (m_dbis.trigramDbi && TrigramDB(m_dbis.trigramDbi, m_txn).isRebuilding());
+}
+
+void Transaction::continueRebuild()
+{
+    Q_ASSERT(m_txn);
+    Q_ASSERT(m_writeTrans);
+
+    // The batch starts from the position recorded in the database, so the
+    // same one is written again if the map has to be grown, see Database::write
+    if (m_dbis.prefixDbi) {
+        PrefixDB(m_dbis.prefixDbi, m_txn).continueRebuild(m_dbis.postingDbi, 10000);
+    }
+    if (m_dbis.trigramDbi) {
+        TrigramDB(m_dbis.trigramDbi, m_txn).continueRebuild(m_dbis.idFilenameDbi, m_dbis.docTimeDbi, 100000);
+    }
+}
+
+int Transaction::finishWrite(quint64* bytes)
+{
+    int rc = MDB_MAP_FULL;
+    if (!mapFullOccurred()) {
+        m_writeTrans->commit();
+    }
+    *bytes = m_writeTrans->bytesWritten();
     delete m_writeTrans;
     m_writeTrans = 0;
+
+    // A failed commit frees the transaction as well
+    if (mapFullOccurred()) {
+        mdb_txn_abort(m_txn);
+    } else {
+        rc = mdb_txn_commit(m_txn);
+    }
+    m_txn = 0;
+    m_db.unregisterTransaction();
+
+    return rc;
 }
 
 //
 // Queries
 //
 
+void Transaction::setProfile(QueryProfile* profile)
+{
+    m_profile = profile;
+}
+
+PostingIterator* Transaction::profiled(PostingIterator* it, const QString& name) const
+{
+    if (!m_profile || !it) {
+        return it;
+    }
+
+    return m_profile->wrap(it, name, it->estimateSize(size()));
+}
+
+namespace {
+QString profileName(const EngineQuery& query)
+{
+    switch (query.op()) {
+    case EngineQuery::Equal:
+        return QString::fromUtf8(query.term());
+    case EngineQuery::StartsWith:
+        return QString::fromUtf8(query.term()) + QLatin1Char('*');
+    case EngineQuery::And:
+        return QStringLiteral("AND");
+    case EngineQuery::Or:
+        return QStringLiteral("OR");
+    case EngineQuery::Phrase:
+        return QStringLiteral("PHRASE");
+    case EngineQuery::Not:
+        return QStringLiteral("NOT");
+    }
+    return QString();
+}
+}
+
 PostingIterator* Transaction::postingIterator(const EngineQuery& query) const
+{
+    PostingIterator* it = buildPostingIterator(query);
+    return m_profile ? profiled(it, profileName(query)) : it;
+}
+
+PostingIterator* Transaction::buildPostingIterator(const EngineQuery& query) const
 {
     PostingDB postingDb(m_dbis.postingDbi, m_txn);
     PositionDB positionDb(m_dbis.positionDBi, m_txn);
@@ -293,6 +524,15 @@ PostingIterator* Transaction::postingIterator(const EngineQuery& query) const
         if (query.op() == EngineQuery::Equal) {
             return postingDb.iter(query.term());
         } else if (query.op() == EngineQuery::StartsWith) {
+            // The short prefixes match the most terms, their union is stored
+            if (m_dbis.prefixDbi && PrefixDB::contains(query.term())) {
+                PrefixDB prefixDb(m_dbis.prefixDbi, m_txn);
+
+                // The unions are not complete until then
+                if (!prefixDb.isRebuilding()) {
+                    return prefixDb.iter(query.term());
+                }
+            }
             return postingDb.prefixIter(query.term());
         } else {
             Q_ASSERT(0);
@@ -303,24 +543,50 @@ PostingIterator* Transaction::postingIterator(const EngineQuery& query) const
         return 0;
     }
 
+    if (query.op() == EngineQuery::Not) {
+        Q_ASSERT(query.subQueries().size() == 1);
+
+        return new AndNotPostingIterator(allDocumentsIter(), {postingIterator(query.subQueries().first())});
+    }
+
     QVector<PostingIterator*> vec;
     vec.reserve(query.subQueries().size());
 
     if (query.op() == EngineQuery::Phrase) {
         for (const EngineQuery& q : query.subQueries()) {
             Q_ASSERT_X(q.leaf(), "Transaction::toPostingIterator", "Phrase queries must contain leaf queries");
-            vec << positionDb.iter(q.term());
+            vec << profiled(positionDb.iter(q.term()), profileName(q));
         }
 
         return new PhraseAndIterator(vec);
     }
 
+    // The negated sub queries only filter the results of the others, so
+    // that they are never read completely
+    QVector<PostingIterator*> excluded;
     for (const EngineQuery& q : query.subQueries()) {
-        vec << postingIterator(q);
+        if (query.op() == EngineQuery::And && q.op() == EngineQuery::Not) {
+            Q_ASSERT(q.subQueries().size() == 1);
+            excluded << postingIterator(q.subQueries().first());
+        } else {
+            vec << postingIterator(q);
+        }
     }
 
     if (query.op() == EngineQuery::And) {
-        return new AndPostingIterator(vec);
+        if (excluded.isEmpty()) {
+            return new AndPostingIterator(vec);
+        }
+
+        PostingIterator* it;
+        if (vec.isEmpty()) {
+            it = allDocumentsIter();
+        } else if (vec.size() == 1) {
+            it = vec.first();
+        } else {
+            it = new AndPostingIterator(vec);
+        }
+        return new AndNotPostingIterator(it, excluded);
     } else if (query.op() == EngineQuery::Or) {
         return new OrPostingIterator(vec);
     }
@@ -335,6 +601,12 @@ PostingIterator* Transaction::postingCompIterator(const QByteArray& prefix, cons
     return postingDb.compIter(prefix, value, com);
 }
 
+PostingIterator* Transaction::postingRangeIterator(const QByteArray& prefix, const QByteArray& lower, const QByteArray& upper) const
+{
+    PostingDB postingDb(m_dbis.postingDbi, m_txn);
+    return postingDb.rangeIter(prefix, lower, upper);
+}
+
 PostingIterator* Transaction::mTimeIter(quint32 mtime, MTimeDB::Comparator com) const
 {
     MTimeDB mTimeDb(m_dbis.mtimeDbi, m_txn);
@@ -353,6 +625,87 @@ PostingIterator* Transaction::docUrlIter(quint64 id) const
     return docUrlDb.iter(id);
 }
 
+namespace {
+// Leaves out the candidates of the TrigramDB whose name does not
+// contain the substring after all
+class FileNamePostingIterator : public PostingIterator
+{
+public:
+    FileNamePostingIterator(PostingIterator* candidates, const QByteArray& substring,
+                            MDB_dbi idFilenameDbi, MDB_txn* txn)
+        : m_candidates(candidates)
+        , m_substring(substring)
+        , m_idFilenameDb(idFilenameDbi, txn)
+        , m_docId(0)
+    {}
+
+    ~FileNamePostingIterator() {
+        delete m_candidates;
+    }
+
+    quint64 next() Q_DECL_OVERRIDE {
+        while (const quint64 id = m_candidates->next()) {
+            if (TrigramDB::normalize(m_idFilenameDb.get(id).name).contains(m_substring)) {
+                m_docId = id;
+                return id;
+            }
+        }
+
+        m_docId = 0;
+        return 0;
+    }
+
+    quint64 docId() const Q_DECL_OVERRIDE {
+        return m_docId;
+    }
+
+    uint estimateSize(uint totalDocuments) const Q_DECL_OVERRIDE {
+        return m_candidates->estimateSize(totalDocuments);
+    }
+
+    QVector<PostingIterator*> subIterators() const Q_DECL_OVERRIDE {
+        return {m_candidates};
+    }
+
+private:
+    PostingIterator* m_candidates;
+    QByteArray m_substring;
+    IdFilenameDB m_idFilenameDb;
+    quint64 m_docId;
+};
+}
+
+PostingIterator* Transaction::fileNameIter(const QString& substring) const
+{
+    Q_ASSERT(m_txn);
+
+    const QByteArray normalized = TrigramDB::normalize(substring.toUtf8());
+    if (!m_dbis.trigramDbi || normalized.size() < 3) {
+        return 0;
+    }
+
+    // The lists are not complete until then
+    TrigramDB trigramDb(m_dbis.trigramDbi, m_txn);
+    if (trigramDb.isRebuilding()) {
+        return 0;
+    }
+
+    PostingIterator* candidates = trigramDb.iter(normalized);
+    if (!candidates) {
+        return 0;
+    }
+
+    return new FileNamePostingIterator(candidates, normalized, m_dbis.idFilenameDbi, m_txn);
+}
+
+PostingIterator* Transaction::allDocumentsIter() const
+{
+    Q_ASSERT(m_txn);
+
+    DocumentDB documentTermsDB(m_dbis.docTermsDbi, m_txn);
+    return documentTermsDB.iter();
+}
+
 QVector<quint64> Transaction::exec(const EngineQuery& query, int limit) const
 {
     Q_ASSERT(m_txn);
@@ -371,6 +724,228 @@ QVector<quint64> Transaction::exec(const EngineQuery& query, int limit) const
     return results;
 }
 
+static void collectTerms(const EngineQuery& query, PostingDB& postingDb, QSet<QByteArray>& terms)
+{
+    if (query.leaf()) {
+        if (query.op() == EngineQuery::StartsWith) {
+            for (const QByteArray& term : postingDb.fetchTermsStartingWith(query.term())) {
+                terms << term;
+            }
+        } else {
+            terms << query.term();
+        }
+        return;
+    }
+
+    // The documents with these terms are not returned at all
+    if (query.op() == EngineQuery::Not) {
+        return;
+    }
+
+    for (const EngineQuery& q : query.subQueries()) {
+        collectTerms(q, postingDb, terms);
+    }
+}
+
+QVector<quint64> Transaction::execRanked(const EngineQuery& query, PostingIterator* filter, int limit) const
+{
+    Q_ASSERT(m_txn);
+
+    PostingDB postingDb(m_dbis.postingDbi, m_txn);
+    TermFrequencyDB termFrequencyDb(m_dbis.termFrequencyDbi, m_txn);
+    DocumentLengthDB docLengthDb(m_dbis.docLengthDbi, m_txn);
+
+    QSet<QByteArray> terms;
+    collectTerms(query, postingDb, terms);
+
+    WandRanker ranker(docLengthDb.count(), docLengthDb.averageLength(), [&docLengthDb](quint64 id) {
+        return docLengthDb.get(id);
+    });
+
+    // A prefix can expand to many terms, most of which have few documents
+    // that are ever scored. So their lists are only decoded as needed.
+    for (const QByteArray& term : terms) {
+        const QByteArray ids = postingDb.getEncoded(term);
+        if (ids.isEmpty()) {
+            continue;
+        }
+
+        FrequencyPostingIterator* it = new FrequencyPostingIterator(ids, termFrequencyDb.getEncoded(term));
+        ranker.addTerm(it, it->size());
+    }
+
+    return ranker.topK(limit, filter);
+}
+
+static bool matches(const QVector<QByteArray>& terms, const EngineQuery& query)
+{
+    if (query.leaf()) {
+        auto it = std::lower_bound(terms.constBegin(), terms.constEnd(), query.term());
+        if (it == terms.constEnd()) {
+            return false;
+        }
+
+        if (query.op() == EngineQuery::StartsWith) {
+            return it->startsWith(query.term());
+        }
+        return *it == query.term();
+    }
+
+    Q_ASSERT_X(query.op() != EngineQuery::Phrase, "Transaction::filter", "Phrase queries are not supported");
+
+    const QVector<EngineQuery> subQueries = query.subQueries();
+    if (query.op() == EngineQuery::Not) {
+        Q_ASSERT(subQueries.size() == 1);
+        return !matches(terms, subQueries.first());
+    }
+
+    if (query.op() == EngineQuery::Or) {
+        for (const EngineQuery& q : subQueries) {
+            if (matches(terms, q)) {
+                return true;
+            }
+        }
+        return subQueries.isEmpty();
+    }
+
+    for (const EngineQuery& q : subQueries) {
+        if (!matches(terms, q)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QVector<quint64> Transaction::filter(const QVector<quint64>& ids, const EngineQuery& query) const
+{
+    Q_ASSERT(m_txn);
+
+    DocumentDB documentTermsDB(m_dbis.docTermsDbi, m_txn);
+    DocumentDB documentFileNameTermsDB(m_dbis.docFilenameTermsDbi, m_txn);
+    DocumentDB documentXattrTermsDB(m_dbis.docXattrTermsDbi, m_txn);
+
+    QVector<quint64> results;
+    for (quint64 id : ids) {
+        QVector<QByteArray> terms = documentTermsDB.get(id);
+        terms << documentFileNameTermsDB.get(id);
+        terms << documentXattrTermsDB.get(id);
+        std::sort(terms.begin(), terms.end());
+
+        if (matches(terms, query)) {
+            results << id;
+        }
+    }
+
+    return results;
+}
+
+// Counts the ids which are in both sorted lists. Every id of the shorter
+// list is looked up in the longer one by galloping ahead of the last match.
+static uint intersectionSize(const QVector<quint64>& first, const QVector<quint64>& second)
+{
+    const QVector<quint64>& shorter = first.size() <= second.size() ? first : second;
+    const QVector<quint64>& longer = first.size() <= second.size() ? second : first;
+
+    uint count = 0;
+    auto begin = longer.constBegin();
+    const auto end = longer.constEnd();
+    for (quint64 id : shorter) {
+        int step = 1;
+        auto bound = begin;
+        while (bound != end && *bound < id) {
+            begin = bound;
+            bound = (end - bound > step) ? bound + step : end;
+            step *= 2;
+        }
+
+        begin = std::lower_bound(begin, bound, id);
+        if (begin == end) {
+            break;
+        }
+        if (*begin == id) {
+            count++;
+            ++begin;
+        }
+    }
+
+    return count;
+}
+
+QMap<QByteArray, uint> Transaction::termCounts(const QVector<quint64>& ids, const QVector<QByteArray>& terms,
+                                               int msecs, bool* complete) const
+{
+    Q_ASSERT(m_txn);
+    Q_ASSERT(std::is_sorted(ids.begin(), ids.end()));
+
+    if (complete) {
+        *complete = true;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    PostingDB postingDb(m_dbis.postingDbi, m_txn);
+
+    QMap<QByteArray, uint> counts;
+    for (const QByteArray& term : terms) {
+        if (msecs >= 0 && timer.elapsed() >= msecs) {
+            if (complete) {
+                *complete = false;
+            }
+            break;
+        }
+
+        const uint count = intersectionSize(ids, postingDb.get(term));
+        if (count) {
+            counts.insert(term, count);
+        }
+    }
+
+    return counts;
+}
+
+QMap<int, uint> Transaction::yearCounts(const QVector<quint64>& ids, int msecs, bool* complete) const
+{
+    Q_ASSERT(m_txn);
+
+    if (complete) {
+        *complete = true;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    DocumentTimeDB docTimeDb(m_dbis.docTimeDbi, m_txn);
+
+    // Most files are from the same few years, so avoid converting
+    // each time into a date
+    int year = 0;
+    quint32 yearBegin = 1;
+    quint32 yearEnd = 0;
+
+    QMap<int, uint> counts;
+    for (int i = 0; i < ids.size(); i++) {
+        // Checking the clock for every id would be too costly
+        if (msecs >= 0 && (i % 1024) == 1023 && timer.elapsed() >= msecs) {
+            if (complete) {
+                *complete = false;
+            }
+            break;
+        }
+
+        const quint32 mtime = docTimeDb.get(ids[i]).mTime;
+        if (mtime < yearBegin || mtime > yearEnd) {
+            const QDate date = QDateTime::fromTime_t(mtime).date();
+            year = date.year();
+            yearBegin = QDateTime(QDate(year, 1, 1)).toTime_t();
+            yearEnd = QDateTime(QDate(year + 1, 1, 1)).toTime_t() - 1;
+        }
+        counts[year]++;
+    }
+
+    return counts;
+}
+
 //
 // Introspection
 //
@@ -430,9 +1005,17 @@ DatabaseSize Transaction::dbSize()
 
     dbSize.mtimeDb = dbiSize(m_txn, m_dbis.mtimeDbi);
 
-    dbSize.expectedSize = dbSize.positionDb + dbSize.positionDb + dbSize.docTerms + dbSize.docFilenameTerms
+    dbSize.termFrequencyDb = dbiSize(m_txn, m_dbis.termFrequencyDbi);
+    dbSize.docLength = dbiSize(m_txn, m_dbis.docLengthDbi);
+    dbSize.docProperty = dbiSize(m_txn, m_dbis.docPropertyDbi);
+    dbSize.prefixDb = m_dbis.prefixDbi ? dbiSize(m_txn, m_dbis.prefixDbi) : 0;
+    dbSize.trigramDb = m_dbis.trigramDbi ? dbiSize(m_txn, m_dbis.trigramDbi) : 0;
+
+    dbSize.expectedSize = dbSize.postingDb + dbSize.positionDb + dbSize.docTerms + dbSize.docFilenameTerms
                   + dbSize.docXattrTerms + dbSize.idTree + dbSize.idFilename + dbSize.docTime
-                  + dbSize.docData + dbSize.contentIndexingIds + dbSize.failedIds + dbSize.mtimeDb;
+                  + dbSize.docData + dbSize.contentIndexingIds + dbSize.failedIds + dbSize.mtimeDb
+                  + dbSize.termFrequencyDb + dbSize.docLength + dbSize.docProperty + dbSize.prefixDb
+                  + dbSize.trigramDb;
 
     MDB_envinfo info;
     mdb_env_info(m_env, &info);
@@ -28,6 +28,9 @@
 #include "documenttimedb.h"
 
 #include <QString>
+#include <QMap>
+#include <QPair>
+#include <QVector>
 #include <lmdb.h>
 
 namespace Baloo {
@@ -38,6 +41,7 @@ class PostingIterator;
 class EngineQuery;
 class DatabaseSize;
 class DBState;
+class QueryProfile;
 
 class BALOO_ENGINE_EXPORT Transaction
 {
@@ -66,21 +70,121 @@ public:
     QByteArray documentData(quint64 id) const;
 
     DocumentTimeDB::TimeInfo documentTimeInfo(quint64 id) const;
+    quint32 documentLength(quint64 id) const;
+
+    /**
+     * Returns false if the document \p id has no value for the numeric,
+     * date or time \p property. See DocumentPropertyDB.
+     */
+    bool documentProperty(quint64 id, quint32 property, qint64* value) const;
+
+    /**
+     * Returns the id and the value of \p property of each of the \p ids
+     * which have one, without reading the document data. The \p ids need
+     * to be sorted.
+     */
+    QVector<QPair<quint64, qint64> > propertyValues(quint32 property, const QVector<quint64>& ids) const;
 
     QVector<quint64> exec(const EngineQuery& query, int limit = -1) const;
 
+    /**
+     * Returns the ids of the documents which best match the terms in \p query,
+     * ranked by BM25 with the best match first. Only the terms of \p query are
+     * considered, its structure is ignored.
+     *
+     * If a \p filter is given, only the documents matched by it are returned,
+     * including the ones which do not contain any of the terms. The filter
+     * is not deleted.
+     */
+    QVector<quint64> execRanked(const EngineQuery& query, PostingIterator* filter = 0, int limit = -1) const;
+
+    /**
+     * Returns the documents from \p ids which match the \p query. This only
+     * looks at the terms of each of the documents, so it is only worth using
+     * when there are few ids compared to the size of the index.
+     *
+     * Phrase queries are not supported.
+     */
+    QVector<quint64> filter(const QVector<quint64>& ids, const EngineQuery& query) const;
+
+    /**
+     * Returns how many of the \p ids are in the posting list of each of
+     * the \p terms. The \p ids need to be sorted. Terms which have none
+     * of the \p ids are left out.
+     *
+     * If \p msecs is not negative, counting stops once it has taken about
+     * that long, and \p complete is set to false.
+     */
+    QMap<QByteArray, uint> termCounts(const QVector<quint64>& ids, const QVector<QByteArray>& terms,
+                                      int msecs = -1, bool* complete = 0) const;
+
+    /**
+     * Returns how many of the \p ids were last modified in each year,
+     * in local time. See termCounts for \p msecs and \p complete.
+     */
+    QMap<int, uint> yearCounts(const QVector<quint64>& ids, int msecs = -1, bool* complete = 0) const;
+
     PostingIterator* postingIterator(const EngineQuery& query) const;
+
+    /**
+     * Records the use of the iterators built by this transaction in
+     * \p profile, which is not owned. Profiling is off by default.
+     */
+    void setProfile(QueryProfile* profile);
+    bool isProfiling() const { return m_profile; }
+
+    /**
+     * Records the use of \p it under \p name if this transaction is being
+     * profiled, and returns \p it otherwise. See QueryProfile::wrap.
+     */
+    PostingIterator* profiled(PostingIterator* it, const QString& name) const;
+
     PostingIterator* postingCompIterator(const QByteArray& prefix, const QByteArray& value, PostingDB::Comparator com) const;
+    PostingIterator* postingRangeIterator(const QByteArray& prefix, const QByteArray& lower, const QByteArray& upper) const;
     PostingIterator* mTimeIter(quint32 mtime, MTimeDB::Comparator com) const;
     PostingIterator* mTimeRangeIter(quint32 beginTime, quint32 endTime) const;
     PostingIterator* docUrlIter(quint64 id) const;
 
+    /**
+     * Iterates over the documents whose file name contains \p substring,
+     * ignoring case and accents. Returns 0 if the index has no TrigramDB,
+     * it is still being rebuilt, or \p substring is shorter than three
+     * bytes.
+     */
+    PostingIterator* fileNameIter(const QString& substring) const;
+
+    /**
+     * Iterates over every document in the index. This is only needed for
+     * negated queries which are not restricted by anything else.
+     */
+    PostingIterator* allDocumentsIter() const;
+
     QVector<quint64> fetchPhaseOneIds(int size) const;
     uint phaseOneSize() const;
     uint size() const;
 
+    /**
+     * Returns true if none of the databases of the index have any entries,
+     * not even the ones a partially written document leaves behind
+     */
+    bool isEmpty() const;
+
+    /**
+     * Removes everything from all of the databases of the index
+     */
+    void clear();
+
     QVector<QByteArray> fetchTermsStartingWith(const QByteArray& term) const;
 
+    /**
+     * Returns the id of the snapshot of the index this transaction reads
+     * from. This changes whenever the index is modified, and never goes
+     * back, even when the index has been compacted and opened again.
+     * Another process which has not opened it again meanwhile then has
+     * other generations for the same snapshots.
+     */
+    quint64 generation() const;
+
     //
     // Introspecing document data
     //
@@ -93,10 +197,27 @@ public:
     //
     // Transaction handling
     //
-    void commit();
+
+    /**
+     * Returns MDB_MAP_FULL if the map ran out of space, in which case the
+     * changes were dropped, and 0 otherwise. See Database::write, which
+     * grows the map and makes the changes again.
+     */
+    int commit();
     void abort();
     bool hasChanges() const;
 
+    /**
+     * Returns true while the PrefixDB or the TrigramDB is being rebuilt,
+     * see Database::open
+     */
+    bool isRebuilding() const;
+
+    /**
+     * Rebuilds the next batch of the PrefixDB and of the TrigramDB
+     */
+    void continueRebuild();
+
     //
     // Write Methods
     //
@@ -114,6 +235,15 @@ public:
     }
 
     void replaceDocument(const Document& doc, DocumentOperations operations);
+
+    /**
+     * Converts the document data of up to \p size documents after the
+     * id \p lastId from the JSON of older indexes into the current
+     * format. Returns the last id looked at, or 0 once all the documents
+     * have been looked at. See DocumentDataCodec.
+     */
+    quint64 convertDocumentData(quint64 lastId, int size);
+
     void setPhaseOne(quint64 id);
     void removePhaseOne(quint64 id);
 
@@ -125,11 +255,23 @@ public:
 private:
     Transaction(const Transaction& rhs) = delete;
 
+    PostingIterator* buildPostingIterator(const EngineQuery& query) const;
+
+    /**
+     * Commits the transaction, or aborts it if the map became full. Returns
+     * the return code of the commit, which is MDB_MAP_FULL in the latter case.
+     * Sets \p bytes to the size of the posting and position lists written.
+     */
+    int finishWrite(quint64* bytes);
+
+    const Database& m_db;
     const DatabaseDbis& m_dbis;
     MDB_txn* m_txn;
     MDB_env* m_env;
     WriteTransaction* m_writeTrans;
+    QueryProfile* m_profile;
 
+    friend class IndexBuilder;
     friend class DBState; // for testing
 };
 }
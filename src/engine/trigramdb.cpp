@@ -0,0 +1,365 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "trigramdb.h"
+#include "mapfull.h"
+#include "idfilenamedb.h"
+#include "documenttimedb.h"
+#include "andpostingiterator.h"
+#include "vectorpostingiterator.h"
+#include "termgenerator.h"
+#include "postingcodec.h"
+#include "metrics.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <iterator>
+
+using namespace Baloo;
+
+TrigramDB::TrigramDB(MDB_dbi dbi, MDB_txn* txn)
+    : m_txn(txn)
+    , m_dbi(dbi)
+{
+    Q_ASSERT(txn != 0);
+    Q_ASSERT(dbi != 0);
+}
+
+TrigramDB::~TrigramDB()
+{
+}
+
+MDB_dbi TrigramDB::create(MDB_txn* txn)
+{
+    MDB_dbi dbi;
+    int rc = mdb_dbi_open(txn, "trigramdb", MDB_CREATE, &dbi);
+    Q_ASSERT_X(rc == 0, "TrigramDB::create", mdb_strerror(rc));
+
+    return dbi;
+}
+
+MDB_dbi TrigramDB::open(MDB_txn* txn)
+{
+    MDB_dbi dbi;
+    int rc = mdb_dbi_open(txn, "trigramdb", 0, &dbi);
+    if (rc == MDB_NOTFOUND) {
+        return 0;
+    }
+    Q_ASSERT_X(rc == 0, "TrigramDB::open", mdb_strerror(rc));
+
+    return dbi;
+}
+
+QByteArray TrigramDB::normalize(const QByteArray& name)
+{
+    return TermGenerator::normalize(QString::fromUtf8(name)).toUtf8();
+}
+
+QVector<QByteArray> TrigramDB::trigrams(const QByteArray& normalized)
+{
+    QVector<QByteArray> list;
+    list.reserve(qMax(normalized.size() - 2, 0));
+    for (int i = 0; i + 3 <= normalized.size(); i++) {
+        list << normalized.mid(i, 3);
+    }
+
+    std::sort(list.begin(), list.end());
+    list.erase(std::unique(list.begin(), list.end()), list.end());
+    return list;
+}
+
+void TrigramDB::put(const QByteArray& trigram, const PostingList& list, uint flags)
+{
+    Q_ASSERT(trigram.size() == 3);
+    Q_ASSERT(!list.isEmpty());
+
+    MDB_val key;
+    key.mv_size = trigram.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(trigram.constData()));
+
+    QByteArray arr = PostingCodec().encode(list);
+
+    MDB_val val;
+    val.mv_size = arr.size();
+    val.mv_data = static_cast<void*>(arr.data());
+
+    int rc = mdb_put(m_txn, m_dbi, &key, &val, flags);
+    if (isMapFull(rc)) {
+        return;
+    }
+    Q_ASSERT_X(rc == 0, "TrigramDB::put", mdb_strerror(rc));
+}
+
+PostingList TrigramDB::get(const QByteArray& trigram)
+{
+    Q_ASSERT(trigram.size() == 3);
+
+    MDB_val key;
+    key.mv_size = trigram.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(trigram.constData()));
+
+    MDB_val val;
+    int rc = mdb_get(m_txn, m_dbi, &key, &val);
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+        return PostingList();
+    }
+    Q_ASSERT_X(rc == 0, "TrigramDB::get", mdb_strerror(rc));
+
+    QByteArray arr = QByteArray::fromRawData(static_cast<char*>(val.mv_data), val.mv_size);
+    return PostingCodec().decode(arr);
+}
+
+void TrigramDB::del(const QByteArray& trigram)
+{
+    Q_ASSERT(trigram.size() == 3);
+
+    MDB_val key;
+    key.mv_size = trigram.size();
+    key.mv_data = static_cast<void*>(const_cast<char*>(trigram.constData()));
+
+    int rc = mdb_del(m_txn, m_dbi, &key, 0);
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+        return;
+    }
+    Q_ASSERT_X(rc == 0, "TrigramDB::del", mdb_strerror(rc));
+}
+
+void TrigramDB::update(const QByteArray& trigram, const QMap<quint64, int>& delta)
+{
+    const PostingList list = get(trigram);
+
+    // Both are sorted by id, so they are merged in a single pass
+    PostingList merged;
+    merged.reserve(list.size() + delta.size());
+
+    int i = 0;
+    auto it = delta.constBegin();
+    while (i < list.size() || it != delta.constEnd()) {
+        if (it == delta.constEnd() || (i < list.size() && list[i] < it.key())) {
+            merged << list[i];
+            i++;
+            continue;
+        }
+
+        const bool found = i < list.size() && list[i] == it.key();
+        if (found) {
+            i++;
+        }
+        if (it.value() > 0 || (found && it.value() == 0)) {
+            merged << it.key();
+        }
+        ++it;
+    }
+
+    if (!merged.isEmpty()) {
+        put(trigram, merged);
+    } else {
+        del(trigram);
+    }
+}
+
+// The position of a rebuild is kept under this key, which is too short
+// to be one of the trigrams
+static MDB_val rebuildKey()
+{
+    static char key = 0;
+
+    MDB_val val;
+    val.mv_size = 1;
+    val.mv_data = &key;
+    return val;
+}
+
+quint64 TrigramDB::rebuildPosition()
+{
+    MDB_val key = rebuildKey();
+    MDB_val val;
+    int rc = mdb_get(m_txn, m_dbi, &key, &val);
+    if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+        return 0;
+    }
+    Q_ASSERT_X(rc == 0, "TrigramDB::rebuildPosition", mdb_strerror(rc));
+
+    return *(static_cast<quint64*>(val.mv_data));
+}
+
+void TrigramDB::setRebuildPosition(quint64 id)
+{
+    MDB_val key = rebuildKey();
+    int rc;
+    if (!id) {
+        rc = mdb_del(m_txn, m_dbi, &key, 0);
+        if (rc == MDB_NOTFOUND) {
+            return;
+        }
+    } else {
+        MDB_val val;
+        val.mv_size = sizeof(quint64);
+        val.mv_data = static_cast<void*>(&id);
+        rc = mdb_put(m_txn, m_dbi, &key, &val, 0);
+    }
+    if (isMapFull(rc)) {
+        return;
+    }
+    Q_ASSERT_X(rc == 0, "TrigramDB::setRebuildPosition", mdb_strerror(rc));
+}
+
+void TrigramDB::beginRebuild()
+{
+    int rc = mdb_drop(m_txn, m_dbi, 0);
+    Q_ASSERT_X(rc == 0, "TrigramDB::beginRebuild", mdb_strerror(rc));
+
+    // The ids start at 1
+    setRebuildPosition(1);
+}
+
+bool TrigramDB::isRebuilding()
+{
+    return rebuildPosition() != 0;
+}
+
+void TrigramDB::continueRebuild(MDB_dbi idFilenameDbi, MDB_dbi docTimeDbi, int maxIds)
+{
+    const quint64 from = rebuildPosition();
+    if (!from) {
+        return;
+    }
+
+    IdFilenameDB idFilenameDB(idFilenameDbi, m_txn);
+    DocumentTimeDB docTimeDB(docTimeDbi, m_txn);
+
+    QMap<QByteArray, PostingList> pending;
+    quint64 next = 0;
+    int ids = 0;
+    idFilenameDB.forEach(from, [&](quint64 id, const IdFilenameDB::FilePath& path) {
+        if (ids >= maxIds) {
+            next = id;
+            return false;
+        }
+        ids++;
+
+        // The folders which are only kept as the parents of documents
+        if (!docTimeDB.contains(id)) {
+            return true;
+        }
+
+        for (const QByteArray& trigram : trigrams(normalize(path.name))) {
+            pending[trigram] << id;
+        }
+        return true;
+    });
+
+    for (auto it = pending.constBegin(); it != pending.constEnd(); ++it) {
+        const PostingList list = get(it.key());
+
+        PostingList merged;
+        merged.reserve(list.size() + it.value().size());
+        std::set_union(list.constBegin(), list.constEnd(), it.value().constBegin(), it.value().constEnd(),
+                       std::back_inserter(merged));
+        put(it.key(), merged);
+    }
+
+    // Done once there are no names left
+    setRebuildPosition(next);
+}
+
+//
+// Query
+//
+
+class DBTrigramIterator : public VectorPostingIterator {
+public:
+    DBTrigramIterator(void* data, uint size)
+        : VectorPostingIterator(PostingCodec().decode(QByteArray(static_cast<char*>(data), size)))
+        , m_size(size)
+    {
+        static MetricsCounter* decoded = Metrics::instance()->counter(QStringLiteral("trigramdb.decode.bytes"));
+        decoded->add(size);
+    }
+
+    uint readSize() const Q_DECL_OVERRIDE {
+        return m_size;
+    }
+
+private:
+    uint m_size;
+};
+
+PostingIterator* TrigramDB::iter(const QByteArray& normalized)
+{
+    Q_ASSERT(normalized.size() >= 3);
+
+    QVector<PostingIterator*> vec;
+    for (const QByteArray& trigram : trigrams(normalized)) {
+        MDB_val key;
+        key.mv_size = trigram.size();
+        key.mv_data = static_cast<void*>(const_cast<char*>(trigram.constData()));
+
+        MDB_val val;
+        int rc = mdb_get(m_txn, m_dbi, &key, &val);
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+            qDeleteAll(vec);
+            return 0;
+        }
+        Q_ASSERT_X(rc == 0, "TrigramDB::iter", mdb_strerror(rc));
+
+        vec << new DBTrigramIterator(val.mv_data, val.mv_size);
+    }
+
+    if (vec.size() == 1) {
+        return vec.first();
+    }
+
+    // The rarest trigram gives the fewest candidates to look for in the others
+    std::sort(vec.begin(), vec.end(), [](PostingIterator* lhs, PostingIterator* rhs) {
+        return lhs->estimateSize(0) < rhs->estimateSize(0);
+    });
+    return new AndPostingIterator(vec);
+}
+
+QMap<QByteArray, PostingList> TrigramDB::toTestMap() const
+{
+    MDB_cursor* cursor;
+    mdb_cursor_open(m_txn, m_dbi, &cursor);
+
+    MDB_val key = {0, 0};
+    MDB_val val;
+
+    QMap<QByteArray, PostingList> map;
+    while (1) {
+        int rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
+        if (rc == MDB_NOTFOUND || isMapFull(rc)) {
+            break;
+        }
+        Q_ASSERT_X(rc == 0, "TrigramDB::toTestMap", mdb_strerror(rc));
+
+        // The position of a rebuild
+        if (key.mv_size != 3) {
+            continue;
+        }
+
+        const QByteArray trigram(static_cast<char*>(key.mv_data), key.mv_size);
+        const PostingList list = PostingCodec().decode(QByteArray(static_cast<char*>(val.mv_data), val.mv_size));
+        map.insert(trigram, list);
+    }
+
+    mdb_cursor_close(cursor);
+    return map;
+}
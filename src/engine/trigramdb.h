@@ -0,0 +1,110 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_TRIGRAMDB_H
+#define BALOO_TRIGRAMDB_H
+
+#include "postingdb.h"
+
+#include <QMap>
+
+namespace Baloo {
+
+/**
+ * The TrigramDB maps each sequence of three bytes of the normalized file
+ * names to the documents whose name contains it, <trigram> -> <id1> <id2> ...
+ *
+ * This narrows a search for any part of a file name down to a few
+ * candidates, whose names then need to be checked. Unlike the file name
+ * terms, this also finds the parts which do not start a word. It is
+ * optional, see Database::setFileNameTrigrams.
+ */
+class BALOO_ENGINE_EXPORT TrigramDB
+{
+public:
+    TrigramDB(MDB_dbi dbi, MDB_txn* txn);
+    ~TrigramDB();
+
+    static MDB_dbi create(MDB_txn* txn);
+    static MDB_dbi open(MDB_txn* txn);
+
+    /**
+     * Lower cases the file \p name and removes its accents, see
+     * TermGenerator::normalize
+     */
+    static QByteArray normalize(const QByteArray& name);
+
+    /**
+     * Returns the distinct trigrams of the \p normalized name, sorted
+     */
+    static QVector<QByteArray> trigrams(const QByteArray& normalized);
+
+    void put(const QByteArray& trigram, const PostingList& list, uint flags = 0);
+    PostingList get(const QByteArray& trigram);
+    void del(const QByteArray& trigram);
+
+    /**
+     * Adds the ids with a positive value in \p delta to the list of
+     * \p trigram, and removes the ones with a negative value.
+     */
+    void update(const QByteArray& trigram, const QMap<quint64, int>& delta);
+
+    /**
+     * Returns the documents whose normalized name contains all of the
+     * trigrams of the \p normalized substring, which needs to be at least
+     * three bytes long. Their names still need to be checked.
+     */
+    PostingIterator* iter(const QByteArray& normalized);
+
+    /**
+     * Empties the database and starts filling it again with the trigrams
+     * of the names in the IdFilenameDB of the documents in the
+     * DocumentTimeDB, which is then done a batch at a time with
+     * continueRebuild.
+     *
+     * Meanwhile the database holds the id to continue from, and it must
+     * not be used for queries, see isRebuilding.
+     */
+    void beginRebuild();
+    bool isRebuilding();
+
+    /**
+     * Adds the trigrams of the next \p maxIds names in the IdFilenameDB
+     * \p idFilenameDbi of the documents in the DocumentTimeDB
+     * \p docTimeDbi. They are merged with the lists, which may already
+     * hold the ids of documents added since the rebuild began.
+     */
+    void continueRebuild(MDB_dbi idFilenameDbi, MDB_dbi docTimeDbi, int maxIds);
+
+    QMap<QByteArray, PostingList> toTestMap() const;
+
+private:
+    /**
+     * Returns 0 if the database is not being rebuilt
+     */
+    quint64 rebuildPosition();
+    void setRebuildPosition(quint64 id);
+
+    MDB_txn* m_txn;
+    MDB_dbi m_dbi;
+};
+
+}
+
+#endif // BALOO_TRIGRAMDB_H
@@ -59,5 +59,7 @@ QVector<uint> VectorPositionInfoIterator::positions()
     return m_vector[m_pos].positions;
 }
 
-
-
+uint VectorPositionInfoIterator::estimateSize(uint) const
+{
+    return m_vector.size();
+}
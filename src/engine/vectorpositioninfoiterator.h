@@ -34,6 +34,7 @@ public:
     quint64 docId() const Q_DECL_OVERRIDE;
     quint64 next() Q_DECL_OVERRIDE;
     QVector<uint> positions() Q_DECL_OVERRIDE;
+    uint estimateSize(uint totalDocuments) const Q_DECL_OVERRIDE;
 
 private:
     QVector<PositionInfo> m_vector;
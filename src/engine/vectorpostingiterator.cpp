@@ -20,6 +20,8 @@
 
 #include "vectorpostingiterator.h"
 
+#include <algorithm>
+
 using namespace Baloo;
 
 VectorPostingIterator::VectorPostingIterator(const QVector<quint64>& values)
@@ -48,3 +50,41 @@ quint64 VectorPostingIterator::next()
     m_pos++;
     return m_values[m_pos];
 }
+
+quint64 VectorPostingIterator::skipTo(quint64 docId)
+{
+    // Like the default, an iterator which has not been started stays there
+    if (m_pos < 0 || m_pos >= m_values.size()) {
+        return 0;
+    }
+
+    auto it = std::lower_bound(m_values.constBegin() + m_pos, m_values.constEnd(), docId);
+    m_pos = it - m_values.constBegin();
+    return this->docId();
+}
+
+int VectorPostingIterator::nextBlock(quint64* ids, int max)
+{
+    const int start = m_pos + 1;
+    const int count = qBound(0, m_values.size() - start, max);
+    std::copy(m_values.constBegin() + start, m_values.constBegin() + start + count, ids);
+
+    m_pos = count < max ? m_values.size() : start + count - 1;
+    return count;
+}
+
+int VectorPostingIterator::skipToBlock(quint64 docId, quint64* ids, int max)
+{
+    if (m_pos >= m_values.size()) {
+        return 0;
+    }
+
+    auto it = std::lower_bound(m_values.constBegin() + qMax(m_pos, 0), m_values.constEnd(), docId);
+    m_pos = it - m_values.constBegin() - 1;
+    return nextBlock(ids, max);
+}
+
+uint VectorPostingIterator::estimateSize(uint) const
+{
+    return m_values.size();
+}
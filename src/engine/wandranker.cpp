@@ -0,0 +1,214 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "wandranker.h"
+#include "frequencypostingiterator.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace Baloo;
+
+// The usual BM25 parameters
+static const double s_k1 = 1.2;
+static const double s_b = 0.75;
+
+namespace {
+    struct Result {
+        double score;
+        quint64 id;
+    };
+
+    // Used as the "less than" of the heap, so the worst result is at the front
+    bool betterThan(const Result& lhs, const Result& rhs)
+    {
+        if (lhs.score != rhs.score) {
+            return lhs.score > rhs.score;
+        }
+        return lhs.id < rhs.id;
+    }
+}
+
+WandRanker::WandRanker(quint64 totalDocuments, double averageLength, std::function<quint32(quint64)> docLength)
+    : m_totalDocuments(totalDocuments)
+    , m_averageLength(averageLength)
+    , m_docLength(docLength)
+{
+}
+
+WandRanker::~WandRanker()
+{
+    for (const TermInfo& info : m_terms) {
+        delete info.it;
+    }
+}
+
+void WandRanker::addTerm(FrequencyPostingIterator* it, quint64 documentFrequency)
+{
+    const double n = qMax(m_totalDocuments, documentFrequency);
+    const double df = documentFrequency;
+
+    TermInfo info;
+    info.it = it;
+    info.idf = std::log(1.0 + (n - df + 0.5) / (df + 0.5));
+
+    // The score is the highest for the shortest possible document
+    const double maxTf = it->maxFrequency();
+    info.upperBound = info.idf * maxTf * (s_k1 + 1) / (maxTf + s_k1 * (1 - s_b));
+
+    it->next();
+    m_terms << info;
+}
+
+double WandRanker::scoreAndAdvance(quint64 docId)
+{
+    double score = 0;
+    double norm = -1;
+
+    for (const TermInfo& info : m_terms) {
+        if (info.it->skipTo(docId) != docId) {
+            continue;
+        }
+
+        if (norm < 0) {
+            norm = 1;
+            if (m_averageLength > 0) {
+                norm = 1 - s_b + s_b * m_docLength(docId) / m_averageLength;
+            }
+        }
+
+        const double tf = info.it->frequency();
+        score += info.idf * tf * (s_k1 + 1) / (tf + s_k1 * norm);
+
+        info.it->next();
+    }
+
+    return score;
+}
+
+quint64 WandRanker::nextUnion() const
+{
+    quint64 id = 0;
+    for (const TermInfo& info : m_terms) {
+        const quint64 docId = info.it->docId();
+        if (docId && (!id || docId < id)) {
+            id = docId;
+        }
+    }
+
+    return id;
+}
+
+QVector<quint64> WandRanker::topK(int k, PostingIterator* filter)
+{
+    if (k == 0) {
+        return QVector<quint64>();
+    }
+
+    std::vector<Result> heap;
+
+    //
+    // Until we have k results, every candidate makes it in
+    //
+    while (k < 0 || static_cast<int>(heap.size()) < k) {
+        const quint64 id = filter ? filter->next() : nextUnion();
+        if (!id) {
+            break;
+        }
+
+        heap.push_back({scoreAndAdvance(id), id});
+        std::push_heap(heap.begin(), heap.end(), betterThan);
+    }
+
+    //
+    // WAND - Only score documents which could beat the worst result
+    //
+    QVector<TermInfo*> terms;
+    terms.reserve(m_terms.size());
+
+    while (k > 0 && static_cast<int>(heap.size()) == k) {
+        const double threshold = heap.front().score;
+
+        terms.clear();
+        for (TermInfo& info : m_terms) {
+            if (info.it->docId()) {
+                terms << &info;
+            }
+        }
+        std::sort(terms.begin(), terms.end(), [](TermInfo* lhs, TermInfo* rhs) {
+            return lhs->it->docId() < rhs->it->docId();
+        });
+
+        int pivot = -1;
+        double bound = 0;
+        for (int i = 0; i < terms.size(); i++) {
+            bound += terms[i]->upperBound;
+            if (bound > threshold) {
+                pivot = i;
+                break;
+            }
+        }
+        if (pivot < 0) {
+            break;
+        }
+
+        quint64 pivotId = terms[pivot]->it->docId();
+        if (filter) {
+            const quint64 id = filter->skipTo(pivotId);
+            if (!id) {
+                break;
+            }
+            if (id > pivotId) {
+                // None of the documents till id are in the filter
+                for (TermInfo* info : terms) {
+                    if (info->it->docId() >= id) {
+                        break;
+                    }
+                    info->it->skipTo(id);
+                }
+                continue;
+            }
+        }
+
+        if (terms.first()->it->docId() == pivotId) {
+            const double score = scoreAndAdvance(pivotId);
+            const Result result = {score, pivotId};
+            if (betterThan(result, heap.front())) {
+                std::pop_heap(heap.begin(), heap.end(), betterThan);
+                heap.back() = result;
+                std::push_heap(heap.begin(), heap.end(), betterThan);
+            }
+        } else {
+            // The documents before the pivot cannot beat the threshold
+            for (int i = 0; i < pivot; i++) {
+                terms[i]->it->skipTo(pivotId);
+            }
+        }
+    }
+
+    std::sort(heap.begin(), heap.end(), betterThan);
+
+    QVector<quint64> ids;
+    ids.reserve(heap.size());
+    for (const Result& result : heap) {
+        ids << result.id;
+    }
+
+    return ids;
+}
@@ -0,0 +1,87 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_WANDRANKER_H
+#define BALOO_WANDRANKER_H
+
+#include "engine_export.h"
+
+#include <QVector>
+#include <functional>
+
+namespace Baloo {
+
+class PostingIterator;
+class FrequencyPostingIterator;
+
+/**
+ * Ranks documents with BM25 and returns the best \p k of them.
+ *
+ * Instead of scoring every document which contains one of the terms, the
+ * WAND algorithm is used. Each term has an upper bound of the score it can
+ * contribute, and documents whose combined upper bounds cannot beat the
+ * current k-th result are skipped without being scored.
+ */
+class BALOO_ENGINE_EXPORT WandRanker
+{
+public:
+    /**
+     * \p docLength should return the length of the given document. It is
+     * only called for documents which are actually scored.
+     */
+    WandRanker(quint64 totalDocuments, double averageLength, std::function<quint32(quint64)> docLength);
+    ~WandRanker();
+
+    /**
+     * Adds a term which contributes to the score. The ranker takes
+     * ownership of the iterator. \p documentFrequency is the number
+     * of documents which contain the term.
+     */
+    void addTerm(FrequencyPostingIterator* it, quint64 documentFrequency);
+
+    /**
+     * Returns the ids of the best \p k documents, best first. Documents with
+     * the same score are ordered by their id. A negative \p k returns all of
+     * them.
+     *
+     * If a \p filter is given only documents from it are returned, even those
+     * which do not contain any of the terms. The filter is not deleted.
+     */
+    QVector<quint64> topK(int k, PostingIterator* filter = 0);
+
+private:
+    struct TermInfo {
+        FrequencyPostingIterator* it;
+        double idf;
+        double upperBound;
+    };
+
+    double scoreAndAdvance(quint64 docId);
+    quint64 nextUnion() const;
+
+    quint64 m_totalDocuments;
+    double m_averageLength;
+    std::function<quint32(quint64)> m_docLength;
+
+    QVector<TermInfo> m_terms;
+};
+
+}
+
+#endif // BALOO_WANDRANKER_H
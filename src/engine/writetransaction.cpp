@@ -30,6 +30,15 @@
 #include "documenttimedb.h"
 #include "documentdatadb.h"
 #include "mtimedb.h"
+#include "termfrequencydb.h"
+#include "documentlengthdb.h"
+#include "documentpropertydb.h"
+#include "prefixdb.h"
+#include "trigramdb.h"
+#include "idfilenamedb.h"
+#include "mapfull.h"
+#include "metrics.h"
+#include "tracing.h"
 
 using namespace Baloo;
 
@@ -56,10 +65,14 @@ void WriteTransaction::addDocument(const Document& doc)
     if (!docUrlDB.put(id, doc.url())) {
         return;
     }
+    addFileName(id, doc.url());
 
     QVector<QByteArray> docTerms = addTerms(id, doc.m_terms);
     documentTermsDB.put(id, docTerms);
 
+    DocumentLengthDB docLengthDB(m_dbis.docLengthDbi, m_txn);
+    docLengthDB.put(id, documentLength(doc.m_terms));
+
     QVector<QByteArray> docXattrTerms = addTerms(id, doc.m_xattrTerms);
     if (!docXattrTerms.isEmpty())
         documentXattrTermsDB.put(id, docXattrTerms);
@@ -83,6 +96,16 @@ void WriteTransaction::addDocument(const Document& doc)
     if (!doc.m_data.isEmpty()) {
         docDataDB.put(id, doc.m_data);
     }
+
+    putProperties(id, doc.m_properties);
+}
+
+void WriteTransaction::putProperties(quint64 id, const QMap<quint32, qint64>& properties)
+{
+    DocumentPropertyDB docPropertyDB(m_dbis.docPropertyDbi, m_txn);
+    for (auto it = properties.constBegin(); it != properties.constEnd(); ++it) {
+        docPropertyDB.put(it.key(), id, it.value());
+    }
 }
 
 QVector<QByteArray> WriteTransaction::addTerms(quint64 id, const QMap<QByteArray, Document::TermData>& terms)
@@ -99,6 +122,7 @@ QVector<QByteArray> WriteTransaction::addTerms(quint64 id, const QMap<QByteArray
         op.type = AddId;
         op.data.docId = id;
         op.data.positions = it.value().positions;
+        op.wdf = it.value().wdf;
 
         m_pendingOperations[term].append(op);
     }
@@ -106,6 +130,16 @@ QVector<QByteArray> WriteTransaction::addTerms(quint64 id, const QMap<QByteArray
     return termList;
 }
 
+quint32 WriteTransaction::documentLength(const QMap<QByteArray, Document::TermData>& terms)
+{
+    quint32 length = 0;
+    for (const Document::TermData& data : terms) {
+        length += data.wdf;
+    }
+
+    return length;
+}
+
 
 void WriteTransaction::removeDocument(quint64 id)
 {
@@ -127,6 +161,7 @@ void WriteTransaction::removeDocument(quint64 id)
     documentXattrTermsDB.del(id);
     documentFileNameTermsDB.del(id);
 
+    removeFileName(id);
     docUrlDB.del(id, [&docTimeDB](quint64 id) {
         return !docTimeDB.contains(id);
     });
@@ -141,6 +176,12 @@ void WriteTransaction::removeDocument(quint64 id)
     }
 
     docDataDB.del(id);
+
+    DocumentLengthDB docLengthDB(m_dbis.docLengthDbi, m_txn);
+    docLengthDB.del(id);
+
+    DocumentPropertyDB docPropertyDB(m_dbis.docPropertyDbi, m_txn);
+    docPropertyDB.del(id);
 }
 
 void WriteTransaction::removeTerms(quint64 id, const QVector<QByteArray>& terms)
@@ -149,6 +190,7 @@ void WriteTransaction::removeTerms(quint64 id, const QVector<QByteArray>& terms)
         Operation op;
         op.type = RemoveId;
         op.data.docId = id;
+        op.wdf = 0;
 
         m_pendingOperations[term].append(op);
     }
@@ -183,6 +225,9 @@ void WriteTransaction::replaceDocument(const Document& doc, DocumentOperations o
         QVector<QByteArray> docTerms = replaceTerms(id, prevTerms, doc.m_terms);
 
         documentTermsDB.put(id, docTerms);
+
+        DocumentLengthDB docLengthDB(m_dbis.docLengthDbi, m_txn);
+        docLengthDB.put(id, documentLength(doc.m_terms));
     }
 
     if (operations & XAttrTerms) {
@@ -223,12 +268,44 @@ void WriteTransaction::replaceDocument(const Document& doc, DocumentOperations o
         } else {
             docDataDB.del(id);
         }
+
+        // The properties are extracted along with the data
+        DocumentPropertyDB docPropertyDB(m_dbis.docPropertyDbi, m_txn);
+        docPropertyDB.del(id);
+        putProperties(id, doc.m_properties);
     }
 
     if (operations & DocumentUrl) {
+        removeFileName(id);
         docUrlDB.replace(id, doc.url(), [&docTimeDB](quint64 id) {
             return !docTimeDB.contains(id);
         });;
+        addFileName(id, doc.url());
+    }
+}
+
+void WriteTransaction::addFileName(quint64 id, const QByteArray& url)
+{
+    if (!m_dbis.trigramDbi) {
+        return;
+    }
+
+    const QByteArray name = TrigramDB::normalize(url.mid(url.lastIndexOf('/') + 1));
+    for (const QByteArray& trigram : TrigramDB::trigrams(name)) {
+        m_pendingTrigrams[trigram][id]++;
+    }
+}
+
+void WriteTransaction::removeFileName(quint64 id)
+{
+    if (!m_dbis.trigramDbi) {
+        return;
+    }
+
+    IdFilenameDB idFilenameDB(m_dbis.idFilenameDbi, m_txn);
+    const QByteArray name = TrigramDB::normalize(idFilenameDB.get(id).name);
+    for (const QByteArray& trigram : TrigramDB::trigrams(name)) {
+        m_pendingTrigrams[trigram][id]--;
     }
 }
 
@@ -239,6 +316,7 @@ QVector< QByteArray > WriteTransaction::replaceTerms(quint64 id, const QVector<Q
         Operation op;
         op.type = RemoveId;
         op.data.docId = id;
+        op.wdf = 0;
 
         m_pendingOperations[term].append(op);
     }
@@ -264,8 +342,19 @@ static void insert(QVector<T>& vec, const T& id)
 
 void WriteTransaction::commit()
 {
+    BALOO_TRACE_SPAN("engine", "WriteTransaction::commit");
+
     PostingDB postingDB(m_dbis.postingDbi, m_txn);
     PositionDB positionDB(m_dbis.positionDBi, m_txn);
+    TermFrequencyDB termFrequencyDB(m_dbis.termFrequencyDbi, m_txn);
+
+    static MetricsHistogram* pendingTerms = Metrics::instance()->histogram(QStringLiteral("writetransaction.pending.terms"));
+    static MetricsHistogram* pendingOperations = Metrics::instance()->histogram(QStringLiteral("writetransaction.pending.operations"));
+    pendingTerms->record(m_pendingOperations.size());
+    quint64 operationCount = 0;
+
+    // How many more or fewer terms of each prefix contain an id
+    QHash<QByteArray, QMap<quint64, int> > prefixDeltas;
 
     QHashIterator<QByteArray, QVector<Operation> > iter(m_pendingOperations);
     while (iter.hasNext()) {
@@ -273,17 +362,36 @@ void WriteTransaction::commit()
 
         const QByteArray& term = iter.key();
         const QVector<Operation> operations = iter.value();
+        operationCount += operations.size();
 
         PostingList list = postingDB.get(term);
 
+        // The frequencies are kept in the same order as the ids
+        QVector<quint32> freqList = termFrequencyDB.get(term);
+        if (freqList.size() != list.size()) {
+            freqList.fill(1, list.size());
+        }
+
         bool fetchedPositionList = false;
         QVector<PositionInfo> positionList;
 
+        const QVector<QByteArray> prefixes = m_dbis.prefixDbi ? PrefixDB::prefixes(term) : QVector<QByteArray>();
+
         for (const Operation& op : operations) {
             quint64 id = op.data.docId;
 
             if (op.type == AddId) {
-                insert(list, id);
+                auto it = std::lower_bound(list.begin(), list.end(), id);
+                const int pos = it - list.begin();
+                if (it != list.end() && *it == id) {
+                    freqList[pos] = op.wdf;
+                } else {
+                    list.insert(pos, id);
+                    freqList.insert(pos, op.wdf);
+                    for (const QByteArray& prefix : prefixes) {
+                        prefixDeltas[prefix][id]++;
+                    }
+                }
 
                 if (!op.data.positions.isEmpty()) {
                     if (!fetchedPositionList) {
@@ -294,7 +402,14 @@ void WriteTransaction::commit()
                 }
             }
             else {
-                list.removeOne(id);
+                const int pos = list.indexOf(id);
+                if (pos >= 0) {
+                    list.remove(pos);
+                    freqList.remove(pos);
+                    for (const QByteArray& prefix : prefixes) {
+                        prefixDeltas[prefix][id]--;
+                    }
+                }
                 if (!fetchedPositionList) {
                     positionList = positionDB.get(term);
                     fetchedPositionList = true;
@@ -304,19 +419,48 @@ void WriteTransaction::commit()
         }
 
         if (!list.isEmpty()) {
-            postingDB.put(term, list);
+            m_bytesWritten += postingDB.put(term, list);
+            termFrequencyDB.put(term, freqList);
         } else {
             postingDB.del(term);
+            termFrequencyDB.del(term);
         }
 
         if (fetchedPositionList) {
             if (!positionList.isEmpty()) {
-                positionDB.put(term, positionList);
+                m_bytesWritten += positionDB.put(term, positionList);
             } else {
                 positionDB.del(term);
             }
         }
+
+        // The transaction cannot be used any more, see Transaction::commit
+        if (mapFullOccurred()) {
+            break;
+        }
+    }
+
+    if (m_dbis.trigramDbi && !mapFullOccurred()) {
+        TrigramDB trigramDB(m_dbis.trigramDbi, m_txn);
+        for (auto it = m_pendingTrigrams.constBegin(); it != m_pendingTrigrams.constEnd(); ++it) {
+            trigramDB.update(it.key(), it.value());
+            if (mapFullOccurred()) {
+                break;
+            }
+        }
+    }
+    m_pendingTrigrams.clear();
+
+    if (m_dbis.prefixDbi && !mapFullOccurred()) {
+        PrefixDB prefixDB(m_dbis.prefixDbi, m_txn);
+        for (auto it = prefixDeltas.constBegin(); it != prefixDeltas.constEnd(); ++it) {
+            prefixDB.update(it.key(), it.value());
+            if (mapFullOccurred()) {
+                break;
+            }
+        }
     }
 
     m_pendingOperations.clear();
+    pendingOperations->record(operationCount);
 }
@@ -35,6 +35,7 @@ public:
     WriteTransaction(DatabaseDbis dbis, MDB_txn* txn)
         : m_txn(txn)
         , m_dbis(dbis)
+        , m_bytesWritten(0)
     {}
 
     void addDocument(const Document& doc);
@@ -74,8 +75,13 @@ public:
     void commit();
 
     bool hasChanges() const {
-        return !m_pendingOperations.isEmpty();
+        return !m_pendingOperations.isEmpty() || !m_pendingTrigrams.isEmpty();
     }
+
+    /**
+     * The size of the posting and position lists written by commit()
+     */
+    quint64 bytesWritten() const { return m_bytesWritten; }
     enum OperationType {
         AddId,
         RemoveId
@@ -83,6 +89,7 @@ public:
     struct Operation {
         OperationType type;
         PositionInfo data;
+        quint32 wdf;
     };
 
 private:
@@ -94,11 +101,28 @@ private:
     QVector<QByteArray> replaceTerms(quint64 id, const QVector<QByteArray>& prevTerms,
                                      const QMap<QByteArray, Document::TermData>& terms);
     void removeTerms(quint64 id, const QVector<QByteArray>& terms);
+    void putProperties(quint64 id, const QMap<quint32, qint64>& properties);
+
+    /*
+     * Adds or removes the trigrams of the file name of \p url for \p id,
+     * if there is a TrigramDB
+     */
+    void addFileName(quint64 id, const QByteArray& url);
+    void removeFileName(quint64 id);
+
+    /*
+     * The length of a document is the sum of the frequencies of its terms
+     */
+    static quint32 documentLength(const QMap<QByteArray, Document::TermData>& terms);
 
     QHash<QByteArray, QVector<Operation> > m_pendingOperations;
 
+    // The ids which are added to (1) or removed from (-1) each trigram
+    QHash<QByteArray, QMap<quint64, int> > m_pendingTrigrams;
+
     MDB_txn* m_txn;
     DatabaseDbis m_dbis;
+    quint64 m_bytesWritten;
 };
 }
 
@@ -23,6 +23,7 @@
 #include "basicindexingjob.h"
 #include "termgenerator.h"
 #include "idutils.h"
+#include "orderedvalues.h"
 #include "baloodebug.h"
 
 #include <QFileInfo>
@@ -111,7 +112,7 @@ bool BasicIndexingJob::indexXAttr(const QString& url, Document& doc)
 
     int rating = userMetaData.rating();
     if (rating) {
-        doc.addXattrBoolTerm(QByteArray("R") + QByteArray::number(rating));
+        doc.addXattrBoolTerm(QByteArray("R") + orderedValue(rating));
         modified = true;
     }
 
@@ -0,0 +1,158 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "deviceindexer.h"
+#include "basicindexingjob.h"
+#include "fileindexerconfig.h"
+#include "filtereddiriterator.h"
+#include "unindexedfileiterator.h"
+
+#include "database.h"
+#include "databaseshards.h"
+#include "transaction.h"
+#include "indexbuilder.h"
+#include "idutils.h"
+#include "tracing.h"
+
+#include <QMimeDatabase>
+#include <QFile>
+#include <QDebug>
+
+using namespace Baloo;
+
+DeviceIndexer::DeviceIndexer(FileIndexerConfig* config, const QString& mountPath)
+    : m_config(config)
+    , m_mountPath(mountPath)
+    , m_shardPath(DatabaseShards::shardPath(mountPath))
+{
+    Q_ASSERT(m_config);
+}
+
+void DeviceIndexer::run()
+{
+    BALOO_TRACE_SPAN("indexer", "DeviceIndexer::run");
+
+    DatabaseShards* shards = DatabaseShards::instance();
+    QSharedPointer<Database> db = shards->open(m_mountPath, Database::CreateDatabase);
+    if (!db) {
+        Q_EMIT done(m_mountPath);
+        return;
+    }
+
+    const QByteArray rootUrl = QFile::encodeName(m_mountPath);
+    quint64 rootId = 0;
+    uint size = 0;
+    {
+        Transaction tr(db.data(), Transaction::ReadOnly);
+        rootId = tr.documentId(rootUrl);
+        size = tr.size();
+    }
+
+    // The ids contain the device number, which can be a different one
+    // every time the device is plugged in. A build which was interrupted
+    // may have left documents without their terms behind.
+    if (size && (rootId != filePathToId(rootUrl) || IndexBuilder::isIncomplete(db.data()))) {
+        qDebug() << "The index of" << m_mountPath << "is out of date or incomplete, rebuilding it";
+        db.clear();
+        shards->remove(m_mountPath);
+
+        db = shards->open(m_mountPath, Database::CreateDatabase);
+        if (!db) {
+            Q_EMIT done(m_mountPath);
+            return;
+        }
+        size = 0;
+    }
+
+    if (size) {
+        update(db.data(), rootId);
+    } else {
+        build(db.data());
+    }
+
+    Q_EMIT done(m_mountPath);
+}
+
+void DeviceIndexer::build(Database* db)
+{
+    QMimeDatabase mimeDb;
+    IndexBuilder builder(db);
+
+    FilteredDirIterator it(m_config, m_mountPath);
+    while (!it.next().isEmpty()) {
+        const QString filePath = it.filePath();
+        if (filePath.startsWith(m_shardPath)) {
+            continue;
+        }
+
+        QString mimetype = mimeDb.mimeTypeForFile(filePath, QMimeDatabase::MatchExtension).name();
+        if (!m_config->shouldMimeTypeBeIndexed(mimetype)) {
+            continue;
+        }
+
+        BasicIndexingJob job(filePath, mimetype, BasicIndexingJob::NoLevel);
+        if (job.index()) {
+            builder.addDocument(job.document());
+        }
+    }
+
+    if (!builder.finish()) {
+        qWarning() << "DeviceIndexer: Could not build the index of" << m_mountPath;
+    }
+}
+
+void DeviceIndexer::update(Database* db, quint64 rootId)
+{
+    db->write([&](Transaction* tr) {
+        // The files which were changed while the device was elsewhere
+        auto shouldDelete = [&](quint64 id) {
+            if (!id) {
+                return false;
+            }
+
+            const QString url = QFile::decodeName(tr->documentUrl(id));
+            return !QFile::exists(url) || !m_config->shouldBeIndexed(url);
+        };
+        tr->removeRecursively(rootId, shouldDelete);
+
+        UnIndexedFileIterator it(m_config, tr, m_mountPath);
+        while (!it.next().isEmpty()) {
+            const QString filePath = it.filePath();
+            if (filePath.startsWith(m_shardPath)) {
+                continue;
+            }
+
+            BasicIndexingJob job(filePath, it.mimetype(), BasicIndexingJob::NoLevel);
+            if (!job.index()) {
+                continue;
+            }
+
+            const quint64 id = job.document().id();
+            if (tr->hasDocument(id)) {
+                DocumentOperations ops = DocumentTime | XAttrTerms;
+                if (tr->documentUrl(id) != QFile::encodeName(filePath)) {
+                    ops |= (FileNameTerms | DocumentUrl);
+                }
+                tr->replaceDocument(job.document(), ops);
+            } else {
+                tr->addDocument(job.document());
+            }
+        }
+    });
+}
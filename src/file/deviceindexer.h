@@ -0,0 +1,59 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_DEVICEINDEXER_H
+#define BALOO_DEVICEINDEXER_H
+
+#include <QRunnable>
+#include <QObject>
+#include <QSharedPointer>
+#include <QString>
+
+namespace Baloo {
+
+class Database;
+class FileIndexerConfig;
+
+/**
+ * Brings the index kept on a removable medium up to date after it has
+ * been mounted, see DatabaseShards. The files are only indexed with their
+ * basic information, as the content is extracted into the main index.
+ */
+class DeviceIndexer : public QObject, public QRunnable
+{
+    Q_OBJECT
+public:
+    DeviceIndexer(FileIndexerConfig* config, const QString& mountPath);
+
+    void run() Q_DECL_OVERRIDE;
+
+Q_SIGNALS:
+    void done(const QString& mountPath);
+
+private:
+    void build(Database* db);
+    void update(Database* db, quint64 rootId);
+
+    FileIndexerConfig* m_config;
+    QString m_mountPath;
+    QString m_shardPath;
+};
+}
+
+#endif // BALOO_DEVICEINDEXER_H
@@ -27,6 +27,8 @@
 #include "transaction.h"
 #include "baloodebug.h"
 #include "global.h"
+#include "metrics.h"
+#include "tracing.h"
 
 #include <QCoreApplication>
 
@@ -34,6 +36,9 @@
 #include <QFileInfo>
 #include <QDBusMessage>
 #include <QDBusConnection>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 
 #include <KFileMetaData/Extractor>
 #include <KFileMetaData/PropertyInfo>
@@ -47,7 +52,6 @@ App::App(QObject* parent)
     : QObject(parent)
     , m_notifyNewData(STDIN_FILENO, QSocketNotifier::Read)
     , m_io(STDIN_FILENO, STDOUT_FILENO)
-    , m_tr(0)
 {
     connect(&m_notifyNewData, &QSocketNotifier::activated, this, &App::slotNewInput);
 }
@@ -55,16 +59,16 @@ App::App(QObject* parent)
 void App::slotNewInput()
 {
     Database *db = globalDatabaseInstance();
+    if (!db->isOpen()) {
+        db->setMapSizeLimits(m_config.initialIndexSize(), m_config.maximumIndexSize());
+    }
     if (!db->open(Database::OpenDatabase)) {
         qCritical() << "Failed to open the database";
         exit(1);
     }
 
-    Q_ASSERT(m_tr == 0);
-
-    m_tr = new Transaction(db, Transaction::ReadWrite);
-    // FIXME: The transaction is open for way too long. We should just open it for when we're
-    //        committing the data not during the extraction.
+    // The changes are only written once the whole batch has been extracted
+    Q_ASSERT(m_changes.isEmpty());
     m_io.newBatch();
     QTimer::singleShot(0, this, &App::processNextFile);
 
@@ -82,24 +86,34 @@ void App::processNextFile()
 
         quint64 id = m_io.nextId();
 
-        QString url = QFile::decodeName(m_tr->documentUrl(id));
+        QString url;
+        {
+            Transaction tr(globalDatabaseInstance(), Transaction::ReadOnly);
+            url = QFile::decodeName(tr.documentUrl(id));
+        }
         if (!QFile::exists(url)) {
-            m_tr->removeDocument(id);
+            write([id](Transaction* tr) {
+                tr->removeDocument(id);
+            });
             QTimer::singleShot(0, this, &App::processNextFile);
             return;
         }
 
         m_io.writeStartedIndexingUrl(url);
-        index(m_tr, url, id);
+        index(url, id);
         m_io.writeFinishedIndexingUrl(url);
         m_updatedFiles << url;
 
         QTimer::singleShot(delay, this, &App::processNextFile);
 
     } else {
-        m_tr->commit();
-        delete m_tr;
-        m_tr = 0;
+        const QVector<std::function<void(Transaction*)> > changes = m_changes;
+        m_changes.clear();
+        globalDatabaseInstance()->write([&changes](Transaction* tr) {
+            for (const auto& change : changes) {
+                change(tr);
+            }
+        });
 
         /*
         * TODO we're already sending out each file as we start we can simply send out a done
@@ -118,20 +132,40 @@ void App::processNextFile()
 
         QDBusConnection::sessionBus().send(message);
 
+        // The metrics of this process only reach baloo_file this way
+        Metrics* metrics = Metrics::instance();
+        m_io.writeMetrics(QJsonDocument(QJsonObject::fromVariantMap(metrics->toVariantMap())).toJson(QJsonDocument::Compact));
+        metrics->reset();
+
+#ifdef BALOO_ENABLE_TRACING
+        Tracer* tracer = Tracer::instance();
+        m_io.writeTrace(QJsonDocument(QJsonArray::fromVariantList(tracer->events())).toJson(QJsonDocument::Compact));
+        tracer->clear();
+#endif
+
         // Enable the SocketNotifier for the next batch
         m_notifyNewData.setEnabled(true);
         m_io.writeBatchIndexed();
     }
 }
 
-void App::index(Transaction* tr, const QString& url, quint64 id)
+void App::write(const std::function<void(Transaction*)>& change)
+{
+    m_changes << change;
+}
+
+void App::index(const QString& url, quint64 id)
 {
+    BALOO_TRACE_SPAN("extractor", "App::index");
+
     QString mimetype = m_mimeDb.mimeTypeForFile(url, QMimeDatabase::MatchContent).name();
 
     bool shouldIndex = m_config.shouldBeIndexed(url) && m_config.shouldMimeTypeBeIndexed(mimetype);
     if (!shouldIndex) {
         // FIXME: This should never be happening!
-        tr->removeDocument(id);
+        write([id](Transaction* tr) {
+            tr->removeDocument(id);
+        });
         return;
     }
 
@@ -141,7 +175,9 @@ void App::index(Transaction* tr, const QString& url, quint64 id)
     if (mimetype == QLatin1String("text/plain")) {
         if (!url.endsWith(QLatin1String(".txt"))) {
             qCDebug(BALOO) << "text/plain does not end with .txt. Ignoring";
-            tr->removePhaseOne(id);
+            write([id](Transaction* tr) {
+                tr->removePhaseOne(id);
+            });
             return;
         }
     }
@@ -153,11 +189,15 @@ void App::index(Transaction* tr, const QString& url, quint64 id)
     if (mimetype.startsWith(QStringLiteral("text/"))) {
         QFileInfo fileInfo(url);
         if (fileInfo.size() >= 10 * 1024 * 1024) {
-            tr->removePhaseOne(id);
+            write([id](Transaction* tr) {
+                tr->removePhaseOne(id);
+            });
             return;
         }
     }
 
+    MetricsTimer timer(Metrics::instance()->histogram(QStringLiteral("extractor.usecs.") + mimetype));
+
     // We always run the basic indexing again. This is mostly so that the proper
     // mimetype is set and we get proper type information.
     // The mimetype fetched in the BasicIQ is fast but not accurate
@@ -178,14 +218,21 @@ void App::index(Transaction* tr, const QString& url, quint64 id)
     result.finish();
     if (doc.id() != id) {
         qWarning() << url << "id seems to have changed. Perhaps baloo was not running, and this file was deleted + re-created";
-        tr->removeDocument(id);
-        if (!tr->hasDocument(doc.id())) {
-            tr->addDocument(result.document());
-        } else {
-            tr->replaceDocument(result.document(), DocumentTerms | DocumentData);
-        }
-    } else {
-        tr->replaceDocument(result.document(), DocumentTerms | DocumentData);
     }
-    tr->removePhaseOne(doc.id());
+
+    const Document document = result.document();
+    // baloo_file may have removed the document since it was looked up
+    write([id, document](Transaction* tr) {
+        if (document.id() != id) {
+            tr->removeDocument(id);
+            if (!tr->hasDocument(document.id())) {
+                tr->addDocument(document);
+            } else {
+                tr->replaceDocument(document, DocumentTerms | DocumentData);
+            }
+        } else if (tr->hasDocument(id)) {
+            tr->replaceDocument(document, DocumentTerms | DocumentData);
+        }
+        tr->removePhaseOne(document.id());
+    });
 }
@@ -32,6 +32,8 @@
 
 #include <KFileMetaData/ExtractorCollection>
 
+#include <functional>
+
 #include "database.h"
 #include "../fileindexerconfig.h"
 #include "iohandler.h"
@@ -53,7 +55,13 @@ private Q_SLOTS:
     void processNextFile();
 
 private:
-    void index(Transaction* tr, const QString& filePath, quint64 id);
+    void index(const QString& filePath, quint64 id);
+
+    /**
+     * Queues \p change for the write transaction at the end of the batch,
+     * which runs it again if the map has to be grown
+     */
+    void write(const std::function<void(Transaction*)>& change);
 
     QMimeDatabase m_mimeDb;
 
@@ -67,7 +75,7 @@ private:
     IdleStateMonitor m_idleMonitor;
 
     QStringList m_updatedFiles;
-    Transaction* m_tr;
+    QVector<std::function<void(Transaction*)> > m_changes;
 };
 
 }
@@ -74,3 +74,13 @@ void IOHandler::writeFinishedIndexingUrl(const QString& url)
 {
     m_stdout << "F " << url << endl;
 }
+
+void IOHandler::writeMetrics(const QByteArray& json)
+{
+    m_stdout << "M " << json << endl;
+}
+
+void IOHandler::writeTrace(const QByteArray& json)
+{
+    m_stdout << "T " << json << endl;
+}
@@ -40,6 +40,18 @@ public:
     void writeStartedIndexingUrl(const QString& url);
     void writeFinishedIndexingUrl(const QString& url);
 
+    /**
+     * Sends the \p json of the metrics of this process, see
+     * Metrics::toVariantMap. It must not contain any newlines.
+     */
+    void writeMetrics(const QByteArray& json);
+
+    /**
+     * Sends the trace events of this process as a \p json array, see
+     * Tracer::events
+     */
+    void writeTrace(const QByteArray& json);
+
     // always call this after a batch has been indexed
     void writeBatchIndexed();
 
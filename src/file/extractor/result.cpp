@@ -21,10 +21,10 @@
  */
 
 #include "result.h"
+#include "orderedvalues.h"
+#include "documentdatacodec.h"
 
 #include <QDebug>
-#include <QJsonDocument>
-#include <QJsonObject>
 
 #include <QDateTime>
 #include <KFileMetaData/PropertyInfo>
@@ -73,17 +73,21 @@ void Result::add(KFileMetaData::Property::Property property, const QVariant& val
     if (value.type() == QVariant::Bool) {
         m_doc.addBoolTerm(prefix);
     }
-    else if (value.type() == QVariant::Int) {
-        const QByteArray term = prefix + value.toString().toUtf8();
+    else if (value.type() == QVariant::Int || value.type() == QVariant::UInt ||
+             value.type() == QVariant::LongLong || value.type() == QVariant::ULongLong) {
+        const QByteArray term = prefix + Baloo::orderedValue(value.toLongLong());
         m_doc.addBoolTerm(term);
+        m_doc.addProperty(propNum, value.toLongLong());
     }
     else if (value.type() == QVariant::Date) {
-        const QByteArray term = prefix + value.toDate().toString(Qt::ISODate).toUtf8();
+        const QByteArray term = prefix + Baloo::orderedValue(value.toDate());
         m_doc.addBoolTerm(term);
+        m_doc.addProperty(propNum, Baloo::secondsSinceEpoch(value.toDate()));
     }
     else if (value.type() == QVariant::DateTime) {
-        const QByteArray term = prefix + value.toDateTime().toString(Qt::ISODate).toUtf8();
+        const QByteArray term = prefix + Baloo::orderedValue(value.toDateTime());
         m_doc.addBoolTerm(term);
+        m_doc.addProperty(propNum, Baloo::secondsSinceEpoch(value.toDateTime()));
     }
     else {
         const QString val = value.toString();
@@ -111,10 +115,13 @@ void Result::addType(KFileMetaData::Type::Type type)
 
 void Result::finish()
 {
-    QJsonObject jo = QJsonObject::fromVariantMap(m_map);
-    QJsonDocument jdoc;
-    jdoc.setObject(jo);
-    m_doc.setData(jdoc.toJson());
+    QMap<int, QVariant> properties;
+    for (auto it = m_map.constBegin(); it != m_map.constEnd(); ++it) {
+        properties.insert(it.key().toInt(), it.value());
+    }
+
+    Baloo::DocumentDataCodec codec;
+    m_doc.setData(codec.encode(properties));
 }
 
 void Result::setDocument(const Baloo::Document& doc)
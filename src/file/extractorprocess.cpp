@@ -20,8 +20,14 @@
 
 #include "extractorprocess.h"
 
+#include "metrics.h"
+#include "tracing.h"
+
 #include <QStandardPaths>
 #include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 
 using namespace Baloo;
 
@@ -80,6 +86,14 @@ void ExtractorProcess::slotIndexingFile()
             Q_EMIT finishedIndexingFile(arg);
             break;
 
+        case 'M':
+            Metrics::instance()->merge(QJsonDocument::fromJson(arg.toUtf8()).object().toVariantMap());
+            break;
+
+        case 'T':
+            Tracer::instance()->merge(QJsonDocument::fromJson(arg.toUtf8()).array().toVariantList());
+            break;
+
         case 'B':
             Q_EMIT done();
             m_extractorIdle = true;
@@ -62,6 +62,10 @@ FileIndexerConfig::FileIndexerConfig(QObject* parent)
     , m_devices(new StorageDevices(this))
 {
     forceConfigUpdate();
+
+    connect(m_devices, &StorageDevices::deviceAdded, this, &FileIndexerConfig::updateFolderCache);
+    connect(m_devices, &StorageDevices::deviceRemoved, this, &FileIndexerConfig::updateFolderCache);
+    connect(m_devices, &StorageDevices::deviceAccessibilityChanged, this, &FileIndexerConfig::updateFolderCache);
 }
 
 
@@ -74,7 +78,7 @@ QStringList FileIndexerConfig::includeFolders() const
 {
     QStringList fl;
     for (int i = 0; i < m_folderCache.count(); ++i) {
-        if (m_folderCache[i].second)
+        if (m_folderCache[i].second && !m_removableMedia.contains(m_folderCache[i].first))
             fl << m_folderCache[i].first;
     }
     return fl;
@@ -283,6 +287,9 @@ void FileIndexerConfig::buildFolderCache()
     QStringList includeFoldersPlain = group.readPathEntry("folders", QStringList() << QDir::homePath());
     QStringList excludeFoldersPlain = group.readPathEntry("exclude folders", QStringList());
 
+    const bool indexRemovableMedia = group.readEntry("index removable media", false);
+    QStringList removableMedia;
+
     // Add all removable media and network shares as ignored unless they have
     // been explicitly added in the include list
     for (auto device: m_devices->allMedia()) {
@@ -290,15 +297,58 @@ void FileIndexerConfig::buildFolderCache()
         if (!device.isUsable() && !mountPath.isEmpty()) {
             if (!includeFoldersPlain.contains(mountPath)) {
                 excludeFoldersPlain << mountPath;
+
+                if (indexRemovableMedia && device.isRemovable()) {
+                    removableMedia << mountPath;
+                }
             }
         }
     }
 
     m_folderCache.clear();
+    m_removableMedia.clear();
     insertSortFolders(includeFoldersPlain, true, m_folderCache);
     insertSortFolders(excludeFoldersPlain, false, m_folderCache);
 
     cleanupList(m_folderCache);
+
+    // The media mounted within the indexed folders stay excluded, as they
+    // would otherwise end up in the main index as well
+    for (const QString& mountPath : removableMedia) {
+        if (!folderInFolderList(QFileInfo(mountPath).absolutePath())) {
+            m_removableMedia << mountPath;
+        }
+    }
+
+    if (!m_removableMedia.isEmpty()) {
+        for (const QString& mountPath : m_removableMedia) {
+            excludeFoldersPlain.removeOne(mountPath);
+        }
+
+        m_folderCache.clear();
+        insertSortFolders(includeFoldersPlain + m_removableMedia, true, m_folderCache);
+        insertSortFolders(excludeFoldersPlain, false, m_folderCache);
+
+        cleanupList(m_folderCache);
+    }
+}
+
+// Tells about the removable media which have been added to or dropped from the indexed folders
+void FileIndexerConfig::updateFolderCache()
+{
+    const QStringList previous = m_removableMedia;
+    buildFolderCache();
+
+    for (const QString& mountPath : m_removableMedia) {
+        if (!previous.contains(mountPath)) {
+            Q_EMIT removableMediaMounted(mountPath);
+        }
+    }
+    for (const QString& mountPath : previous) {
+        if (!m_removableMedia.contains(mountPath)) {
+            Q_EMIT removableMediaUnmounted(mountPath);
+        }
+    }
 }
 
 
@@ -317,7 +367,7 @@ void FileIndexerConfig::forceConfigUpdate()
 {
     m_config.reparseConfiguration();
 
-    buildFolderCache();
+    updateFolderCache();
     buildExcludeFilterRegExpCache();
     buildMimeTypeCache();
 
@@ -352,3 +402,45 @@ bool FileIndexerConfig::indexingEnabled() const
     return m_config.group("Basic Settings").readEntry("Indexing-Enabled", true);
 }
 
+// The sizes are configured in MiB
+quint64 FileIndexerConfig::initialIndexSize() const
+{
+    return m_config.group("General").readEntry("initial index size", 256) * Q_UINT64_C(1024 * 1024);
+}
+
+quint64 FileIndexerConfig::maximumIndexSize() const
+{
+    const int defaultSize = sizeof(size_t) > 4 ? 256 * 1024 : 1024;
+    return m_config.group("General").readEntry("maximum index size", defaultSize) * Q_UINT64_C(1024 * 1024);
+}
+
+int FileIndexerConfig::commitInterval() const
+{
+    return qMax(0, m_config.group("General").readEntry("commit interval", 1000));
+}
+
+int FileIndexerConfig::commitBatchSize() const
+{
+    return qMax(1, m_config.group("General").readEntry("commit batch size", 100));
+}
+
+int FileIndexerConfig::syncInterval() const
+{
+    return qMax(0, m_config.group("General").readEntry("sync interval", 5000));
+}
+
+bool FileIndexerConfig::indexRemovableMedia() const
+{
+    return m_config.group("General").readEntry("index removable media", false);
+}
+
+QStringList FileIndexerConfig::removableMediaFolders() const
+{
+    return m_removableMedia;
+}
+
+bool FileIndexerConfig::indexFileNameSubstrings() const
+{
+    return m_config.group("General").readEntry("index filename substrings", false);
+}
+
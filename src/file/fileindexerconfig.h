@@ -146,6 +146,56 @@ public:
 
     bool indexingEnabled() const;
 
+    /**
+     * The size in bytes the index starts out with, and the size it may
+     * grow up to. See Database::setMapSizeLimits
+     */
+    quint64 initialIndexSize() const;
+    quint64 maximumIndexSize() const;
+
+    /**
+     * The changes of the file watcher are committed at most this many
+     * milliseconds after they were made, or once this many of them are
+     * pending. See IndexWriter
+     */
+    int commitInterval() const;
+    int commitBatchSize() const;
+
+    /**
+     * The commits are written to disk at least this often, in
+     * milliseconds, which bounds what is lost when the system crashes.
+     * 0 writes every commit to disk right away.
+     */
+    int syncInterval() const;
+
+    /**
+     * Removable media which are mounted outside of the indexed folders
+     * are indexed into an index of their own on the device, see
+     * DatabaseShards. This is off by default.
+     */
+    bool indexRemovableMedia() const;
+
+    /**
+     * The mount points of the removable media which are currently
+     * indexed into their own index. They are not part of includeFolders.
+     */
+    QStringList removableMediaFolders() const;
+
+    /**
+     * Whether any part of the file names can be searched for, not only
+     * their words, see Database::setFileNameTrigrams. The change is only
+     * applied the next time the indexer starts. This is off by default.
+     */
+    bool indexFileNameSubstrings() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted when a removable medium which is indexed on its own
+     * has been mounted at \p mountPath
+     */
+    void removableMediaMounted(const QString& mountPath);
+    void removableMediaUnmounted(const QString& mountPath);
+
 public Q_SLOTS:
     /**
      * Reread the config from disk and update the configuration cache.
@@ -162,6 +212,9 @@ public Q_SLOTS:
      */
     void setInitialRun(bool isInitialRun);
 
+private Q_SLOTS:
+    void updateFolderCache();
+
 private:
 
     void buildFolderCache();
@@ -173,6 +226,9 @@ private:
     /// Caching cleaned up list (no duplicates, no useless entries, etc.)
     QList<QPair<QString, bool> > m_folderCache;
 
+    /// The included removable media, which have an index of their own
+    QStringList m_removableMedia;
+
     /// cache of regexp objects for all exclude filters
     /// to prevent regexp parsing over and over
     RegExpCache m_excludeFilterRegExpCache;
@@ -26,6 +26,9 @@
 #include "filecontentindexer.h"
 #include "filecontentindexerprovider.h"
 #include "unindexedfileindexer.h"
+#include "indexcompactor.h"
+#include "indexwriter.h"
+#include "deviceindexer.h"
 
 #include "fileindexerconfig.h"
 
@@ -35,21 +38,27 @@
 
 using namespace Baloo;
 
-FileIndexScheduler::FileIndexScheduler(Database* db, FileIndexerConfig* config, QObject* parent)
+FileIndexScheduler::FileIndexScheduler(Database* db, FileIndexerConfig* config, IndexWriter* writer, QObject* parent)
     : QObject(parent)
     , m_db(db)
     , m_config(config)
+    , m_writer(writer)
     , m_provider(db)
     , m_contentIndexer(0)
     , m_indexerState(Idle)
     , m_timeEstimator(this)
     , m_checkUnindexedFiles(false)
+    , m_compact(false)
 {
     Q_ASSERT(db);
     Q_ASSERT(config);
+    Q_ASSERT(writer);
 
     m_threadPool.setMaxThreadCount(1);
 
+    // The files to be content indexed are only known once they are committed
+    connect(m_writer, &IndexWriter::committed, this, &FileIndexScheduler::scheduleIndexing);
+
     connect(&m_powerMonitor, &PowerStateMonitor::powerManagementStatusChanged,
             this, &FileIndexScheduler::powerManagementStatusChanged);
 
@@ -60,6 +69,11 @@ FileIndexScheduler::FileIndexScheduler(Database* db, FileIndexerConfig* config,
     connect(m_contentIndexer, &FileContentIndexer::newBatchTime, &m_timeEstimator,
             &TimeEstimator::handleNewBatchTime);
 
+    connect(m_config, &FileIndexerConfig::removableMediaMounted, this, &FileIndexScheduler::indexRemovableMedia);
+    for (const QString& mountPath : m_config->removableMediaFolders()) {
+        indexRemovableMedia(mountPath);
+    }
+
     QDBusConnection::sessionBus().registerObject(QStringLiteral("/scheduler"),
                                                  this, QDBusConnection::ExportScriptableContents);
 }
@@ -67,6 +81,7 @@ FileIndexScheduler::FileIndexScheduler(Database* db, FileIndexerConfig* config,
 FileIndexScheduler::~FileIndexScheduler()
 {
     m_threadPool.waitForDone(0); // wait 0 msecs
+    m_deviceThreadPool.waitForDone(0);
 }
 
 void FileIndexScheduler::scheduleIndexing()
@@ -76,7 +91,7 @@ void FileIndexScheduler::scheduleIndexing()
     }
 
     if (m_config->isInitialRun()) {
-        auto runnable = new FirstRunIndexer(m_db, m_config, m_config->includeFolders());
+        auto runnable = new FirstRunIndexer(m_writer, m_config, m_config->includeFolders());
         connect(runnable, &FirstRunIndexer::done, this, &FileIndexScheduler::scheduleIndexing);
 
         m_threadPool.start(runnable);
@@ -86,7 +101,7 @@ void FileIndexScheduler::scheduleIndexing()
     }
 
     if (!m_newFiles.isEmpty()) {
-        auto runnable = new NewFileIndexer(m_db, m_config, m_newFiles);
+        auto runnable = new NewFileIndexer(m_writer, m_config, m_newFiles);
         connect(runnable, &NewFileIndexer::done, this, &FileIndexScheduler::scheduleIndexing);
 
         m_threadPool.start(runnable);
@@ -97,7 +112,7 @@ void FileIndexScheduler::scheduleIndexing()
     }
 
     if (!m_modifiedFiles.isEmpty()) {
-        auto runnable = new ModifiedFileIndexer(m_db, m_config, m_modifiedFiles);
+        auto runnable = new ModifiedFileIndexer(m_writer, m_config, m_modifiedFiles);
         connect(runnable, &ModifiedFileIndexer::done, this, &FileIndexScheduler::scheduleIndexing);
 
         m_threadPool.start(runnable);
@@ -108,7 +123,7 @@ void FileIndexScheduler::scheduleIndexing()
     }
 
     if (!m_xattrFiles.isEmpty()) {
-        auto runnable = new XAttrIndexer(m_db, m_config, m_xattrFiles);
+        auto runnable = new XAttrIndexer(m_writer, m_config, m_xattrFiles);
         connect(runnable, &XAttrIndexer::done, this, &FileIndexScheduler::scheduleIndexing);
 
         m_threadPool.start(runnable);
@@ -135,6 +150,29 @@ void FileIndexScheduler::scheduleIndexing()
         Q_EMIT stateChanged(m_indexerState);
         return;
     }
+
+    // Looking for free pages is cheap, but compacting is not, so this
+    // is only done every once in a while
+    if (!m_compact && !m_powerMonitor.isOnBattery()
+        && (!m_lastCompactionCheck.isValid() || m_lastCompactionCheck.elapsed() > 60 * 60 * 1000)) {
+        m_lastCompactionCheck.start();
+        m_compact = IndexCompactor::shouldCompact(m_db);
+    }
+
+    if (m_compact) {
+        auto runnable = new IndexCompactor(m_db);
+        connect(runnable, &IndexCompactor::done, this, [this](qint64 reclaimedBytes) {
+            Q_EMIT compacted(reclaimedBytes);
+            scheduleIndexing();
+        });
+
+        m_threadPool.start(runnable);
+        m_compact = false;
+        m_indexerState = Compacting;
+        Q_EMIT stateChanged(m_indexerState);
+        return;
+    }
+
     m_indexerState = Idle;
     Q_EMIT stateChanged(m_indexerState);
 }
@@ -164,6 +202,22 @@ void FileIndexScheduler::handleFileRemoved(const QString& file)
     }
 }
 
+void FileIndexScheduler::indexRemovableMedia(const QString& mountPath)
+{
+    // It is brought up to date on the next mount otherwise
+    if (m_indexedDevices.contains(mountPath)) {
+        return;
+    }
+
+    auto runnable = new DeviceIndexer(m_config, mountPath);
+    connect(runnable, &DeviceIndexer::done, this, [this](const QString& mountPath) {
+        m_indexedDevices.removeOne(mountPath);
+    });
+
+    m_deviceThreadPool.start(runnable);
+    m_indexedDevices << mountPath;
+}
+
 void FileIndexScheduler::powerManagementStatusChanged(bool isOnBattery)
 {
     qDebug() << "Power state changed";
@@ -208,3 +262,9 @@ void FileIndexScheduler::checkUnindexedFiles()
     m_checkUnindexedFiles = true;
     scheduleIndexing();
 }
+
+void FileIndexScheduler::compact()
+{
+    m_compact = true;
+    scheduleIndexing();
+}
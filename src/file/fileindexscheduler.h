@@ -24,6 +24,7 @@
 #include <QStringList>
 #include <QThreadPool>
 #include <QTimer>
+#include <QElapsedTimer>
 
 #include "filecontentindexerprovider.h"
 #include "powerstatemonitor.h"
@@ -35,6 +36,7 @@ namespace Baloo {
 class Database;
 class FileIndexerConfig;
 class FileContentIndexer;
+class IndexWriter;
 
 class FileIndexScheduler : public QObject
 {
@@ -43,13 +45,19 @@ class FileIndexScheduler : public QObject
 
     Q_PROPERTY(int state READ state NOTIFY stateChanged)
 public:
-    FileIndexScheduler(Database* db, FileIndexerConfig* config, QObject* parent = 0);
+    FileIndexScheduler(Database* db, FileIndexerConfig* config, IndexWriter* writer, QObject* parent = 0);
     ~FileIndexScheduler() Q_DECL_OVERRIDE;
     int state() const { return m_indexerState; }
 
 Q_SIGNALS:
     Q_SCRIPTABLE void stateChanged(int state);
 
+    /**
+     * Emitted once the index has been compacted. \p reclaimedBytes is -1
+     * if that failed.
+     */
+    Q_SCRIPTABLE void compacted(qlonglong reclaimedBytes);
+
 public Q_SLOTS:
     void indexNewFile(const QString& file) {
         if (!m_newFiles.contains(file)) {
@@ -74,6 +82,13 @@ public Q_SLOTS:
 
     void handleFileRemoved(const QString& file);
 
+    /**
+     * Updates the index kept on the removable medium mounted at
+     * \p mountPath. The media are indexed in parallel to each other and
+     * to the main index, as each of them has an index of its own.
+     */
+    void indexRemovableMedia(const QString& mountPath);
+
     void scheduleIndexing();
 
     Q_SCRIPTABLE void suspend() { setSuspend(true); }
@@ -81,6 +96,13 @@ public Q_SLOTS:
     Q_SCRIPTABLE uint getRemainingTime();
     Q_SCRIPTABLE void checkUnindexedFiles();
 
+    /**
+     * Compacts the index once the indexing is done, see Database::compact.
+     * This also happens on its own when the indexer is idle and most of
+     * the index consists of free pages.
+     */
+    Q_SCRIPTABLE void compact();
+
 private Q_SLOTS:
     void powerManagementStatusChanged(bool isOnBattery);
 
@@ -89,6 +111,7 @@ private:
 
     Database* m_db;
     FileIndexerConfig* m_config;
+    IndexWriter* m_writer;
 
     QStringList m_newFiles;
     QStringList m_modifiedFiles;
@@ -96,6 +119,9 @@ private:
 
     QThreadPool m_threadPool;
 
+    QThreadPool m_deviceThreadPool;
+    QStringList m_indexedDevices;
+
     FileContentIndexerProvider m_provider;
     FileContentIndexer* m_contentIndexer;
 
@@ -105,6 +131,9 @@ private:
     TimeEstimator m_timeEstimator;
 
     bool m_checkUnindexedFiles;
+
+    bool m_compact;
+    QElapsedTimer m_lastCompactionCheck;
 };
 
 }
@@ -73,6 +73,11 @@ FileWatch::~FileWatch()
 {
 }
 
+void FileWatch::setIndexWriter(IndexWriter* writer)
+{
+    m_metadataMover->setIndexWriter(writer);
+}
+
 void FileWatch::watchIndexedFolders()
 {
     // Watch all indexed folders
@@ -28,6 +28,7 @@ namespace Baloo
 {
 class Database;
 class MetadataMover;
+class IndexWriter;
 class FileIndexerConfig;
 class PendingFileQueue;
 class FileWatchTest;
@@ -40,6 +41,11 @@ public:
     FileWatch(Database* db, FileIndexerConfig* config, QObject* parent = 0);
     ~FileWatch();
 
+    /**
+     * The moved and removed files are then written by \p writer
+     */
+    void setIndexWriter(IndexWriter* writer);
+
 public Q_SLOTS:
     /**
      * To be called whenever the list of indexed folders changes. This is done because
@@ -21,67 +21,141 @@
 #include "basicindexingjob.h"
 #include "fileindexerconfig.h"
 #include "filtereddiriterator.h"
+#include "indexwriter.h"
 
 #include "database.h"
 #include "transaction.h"
+#include "indexbuilder.h"
+#include "document.h"
+#include "tracing.h"
 
 #include <QMimeDatabase>
+#include <QVector>
+#include <QDebug>
+
+#include <functional>
 
 using namespace Baloo;
 
-FirstRunIndexer::FirstRunIndexer(Database* db, FileIndexerConfig* config, const QStringList& folders)
-    : m_db(db)
+FirstRunIndexer::FirstRunIndexer(IndexWriter* writer, FileIndexerConfig* config, const QStringList& folders)
+    : m_writer(writer)
+    , m_db(writer->database())
     , m_config(config)
     , m_folders(folders)
 {
-    Q_ASSERT(m_db);
+    Q_ASSERT(m_writer);
     Q_ASSERT(m_config);
     Q_ASSERT(!m_folders.isEmpty());
 }
 
+/**
+ * Calls \p fn with the document of each of the files in \p folder which
+ * should be indexed
+ */
+static void indexFolder(FileIndexerConfig* config, const QString& folder,
+                        const std::function<void(const Document&)>& fn)
+{
+    QMimeDatabase mimeDb;
+
+    FilteredDirIterator it(config, folder);
+    while (!it.next().isEmpty()) {
+        QString mimetype = mimeDb.mimeTypeForFile(it.filePath(), QMimeDatabase::MatchExtension).name();
+        if (!config->shouldMimeTypeBeIndexed(mimetype)) {
+            continue;
+        }
+        BasicIndexingJob::IndexingLevel level =
+            config->onlyBasicIndexing() ? BasicIndexingJob::NoLevel : BasicIndexingJob::MarkForContentIndexing;
+        BasicIndexingJob job(it.filePath(), mimetype, level);
+        if (!job.index()) {
+            continue;
+        }
+        fn(job.document());
+    }
+}
+
 void FirstRunIndexer::run()
 {
+    BALOO_TRACE_SPAN("indexer", "FirstRunIndexer::run");
+
     Q_ASSERT(m_config->isInitialRun());
+
+    // Neither the builder nor the transactions below may interleave with
+    // the batches of the writer, e.g. the ones of the MetadataMover
+    m_writer->pause();
+
+    bool empty;
     {
         Transaction tr(m_db, Transaction::ReadOnly);
-        Q_ASSERT_X(tr.size() == 0, "FirstRunIndexer", "The database is not empty on first run");
+        empty = tr.isEmpty();
     }
 
-    QMimeDatabase mimeDb;
-
-    for (const QString& folder : m_folders) {
-        Transaction tr(m_db, Transaction::ReadWrite);
+    // The documents of an interrupted build may be missing their terms,
+    // which updating the index would not add
+    if (!empty && IndexBuilder::isIncomplete(m_db)) {
+        qWarning() << "FirstRunIndexer: Building the partially built index again";
+        empty = m_db->write([](Transaction* tr) {
+            tr->clear();
+        });
+    }
 
-        FilteredDirIterator it(m_config, folder);
-        while (!it.next().isEmpty()) {
-            QString mimetype = mimeDb.mimeTypeForFile(it.filePath(), QMimeDatabase::MatchExtension).name();
-            if (!m_config->shouldMimeTypeBeIndexed(mimetype)) {
-                continue;
-            }
-            BasicIndexingJob::IndexingLevel level =
-                m_config->onlyBasicIndexing() ? BasicIndexingJob::NoLevel : BasicIndexingJob::MarkForContentIndexing;
-            BasicIndexingJob job(it.filePath(), mimetype, level);
-            if (!job.index()) {
-                continue;
-            }
+    bool ok = true;
+    if (empty) {
+        ok = build();
+    } else {
+        update();
+    }
 
-            // Even though this is the first run, because 2 hard links will resolve to the same id,
-            // we land up crashing (due to the asserts in addDocument).
-            // Hence we are checking before.
-            // FIXME: Silently ignore hard links!
-            //
-            if (tr.hasDocument(job.document().id())) {
-                continue;
-            }
-            tr.addDocument(job.document());
-        }
+    m_writer->resume();
 
-        // FIXME: This would consume too much memory. We should make some more commits
-        //        based on how much memory we consume
-        tr.commit();
+    // The next run builds the index again, see IndexBuilder::isIncomplete
+    if (!ok) {
+        qWarning() << "FirstRunIndexer: Could not build the index";
+        Q_EMIT done();
+        return;
     }
 
     m_config->setInitialRun(false);
 
     Q_EMIT done();
 }
+
+bool FirstRunIndexer::build()
+{
+    // The index is empty, so it can be built in one go which is much
+    // faster than committing the documents a folder at a time
+    IndexBuilder builder(m_db);
+
+    for (const QString& folder : m_folders) {
+        // Even though this is the first run, 2 hard links will resolve to the same id.
+        // The builder only keeps the first of them.
+        // FIXME: Silently ignore hard links!
+        indexFolder(m_config, folder, [&builder](const Document& doc) {
+            builder.addDocument(doc);
+        });
+    }
+
+    return builder.finish();
+}
+
+void FirstRunIndexer::update()
+{
+    for (const QString& folder : m_folders) {
+        QVector<Document> documents;
+        indexFolder(m_config, folder, [&documents](const Document& doc) {
+            documents << doc;
+        });
+
+        // The documents of an earlier run are kept as they are. Two hard
+        // links also resolve to the same id, and would crash addDocument.
+        // FIXME: Silently ignore hard links!
+        // FIXME: This would consume too much memory. We should make some more commits
+        //        based on how much memory we consume
+        m_db->write([&documents](Transaction* tr) {
+            for (const Document& doc : documents) {
+                if (!tr->hasDocument(doc.id())) {
+                    tr->addDocument(doc);
+                }
+            }
+        });
+    }
+}
@@ -28,12 +28,13 @@ namespace Baloo {
 
 class Database;
 class FileIndexerConfig;
+class IndexWriter;
 
 class FirstRunIndexer : public QObject, public QRunnable
 {
     Q_OBJECT
 public:
-    FirstRunIndexer(Database* db, FileIndexerConfig* config, const QStringList& folders);
+    FirstRunIndexer(IndexWriter* writer, FileIndexerConfig* config, const QStringList& folders);
 
     void run() Q_DECL_OVERRIDE;
 
@@ -41,6 +42,19 @@ Q_SIGNALS:
     void done();
 
 private:
+    /**
+     * Builds the index in one go, which is only possible if it is empty
+     */
+    bool build();
+
+    /**
+     * Adds the documents which are not in the index yet, a folder at a
+     * time. This is needed when a first run was interrupted while
+     * updating the index, or the indexing was enabled again.
+     */
+    void update();
+
+    IndexWriter* m_writer;
     Database* m_db;
     FileIndexerConfig* m_config;
 
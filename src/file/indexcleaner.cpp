@@ -42,40 +42,39 @@ void IndexCleaner::run()
 {
     QMimeDatabase mimeDb;
 
-    Transaction tr(m_db, Transaction::ReadWrite);
+    m_db->write([this, &mimeDb](Transaction* tr) {
+        auto shouldDelete = [&](quint64 id) {
+            if (!id) {
+                return false;
+            }
 
-    auto shouldDelete = [&](quint64 id) {
-        if (!id) {
-            return false;
-        }
+            QString url = tr->documentUrl(id);
 
-        QString url = tr.documentUrl(id);
-
-        if (!QFile::exists(url)) {
-            qDebug() << "not exists: " << url;
-            return true;
-        }
+            if (!QFile::exists(url)) {
+                qDebug() << "not exists: " << url;
+                return true;
+            }
 
-        if (!m_config->shouldBeIndexed(url)) {
-            qDebug() << "should not be indexed: " << url;
-            return true;
-        }
+            if (!m_config->shouldBeIndexed(url)) {
+                qDebug() << "should not be indexed: " << url;
+                return true;
+            }
 
-        // FIXME: This mimetype is not completely accurate!
-        QString mimetype = mimeDb.mimeTypeForFile(url, QMimeDatabase::MatchExtension).name();
-        if (!m_config->shouldMimeTypeBeIndexed(mimetype)) {
-            qDebug() << "mimetype should not be indexed: " << url << mimetype;
-            return true;
-        }
+            // FIXME: This mimetype is not completely accurate!
+            QString mimetype = mimeDb.mimeTypeForFile(url, QMimeDatabase::MatchExtension).name();
+            if (!m_config->shouldMimeTypeBeIndexed(mimetype)) {
+                qDebug() << "mimetype should not be indexed: " << url << mimetype;
+                return true;
+            }
 
-        return false;
-    };
+            return false;
+        };
 
-    for (const QString& folder : m_config->includeFolders()) {
-        quint64 id = filePathToId(QFile::encodeName(folder));
-        tr.removeRecursively(id, shouldDelete);
-    }
-    tr.commit();
+        for (const QString& folder : m_config->includeFolders()) {
+            quint64 id = filePathToId(QFile::encodeName(folder));
+            tr->removeRecursively(id, shouldDelete);
+        }
+    });
 
     Q_EMIT done();
 }
@@ -0,0 +1,63 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "indexcompactor.h"
+
+#include "database.h"
+#include "transaction.h"
+#include "databasesize.h"
+#include "metrics.h"
+#include "tracing.h"
+
+#include <QDebug>
+
+using namespace Baloo;
+
+// Compacting rewrites the whole index, so smaller gains are not worth it
+static const qint64 s_minimumReclaimedSize = 64 * 1024 * 1024;
+
+IndexCompactor::IndexCompactor(Database* db)
+    : m_db(db)
+{
+}
+
+void IndexCompactor::run()
+{
+    BALOO_TRACE_SPAN("indexer", "IndexCompactor::run");
+
+    const qint64 reclaimed = m_db->compact();
+    if (reclaimed >= 0) {
+        static MetricsCounter* reclaimedBytes = Metrics::instance()->counter(QStringLiteral("database.compaction.reclaimed.bytes"));
+        reclaimedBytes->add(reclaimed);
+        qDebug() << "Compacting the index reclaimed" << reclaimed << "bytes";
+    }
+
+    Q_EMIT done(reclaimed);
+}
+
+bool IndexCompactor::shouldCompact(Database* db)
+{
+    quint64 liveSize;
+    {
+        Transaction tr(db, Transaction::ReadOnly);
+        liveSize = tr.dbSize().expectedSize;
+    }
+
+    const quint64 usedSize = db->usedSize();
+    return usedSize > 2 * liveSize && usedSize - liveSize >= s_minimumReclaimedSize;
+}
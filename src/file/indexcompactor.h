@@ -0,0 +1,57 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#ifndef BALOO_INDEXCOMPACTOR_H
+#define BALOO_INDEXCOMPACTOR_H
+
+#include <QRunnable>
+#include <QObject>
+
+namespace Baloo {
+
+class Database;
+
+/**
+ * Compacts the index, see Database::compact
+ */
+class IndexCompactor : public QObject, public QRunnable
+{
+    Q_OBJECT
+public:
+    explicit IndexCompactor(Database* db);
+
+    void run() Q_DECL_OVERRIDE;
+
+    /**
+     * Returns true if most of the index file consists of free pages, so
+     * that compacting it is worth the while
+     */
+    static bool shouldCompact(Database* db);
+
+Q_SIGNALS:
+    /**
+     * \p reclaimedBytes is -1 if the index could not be compacted
+     */
+    void done(qint64 reclaimedBytes);
+
+private:
+    Database* m_db;
+};
+}
+
+#endif // BALOO_INDEXCOMPACTOR_H
@@ -0,0 +1,243 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#include "indexwriter.h"
+
+#include "database.h"
+#include "transaction.h"
+#include "metrics.h"
+#include "tracing.h"
+
+using namespace Baloo;
+
+IndexWriter::IndexWriter(Database* db, QObject* parent)
+    : QThread(parent)
+    , m_db(db)
+    , m_commitInterval(1000)
+    , m_commitBatchSize(100)
+    , m_syncInterval(5000)
+    , m_submitted(0)
+    , m_committed(0)
+    , m_synced(0)
+    , m_flushes(0)
+    , m_pauses(0)
+    , m_committing(false)
+    , m_stop(false)
+{
+    Q_ASSERT(db);
+    m_clock.start();
+}
+
+IndexWriter::~IndexWriter()
+{
+    if (isRunning()) {
+        stop();
+    }
+}
+
+void IndexWriter::setCommitInterval(int msecs)
+{
+    QMutexLocker lock(&m_mutex);
+    m_commitInterval = msecs;
+}
+
+void IndexWriter::setCommitBatchSize(int batches)
+{
+    QMutexLocker lock(&m_mutex);
+    m_commitBatchSize = batches;
+}
+
+void IndexWriter::setSyncInterval(int msecs)
+{
+    Q_ASSERT(!isRunning());
+    m_syncInterval = msecs;
+}
+
+void IndexWriter::submit(const Batch& batch)
+{
+    QMutexLocker lock(&m_mutex);
+
+    PendingBatch pending;
+    pending.batch = batch;
+    pending.submitted = m_clock.nsecsElapsed() / 1000;
+    m_pending.append(pending);
+    m_submitted++;
+
+    m_pendingCondition.wakeOne();
+}
+
+void IndexWriter::flush()
+{
+    QMutexLocker lock(&m_mutex);
+    if (!isRunning()) {
+        return;
+    }
+
+    const quint64 submitted = m_submitted;
+    m_flushes++;
+    m_pendingCondition.wakeOne();
+    while (m_synced < submitted) {
+        m_syncedCondition.wait(&m_mutex);
+    }
+    m_flushes--;
+}
+
+void IndexWriter::pause()
+{
+    QMutexLocker lock(&m_mutex);
+    m_pauses++;
+    while (m_committing) {
+        m_idleCondition.wait(&m_mutex);
+    }
+}
+
+void IndexWriter::resume()
+{
+    QMutexLocker lock(&m_mutex);
+    Q_ASSERT(m_pauses > 0);
+    m_pauses--;
+    m_pendingCondition.wakeOne();
+}
+
+void IndexWriter::stop()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        m_stop = true;
+        m_pendingCondition.wakeOne();
+    }
+    wait();
+}
+
+void IndexWriter::run()
+{
+    static MetricsHistogram* syncTime = Metrics::instance()->histogram(QStringLiteral("indexwriter.sync.usecs"));
+
+    // Each commit then only waits for its data pages to be written to
+    // disk, and not for the meta page as well
+    if (m_syncInterval > 0) {
+        m_db->setNoSync(true);
+    }
+
+    QElapsedTimer lastSync;
+    lastSync.start();
+
+    QMutexLocker lock(&m_mutex);
+    while (true) {
+        // Wait for the first batch, or until the commits have to be written to disk
+        while (m_pending.isEmpty() && !m_stop && !(m_flushes && m_synced < m_committed)) {
+            if (m_synced == m_committed) {
+                m_pendingCondition.wait(&m_mutex);
+                continue;
+            }
+
+            const qint64 remaining = m_syncInterval - lastSync.elapsed();
+            if (remaining <= 0) {
+                break;
+            }
+            m_pendingCondition.wait(&m_mutex, remaining);
+        }
+
+        while (m_pauses && !m_stop) {
+            m_pendingCondition.wait(&m_mutex);
+        }
+
+        if (!m_pending.isEmpty()) {
+            // Give the others some time to submit their batches as well
+            while (!m_stop && !m_flushes && m_pending.size() < m_commitBatchSize) {
+                const qint64 waited = (m_clock.nsecsElapsed() / 1000 - m_pending.first().submitted) / 1000;
+                const qint64 remaining = m_commitInterval - waited;
+                if (remaining <= 0) {
+                    break;
+                }
+                m_pendingCondition.wait(&m_mutex, remaining);
+            }
+
+            // Paused while waiting for them
+            if (m_pauses && !m_stop) {
+                continue;
+            }
+
+            QVector<PendingBatch> batches;
+            batches.swap(m_pending);
+
+            m_committing = true;
+            lock.unlock();
+            commit(batches);
+            Q_EMIT committed();
+            lock.relock();
+            m_committing = false;
+            m_idleCondition.wakeAll();
+
+            m_committed += batches.size();
+            if (m_syncInterval == 0) {
+                m_synced = m_committed;
+                m_syncedCondition.wakeAll();
+            }
+        }
+
+        if (m_synced < m_committed && (m_stop || m_flushes || lastSync.elapsed() >= m_syncInterval)) {
+            const quint64 committed = m_committed;
+
+            lock.unlock();
+            {
+                MetricsTimer timer(syncTime);
+                m_db->sync();
+            }
+            lastSync.restart();
+            lock.relock();
+
+            m_synced = committed;
+            m_syncedCondition.wakeAll();
+        }
+
+        if (m_stop && m_pending.isEmpty() && m_synced == m_committed) {
+            break;
+        }
+    }
+
+    if (m_syncInterval > 0) {
+        m_db->setNoSync(false);
+    }
+}
+
+void IndexWriter::commit(const QVector<PendingBatch>& batches)
+{
+    BALOO_TRACE_SPAN("indexer", "IndexWriter::commit");
+
+    static MetricsHistogram* commitTime = Metrics::instance()->histogram(QStringLiteral("indexwriter.commit.usecs"));
+    static MetricsHistogram* commitBatches = Metrics::instance()->histogram(QStringLiteral("indexwriter.commit.batches"));
+    static MetricsHistogram* latency = Metrics::instance()->histogram(QStringLiteral("indexwriter.latency.usecs"));
+
+    {
+        MetricsTimer timer(commitTime);
+
+        m_db->write([&batches](Transaction* tr) {
+            for (const PendingBatch& pending : batches) {
+                pending.batch(tr);
+            }
+        });
+    }
+
+    // The time from submitting each batch until it was committed
+    const qint64 now = m_clock.nsecsElapsed() / 1000;
+    for (const PendingBatch& pending : batches) {
+        latency->record(now - pending.submitted);
+    }
+    commitBatches->record(batches.size());
+}
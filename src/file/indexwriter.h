@@ -0,0 +1,142 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+#ifndef BALOO_INDEXWRITER_H
+#define BALOO_INDEXWRITER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QVector>
+
+#include <functional>
+
+namespace Baloo {
+
+class Database;
+class Transaction;
+
+/**
+ * The single writer of baloo_file.
+ *
+ * The indexers and the file watcher submit their changes as batches,
+ * which are run by the writer thread. The batches which arrive within
+ * the commit interval are coalesced into a single write transaction, so
+ * a burst of small changes costs one commit instead of one each.
+ *
+ * The commits only wait for their data to be written to disk. The meta
+ * page which makes a commit durable is written along with the next
+ * commit, or at the latest after the sync interval. A system crash can
+ * therefore undo the last commit, but never leaves a corrupt index.
+ */
+class IndexWriter : public QThread
+{
+    Q_OBJECT
+public:
+    typedef std::function<void(Transaction*)> Batch;
+
+    explicit IndexWriter(Database* db, QObject* parent = 0);
+    ~IndexWriter();
+
+    Database* database() const { return m_db; }
+
+    /**
+     * The batches are committed at most \p msecs after the first of them
+     * was submitted, or once \p batches of them are pending
+     */
+    void setCommitInterval(int msecs);
+    void setCommitBatchSize(int batches);
+
+    /**
+     * The commits are written to disk at least every \p msecs. With 0
+     * each commit is written to disk before the next batch is run.
+     * This needs to be called before start.
+     */
+    void setSyncInterval(int msecs);
+
+    /**
+     * Queues \p batch to be run in the writer thread. The batches are
+     * run in the order they were submitted, and may read the changes of
+     * the earlier ones. They are run again if the map has to be grown,
+     * see Database::write.
+     */
+    void submit(const Batch& batch);
+
+    /**
+     * Blocks until all of the batches submitted so far have been
+     * committed and written to disk
+     */
+    void flush();
+
+    /**
+     * Blocks until the current commit is done, and then keeps the batches
+     * from being run until resume() is called, for the ones writing to the
+     * index directly. flush() blocks until then as well, while stop() does
+     * not wait for it.
+     */
+    void pause();
+    void resume();
+
+    /**
+     * Commits the pending batches, writes them to disk and stops the
+     * writer thread
+     */
+    void stop();
+
+Q_SIGNALS:
+    /**
+     * Emitted from the writer thread after each commit
+     */
+    void committed();
+
+protected:
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    struct PendingBatch {
+        Batch batch;
+        qint64 submitted;
+    };
+
+    void commit(const QVector<PendingBatch>& batches);
+
+    Database* m_db;
+
+    int m_commitInterval;
+    int m_commitBatchSize;
+    int m_syncInterval;
+
+    QMutex m_mutex;
+    QWaitCondition m_pendingCondition;
+    QWaitCondition m_syncedCondition;
+    QWaitCondition m_idleCondition;
+    QElapsedTimer m_clock;
+
+    QVector<PendingBatch> m_pending;
+    quint64 m_submitted;
+    quint64 m_committed;
+    quint64 m_synced;
+    int m_flushes;
+    int m_pauses;
+    bool m_committing;
+    bool m_stop;
+};
+}
+
+#endif // BALOO_INDEXWRITER_H
@@ -23,6 +23,8 @@
 #include "fileindexerconfig.h"
 #include "filtereddiriterator.h"
 #include "baloodebug.h"
+#include "metrics.h"
+#include "tracing.h"
 
 #include <QSocketNotifier>
 #include <QHash>
@@ -312,6 +314,8 @@ bool KInotify::removeWatch(const QString& path)
 
 void KInotify::slotEvent(int socket)
 {
+    BALOO_TRACE_SPAN("filewatch", "KInotify::slotEvent");
+
     int avail;
     if (ioctl(socket, FIONREAD, &avail) == EINVAL) {
         qCDebug(BALOO) << "Did not receive an entire inotify event.";
@@ -323,15 +327,20 @@ void KInotify::slotEvent(int socket)
     const int len = read(socket, buffer, avail);
     Q_ASSERT(len == avail);
 
+    static Baloo::MetricsCounter* eventCount = Baloo::Metrics::instance()->counter(QStringLiteral("inotify.events"));
+    static Baloo::MetricsCounter* overflowCount = Baloo::Metrics::instance()->counter(QStringLiteral("inotify.overflows"));
+
     int i = 0;
     while (i < len) {
         const struct inotify_event* event = (struct inotify_event*)&buffer[i];
+        eventCount->add();
 
         QByteArray path;
 
         // Overflow happens sometimes if we process the events too slowly
         if (event->wd < 0 && (event->mask & EventQueueOverflow)) {
             qWarning() << "Inotify - too many event - Overflowed";
+            overflowCount->add();
             free(buffer);
             return;
         }
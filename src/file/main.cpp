@@ -82,6 +82,8 @@ int main(int argc, char** argv)
     QFile::remove(path + "/index-lock");
 
     Baloo::Database *db = Baloo::globalDatabaseInstance();
+    db->setMapSizeLimits(indexerConfig.initialIndexSize(), indexerConfig.maximumIndexSize());
+    db->setFileNameTrigrams(indexerConfig.indexFileNameSubstrings());
     db->open(Baloo::Database::CreateDatabase);
 
     Baloo::MainHub hub(db, &indexerConfig);
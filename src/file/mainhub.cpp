@@ -20,22 +20,35 @@
 #include "mainhub.h"
 #include "fileindexerconfig.h"
 #include "mainadaptor.h"
+#include "metrics.h"
+#include "tracing.h"
 
 #include <QDBusConnection>
 #include <QCoreApplication>
 #include <QTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 
 using namespace Baloo;
 
 MainHub::MainHub(Database* db, FileIndexerConfig* config)
     : m_db(db)
     , m_config(config)
+    , m_indexWriter(db, this)
     , m_fileWatcher(db, config, this)
-    , m_fileIndexScheduler(db, config, this)
+    , m_fileIndexScheduler(db, config, &m_indexWriter, this)
 {
     Q_ASSERT(db);
     Q_ASSERT(config);
 
+    m_indexWriter.setCommitInterval(config->commitInterval());
+    m_indexWriter.setCommitBatchSize(config->commitBatchSize());
+    m_indexWriter.setSyncInterval(config->syncInterval());
+    m_indexWriter.start();
+
+    m_fileWatcher.setIndexWriter(&m_indexWriter);
+
     connect(&m_fileWatcher, &FileWatch::indexNewFile, &m_fileIndexScheduler, &FileIndexScheduler::indexNewFile);
     connect(&m_fileWatcher, &FileWatch::indexModifiedFile, &m_fileIndexScheduler, &FileIndexScheduler::indexModifiedFile);
     connect(&m_fileWatcher, &FileWatch::indexXAttr, &m_fileIndexScheduler, &FileIndexScheduler::indexXAttrFile);
@@ -53,14 +66,36 @@ MainHub::MainHub(Database* db, FileIndexerConfig* config)
     QTimer::singleShot(0, &m_fileWatcher, &FileWatch::watchIndexedFolders);
 }
 
+MainHub::~MainHub()
+{
+    // The pending batches may still use the file watcher
+    m_indexWriter.stop();
+}
+
 void MainHub::quit() const
 {
     QCoreApplication::instance()->quit();
 }
 
+QString MainHub::metrics() const
+{
+    const QVariantMap map = Metrics::instance()->toVariantMap();
+    return QString::fromUtf8(QJsonDocument(QJsonObject::fromVariantMap(map)).toJson(QJsonDocument::Compact));
+}
+
+QString MainHub::trace() const
+{
+    QJsonObject object;
+    object.insert(QStringLiteral("traceEvents"), QJsonArray::fromVariantList(Tracer::instance()->events()));
+    object.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ms"));
+    return QString::fromUtf8(QJsonDocument(object).toJson(QJsonDocument::Compact));
+}
+
 void MainHub::updateConfig()
 {
     m_config->forceConfigUpdate();
+    m_indexWriter.setCommitInterval(m_config->commitInterval());
+    m_indexWriter.setCommitBatchSize(m_config->commitBatchSize());
     // FIXME!!
     //m_fileIndexer.updateConfig();
     m_fileWatcher.updateIndexedFoldersWatches();
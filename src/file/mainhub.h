@@ -24,6 +24,7 @@
 
 #include "filewatch.h"
 #include "fileindexscheduler.h"
+#include "indexwriter.h"
 
 namespace Baloo {
 
@@ -36,15 +37,30 @@ class MainHub : public QObject
     Q_CLASSINFO("D-Bus Interface", "org.kde.baloo.main")
 public:
     MainHub(Database* db, FileIndexerConfig* config);
+    ~MainHub();
 
 public Q_SLOTS:
     Q_SCRIPTABLE void quit() const;
     Q_SCRIPTABLE void updateConfig();
 
+    /**
+     * Returns the metrics of the indexer and of the extractor process
+     * as JSON, see Metrics::toVariantMap
+     */
+    Q_SCRIPTABLE QString metrics() const;
+
+    /**
+     * Returns the last trace spans of the indexer and of the extractor
+     * process as Chrome trace event JSON. There are none unless Baloo
+     * was built with BALOO_ENABLE_TRACING.
+     */
+    Q_SCRIPTABLE QString trace() const;
+
 private:
     Database* m_db;
     FileIndexerConfig* m_config;
 
+    IndexWriter m_indexWriter;
     FileWatch m_fileWatcher;
     FileIndexScheduler m_fileIndexScheduler;
 };
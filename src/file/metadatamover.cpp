@@ -20,6 +20,7 @@
 #include "metadatamover.h"
 #include "database.h"
 #include "transaction.h"
+#include "indexwriter.h"
 #include "basicindexingjob.h"
 #include "idutils.h"
 #include "baloodebug.h"
@@ -31,6 +32,7 @@ using namespace Baloo;
 MetadataMover::MetadataMover(Database* db, QObject* parent)
     : QObject(parent)
     , m_db(db)
+    , m_writer(0)
 {
 }
 
@@ -46,25 +48,33 @@ void MetadataMover::moveFileMetadata(const QString& from, const QString& to)
     Q_ASSERT(!from.isEmpty() && from != QLatin1String("/"));
     Q_ASSERT(!to.isEmpty() && to != QLatin1String("/"));
 
-    Transaction tr(m_db, Transaction::ReadWrite);
+    write([this, from, to](Transaction* tr) {
+        // We do NOT get deleted messages for overwritten files! Thus, we
+        // have to remove all metadata for overwritten files first.
+        removeMetadata(tr, to);
 
-    // We do NOT get deleted messages for overwritten files! Thus, we
-    // have to remove all metadata for overwritten files first.
-    removeMetadata(&tr, to);
-
-    // and finally update the old statements
-    updateMetadata(&tr, from, to);
-
-    tr.commit();
+        // and finally update the old statements
+        updateMetadata(tr, from, to);
+    });
 }
 
 void MetadataMover::removeFileMetadata(const QString& file)
 {
     Q_ASSERT(!file.isEmpty() && file != QLatin1String("/"));
 
-    Transaction tr(m_db, Transaction::ReadWrite);
-    removeMetadata(&tr, file);
-    tr.commit();
+    write([this, file](Transaction* tr) {
+        removeMetadata(tr, file);
+    });
+}
+
+void MetadataMover::write(const std::function<void(Transaction*)>& batch)
+{
+    if (m_writer) {
+        m_writer->submit(batch);
+        return;
+    }
+
+    m_db->write(batch);
 }
 
 void MetadataMover::removeMetadata(Transaction* tr, const QString& url)
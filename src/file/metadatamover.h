@@ -22,11 +22,14 @@
 
 #include <QObject>
 
+#include <functional>
+
 namespace Baloo
 {
 
 class Database;
 class Transaction;
+class IndexWriter;
 
 class MetadataMover : public QObject
 {
@@ -36,6 +39,12 @@ public:
     MetadataMover(Database* db, QObject* parent = 0);
     ~MetadataMover();
 
+    /**
+     * Hands the changes to \p writer instead of committing them right
+     * away. The signals are then emitted from the writer thread.
+     */
+    void setIndexWriter(IndexWriter* writer) { m_writer = writer; }
+
 public Q_SLOTS:
     void moveFileMetadata(const QString& from, const QString& to);
     void removeFileMetadata(const QString& file);
@@ -53,6 +62,8 @@ Q_SIGNALS:
     void fileRemoved(const QString& path);
 
 private:
+    void write(const std::function<void(Transaction*)>& batch);
+
     /**
      * Remove the metadata for file \p url
      */
@@ -65,6 +76,7 @@ private:
     void updateMetadata(Transaction* tr, const QString& from, const QString& to);
 
     Database* m_db;
+    IndexWriter* m_writer;
 };
 }
 
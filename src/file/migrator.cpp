@@ -19,6 +19,8 @@
 
 #include "migrator.h"
 #include "fileindexerconfig.h"
+#include "database.h"
+#include "transaction.h"
 
 #include <QFile>
 #include <QDir>
@@ -36,9 +38,10 @@ Migrator::Migrator(const QString& dbPath, FileIndexerConfig* config)
 
 /*
  * Changing this version number indicates that the old index should be deleted
- * and the indexing should be started from scratch.
+ * and the indexing should be started from scratch, unless migrate() knows how
+ * to convert it.
  */
-static int s_dbVersion = 2;
+static int s_dbVersion = 6;
 
 bool Migrator::migrationRequired()
 {
@@ -54,6 +57,13 @@ void Migrator::migrate()
         QDir dir(m_dbPath + "/file");
         dir.removeRecursively();
     }
+    else if (dbVersion == 5 && QFile::exists(m_dbPath + "/index")) {
+        // Only the format of the document data has changed since, which
+        // is converted instead of indexing everything again
+        convertDocumentData();
+        m_config->setDatabaseVersion(s_dbVersion);
+        return;
+    }
     else if (QFile::exists(m_dbPath + "/index")) {
         QFile::remove(m_dbPath + "/index");
         QFile::remove(m_dbPath + "/index-lock");
@@ -62,3 +72,23 @@ void Migrator::migrate()
     m_config->setDatabaseVersion(s_dbVersion);
     m_config->setInitialRun(true);
 }
+
+void Migrator::convertDocumentData()
+{
+    Database db(m_dbPath);
+    if (!db.open(Database::CreateDatabase)) {
+        return;
+    }
+
+    // Converting everything in one transaction could exhaust its dirty pages
+    quint64 lastId = 0;
+    do {
+        quint64 nextId = 0;
+        if (!db.write([&](Transaction* tr) {
+            nextId = tr->convertDocumentData(lastId, 5000);
+        })) {
+            return;
+        }
+        lastId = nextId;
+    } while (lastId);
+}
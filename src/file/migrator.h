@@ -35,6 +35,8 @@ public:
     void migrate();
 
 private:
+    void convertDocumentData();
+
     QString m_dbPath;
     FileIndexerConfig* m_config;
 };
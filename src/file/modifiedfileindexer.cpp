@@ -22,8 +22,10 @@
 #include "fileindexerconfig.h"
 #include "idutils.h"
 
+#include "indexwriter.h"
 #include "database.h"
 #include "transaction.h"
+#include "tracing.h"
 
 #include <QMimeDatabase>
 #include <QFile>
@@ -32,21 +34,26 @@
 
 using namespace Baloo;
 
-ModifiedFileIndexer::ModifiedFileIndexer(Database* db, FileIndexerConfig* config, const QStringList& files)
-    : m_db(db)
+ModifiedFileIndexer::ModifiedFileIndexer(IndexWriter* writer, FileIndexerConfig* config, const QStringList& files)
+    : m_writer(writer)
     , m_config(config)
     , m_files(files)
 {
-    Q_ASSERT(m_db);
+    Q_ASSERT(m_writer);
     Q_ASSERT(m_config);
     Q_ASSERT(!m_files.isEmpty());
 }
 
 void ModifiedFileIndexer::run()
 {
+    BALOO_TRACE_SPAN("indexer", "ModifiedFileIndexer::run");
+
     QMimeDatabase mimeDb;
 
-    Transaction tr(m_db, Transaction::ReadWrite);
+    // The changes are written by the IndexWriter, this is only used to
+    // skip the files which have not changed
+    Transaction tr(m_writer->database(), Transaction::ReadOnly);
+    QVector<Document> documents;
 
     for (const QString& filePath : m_files) {
         Q_ASSERT(!filePath.endsWith('/'));
@@ -89,17 +96,25 @@ void ModifiedFileIndexer::run()
             continue;
         }
 
-        // we can get modified events for files which do not exist
-        // cause Baloo was not running and missed those events
-        if (tr.hasDocument(job.document().id())) {
-            tr.replaceDocument(job.document(), DocumentTime);
-            tr.setPhaseOne(job.document().id());
-        }
-        else {
-            tr.addDocument(job.document());
-        }
+        documents.append(job.document());
+    }
+    tr.abort();
+
+    if (!documents.isEmpty()) {
+        m_writer->submit([documents](Transaction* tr) {
+            for (const Document& doc : documents) {
+                // we can get modified events for files which do not exist
+                // cause Baloo was not running and missed those events
+                if (tr->hasDocument(doc.id())) {
+                    tr->replaceDocument(doc, DocumentTime);
+                    tr->setPhaseOne(doc.id());
+                }
+                else {
+                    tr->addDocument(doc);
+                }
+            }
+        });
     }
 
-    tr.commit();
     Q_EMIT done();
 }
@@ -26,14 +26,14 @@
 
 namespace Baloo {
 
-class Database;
+class IndexWriter;
 class FileIndexerConfig;
 
 class ModifiedFileIndexer : public QObject, public QRunnable
 {
     Q_OBJECT
 public:
-    ModifiedFileIndexer(Database* db, FileIndexerConfig* config, const QStringList& files);
+    ModifiedFileIndexer(IndexWriter* writer, FileIndexerConfig* config, const QStringList& files);
 
     void run() Q_DECL_OVERRIDE;
 
@@ -41,7 +41,7 @@ Q_SIGNALS:
     void done();
 
 private:
-    Database* m_db;
+    IndexWriter* m_writer;
     FileIndexerConfig* m_config;
     QStringList m_files;
 };
@@ -21,28 +21,32 @@
 #include "basicindexingjob.h"
 #include "fileindexerconfig.h"
 
+#include "indexwriter.h"
 #include "database.h"
 #include "transaction.h"
+#include "tracing.h"
 
 #include <QMimeDatabase>
 
 using namespace Baloo;
 
-NewFileIndexer::NewFileIndexer(Database* db, FileIndexerConfig* config, const QStringList& newFiles)
-    : m_db(db)
+NewFileIndexer::NewFileIndexer(IndexWriter* writer, FileIndexerConfig* config, const QStringList& newFiles)
+    : m_writer(writer)
     , m_config(config)
     , m_files(newFiles)
 {
-    Q_ASSERT(m_db);
+    Q_ASSERT(m_writer);
     Q_ASSERT(m_config);
     Q_ASSERT(!m_files.isEmpty());
 }
 
 void NewFileIndexer::run()
 {
+    BALOO_TRACE_SPAN("indexer", "NewFileIndexer::run");
+
     QMimeDatabase mimeDb;
 
-    Transaction tr(m_db, Transaction::ReadWrite);
+    QVector<Document> documents;
 
     for (const QString& filePath : m_files) {
         Q_ASSERT(!filePath.endsWith('/'));
@@ -64,14 +68,21 @@ void NewFileIndexer::run()
             continue;
         }
 
-        // The same file can be sent twice though it shouldn't be.
-        // Lets just silently ignore it instead of crashing
-        if (tr.hasDocument(job.document().id())) {
-            continue;
-        }
-        tr.addDocument(job.document());
+        documents.append(job.document());
+    }
+
+    if (!documents.isEmpty()) {
+        m_writer->submit([documents](Transaction* tr) {
+            for (const Document& doc : documents) {
+                // The same file can be sent twice though it shouldn't be.
+                // Lets just silently ignore it instead of crashing
+                if (tr->hasDocument(doc.id())) {
+                    continue;
+                }
+                tr->addDocument(doc);
+            }
+        });
     }
 
-    tr.commit();
     Q_EMIT done();
 }
@@ -26,7 +26,7 @@
 
 namespace Baloo {
 
-class Database;
+class IndexWriter;
 class FileIndexerConfig;
 
 /**
@@ -36,7 +36,7 @@ class NewFileIndexer : public QObject, public QRunnable
 {
     Q_OBJECT
 public:
-    NewFileIndexer(Database* db, FileIndexerConfig* config, const QStringList& newFiles);
+    NewFileIndexer(IndexWriter* writer, FileIndexerConfig* config, const QStringList& newFiles);
 
     void run() Q_DECL_OVERRIDE;
 
@@ -44,7 +44,7 @@ Q_SIGNALS:
     void done();
 
 private:
-    Database* m_db;
+    IndexWriter* m_writer;
     FileIndexerConfig* m_config;
     QStringList m_files;
 };
@@ -21,6 +21,7 @@
 */
 
 #include "pendingfilequeue.h"
+#include "tracing.h"
 
 #include <QDebug>
 #include <QDateTime>
@@ -82,6 +83,8 @@ void PendingFileQueue::enqueue(const PendingFile& file)
 
 void PendingFileQueue::processCache()
 {
+    BALOO_TRACE_SPAN("filewatch", "PendingFileQueue::processCache");
+
     QTime currentTime = QTime::currentTime();
 
     for (const PendingFile& file : m_cache) {
@@ -160,6 +163,8 @@ void PendingFileQueue::clearRecentlyEmitted()
 
 void PendingFileQueue::processPendingFiles()
 {
+    BALOO_TRACE_SPAN("filewatch", "PendingFileQueue::processPendingFiles");
+
     QTime currentTime = QTime::currentTime();
     int nextUpdate = m_maxTimeout;
 
@@ -151,6 +151,22 @@ bool StorageDevices::Entry::isMounted() const
     }
 }
 
+bool StorageDevices::Entry::isRemovable() const
+{
+    const Solid::Device& dev = m_device;
+    if (!dev.is<Solid::StorageVolume>() || !dev.parent().is<Solid::StorageDrive>()) {
+        return false;
+    }
+
+    auto parent = dev.parent().as<Solid::StorageDrive>();
+    if (!parent->isRemovable() && !parent->isHotpluggable()) {
+        return false;
+    }
+
+    const Solid::StorageVolume* volume = dev.as<Solid::StorageVolume>();
+    return !volume->isIgnored() && volume->usage() == Solid::StorageVolume::FileSystem;
+}
+
 bool StorageDevices::Entry::isUsable() const
 {
     if (mountPath().isEmpty()) {
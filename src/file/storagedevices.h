@@ -61,6 +61,12 @@ public:
          */
         bool isUsable() const;
 
+        /**
+         * Returns true if this is a file system on a removable or
+         * hotpluggable drive, such as a USB stick
+         */
+        bool isRemovable() const;
+
         QString udi() const {
             return m_device.udi();
         }
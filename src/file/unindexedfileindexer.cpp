@@ -23,7 +23,9 @@
 #include "unindexedfileindexer.h"
 
 #include "unindexedfileiterator.h"
+#include "database.h"
 #include "transaction.h"
+#include "tracing.h"
 #include "fileindexerconfig.h"
 #include "basicindexingjob.h"
 
@@ -40,42 +42,44 @@ UnindexedFileIndexer::UnindexedFileIndexer(Database* db, FileIndexerConfig* conf
 
 void UnindexedFileIndexer::run()
 {
+    BALOO_TRACE_SPAN("indexer", "UnindexedFileIndexer::run");
+
     QMimeDatabase m_mimeDb;
     QStringList includeFolders = m_config->includeFolders();
 
     for (const QString& includeFolder : includeFolders) {
-        Transaction tr(m_db, Transaction::ReadWrite);
-        UnIndexedFileIterator it(m_config, &tr, includeFolder);
+        m_db->write([&](Transaction* tr) {
+            UnIndexedFileIterator it(m_config, tr, includeFolder);
 
-        while (!it.next().isEmpty()) {
-            QString mime = m_mimeDb.mimeTypeForFile(it.filePath(), QMimeDatabase::MatchExtension).name();
-            BasicIndexingJob::IndexingLevel level = m_config->onlyBasicIndexing() ? BasicIndexingJob::NoLevel
-                : BasicIndexingJob::MarkForContentIndexing;
-            BasicIndexingJob job(it.filePath(), mime, level);
-            job.index();
+            while (!it.next().isEmpty()) {
+                QString mime = m_mimeDb.mimeTypeForFile(it.filePath(), QMimeDatabase::MatchExtension).name();
+                BasicIndexingJob::IndexingLevel level = m_config->onlyBasicIndexing() ? BasicIndexingJob::NoLevel
+                    : BasicIndexingJob::MarkForContentIndexing;
+                BasicIndexingJob job(it.filePath(), mime, level);
+                job.index();
 
-            // We handle modified files by simply updating the mTime and filename in the Db and marking them for ContentIndexing
-            const quint64 id = job.document().id();
-            if (tr.hasDocument(id)) {
+                // We handle modified files by simply updating the mTime and filename in the Db and marking them for ContentIndexing
+                const quint64 id = job.document().id();
+                if (tr->hasDocument(id)) {
 
-                DocumentOperations ops = DocumentTime;
-                if (it.cTimeChanged()) {
-                    ops |= XAttrTerms;
-                    if (tr.documentUrl(id) != it.filePath()) {
-                        ops |= (FileNameTerms | DocumentUrl);
+                    DocumentOperations ops = DocumentTime;
+                    if (it.cTimeChanged()) {
+                        ops |= XAttrTerms;
+                        if (tr->documentUrl(id) != it.filePath()) {
+                            ops |= (FileNameTerms | DocumentUrl);
+                        }
                     }
-                }
-                tr.replaceDocument(job.document(), ops);
+                    tr->replaceDocument(job.document(), ops);
 
-                if (it.mTimeChanged()) {
-                    tr.setPhaseOne(id);
-                }
+                    if (it.mTimeChanged()) {
+                        tr->setPhaseOne(id);
+                    }
 
-            } else { // New file
-                tr.addDocument(job.document());
+                } else { // New file
+                    tr->addDocument(job.document());
+                }
             }
-        }
-        tr.commit();
+        });
     }
 
     Q_EMIT done();
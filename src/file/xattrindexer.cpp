@@ -21,28 +21,32 @@
 #include "basicindexingjob.h"
 #include "fileindexerconfig.h"
 
+#include "indexwriter.h"
 #include "database.h"
 #include "transaction.h"
+#include "tracing.h"
 
 #include <QMimeDatabase>
 
 using namespace Baloo;
 
-XAttrIndexer::XAttrIndexer(Database* db, FileIndexerConfig* config, const QStringList& files)
-    : m_db(db)
+XAttrIndexer::XAttrIndexer(IndexWriter* writer, FileIndexerConfig* config, const QStringList& files)
+    : m_writer(writer)
     , m_config(config)
     , m_files(files)
 {
-    Q_ASSERT(m_db);
+    Q_ASSERT(m_writer);
     Q_ASSERT(m_config);
     Q_ASSERT(!m_files.isEmpty());
 }
 
 void XAttrIndexer::run()
 {
+    BALOO_TRACE_SPAN("indexer", "XAttrIndexer::run");
+
     QMimeDatabase mimeDb;
 
-    Transaction tr(m_db, Transaction::ReadWrite);
+    QVector<Document> documents;
 
     for (const QString& filePath : m_files) {
         Q_ASSERT(!filePath.endsWith('/'));
@@ -65,18 +69,25 @@ void XAttrIndexer::run()
             continue;
         }
 
-        // FIXME: This slightly defeats the point of having separate indexers
-        //        But we can get xattr changes of a file, even when it doesn't exist
-        //        cause we missed its creation somehow
-        if (!tr.hasDocument(job.document().id())) {
-            tr.addDocument(job.document());
-            continue;
-        }
+        documents.append(job.document());
+    }
+
+    if (!documents.isEmpty()) {
+        m_writer->submit([documents](Transaction* tr) {
+            for (const Document& doc : documents) {
+                // FIXME: This slightly defeats the point of having separate indexers
+                //        But we can get xattr changes of a file, even when it doesn't exist
+                //        cause we missed its creation somehow
+                if (!tr->hasDocument(doc.id())) {
+                    tr->addDocument(doc);
+                    continue;
+                }
 
-        // FIXME: Do we also need to update the ctime of the file?
-        tr.replaceDocument(job.document(), XAttrTerms);
+                // FIXME: Do we also need to update the ctime of the file?
+                tr->replaceDocument(doc, XAttrTerms);
+            }
+        });
     }
 
-    tr.commit();
     Q_EMIT done();
 }
@@ -105,8 +105,9 @@ static void addTermToStack(QStack<Term>& stack, const Term& termInConstruction,
         return;
     }
 
-    if (tos.subTerms().count() == 0 || tos.operation() != op) {
-        // Top of stack is a "literal" term or a logical term of the wrong operation
+    if (tos.subTerms().count() == 0 || tos.operation() != op || tos.isNegated()) {
+        // Top of stack is a "literal" term, a logical term of the wrong operation
+        // or a negated one
         Term tmp = stack.pop();
 
         stack.push(Term(op));
@@ -124,6 +125,12 @@ static QVariant tokenToVariant(const QString& token)
         return QVariant(intValue);
     }
 
+    // Sizes and durations can be beyond the range of an int
+    qlonglong longValue = token.toLongLong(&okay);
+    if (okay) {
+        return QVariant(longValue);
+    }
+
     QDate date = QDate::fromString(token, Qt::ISODate);
     if (date.isValid() && !date.isNull()) {
         return date;
@@ -137,8 +144,10 @@ Term AdvancedQueryParser::parse(const QString& text)
     // The parser does not do any look-ahead but has to store some state
     QStack<Term> stack;
     QStack<Term::Operation> ops;
+    QStack<bool> negatedGroups;
     Term termInConstruction;
     bool valueExpected = false;
+    bool negateNext = false;
     Term::Operation nextOp = Term::And;
 
     stack.push(Term());
@@ -173,6 +182,9 @@ Term AdvancedQueryParser::parse(const QString& text)
         } else if (token == QStringLiteral("OR")) {
             nextOp = Term::Or;
             continue;
+        } else if (token == QStringLiteral("NOT")) {
+            negateNext = true;
+            continue;
         }
 
         // Handle the different comparators (and braces)
@@ -209,7 +221,9 @@ Term AdvancedQueryParser::parse(const QString& text)
 
                 stack.push(Term());
                 ops.push(Term::And);
+                negatedGroups.push(negateNext);
                 nextOp = Term::And;
+                negateNext = false;
                 termInConstruction = Term();
 
                 continue;
@@ -223,8 +237,13 @@ Term AdvancedQueryParser::parse(const QString& text)
 
                     // stack.pop() is the term that has just been closed. Append
                     // it to the term just above it.
+                    Term group = stack.pop();
+                    if (negatedGroups.pop()) {
+                        group.setNegation(true);
+                    }
+
                     ops.pop();
-                    addTermToStack(stack, stack.pop(), ops.top());
+                    addTermToStack(stack, group, ops.top());
                     nextOp = Term::And;
                     termInConstruction = Term();
                 }
@@ -247,7 +266,15 @@ Term AdvancedQueryParser::parse(const QString& text)
                 nextOp = Term::And;
             }
 
-            termInConstruction = Term(QString(), token);
+            // "-foo" and "NOT foo" exclude the results of foo
+            if (token.size() > 1 && token.at(0) == QLatin1Char('-')) {
+                termInConstruction = Term(QString(), token.mid(1));
+                termInConstruction.setNegation(true);
+            } else {
+                termInConstruction = Term(QString(), token);
+                termInConstruction.setNegation(negateNext);
+            }
+            negateNext = false;
         }
     }
 
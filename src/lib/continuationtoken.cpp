@@ -0,0 +1,105 @@
+/*
+ * This file is part of the KDE Baloo Project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "continuationtoken.h"
+
+#include <QList>
+
+using namespace Baloo;
+
+static const char s_version = '3';
+
+ContinuationToken::ContinuationToken()
+    : sortingOption(Query::SortAuto)
+    , generation(0)
+    , mTime(0)
+    , hasValue(false)
+    , value(0)
+    , docId(0)
+    , position(0)
+    , merged(false)
+{
+}
+
+QByteArray ContinuationToken::toByteArray() const
+{
+    if (!isValid()) {
+        return QByteArray();
+    }
+
+    QByteArray arr;
+    arr += s_version;
+    arr += ':' + QByteArray::number(static_cast<int>(sortingOption));
+    arr += ':' + QByteArray::number(generation);
+    arr += ':' + QByteArray::number(mTime);
+    arr += ':' + QByteArray::number(docId);
+    arr += ':' + QByteArray::number(position);
+    arr += ':' + sortingProperty.toUtf8();
+    arr += ':' + (hasValue ? QByteArray::number(value) : QByteArray());
+    arr += ':' + QByteArray::number(merged ? 1 : 0);
+
+    return arr;
+}
+
+// static
+ContinuationToken ContinuationToken::fromByteArray(const QByteArray& arr)
+{
+    ContinuationToken token;
+
+    const QList<QByteArray> parts = arr.split(':');
+    if (parts.size() != 9 || parts[0].size() != 1 || parts[0][0] != s_version) {
+        return token;
+    }
+
+    bool ok[7];
+    const int option = parts[1].toInt(&ok[0]);
+    const quint64 generation = parts[2].toULongLong(&ok[1]);
+    const quint32 mTime = parts[3].toUInt(&ok[2]);
+    const quint64 docId = parts[4].toULongLong(&ok[3]);
+    const uint position = parts[5].toUInt(&ok[4]);
+    const int merged = parts[8].toInt(&ok[6]);
+
+    // The last result may not have had a value
+    ok[5] = true;
+    const bool hasValue = !parts[7].isEmpty();
+    const qint64 value = hasValue ? parts[7].toLongLong(&ok[5]) : 0;
+
+    for (bool b : ok) {
+        if (!b) {
+            return token;
+        }
+    }
+    if (option < Query::SortNone || option > Query::SortProperty) {
+        return token;
+    }
+
+    token.sortingOption = static_cast<Query::SortingOption>(option);
+    token.generation = generation;
+    token.mTime = mTime;
+    token.sortingProperty = QString::fromUtf8(parts[6]);
+    token.hasValue = hasValue;
+    token.value = value;
+    token.docId = docId;
+    token.position = position;
+    token.merged = merged != 0;
+
+    return token;
+}
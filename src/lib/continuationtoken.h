@@ -0,0 +1,87 @@
+/*
+ * This file is part of the KDE Baloo Project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_CONTINUATIONTOKEN_H
+#define BALOO_CONTINUATIONTOKEN_H
+
+#include "query.h"
+
+#include <QByteArray>
+#include <QString>
+
+namespace Baloo {
+
+/**
+ * Identifies the last result which was returned for a query, so that the
+ * next page of results can start right after it, instead of skipping over
+ * all the previous results again.
+ */
+class ContinuationToken
+{
+public:
+    ContinuationToken();
+
+    bool isValid() const {
+        return docId != 0 || merged;
+    }
+
+    QByteArray toByteArray() const;
+    static ContinuationToken fromByteArray(const QByteArray& arr);
+
+    Query::SortingOption sortingOption;
+
+    /**
+     * The generation of the index the results were fetched from. Only
+     * relevance sorted results depend on it
+     */
+    quint64 generation;
+
+    /**
+     * The mtime of the last result. Only used for SortAuto
+     */
+    quint32 mTime;
+
+    /**
+     * The property the results are sorted by, and its value for the
+     * last result if it has one. Only used for SortProperty
+     */
+    QString sortingProperty;
+    bool hasValue;
+    qint64 value;
+
+    quint64 docId;
+
+    /**
+     * The number of results before and including the last one
+     */
+    uint position;
+
+    /**
+     * The results of the other devices were merged with those of the main
+     * index. Their ids cannot be resumed after, so the next page skips
+     * position merged results instead, just like an offset.
+     */
+    bool merged;
+};
+
+}
+
+#endif // BALOO_CONTINUATIONTOKEN_H
@@ -25,9 +25,8 @@
 #include "database.h"
 #include "transaction.h"
 #include "idutils.h"
+#include "documentdatacodec.h"
 
-#include <QJsonDocument>
-#include <QJsonObject>
 #include <QFileInfo>
 #include <QDebug>
 
@@ -35,10 +34,35 @@ using namespace Baloo;
 
 class File::Private {
 public:
+    Private() : decoded(false) {}
+
+    void decode();
+
     QString url;
     KFileMetaData::PropertyMap propertyMap;
+
+    // The properties are only decoded once all of them are needed
+    QByteArray data;
+    bool decoded;
 };
 
+void File::Private::decode()
+{
+    if (decoded) {
+        return;
+    }
+
+    DocumentDataCodec codec;
+    const QMap<int, QVariant> properties = codec.decode(data);
+    for (auto it = properties.constBegin(); it != properties.constEnd(); ++it) {
+        const auto property = static_cast<KFileMetaData::Property::Property>(it.key());
+        propertyMap.insert(property, it.value());
+    }
+
+    data.clear();
+    decoded = true;
+}
+
 File::File()
     : d(new Private)
 {
@@ -55,6 +79,27 @@ File::File(const QString& url)
     d->url = QFileInfo(url).canonicalFilePath();
 }
 
+File::File(const QString& url, const QByteArray& data,
+           const QList<KFileMetaData::Property::Property>& properties)
+    : d(new Private)
+{
+    d->url = url;
+    d->data = data;
+
+    if (!properties.isEmpty()) {
+        DocumentDataCodec codec;
+        for (KFileMetaData::Property::Property property : properties) {
+            const QVariant value = codec.decode(data, static_cast<int>(property));
+            if (value.isValid()) {
+                d->propertyMap.insert(property, value);
+            }
+        }
+
+        d->data.clear();
+        d->decoded = true;
+    }
+}
+
 File::~File()
 {
     delete d;
@@ -74,12 +119,18 @@ QString File::path() const
 
 KFileMetaData::PropertyMap File::properties() const
 {
+    d->decode();
     return d->propertyMap;
 }
 
 QVariant File::property(KFileMetaData::Property::Property property) const
 {
-    return d->propertyMap.value(property);
+    if (d->decoded) {
+        return d->propertyMap.value(property);
+    }
+
+    DocumentDataCodec codec;
+    return codec.decode(d->data, static_cast<int>(property));
 }
 
 bool File::load(const QString& url)
@@ -114,9 +165,9 @@ bool File::load()
         return false;
     }
 
-    const QJsonDocument jdoc = QJsonDocument::fromJson(arr);
-    const QVariantMap varMap = jdoc.object().toVariantMap();
-    d->propertyMap = KFileMetaData::toPropertyMap(varMap);
+    d->propertyMap.clear();
+    d->data = arr;
+    d->decoded = false;
 
     return true;
 }
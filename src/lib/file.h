@@ -26,6 +26,8 @@
 #include "core_export.h"
 #include <KFileMetaData/Properties>
 
+#include <QMetaType>
+
 namespace Baloo {
 
 /**
@@ -66,10 +68,21 @@ public:
     bool load(const QString& url);
 
 private:
+    /**
+     * Creates a file from the document \p data which has already been
+     * read. Only the \p properties are decoded, unless none are given.
+     */
+    File(const QString& url, const QByteArray& data,
+         const QList<KFileMetaData::Property::Property>& properties);
+
     class Private;
     Private* d;
+
+    friend class FileFetchRunnable;
 };
 
 }
 
+Q_DECLARE_METATYPE(Baloo::File)
+
 #endif // BALOO_FILE_H
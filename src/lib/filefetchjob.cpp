@@ -0,0 +1,219 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "filefetchjob.h"
+#include "global.h"
+#include "database.h"
+#include "transaction.h"
+#include "idutils.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QPair>
+#include <QRunnable>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QVector>
+
+#include <algorithm>
+
+using namespace Baloo;
+
+namespace Baloo {
+/**
+ * Shared by the job and its runnable. The job clears it when it is
+ * deleted, so that the runnable never delivers anything to a dead job.
+ */
+class FileFetchState
+{
+public:
+    FileFetchState(FileFetchJob* job)
+        : job(job)
+    {}
+
+    QMutex mutex;
+    FileFetchJob* job;
+    QAtomicInt cancelled;
+};
+
+class FileFetchRunnable : public QRunnable
+{
+public:
+    FileFetchRunnable(const QSharedPointer<FileFetchState>& state, const QStringList& paths,
+                  const QList<KFileMetaData::Property::Property>& properties, int chunkSize)
+        : m_state(state)
+        , m_paths(paths)
+        , m_properties(properties)
+        , m_chunkSize(chunkSize)
+    {}
+
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    bool deliver(const QList<File>& files);
+    void finish(bool success);
+
+    QSharedPointer<FileFetchState> m_state;
+    QStringList m_paths;
+    QList<KFileMetaData::Property::Property> m_properties;
+    int m_chunkSize;
+};
+
+void FileFetchRunnable::run()
+{
+    Database* db = globalDatabaseInstance();
+    if (!db->open(Database::OpenDatabase)) {
+        finish(false);
+        return;
+    }
+
+    QList<File> chunk;
+
+    typedef QPair<quint64, QString> Entry;
+    QVector<Entry> entries;
+    entries.reserve(m_paths.size());
+    for (const QString& path : m_paths) {
+        const QString url = QFileInfo(path).canonicalFilePath();
+        const quint64 id = url.isEmpty() ? 0 : filePathToId(QFile::encodeName(url));
+        if (id) {
+            entries << qMakePair(id, url);
+        } else {
+            chunk << File(path, QByteArray(), m_properties);
+        }
+    }
+
+    // Reading the data in the order of the ids keeps the accesses local
+    std::sort(entries.begin(), entries.end());
+
+    {
+        Transaction tr(db, Transaction::ReadOnly);
+        for (const Entry& entry : entries) {
+            chunk << File(entry.second, tr.documentData(entry.first), m_properties);
+            if (chunk.size() >= m_chunkSize) {
+                // The job has been killed or deleted
+                if (!deliver(chunk)) {
+                    return;
+                }
+                chunk.clear();
+            }
+        }
+    }
+
+    if (!chunk.isEmpty() && !deliver(chunk)) {
+        return;
+    }
+    finish(true);
+}
+
+bool FileFetchRunnable::deliver(const QList<File>& files)
+{
+    // Held while posting, so that the job cannot be deleted meanwhile. Its
+    // pending events are discarded once it is
+    QMutexLocker lock(&m_state->mutex);
+    if (!m_state->job || m_state->cancelled.load()) {
+        return false;
+    }
+
+    QMetaObject::invokeMethod(m_state->job, "addFiles", Qt::QueuedConnection, Q_ARG(QList<Baloo::File>, files));
+    return true;
+}
+
+void FileFetchRunnable::finish(bool success)
+{
+    QMutexLocker lock(&m_state->mutex);
+    if (!m_state->job || m_state->cancelled.load()) {
+        return;
+    }
+
+    QMetaObject::invokeMethod(m_state->job, "finish", Qt::QueuedConnection, Q_ARG(bool, success));
+}
+}
+
+class FileFetchJob::Private {
+public:
+    QStringList paths;
+    QList<KFileMetaData::Property::Property> properties;
+    int chunkSize;
+
+    QList<File> files;
+    QSharedPointer<FileFetchState> state;
+};
+
+FileFetchJob::FileFetchJob(const QStringList& paths, QObject* parent)
+    : KJob(parent)
+    , d(new Private)
+{
+    d->paths = paths;
+    d->chunkSize = 100;
+    d->state.reset(new FileFetchState(this));
+
+    qRegisterMetaType<QList<Baloo::File> >("QList<Baloo::File>");
+}
+
+FileFetchJob::~FileFetchJob()
+{
+    {
+        QMutexLocker lock(&d->state->mutex);
+        d->state->job = 0;
+    }
+    delete d;
+}
+
+void FileFetchJob::setProperties(const QList<KFileMetaData::Property::Property>& properties)
+{
+    d->properties = properties;
+}
+
+void FileFetchJob::setChunkSize(int size)
+{
+    d->chunkSize = qMax(size, 1);
+}
+
+void FileFetchJob::start()
+{
+    QThreadPool::globalInstance()->start(new FileFetchRunnable(d->state, d->paths, d->properties, d->chunkSize));
+}
+
+bool FileFetchJob::doKill()
+{
+    // The runnable stops at the next chunk
+    d->state->cancelled.store(1);
+    return true;
+}
+
+QList<File> FileFetchJob::files() const
+{
+    return d->files;
+}
+
+void FileFetchJob::addFiles(const QList<Baloo::File>& files)
+{
+    d->files << files;
+    Q_EMIT filesFetched(files);
+}
+
+void FileFetchJob::finish(bool success)
+{
+    if (!success) {
+        setError(UserDefinedError);
+        setErrorText(QStringLiteral("Failed to open the database"));
+    }
+    emitResult();
+}
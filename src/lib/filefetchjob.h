@@ -0,0 +1,89 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_FILEFETCHJOB_H
+#define BALOO_FILEFETCHJOB_H
+
+#include "core_export.h"
+#include "file.h"
+
+#include <KJob>
+#include <QStringList>
+
+namespace Baloo {
+
+/**
+ * @short Fetches the metadata of many files at once
+ *
+ * Calling File::load for each file opens a new transaction and reads
+ * the data of each file separately. This job looks up all the files in
+ * a single read transaction, in the order in which they are stored.
+ *
+ * The job runs on a worker thread. The files are delivered in chunks
+ * through filesFetched, in no particular order, and files which are not
+ * indexed have no properties. Use exec() to fetch them synchronously.
+ *
+ * The job can be killed or deleted while it is running.
+ */
+class BALOO_CORE_EXPORT FileFetchJob : public KJob
+{
+    Q_OBJECT
+public:
+    explicit FileFetchJob(const QStringList& paths, QObject* parent = 0);
+    ~FileFetchJob() Q_DECL_OVERRIDE;
+
+    /**
+     * Only fetch these \p properties. All of them are fetched by default.
+     */
+    void setProperties(const QList<KFileMetaData::Property::Property>& properties);
+
+    /**
+     * The number of files delivered with each filesFetched signal.
+     * Defaults to 100.
+     */
+    void setChunkSize(int size);
+
+    void start() Q_DECL_OVERRIDE;
+
+    /**
+     * All the files which have been fetched
+     */
+    QList<File> files() const;
+
+Q_SIGNALS:
+    void filesFetched(const QList<Baloo::File>& files);
+
+protected:
+    /**
+     * Stops the fetching. No more files are delivered afterwards.
+     */
+    bool doKill() Q_DECL_OVERRIDE;
+
+private Q_SLOTS:
+    void addFiles(const QList<Baloo::File>& files);
+    void finish(bool success);
+
+private:
+    class Private;
+    Private* d;
+};
+
+}
+
+#endif // BALOO_FILEFETCHJOB_H
@@ -24,11 +24,16 @@
 #include "term.h"
 #include "advancedqueryparser.h"
 #include "searchstore.h"
+#include "shardsearch.h"
+#include "queryclient.h"
+
+#include "transaction.h"
 
 #include <QString>
 #include <QStringList>
 #include <QSharedPointer>
 #include <QList>
+#include <QScopedPointer>
 #include <QUrlQuery>
 
 #include <QJsonDocument>
@@ -47,6 +52,7 @@ public:
         m_monthFilter = 0;
         m_dayFilter = 0;
         m_sortingOption = SortAuto;
+        m_sortOrder = Qt::AscendingOrder;
     }
     Term m_term;
 
@@ -54,12 +60,15 @@ public:
     QString m_searchString;
     int m_limit;
     uint m_offset;
+    QByteArray m_continuationToken;
 
     int m_yearFilter;
     int m_monthFilter;
     int m_dayFilter;
 
     SortingOption m_sortingOption;
+    QString m_sortingProperty;
+    Qt::SortOrder m_sortOrder;
     QString m_includeFolder;
 };
 
@@ -139,6 +148,16 @@ void Query::setOffset(uint offset)
     d->m_offset = offset;
 }
 
+QByteArray Query::continuationToken() const
+{
+    return d->m_continuationToken;
+}
+
+void Query::setContinuationToken(const QByteArray& token)
+{
+    d->m_continuationToken = token;
+}
+
 void Query::setDateFilter(int year, int month, int day)
 {
     d->m_yearFilter = year;
@@ -171,6 +190,23 @@ Query::SortingOption Query::sortingOption() const
     return d->m_sortingOption;
 }
 
+void Query::setSortingProperty(const QString& property, Qt::SortOrder order)
+{
+    d->m_sortingOption = SortProperty;
+    d->m_sortingProperty = property;
+    d->m_sortOrder = order;
+}
+
+QString Query::sortingProperty() const
+{
+    return d->m_sortingProperty;
+}
+
+Qt::SortOrder Query::sortOrder() const
+{
+    return d->m_sortOrder;
+}
+
 QString Query::includeFolder() const
 {
     return d->m_includeFolder;
@@ -181,9 +217,14 @@ void Query::setIncludeFolder(const QString& folder)
     d->m_includeFolder = folder;
 }
 
-ResultIterator Query::exec()
+Term Query::searchTerm() const
+{
+    return d->m_term;
+}
+
+Term Query::filterTerm() const
 {
-    Term term(d->m_term);
+    Term term;
     if (!d->m_types.isEmpty()) {
         for (const QString& type : d->m_types) {
             term = term && Term(QStringLiteral("type"), type);
@@ -206,9 +247,120 @@ ResultIterator Query::exec()
         term = term && Term(QStringLiteral("modified"), ba, Term::Equal);
     }
 
-    SearchStore searchStore;
-    QStringList result = searchStore.exec(term, d->m_offset, d->m_limit, d->m_sortingOption == SortAuto);
-    return ResultIterator(result);
+    return term;
+}
+
+ResultIterator Query::exec()
+{
+    Term term = searchTerm() && filterTerm();
+
+    // The query server has the index open and its caches warm already
+    if (QueryClient* client = QueryClient::connectToServer()) {
+        if (client->exec(toJSON())) {
+            return ResultIterator(*this, term, client);
+        }
+        delete client;
+    }
+
+    return ResultIterator(*this, term);
+}
+
+namespace {
+    bool countOnServer(const Query& query, int msecs, uint* count)
+    {
+        QScopedPointer<QueryClient> client(QueryClient::connectToServer());
+        return client && client->count(Query(query).toJSON(), msecs, count);
+    }
+
+    uint countResults(const Term& term, int msecs)
+    {
+        if (!term.isValid()) {
+            return 0;
+        }
+
+        // The other devices are counted meanwhile
+        ShardSearch shards(term);
+        const bool hasShards = shards.startCount(msecs);
+
+        SearchStore store;
+        QScopedPointer<Transaction> tr(store.transaction());
+        const uint count = tr ? store.count(tr.data(), term, msecs) : 0;
+
+        return hasShards ? count + shards.count() : count;
+    }
+}
+
+uint Query::count() const
+{
+    uint count = 0;
+    if (countOnServer(*this, -1, &count)) {
+        return count;
+    }
+    return countResults(searchTerm() && filterTerm(), -1);
+}
+
+uint Query::estimatedCount(int msecs) const
+{
+    uint count = 0;
+    if (countOnServer(*this, qMax(msecs, 0), &count)) {
+        return count;
+    }
+    return countResults(searchTerm() && filterTerm(), qMax(msecs, 0));
+}
+
+QMap<QString, QMap<QString, uint> > Query::facetCounts(const QStringList& facets, int msecs) const
+{
+    const Term term = searchTerm() && filterTerm();
+    if (!term.isValid()) {
+        return QMap<QString, QMap<QString, uint> >();
+    }
+
+    SearchStore store;
+    QScopedPointer<Transaction> tr(store.transaction());
+    if (!tr) {
+        return QMap<QString, QMap<QString, uint> >();
+    }
+
+    QStringList names = facets;
+    if (names.isEmpty()) {
+        names << QStringLiteral("type") << QStringLiteral("mimetype")
+              << QStringLiteral("year") << QStringLiteral("tag");
+    }
+
+    return store.facetCounts(tr.data(), term, names, msecs);
+}
+
+QVariantMap Query::propertyStatistics(const QString& property, int buckets) const
+{
+    const Term term = searchTerm() && filterTerm();
+    if (!term.isValid() || buckets <= 0) {
+        return QVariantMap();
+    }
+
+    SearchStore store;
+    QScopedPointer<Transaction> tr(store.transaction());
+    if (!tr) {
+        return QVariantMap();
+    }
+
+    return store.propertyStatistics(tr.data(), term, property, buckets);
+}
+
+QByteArray Query::explain() const
+{
+    const Term term = searchTerm() && filterTerm();
+    if (!term.isValid()) {
+        return QByteArray();
+    }
+
+    SearchStore store;
+    QScopedPointer<Transaction> tr(store.transaction());
+    if (!tr) {
+        return QByteArray();
+    }
+
+    const QVariantMap map = store.explain(tr.data(), term);
+    return QJsonDocument(QJsonObject::fromVariantMap(map)).toJson(QJsonDocument::Indented);
 }
 
 QByteArray Query::toJSON()
@@ -224,6 +376,9 @@ QByteArray Query::toJSON()
     if (d->m_offset)
         map[QStringLiteral("offset")] = d->m_offset;
 
+    if (!d->m_continuationToken.isEmpty())
+        map[QStringLiteral("continuationToken")] = QString::fromLatin1(d->m_continuationToken);
+
     if (!d->m_searchString.isEmpty())
         map[QStringLiteral("searchString")] = d->m_searchString;
 
@@ -240,6 +395,11 @@ QByteArray Query::toJSON()
     if (d->m_sortingOption != SortAuto)
         map[QStringLiteral("sortingOption")] = static_cast<int>(d->m_sortingOption);
 
+    if (!d->m_sortingProperty.isEmpty()) {
+        map[QStringLiteral("sortingProperty")] = d->m_sortingProperty;
+        map[QStringLiteral("sortOrder")] = static_cast<int>(d->m_sortOrder);
+    }
+
     if (!d->m_includeFolder.isEmpty())
         map[QStringLiteral("includeFolder")] = d->m_includeFolder;
 
@@ -264,6 +424,7 @@ Query Query::fromJSON(const QByteArray& arr)
         query.d->m_limit = defaultLimit;
 
     query.d->m_offset = map[QStringLiteral("offset")].toUInt();
+    query.d->m_continuationToken = map[QStringLiteral("continuationToken")].toString().toLatin1();
     query.d->m_searchString = map[QStringLiteral("searchString")].toString();
     query.d->m_term = Term::fromVariantMap(map[QStringLiteral("term")].toMap());
 
@@ -279,6 +440,11 @@ Query Query::fromJSON(const QByteArray& arr)
         query.d->m_sortingOption = static_cast<SortingOption>(option);
     }
 
+    if (map.contains(QStringLiteral("sortingProperty"))) {
+        query.d->m_sortingProperty = map.value(QStringLiteral("sortingProperty")).toString();
+        query.d->m_sortOrder = static_cast<Qt::SortOrder>(map.value(QStringLiteral("sortOrder")).toInt());
+    }
+
 
     if (map.contains(QStringLiteral("includeFolder"))) {
         query.d->m_includeFolder = map.value(QStringLiteral("includeFolder")).toString();
@@ -321,10 +487,12 @@ QString Query::titleFromQueryUrl(const QUrl& url)
 bool Query::operator==(const Query& rhs) const
 {
     if (rhs.d->m_limit != d->m_limit || rhs.d->m_offset != d->m_offset ||
+        rhs.d->m_continuationToken != d->m_continuationToken ||
         rhs.d->m_dayFilter != d->m_dayFilter || rhs.d->m_monthFilter != d->m_monthFilter ||
         rhs.d->m_yearFilter != d->m_yearFilter || rhs.d->m_includeFolder != d->m_includeFolder ||
         rhs.d->m_searchString != d->m_searchString ||
-        rhs.d->m_sortingOption != d->m_sortingOption)
+        rhs.d->m_sortingOption != d->m_sortingOption ||
+        rhs.d->m_sortingProperty != d->m_sortingProperty || rhs.d->m_sortOrder != d->m_sortOrder)
     {
         return false;
     }
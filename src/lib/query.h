@@ -27,9 +27,13 @@
 #include "resultiterator.h"
 
 #include <QVariant>
+#include <QMap>
+#include <QStringList>
 
 namespace Baloo {
 
+class Term;
+
 /**
  * The Query class is the central class to query to search for files from the Index.
  *
@@ -101,6 +105,16 @@ public:
     void setOffset(uint offset);
     uint offset() const;
 
+    /**
+     * Continue after the result the \p token was taken from. See
+     * ResultIterator::continuationToken. This is much cheaper than
+     * using an offset for fetching the next page of results.
+     *
+     * The offset is ignored when a token is set.
+     */
+    void setContinuationToken(const QByteArray& token);
+    QByteArray continuationToken() const;
+
     /**
      * Filter the results in the specified date range.
      *
@@ -126,12 +140,38 @@ public:
          *
          * This is the default sorting mechanism.
          */
-        SortAuto
+        SortAuto,
+
+        /**
+         * The results are ranked by how well they match the search
+         * string, with the best match first. Queries without any
+         * text are returned in the most efficient order.
+         */
+        SortRelevance,
+
+        /**
+         * The results are sorted by the value of a property. See
+         * setSortingProperty.
+         */
+        SortProperty
     };
 
     void setSortingOption(SortingOption option);
     SortingOption sortingOption() const;
 
+    /**
+     * Sorts the results by the value of the numeric, date or time
+     * \p property, such as "duration", "width" or "photoDateTimeOriginal".
+     * Files without a value for the property come last, and the sorting
+     * option is set to SortProperty.
+     *
+     * The values are stored separately from the rest of the metadata,
+     * so sorting by them is about as cheap as sorting by mtime.
+     */
+    void setSortingProperty(const QString& property, Qt::SortOrder order = Qt::AscendingOrder);
+    QString sortingProperty() const;
+    Qt::SortOrder sortOrder() const;
+
     /**
      * Only files in this folder will be returned
      */
@@ -140,6 +180,68 @@ public:
 
     ResultIterator exec();
 
+    /**
+     * Returns the number of files matching this query. The limit, offset
+     * and sorting option are ignored.
+     *
+     * This is much cheaper than iterating over the results of exec(), as
+     * the paths of the files do not need to be looked up.
+     */
+    uint count() const;
+
+    /**
+     * Returns roughly the number of files matching this query, and gives
+     * up on counting them exactly after about \p msecs milliseconds.
+     *
+     * This is meant for showing the order of magnitude of the results,
+     * and may be far off for queries with many terms.
+     */
+    uint estimatedCount(int msecs = 100) const;
+
+    /**
+     * Counts the results of this query for each value of the \p facets.
+     * The supported facets are "type", "mimetype", "year" and "tag", and
+     * all of them are counted if \p facets is empty.
+     *
+     * The values can be used for narrowing down the query, for example
+     * the count of "Audio" for the "type" facet is the number of results
+     * of this query with the "type:Audio" search string added.
+     * The mimetypes are split into their words, e.g. "image" and "png".
+     *
+     * If \p msecs is not negative, counting stops once it has taken
+     * about that long, and the counts are incomplete. If not all the
+     * results could be read in that time, the counts are scaled up to
+     * the estimated number of results. QueryFacetsRunnable counts them
+     * in a thread pool.
+     */
+    QMap<QString, QMap<QString, uint> > facetCounts(const QStringList& facets = QStringList(), int msecs = -1) const;
+
+    /**
+     * Aggregates the values of the numeric, date or time \p property over
+     * the results of this query. The map contains
+     *
+     * - "count": the number of results with a value for the property
+     * - "minimum" and "maximum": the smallest and largest value, as
+     *   numbers or as QDateTimes in UTC
+     * - "histogram": a list of \p buckets counts, for equally wide
+     *   ranges of values from the minimum to the maximum
+     *
+     * An empty map is returned if the property cannot be aggregated.
+     */
+    QVariantMap propertyStatistics(const QString& property, int buckets = 10) const;
+
+    /**
+     * Runs the query without fetching any of the results and returns, as
+     * JSON, the tree of posting lists which was used to find them. Each
+     * node has the estimated and actual number of results, the number of
+     * next and skipTo calls, the bytes read from the database and the
+     * time spent in it and its children.
+     *
+     * This is meant for finding out why a query is slow, and is not
+     * cached.
+     */
+    QByteArray explain() const;
+
     QByteArray toJSON();
     static Query fromJSON(const QByteArray& arr);
 
@@ -155,6 +257,15 @@ public:
 private:
     class Private;
     Private* d;
+
+    Term searchTerm() const;
+
+    /**
+     * The restrictions on the results which are not part of the search string
+     */
+    Term filterTerm() const;
+
+    friend class QuerySession;
 };
 
 }
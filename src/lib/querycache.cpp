@@ -0,0 +1,168 @@
+/*
+ * This file is part of the KDE Baloo Project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "querycache.h"
+#include "term.h"
+#include "metrics.h"
+
+#include <QDateTime>
+#include <QMutexLocker>
+
+#include <algorithm>
+
+using namespace Baloo;
+
+Q_GLOBAL_STATIC(QueryCache, s_queryCache)
+
+static const int s_defaultSize = 4 * 1024 * 1024;
+
+QueryCache::QueryCache()
+    : m_generation(0)
+    , m_hits(0)
+    , m_misses(0)
+{
+    bool ok = false;
+    int size = qgetenv("BALOO_QUERY_CACHE_SIZE").toInt(&ok);
+    m_cache.setMaxCost(ok && size >= 0 ? size * 1024 : s_defaultSize);
+}
+
+QueryCache* QueryCache::instance()
+{
+    return s_queryCache;
+}
+
+void QueryCache::setGeneration(quint64 generation)
+{
+    if (m_generation != generation) {
+        m_cache.clear();
+        m_generation = generation;
+    }
+}
+
+bool QueryCache::lookup(const Term& term, quint64 generation, QVector<quint64>* ids)
+{
+    Q_ASSERT(ids);
+    const QByteArray key = canonicalKey(term);
+
+    // Shared by all the caches of the process, see Metrics
+    static MetricsCounter* hitCounter = Metrics::instance()->counter(QStringLiteral("querycache.hits"));
+    static MetricsCounter* missCounter = Metrics::instance()->counter(QStringLiteral("querycache.misses"));
+
+    QMutexLocker lock(&m_mutex);
+    if (m_generation == generation) {
+        QVector<quint64>* value = m_cache.object(key);
+        if (value) {
+            *ids = *value;
+            m_hits++;
+            hitCounter->add();
+            return true;
+        }
+    }
+
+    m_misses++;
+    missCounter->add();
+    return false;
+}
+
+void QueryCache::insert(const Term& term, quint64 generation, const QVector<quint64>& ids)
+{
+    const QByteArray key = canonicalKey(term);
+    const int cost = key.size() + ids.size() * sizeof(quint64);
+
+    QMutexLocker lock(&m_mutex);
+
+    // Results from an older snapshot are of no use
+    if (generation < m_generation) {
+        return;
+    }
+    setGeneration(generation);
+
+    m_cache.insert(key, new QVector<quint64>(ids), cost);
+}
+
+void QueryCache::clear()
+{
+    QMutexLocker lock(&m_mutex);
+    m_cache.clear();
+}
+
+void QueryCache::setMaximumSize(int bytes)
+{
+    QMutexLocker lock(&m_mutex);
+    m_cache.setMaxCost(bytes);
+}
+
+int QueryCache::maximumSize() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_cache.maxCost();
+}
+
+QueryCache::Statistics QueryCache::statistics() const
+{
+    QMutexLocker lock(&m_mutex);
+
+    Statistics stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.entries = m_cache.count();
+    stats.size = m_cache.totalCost();
+
+    return stats;
+}
+
+// static
+QByteArray QueryCache::canonicalKey(const Term& term)
+{
+    QByteArray key;
+    if (term.isNegated()) {
+        key += '!';
+    }
+
+    if (term.operation() == Term::And || term.operation() == Term::Or) {
+        QVector<QByteArray> keys;
+        for (const Term& t : term.subTerms()) {
+            keys << canonicalKey(t);
+        }
+        std::sort(keys.begin(), keys.end());
+
+        key += term.operation() == Term::And ? "(&" : "(|";
+        for (const QByteArray& k : keys) {
+            key += ' ' + k;
+        }
+        key += ')';
+
+        return key;
+    }
+
+    const QVariant value = term.value();
+
+    key += term.property().toLower().toUtf8();
+    key += ' ' + QByteArray::number(static_cast<int>(term.comparator()));
+    key += ' ' + QByteArray::number(static_cast<int>(value.type()));
+    if (value.type() == QVariant::DateTime) {
+        key += ' ' + QByteArray::number(value.toDateTime().toTime_t());
+    } else {
+        key += ' ' + value.toString().toUtf8().toPercentEncoding();
+    }
+
+    return key;
+}
@@ -0,0 +1,98 @@
+/*
+ * This file is part of the KDE Baloo Project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_QUERYCACHE_H
+#define BALOO_QUERYCACHE_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QMutex>
+#include <QVector>
+
+namespace Baloo {
+
+class Term;
+
+/**
+ * A process wide cache of the document ids matching a Term.
+ *
+ * The entries are only valid for the index generation they were computed
+ * for. As soon as anything is written to the index, the generation changes
+ * and all the entries are dropped. The least recently used entries are
+ * evicted once the cache exceeds its maximum size.
+ *
+ * This class is thread safe.
+ */
+class QueryCache
+{
+public:
+    QueryCache();
+
+    static QueryCache* instance();
+
+    /**
+     * Fills \p ids with the cached results of \p term and returns true,
+     * or returns false if there are none for this \p generation.
+     */
+    bool lookup(const Term& term, quint64 generation, QVector<quint64>* ids);
+    void insert(const Term& term, quint64 generation, const QVector<quint64>& ids);
+    void clear();
+
+    /**
+     * The maximum size of the cache in bytes. It defaults to 4 MiB, and can
+     * also be set in KiB with the BALOO_QUERY_CACHE_SIZE environment variable.
+     */
+    void setMaximumSize(int bytes);
+    int maximumSize() const;
+
+    /**
+     * The hits and misses of this cache. Those of all the caches of the
+     * process are also counted as "querycache.hits" and "querycache.misses"
+     * in the Metrics.
+     */
+    struct Statistics {
+        quint64 hits;
+        quint64 misses;
+        int entries;
+        int size;
+    };
+    Statistics statistics() const;
+
+    /**
+     * Returns a key which is the same for equivalent terms, irrespective
+     * of the order of their sub terms.
+     */
+    static QByteArray canonicalKey(const Term& term);
+
+private:
+    void setGeneration(quint64 generation);
+
+    mutable QMutex m_mutex;
+    QCache<QByteArray, QVector<quint64> > m_cache;
+    quint64 m_generation;
+
+    quint64 m_hits;
+    quint64 m_misses;
+};
+
+}
+
+#endif // BALOO_QUERYCACHE_H
@@ -0,0 +1,172 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "queryclient.h"
+#include "queryprotocol.h"
+
+#include <QDataStream>
+#include <QDebug>
+
+using namespace Baloo;
+
+// A running server answers right away, and a missing one fails right away
+static const int connectTimeout = 100;
+
+// The server is only waited on for this long between two frames
+static const int readTimeout = 10 * 1000;
+
+QueryClient::QueryClient()
+    : m_finished(false)
+{
+}
+
+QueryClient::~QueryClient()
+{
+    m_socket.abort();
+}
+
+QueryClient* QueryClient::connectToServer(const QString& path)
+{
+    if (path.isEmpty() && qgetenv("BALOO_QUERY_SERVER") == "0") {
+        return 0;
+    }
+
+    QueryClient* client = new QueryClient;
+    client->m_socket.connectToServer(path.isEmpty() ? QueryProtocol::socketPath() : path);
+    if (!client->m_socket.waitForConnected(connectTimeout)) {
+        delete client;
+        return 0;
+    }
+
+    return client;
+}
+
+bool QueryClient::sendRequest(int type, const QByteArray& query, int msecs)
+{
+    QByteArray request;
+    QDataStream stream(&request, QIODevice::WriteOnly);
+    stream.setVersion(QueryProtocol::streamVersion());
+    stream << QueryProtocol::Version << static_cast<quint8>(type) << static_cast<qint32>(msecs) << query;
+
+    if (!QueryProtocol::writeFrame(&m_socket, request)) {
+        m_error = m_socket.errorString();
+        return false;
+    }
+
+    while (m_socket.bytesToWrite()) {
+        if (!m_socket.waitForBytesWritten(readTimeout)) {
+            m_error = m_socket.errorString();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool QueryClient::readFrame(QByteArray* frame)
+{
+    while (!QueryProtocol::takeFrame(m_buffer, frame)) {
+        if (!m_socket.waitForReadyRead(readTimeout)) {
+            m_error = m_socket.errorString();
+            qWarning() << "Lost the connection to the query server:" << m_error;
+            return false;
+        }
+        m_buffer += m_socket.readAll();
+    }
+
+    return true;
+}
+
+bool QueryClient::exec(const QByteArray& query)
+{
+    return sendRequest(QueryProtocol::Results, query, -1);
+}
+
+bool QueryClient::readResults(QStringList* filePaths, QVector<QByteArray>* tokens)
+{
+    QByteArray frame;
+    if (m_finished || !readFrame(&frame)) {
+        return false;
+    }
+
+    QDataStream stream(frame);
+    stream.setVersion(QueryProtocol::streamVersion());
+
+    quint8 type;
+    stream >> type;
+    if (type == QueryProtocol::EndFrame) {
+        m_finished = true;
+        return false;
+    }
+
+    if (type == QueryProtocol::ErrorFrame) {
+        m_finished = true;
+        stream >> m_queryError;
+        if (stream.status() == QDataStream::Ok && !m_queryError.isEmpty()) {
+            return false;
+        }
+        m_queryError.clear();
+    }
+
+    if (type == QueryProtocol::ResultsFrame) {
+        stream >> *filePaths >> *tokens;
+        if (stream.status() == QDataStream::Ok && filePaths->size() == tokens->size()) {
+            return true;
+        }
+    }
+
+    m_finished = true;
+    m_error = QStringLiteral("The query server sent an invalid frame");
+    return false;
+}
+
+bool QueryClient::count(const QByteArray& query, int msecs, uint* count)
+{
+    QByteArray frame;
+    if (!sendRequest(QueryProtocol::Count, query, msecs) || !readFrame(&frame)) {
+        return false;
+    }
+
+    QDataStream stream(frame);
+    stream.setVersion(QueryProtocol::streamVersion());
+
+    quint8 type;
+    quint32 value;
+    stream >> type >> value;
+    if (stream.status() != QDataStream::Ok || type != QueryProtocol::CountFrame) {
+        return false;
+    }
+
+    *count = value;
+    return true;
+}
+
+bool QueryClient::metrics(QByteArray* json)
+{
+    QByteArray frame;
+    if (!sendRequest(QueryProtocol::Metrics, QByteArray(), -1) || !readFrame(&frame)) {
+        return false;
+    }
+
+    QDataStream stream(frame);
+    stream.setVersion(QueryProtocol::streamVersion());
+
+    quint8 type;
+    stream >> type >> *json;
+    return stream.status() == QDataStream::Ok && type == QueryProtocol::MetricsFrame;
+}
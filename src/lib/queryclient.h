@@ -0,0 +1,99 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_QUERYCLIENT_H
+#define BALOO_QUERYCLIENT_H
+
+#include <QByteArray>
+#include <QLocalSocket>
+#include <QStringList>
+#include <QVector>
+
+namespace Baloo {
+
+/**
+ * Runs queries in baloo_query, which keeps the index open and its caches
+ * warm between the queries. See QueryProtocol.
+ */
+class QueryClient
+{
+public:
+    /**
+     * Connects to baloo_query. Returns 0 if it is not running, or if
+     * the BALOO_QUERY_SERVER environment variable is set to 0. Connecting
+     * to the server at another \p path ignores that variable.
+     */
+    static QueryClient* connectToServer(const QString& path = QString());
+    ~QueryClient();
+
+    /**
+     * Starts running \p query, whose results are then read with
+     * readResults
+     */
+    bool exec(const QByteArray& query);
+
+    /**
+     * Reads the next of the results which are streamed by the server.
+     * Returns false once all of them have been read, or if the connection
+     * was lost, see hasError.
+     */
+    bool readResults(QStringList* filePaths, QVector<QByteArray>* tokens);
+
+    /**
+     * Counts the results of \p query, see Query::estimatedCount
+     */
+    bool count(const QByteArray& query, int msecs, uint* count);
+
+    /**
+     * Fetches the \p json of the Metrics of the server, see
+     * Metrics::toVariantMap
+     */
+    bool metrics(QByteArray* json);
+
+    /**
+     * Returns true if the server did not answer in time, the connection
+     * was lost, or the server sent something which is not understood
+     */
+    bool hasError() const { return !m_error.isEmpty(); }
+    QString errorString() const { return m_error; }
+
+    /**
+     * Returns true if the results ended because the query itself failed
+     * on the server, see ResultIterator::hasError. The connection is fine
+     * then, and running the query locally would fail as well.
+     */
+    bool hasQueryError() const { return !m_queryError.isEmpty(); }
+    QString queryErrorString() const { return m_queryError; }
+
+private:
+    QueryClient();
+
+    bool sendRequest(int type, const QByteArray& query, int msecs);
+    bool readFrame(QByteArray* frame);
+
+    QLocalSocket m_socket;
+    QByteArray m_buffer;
+    bool m_finished;
+    QString m_error;
+    QString m_queryError;
+};
+
+}
+
+#endif // BALOO_QUERYCLIENT_H
@@ -0,0 +1,65 @@
+/*
+ * This file is part of the KDE Baloo Project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "querycountrunnable.h"
+
+using namespace Baloo;
+
+class QueryCountRunnable::Private {
+public:
+    Query m_query;
+    int m_estimate;
+};
+
+QueryCountRunnable::QueryCountRunnable(const Query& query, QObject* parent)
+    : QObject(parent)
+    , d(new Private)
+{
+    d->m_query = query;
+    d->m_estimate = -1;
+}
+
+QueryCountRunnable::~QueryCountRunnable()
+{
+    delete d;
+}
+
+void QueryCountRunnable::setEstimate(int msecs)
+{
+    d->m_estimate = msecs;
+}
+
+int QueryCountRunnable::estimate() const
+{
+    return d->m_estimate;
+}
+
+void QueryCountRunnable::run()
+{
+    uint count;
+    if (d->m_estimate < 0) {
+        count = d->m_query.count();
+    } else {
+        count = d->m_query.estimatedCount(d->m_estimate);
+    }
+
+    Q_EMIT finished(this, count);
+}
@@ -0,0 +1,61 @@
+/*
+ * This file is part of the KDE Baloo Project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef QUERYCOUNTRUNNABLE_H
+#define QUERYCOUNTRUNNABLE_H
+
+#include "query.h"
+#include <QRunnable>
+#include <QObject>
+
+namespace Baloo {
+
+/**
+ * Counts the results of a Query in a thread pool. See Query::count
+ * and Query::estimatedCount.
+ */
+class BALOO_CORE_EXPORT QueryCountRunnable : public QObject, public QRunnable
+{
+    Q_OBJECT
+public:
+    QueryCountRunnable(const Query& query, QObject* parent = 0);
+    ~QueryCountRunnable() Q_DECL_OVERRIDE;
+    void run() Q_DECL_OVERRIDE;
+
+    /**
+     * Only estimate the number of results, spending about \p msecs
+     * milliseconds on it. A negative value gives the exact count,
+     * which is the default.
+     */
+    void setEstimate(int msecs);
+    int estimate() const;
+
+Q_SIGNALS:
+    void finished(Baloo::QueryCountRunnable* queryRunnable, uint count);
+
+private:
+    class Private;
+    Private* d;
+};
+
+}
+
+#endif // QUERYCOUNTRUNNABLE_H
@@ -0,0 +1,80 @@
+/*
+ * This file is part of the KDE Baloo Project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "queryfacetsrunnable.h"
+
+using namespace Baloo;
+
+class QueryFacetsRunnable::Private {
+public:
+    Query m_query;
+    QStringList m_facets;
+    int m_timeLimit;
+};
+
+QueryFacetsRunnable::QueryFacetsRunnable(const Query& query, QObject* parent)
+    : QObject(parent)
+    , d(new Private)
+{
+    d->m_query = query;
+    d->m_timeLimit = -1;
+}
+
+QueryFacetsRunnable::~QueryFacetsRunnable()
+{
+    delete d;
+}
+
+void QueryFacetsRunnable::setFacets(const QStringList& facets)
+{
+    d->m_facets = facets;
+}
+
+QStringList QueryFacetsRunnable::facets() const
+{
+    return d->m_facets;
+}
+
+void QueryFacetsRunnable::setTimeLimit(int msecs)
+{
+    d->m_timeLimit = msecs;
+}
+
+int QueryFacetsRunnable::timeLimit() const
+{
+    return d->m_timeLimit;
+}
+
+void QueryFacetsRunnable::run()
+{
+    const QMap<QString, QMap<QString, uint> > counts = d->m_query.facetCounts(d->m_facets, d->m_timeLimit);
+
+    QVariantMap facets;
+    for (auto fit = counts.constBegin(); fit != counts.constEnd(); ++fit) {
+        QVariantMap values;
+        for (auto vit = fit.value().constBegin(); vit != fit.value().constEnd(); ++vit) {
+            values.insert(vit.key(), vit.value());
+        }
+        facets.insert(fit.key(), values);
+    }
+
+    Q_EMIT finished(this, facets);
+}
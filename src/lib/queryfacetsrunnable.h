@@ -0,0 +1,72 @@
+/*
+ * This file is part of the KDE Baloo Project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef QUERYFACETSRUNNABLE_H
+#define QUERYFACETSRUNNABLE_H
+
+#include "query.h"
+#include <QRunnable>
+#include <QObject>
+#include <QVariantMap>
+
+namespace Baloo {
+
+/**
+ * Counts the results of a Query for each value of some facets in a
+ * thread pool. See Query::facetCounts.
+ */
+class BALOO_CORE_EXPORT QueryFacetsRunnable : public QObject, public QRunnable
+{
+    Q_OBJECT
+public:
+    QueryFacetsRunnable(const Query& query, QObject* parent = 0);
+    ~QueryFacetsRunnable() Q_DECL_OVERRIDE;
+    void run() Q_DECL_OVERRIDE;
+
+    /**
+     * The facets to count, all of them by default
+     */
+    void setFacets(const QStringList& facets);
+    QStringList facets() const;
+
+    /**
+     * Stop counting after about \p msecs milliseconds, which gives
+     * incomplete counts. A negative value, the default, counts all
+     * the results.
+     */
+    void setTimeLimit(int msecs);
+    int timeLimit() const;
+
+Q_SIGNALS:
+    /**
+     * \p facets maps the name of each facet to a QVariantMap of the
+     * count of each of its values
+     */
+    void finished(Baloo::QueryFacetsRunnable* queryRunnable, const QVariantMap& facets);
+
+private:
+    class Private;
+    Private* d;
+};
+
+}
+
+#endif // QUERYFACETSRUNNABLE_H
@@ -0,0 +1,110 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_QUERYPROTOCOL_H
+#define BALOO_QUERYPROTOCOL_H
+
+#include "global.h"
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QIODevice>
+#include <QStandardPaths>
+#include <QString>
+#include <QtEndian>
+
+namespace Baloo {
+
+/**
+ * The protocol spoken between the clients and baloo_query over a local
+ * socket.
+ *
+ * Every message is a frame, which is its length as a 32 bit big endian
+ * number followed by a QDataStream. A client sends a single request per
+ * connection: the Version, a RequestType, a time limit in milliseconds
+ * for counting, and the query as given by Query::toJSON. The server
+ * answers a Results request with any number of ResultsFrame, each having
+ * the file paths and continuation tokens of some of the results, followed
+ * by an EndFrame, or by an ErrorFrame with the ResultIterator::errorString
+ * if the query failed. A Count request gets a single CountFrame, and a Metrics
+ * request a single MetricsFrame with the JSON of the Metrics of the server.
+ */
+namespace QueryProtocol {
+
+const quint32 Version = 1;
+
+enum RequestType {
+    Results = 1,
+    Count = 2,
+    Metrics = 3
+};
+
+enum FrameType {
+    ResultsFrame = 1,
+    CountFrame = 2,
+    EndFrame = 3,
+    MetricsFrame = 4,
+    ErrorFrame = 5
+};
+
+/**
+ * The server for the index at \p indexPath listens on this socket
+ */
+inline QString socketPath(const QString& indexPath = fileIndexDbPath())
+{
+    return QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation)
+           + QStringLiteral("/baloo_query_") + QString::number(qHash(indexPath), 16);
+}
+
+inline QDataStream::Version streamVersion()
+{
+    return QDataStream::Qt_5_3;
+}
+
+inline bool writeFrame(QIODevice* device, const QByteArray& frame)
+{
+    const quint32 size = qToBigEndian<quint32>(frame.size());
+    return device->write(reinterpret_cast<const char*>(&size), sizeof(size)) == sizeof(size)
+           && device->write(frame) == frame.size();
+}
+
+/**
+ * Takes the first frame out of \p buffer. Returns false if it has not
+ * been received completely yet.
+ */
+inline bool takeFrame(QByteArray& buffer, QByteArray* frame)
+{
+    if (buffer.size() < static_cast<int>(sizeof(quint32))) {
+        return false;
+    }
+
+    const quint32 size = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(buffer.constData()));
+    if (static_cast<quint32>(buffer.size()) - sizeof(quint32) < size) {
+        return false;
+    }
+
+    *frame = buffer.mid(sizeof(quint32), size);
+    buffer.remove(0, sizeof(quint32) + size);
+    return true;
+}
+
+}
+}
+
+#endif // BALOO_QUERYPROTOCOL_H
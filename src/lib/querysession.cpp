@@ -0,0 +1,190 @@
+/*
+ * This file is part of the KDE Baloo Project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "querysession.h"
+#include "resultiterator.h"
+#include "searchstore.h"
+#include "querycache.h"
+#include "term.h"
+
+#include "transaction.h"
+#include "enginequery.h"
+#include "postingiterator.h"
+
+#include <QScopedPointer>
+
+using namespace Baloo;
+
+class QuerySession::Private {
+public:
+    Private()
+        : valid(false)
+        , generation(0)
+    {}
+
+    bool valid;
+    quint64 generation;
+
+    // The last query and all of its results
+    Term filterTerm;
+    EngineQuery searchQuery;
+    QVector<quint64> ids;
+};
+
+QuerySession::QuerySession()
+    : d(new Private)
+{
+}
+
+QuerySession::~QuerySession()
+{
+    delete d;
+}
+
+void QuerySession::reset()
+{
+    d->valid = false;
+    d->ids.clear();
+}
+
+namespace {
+    bool containsPhrase(const EngineQuery& query)
+    {
+        if (query.op() == EngineQuery::Phrase) {
+            return true;
+        }
+
+        for (const EngineQuery& q : query.subQueries()) {
+            if (containsPhrase(q)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Returns true if every document matched by \p newQuery is
+     * also matched by \p oldQuery
+     */
+    bool refines(const EngineQuery& newQuery, const EngineQuery& oldQuery)
+    {
+        // An empty query matches everything
+        if (!oldQuery.leaf() && oldQuery.subQueries().isEmpty()) {
+            return true;
+        }
+
+        if (newQuery == oldQuery) {
+            return true;
+        }
+
+        if (oldQuery.op() == EngineQuery::And) {
+            for (const EngineQuery& q : oldQuery.subQueries()) {
+                if (!refines(newQuery, q)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        if (newQuery.op() == EngineQuery::And) {
+            for (const EngineQuery& q : newQuery.subQueries()) {
+                if (refines(q, oldQuery)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        if (newQuery.op() == EngineQuery::Or) {
+            for (const EngineQuery& q : newQuery.subQueries()) {
+                if (!refines(q, oldQuery)) {
+                    return false;
+                }
+            }
+            return !newQuery.subQueries().isEmpty();
+        }
+
+        if (oldQuery.op() == EngineQuery::Or) {
+            for (const EngineQuery& q : oldQuery.subQueries()) {
+                if (refines(newQuery, q)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        if (!newQuery.leaf() || !oldQuery.leaf()) {
+            return false;
+        }
+
+        if (oldQuery.op() == EngineQuery::StartsWith) {
+            return newQuery.term().startsWith(oldQuery.term());
+        }
+        return newQuery.op() == EngineQuery::Equal && newQuery.term() == oldQuery.term();
+    }
+}
+
+ResultIterator QuerySession::exec(const Query& query)
+{
+    const Term searchTerm = query.searchTerm();
+    const Term filterTerm = query.filterTerm();
+    const Term term = searchTerm && filterTerm;
+
+    SearchStore store;
+    QScopedPointer<Transaction> tr(store.transaction());
+    if (!tr || !term.isValid()) {
+        reset();
+
+        Query q(query);
+        return q.exec();
+    }
+
+    EngineQuery searchQuery;
+    const bool isText = store.toEngineQuery(searchTerm, searchQuery) && !containsPhrase(searchQuery);
+    const quint64 generation = tr->generation();
+
+    QVector<quint64> ids;
+    if (isText && d->valid && d->generation == generation && d->filterTerm == filterTerm &&
+        refines(searchQuery, d->searchQuery))
+    {
+        ids = tr->filter(d->ids, searchQuery);
+    }
+    else {
+        QueryCache* cache = QueryCache::instance();
+        if (!cache->lookup(term, generation, &ids)) {
+            QScopedPointer<PostingIterator> it(store.constructQuery(tr.data(), term));
+            if (it) {
+                while (it->next()) {
+                    ids << it->docId();
+                }
+            }
+            cache->insert(term, generation, ids);
+        }
+    }
+
+    d->valid = isText;
+    d->generation = generation;
+    d->filterTerm = filterTerm;
+    d->searchQuery = searchQuery;
+    d->ids = ids;
+
+    return ResultIterator(query, term, ids);
+}
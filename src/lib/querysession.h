@@ -0,0 +1,64 @@
+/*
+ * This file is part of the KDE Baloo Project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) version 3, or any
+ * later version accepted by the membership of KDE e.V. (or its
+ * successor approved by the membership of KDE e.V.), which shall
+ * act as a proxy defined in Section 6 of version 3 of the license.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BALOO_QUERYSESSION_H
+#define BALOO_QUERYSESSION_H
+
+#include "core_export.h"
+#include "query.h"
+
+namespace Baloo {
+
+/**
+ * Runs a sequence of queries, such as the ones from a search-as-you-type
+ * field, where each query usually narrows down the previous one.
+ *
+ * The session remembers the results of the last query. If the next query
+ * can only match a subset of them, for example when "fir" is extended to
+ * "fire" or "fire water", only those results are checked against the new
+ * search string instead of searching the entire index again.
+ *
+ * Otherwise, or if the index has changed in the meantime, the query is
+ * run normally.
+ */
+class BALOO_CORE_EXPORT QuerySession
+{
+public:
+    QuerySession();
+    ~QuerySession();
+
+    ResultIterator exec(const Query& query);
+
+    /**
+     * Forgets the results of the last query
+     */
+    void reset();
+
+private:
+    QuerySession(const QuerySession& rhs) = delete;
+
+    class Private;
+    Private* d;
+};
+
+}
+
+#endif // BALOO_QUERYSESSION_H
@@ -22,33 +22,563 @@
 
 #include "resultiterator.h"
 #include "searchstore.h"
+#include "term.h"
+#include "query.h"
+#include "continuationtoken.h"
+#include "querycache.h"
+#include "shardsearch.h"
+#include "queryclient.h"
 
+#include "transaction.h"
+#include "postingiterator.h"
+#include "vectorpostingiterator.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QVector>
 
 using namespace Baloo;
 
 class Baloo::ResultIteratorPrivate {
 public:
-    ResultIteratorPrivate() : pos(-1)
+    ResultIteratorPrivate(const Term& term, uint offset, int limit, Query::SortingOption sortingOption,
+                          const ContinuationToken& after)
+        : term(term)
+        , offset(offset)
+        , limit(limit)
+        , sortingOption(sortingOption)
+        , property(0)
+        , sortOrder(Qt::AscendingOrder)
+        , after(after)
+        , hasCandidates(false)
+        , tr(0)
+        , it(0)
+        , pos(-1)
+        , lastId(0)
+        , skipped(0)
+        , count(0)
+        , pending(false)
+        , closed(false)
+        , maxSeenIds(0)
+        , recording(false)
+        , maxSnapshotAge(10 * 1000)
+        , shards(0)
+        , inShards(false)
+        , mainPending(false)
+        , mainDone(false)
+        , mergeOffset(0)
+        , mergeLimit(-1)
+        , mergeSkipped(0)
+        , merged(0)
+        , client(0)
+        , remote(false)
+        , remotePos(-1)
+        , remoteCount(0)
     {}
 
     ~ResultIteratorPrivate() {
+        close();
     }
 
-    QStringList results;
+    bool start();
+    void renew();
+    void skipPast(quint64 id);
+    void close();
+
+    bool nextMain();
+    bool nextStreamed();
+    bool nextSorted();
+    bool nextMerged();
+    bool takeMerged();
+    bool nextRemote();
+    bool fallBack();
+
+    SearchStore store;
+    Term term;
+    uint offset;
+    int limit;
+    Query::SortingOption sortingOption;
+    QString sortingProperty;
+    quint32 property;
+    Qt::SortOrder sortOrder;
+
+    ContinuationToken after;
+    ContinuationToken current;
+
+    QString error;
+
+    // The results are already known, and only need to be iterated over
+    bool hasCandidates;
+    QVector<quint64> candidates;
+
+    Transaction* tr;
+    PostingIterator* it;
+
+    // Only used when the results need to be sorted
+    QVector<quint64> ids;
     int pos;
+
+    quint64 lastId;
+    uint skipped;
+    int count;
+    bool pending;
+    bool closed;
+
+    // The ids seen while streaming, so that they can be cached at the end
+    QVector<quint64> seenIds;
+    int maxSeenIds;
+    bool recording;
+
+    QString filePath;
+
+    QElapsedTimer snapshotAge;
+    int maxSnapshotAge;
+
+    // The results of the other devices, which are merged with the ones of
+    // the main index
+    ShardSearch* shards;
+    bool inShards;
+    QVector<QVector<ShardResult> > shardResults;
+    QVector<int> shardPos;
+
+    // The next result of the main index, which is held back while the
+    // shards have earlier ones
+    bool mainPending;
+    bool mainDone;
+    QString mainPath;
+    ShardResult mainKey;
+    ContinuationToken mainToken;
+
+    // The offset and limit apply to the merged results, so the main index
+    // and each of the shards fetch all the results up to the end of the page
+    uint mergeOffset;
+    int mergeLimit;
+    uint mergeSkipped;
+    int merged;
+
+    // The query is run by the query server, which sends the results in batches
+    QueryClient* client;
+    bool remote;
+    QStringList remotePaths;
+    QVector<QByteArray> remoteTokens;
+    int remotePos;
+    QByteArray remoteToken;
+    int remoteCount;
 };
 
-ResultIterator::ResultIterator(const QStringList& results)
-    : d(new ResultIteratorPrivate)
+bool ResultIteratorPrivate::start()
+{
+    tr = store.transaction();
+    if (!tr) {
+        return false;
+    }
+    snapshotAge.start();
+
+    current.sortingOption = sortingOption;
+    current.generation = tr->generation();
+    current.position = after.isValid() ? after.position : offset;
+
+    if (after.isValid()) {
+        if (after.sortingOption != sortingOption) {
+            error = QStringLiteral("The continuation token belongs to a query with another sorting option");
+            return false;
+        }
+        // Relevance sorted results are resumed from their position, which
+        // points elsewhere once the index has changed
+        if (sortingOption == Query::SortRelevance && after.generation != current.generation) {
+            error = QStringLiteral("The index has changed since the continuation token was created");
+            return false;
+        }
+        if (sortingOption == Query::SortProperty && after.sortingProperty != sortingProperty) {
+            error = QStringLiteral("The continuation token belongs to a query sorted by another property");
+            return false;
+        }
+    }
+    if (sortingOption == Query::SortProperty) {
+        current.sortingProperty = sortingProperty;
+        property = store.orderedProperty(sortingProperty);
+    }
+
+    // The results of the other devices have no place among the ids of the
+    // main index, so such a page is continued from its position instead
+    if (after.merged) {
+        offset = after.position;
+        after = ContinuationToken();
+    }
+
+    if (!hasCandidates && !after.isValid()) {
+        shards = new ShardSearch(term);
+        shards->setSortingOption(sortingOption, sortingProperty, sortOrder);
+        shards->setLimit(limit < 0 ? -1 : static_cast<int>(offset) + limit);
+        if (shards->startResults()) {
+            mergeOffset = offset;
+            mergeLimit = limit;
+            if (limit >= 0) {
+                limit += offset;
+            }
+            offset = 0;
+        } else {
+            delete shards;
+            shards = 0;
+        }
+    }
+
+    QueryCache* cache = QueryCache::instance();
+
+    QVector<quint64> cachedIds;
+    const bool isCached = hasCandidates || cache->lookup(term, current.generation, &cachedIds);
+    if (hasCandidates) {
+        it = new VectorPostingIterator(candidates);
+    } else if (isCached) {
+        it = new VectorPostingIterator(cachedIds);
+    } else {
+        it = store.constructQuery(tr, term);
+    }
+    if (!it) {
+        // The other devices can still have results
+        return shards != 0;
+    }
+
+    if (sortingOption != Query::SortNone) {
+        // All the results need to be fetched for sorting anyway
+        if (!isCached) {
+            while (it->next()) {
+                cachedIds << it->docId();
+            }
+            cache->insert(term, current.generation, cachedIds);
+
+            delete it;
+            it = new VectorPostingIterator(cachedIds);
+        }
+
+        ids = store.sortedResults(tr, it, term, offset, limit, sortingOption, after,
+                                  sortingProperty, sortOrder);
+
+        delete it;
+        it = 0;
+    }
+    else if (after.isValid()) {
+        skipPast(after.docId);
+        offset = 0;
+    }
+    recording = sortingOption == Query::SortNone && !isCached && !pending;
+    maxSeenIds = cache->maximumSize() / sizeof(quint64);
+
+    return true;
+}
+
+void ResultIteratorPrivate::skipPast(quint64 id)
+{
+    // The ids are always increasing, so we can continue after the last one
+    if (it->next() && it->docId() <= id) {
+        it->skipTo(id + 1);
+    }
+    lastId = id;
+    pending = true;
+}
+
+void ResultIteratorPrivate::renew()
+{
+    delete it;
+    it = 0;
+    delete tr;
+
+    tr = store.transaction();
+    if (!tr) {
+        return;
+    }
+    snapshotAge.start();
+
+    if (sortingOption != Query::SortNone) {
+        return;
+    }
+
+    // The results are no longer from a single snapshot
+    recording = false;
+    seenIds.clear();
+
+    if (hasCandidates) {
+        it = new VectorPostingIterator(candidates);
+    } else {
+        it = store.constructQuery(tr, term);
+    }
+    if (it && lastId) {
+        skipPast(lastId);
+    }
+}
+
+void ResultIteratorPrivate::close()
+{
+    delete it;
+    it = 0;
+    delete tr;
+    tr = 0;
+
+    ids.clear();
+    closed = true;
+
+    delete shards;
+    shards = 0;
+    shardResults.clear();
+
+    delete client;
+    client = 0;
+    remotePaths.clear();
+    remoteTokens.clear();
+}
+
+bool ResultIteratorPrivate::nextMain()
+{
+    if (!tr) {
+        return false;
+    }
+
+    if (maxSnapshotAge >= 0 && snapshotAge.hasExpired(maxSnapshotAge)) {
+        renew();
+        if (!tr) {
+            return false;
+        }
+    }
+
+    if (sortingOption == Query::SortNone) {
+        return (limit < 0 || count < limit) && nextStreamed();
+    }
+    return nextSorted();
+}
+
+bool ResultIteratorPrivate::nextStreamed()
+{
+    if (!it) {
+        return false;
+    }
+
+    while (1) {
+        const quint64 id = pending ? it->docId() : it->next();
+        pending = false;
+        if (!id) {
+            if (recording) {
+                QueryCache::instance()->insert(term, current.generation, seenIds);
+                recording = false;
+                seenIds.clear();
+            }
+            return false;
+        }
+        lastId = id;
+
+        if (recording) {
+            // Too large to be cached
+            if (seenIds.size() >= maxSeenIds) {
+                recording = false;
+                seenIds.clear();
+            } else {
+                seenIds << id;
+            }
+        }
+
+        if (skipped < offset) {
+            skipped++;
+            continue;
+        }
+
+        // The file could have been removed after the snapshot was renewed
+        const QByteArray url = tr->documentUrl(id);
+        if (url.isEmpty()) {
+            continue;
+        }
+
+        filePath = QFile::decodeName(url);
+        count++;
+
+        current.docId = id;
+        current.position++;
+        return true;
+    }
+}
+
+bool ResultIteratorPrivate::nextSorted()
+{
+    while (++pos < ids.size()) {
+        const quint64 id = ids[pos];
+        const QByteArray url = tr->documentUrl(id);
+        if (url.isEmpty()) {
+            continue;
+        }
+
+        filePath = QFile::decodeName(url);
+        count++;
+
+        current.docId = id;
+        current.position = (after.isValid() ? after.position : offset) + pos + 1;
+        if (sortingOption == Query::SortProperty && property) {
+            current.hasValue = tr->documentProperty(id, property, &current.value);
+        } else if (sortingOption != Query::SortRelevance) {
+            // Also used when the sorting property is unknown
+            current.mTime = tr->documentTimeInfo(id).mTime;
+        }
+        return true;
+    }
+
+    return false;
+}
+
+bool ResultIteratorPrivate::nextMerged()
+{
+    while (mergeLimit < 0 || merged < mergeLimit) {
+        if (!takeMerged()) {
+            return false;
+        }
+        if (mergeSkipped < mergeOffset) {
+            mergeSkipped++;
+            continue;
+        }
+
+        merged++;
+        current.position = mergeOffset + merged;
+        current.merged = true;
+        return true;
+    }
+
+    return false;
+}
+
+bool ResultIteratorPrivate::takeMerged()
+{
+    // Peek at the next result of the main index
+    if (!mainPending && !mainDone) {
+        const ContinuationToken returned = current;
+        if (nextMain()) {
+            mainPath = filePath;
+            mainKey = ShardResult();
+            mainKey.rank = count - 1;
+            mainKey.mTime = current.mTime;
+            mainKey.hasValue = current.hasValue;
+            mainKey.value = current.value;
+            mainToken = current;
+            current = returned;
+            mainPending = true;
+        } else {
+            // Done with the main index, so its snapshot can go
+            mainDone = true;
+            delete it;
+            it = 0;
+            delete tr;
+            tr = 0;
+            ids.clear();
+        }
+    }
+
+    // Without any order the results of the main index simply come first,
+    // so the shards are not waited for until then
+    const bool waitForShards = !mainPending || sortingOption != Query::SortNone;
+    if (waitForShards && !inShards) {
+        shardResults = shards->results();
+        shardPos.fill(0, shardResults.size());
+        inShards = true;
+    }
+
+    // There are only a few devices, so the heads are compared one by one.
+    // Ties go to the main index, and then to the earlier shards.
+    const ShardResult* next = mainPending ? &mainKey : 0;
+    int shard = -1;
+    for (int i = 0; inShards && i < shardResults.size(); i++) {
+        if (shardPos[i] >= shardResults[i].size()) {
+            continue;
+        }
+        const ShardResult& head = shardResults[i][shardPos[i]];
+        if (!next || shards->lessThan(head, *next)) {
+            next = &head;
+            shard = i;
+        }
+    }
+
+    if (!next) {
+        return false;
+    }
+
+    if (shard < 0) {
+        filePath = mainPath;
+        current = mainToken;
+        mainPending = false;
+    } else {
+        filePath = next->filePath;
+        shardPos[shard]++;
+    }
+    return true;
+}
+
+bool ResultIteratorPrivate::nextRemote()
 {
-    d->results = results;
-    d->pos = -1;
+    while (++remotePos >= remotePaths.size()) {
+        remotePos = -1;
+        if (!client || !client->readResults(&remotePaths, &remoteTokens)) {
+            return false;
+        }
+    }
+
+    filePath = remotePaths[remotePos];
+    remoteToken = remoteTokens[remotePos];
+    remoteCount++;
+    return true;
 }
 
-ResultIterator::ResultIterator(const ResultIterator& rhs)
+bool ResultIteratorPrivate::fallBack()
+{
+    qWarning() << "Running the query locally, as the query server failed:" << client->errorString();
+
+    delete client;
+    client = 0;
+    remote = false;
+    remotePaths.clear();
+    remoteTokens.clear();
+
+    return start();
+}
+
+ResultIterator::ResultIterator(const Query& query, const Term& term)
+    : d(new ResultIteratorPrivate(term, query.offset(), static_cast<int>(query.limit()), query.sortingOption(),
+                                  ContinuationToken::fromByteArray(query.continuationToken())))
+{
+    d->sortingProperty = query.sortingProperty();
+    d->sortOrder = query.sortOrder();
+
+    if (!d->start()) {
+        d->close();
+    }
+}
+
+ResultIterator::ResultIterator(const Query& query, const Term& term, const QVector<quint64>& candidates)
+    : d(new ResultIteratorPrivate(term, query.offset(), static_cast<int>(query.limit()), query.sortingOption(),
+                                  ContinuationToken::fromByteArray(query.continuationToken())))
+{
+    d->sortingProperty = query.sortingProperty();
+    d->sortOrder = query.sortOrder();
+
+    d->hasCandidates = true;
+    d->candidates = candidates;
+
+    if (!d->start()) {
+        d->close();
+    }
+}
+
+ResultIterator::ResultIterator(const Query& query, const Term& term, QueryClient* client)
+    : d(new ResultIteratorPrivate(term, query.offset(), static_cast<int>(query.limit()), query.sortingOption(),
+                                  ContinuationToken::fromByteArray(query.continuationToken())))
+{
+    d->sortingProperty = query.sortingProperty();
+    d->sortOrder = query.sortOrder();
+
+    d->client = client;
+    d->remote = true;
+}
+
+ResultIterator::ResultIterator(ResultIterator&& rhs)
     : d(rhs.d)
 {
+    // Leave a closed iterator behind, which can still be used and destroyed
+    rhs.d = new ResultIteratorPrivate(Term(), 0, 0, Query::SortNone, ContinuationToken());
+    rhs.d->closed = true;
 }
 
 ResultIterator::~ResultIterator()
@@ -58,12 +588,77 @@ ResultIterator::~ResultIterator()
 
 bool ResultIterator::next()
 {
-    d->pos++;
-    return d->pos < d->results.size();
+    if (d->closed) {
+        return false;
+    }
+
+    if (d->remote) {
+        if (d->nextRemote()) {
+            return true;
+        }
+
+        if (d->client && d->client->hasQueryError()) {
+            d->error = d->client->queryErrorString();
+            d->close();
+            return false;
+        }
+        if (!d->client || !d->client->hasError()) {
+            d->close();
+            return false;
+        }
+
+        // Nothing was returned yet, so the query can just as well be run
+        // here. Otherwise the results which are left are lost.
+        if (d->remoteCount) {
+            d->error = QStringLiteral("Lost the connection to the query server: ") + d->client->errorString();
+            d->close();
+            return false;
+        }
+        if (!d->fallBack()) {
+            d->close();
+            return false;
+        }
+    }
+
+    const bool hasNext = d->shards ? d->nextMerged() : d->nextMain();
+
+    // Release the snapshot as soon as we are done
+    if (!hasNext) {
+        d->close();
+    }
+    return hasNext;
 }
 
 QString ResultIterator::filePath() const
 {
-    Q_ASSERT(d->pos >= 0 && d->pos < d->results.size());
-    return d->results.at(d->pos);
+    Q_ASSERT(!d->closed);
+    return d->filePath;
+}
+
+void ResultIterator::close()
+{
+    d->close();
+}
+
+QByteArray ResultIterator::continuationToken() const
+{
+    if (d->remote) {
+        return d->remoteToken;
+    }
+    return d->current.toByteArray();
+}
+
+void ResultIterator::setMaximumSnapshotAge(int msecs)
+{
+    d->maxSnapshotAge = msecs;
+}
+
+bool ResultIterator::hasError() const
+{
+    return !d->error.isEmpty();
+}
+
+QString ResultIterator::errorString() const
+{
+    return d->error;
 }
@@ -26,27 +26,93 @@
 #include "core_export.h"
 
 #include <QString>
+#include <QVector>
 
 namespace Baloo {
 
 class SearchStore;
 class Result;
+class Term;
+class Query;
 class ResultIteratorPrivate;
+class QueryClient;
 
+/**
+ * Iterates over the results of a Query.
+ *
+ * The results are fetched from the database as the iterator advances, and
+ * the iterator holds a read transaction on the database while it is
+ * alive. It should be closed or destroyed once it is no longer needed.
+ */
 class BALOO_CORE_EXPORT ResultIterator
 {
 public:
-    ResultIterator(const ResultIterator& rhs);
+    ResultIterator(ResultIterator&& rhs);
     ~ResultIterator();
 
+    // The iterator owns a read transaction, so it can only be moved
+    ResultIterator(const ResultIterator& rhs) = delete;
+    ResultIterator& operator=(const ResultIterator& rhs) = delete;
+
     bool next();
     QString filePath() const;
 
+    /**
+     * Returns a token for the current result. Passing it to
+     * Query::setContinuationToken makes the query return the results
+     * which come after this one, without going through the previous ones.
+     *
+     * An empty token is returned before the first result.
+     */
+    QByteArray continuationToken() const;
+
+    /**
+     * Releases the database resources held by the iterator. Calling
+     * next() after this returns false.
+     */
+    void close();
+
+    /**
+     * Sets the maximum time in milliseconds the iterator reads from the same
+     * database snapshot. Once it is exceeded, the iterator moves to a newer
+     * snapshot and continues from where it was, so that a long lived iterator
+     * does not prevent the database from reusing freed pages.
+     *
+     * A negative value disables this. The default is 10 seconds. It has no
+     * effect when the query is run by the query server.
+     */
+    void setMaximumSnapshotAge(int msecs);
+
+    /**
+     * Returns true if the results ended because of an error, rather than
+     * because all of them were returned. This happens for example when the
+     * continuation token of the query can no longer be resumed from, or
+     * when the connection to the query server is lost.
+     *
+     * \sa errorString
+     */
+    bool hasError() const;
+    QString errorString() const;
+
 private:
-    ResultIterator(const QStringList& results);
+    ResultIterator(const Query& query, const Term& term);
+
+    /**
+     * Iterates over the already known \p candidates, which should be
+     * the results of the \p term
+     */
+    ResultIterator(const Query& query, const Term& term, const QVector<quint64>& candidates);
+
+    /**
+     * Reads the results of a query which is run by the query server. The
+     * \p query is run locally instead if the server fails before it sent
+     * any results.
+     */
+    ResultIterator(const Query& query, const Term& term, QueryClient* client);
     ResultIteratorPrivate* d;
 
     friend class Query;
+    friend class QuerySession;
 };
 
 }
@@ -31,8 +31,15 @@
 #include "termgenerator.h"
 #include "andpostingiterator.h"
 #include "orpostingiterator.h"
+#include "andnotpostingiterator.h"
 #include "idutils.h"
+#include "orderedvalues.h"
+#include "querycache.h"
+#include "queryprofile.h"
+#include "metrics.h"
 
+#include <QElapsedTimer>
+#include <QScopedPointer>
 #include <QStandardPaths>
 #include <QFile>
 
@@ -41,17 +48,44 @@
 #include <KFileMetaData/Types>
 
 #include <algorithm>
+#include <limits>
 
 using namespace Baloo;
 
+// Appends all the remaining ids of \p it to \p ids
+static void readIds(PostingIterator* it, QVector<quint64>& ids)
+{
+    const int blockSize = 1024;
+    int size;
+    do {
+        const int pos = ids.size();
+        ids.resize(pos + blockSize);
+        size = it->nextBlock(ids.data() + pos, blockSize);
+        ids.resize(pos + size);
+    } while (size == blockSize);
+}
+
 SearchStore::SearchStore()
     : m_db(0)
+    , m_useCache(true)
 {
     m_db = globalDatabaseInstance();
     if (!m_db->open(Database::OpenDatabase)) {
         m_db = 0;
     }
 
+    initPrefixes();
+}
+
+SearchStore::SearchStore(Database* db)
+    : m_db(db)
+    , m_useCache(false)
+{
+    initPrefixes();
+}
+
+void SearchStore::initPrefixes()
+{
     m_prefixes.insert(QByteArray("filename"), QByteArray("F"));
     m_prefixes.insert(QByteArray("mimetype"), QByteArray("M"));
     m_prefixes.insert(QByteArray("rating"), QByteArray("R"));
@@ -64,72 +98,385 @@ SearchStore::~SearchStore()
 {
 }
 
-// Return the result with-in [offset, offset + limit)
-QStringList SearchStore::exec(const Term& term, uint offset, int limit, bool sortResults)
+Transaction* SearchStore::transaction()
 {
     if (!m_db || !m_db->isOpen()) {
-        return QStringList();
+        return 0;
+    }
+
+    return new Transaction(m_db, Transaction::ReadOnly);
+}
+
+uint SearchStore::count(Transaction* tr, const Term& term, int msecs, bool* exact)
+{
+    Q_ASSERT(tr);
+
+    static MetricsHistogram* countTime = Metrics::instance()->histogram(QStringLiteral("searchstore.count.usecs"));
+    MetricsTimer timer(countTime);
+
+    if (exact) {
+        *exact = true;
+    }
+
+    QVector<quint64> cachedIds;
+    if (m_useCache && QueryCache::instance()->lookup(term, tr->generation(), &cachedIds)) {
+        return cachedIds.size();
     }
 
-    Transaction tr(m_db, Transaction::ReadOnly);
-    QScopedPointer<PostingIterator> it(constructQuery(&tr, term));
+    QScopedPointer<PostingIterator> it(constructQuery(tr, term));
     if (!it) {
-        return QStringList();
+        return 0;
     }
 
-    if (sortResults) {
-        QVector<quint64> resultIds;
-        while (it->next()) {
-            quint64 id = it->docId();
-            resultIds << id;
+    // Only needed if we run out of time
+    const uint estimate = msecs >= 0 ? it->estimateSize(tr->size()) : 0;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Checking the clock for every id would be too costly
+    quint64 block[1024];
+    uint count = 0;
+    int size;
+    do {
+        size = it->nextBlock(block, 1024);
+        count += size;
+
+        if (msecs >= 0 && size == 1024 && timer.elapsed() >= msecs) {
+            if (exact) {
+                *exact = false;
+            }
+            return qMax(count, estimate);
+        }
+    } while (size == 1024);
+
+    return count;
+}
+
+QMap<QString, QMap<QString, uint> > SearchStore::facetCounts(Transaction* tr, const Term& term, const QStringList& facets,
+                                                              int msecs, bool* complete)
+{
+    Q_ASSERT(tr);
+
+    if (complete) {
+        *complete = true;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
 
-            Q_ASSERT(id > 0);
+    // At least half of the time is left for counting
+    uint estimate = 0;
+    const QVector<quint64> ids = fetchIds(tr, term, msecs < 0 ? -1 : msecs / 2, &estimate);
+
+    // Only some of the results were read in time, so their counts stand for all of them
+    const double scale = ids.isEmpty() ? 1.0 : static_cast<double>(estimate) / ids.size();
+    if (estimate != static_cast<uint>(ids.size()) && complete) {
+        *complete = false;
+    }
+
+    QMap<QString, QMap<QString, uint> > counts;
+    for (const QString& facet : facets) {
+        int remaining = -1;
+        if (msecs >= 0) {
+            remaining = qMax<int>(msecs - timer.elapsed(), 0);
         }
 
-        // No enough result within range, no need to sort.
-        if (offset >= static_cast<uint>(resultIds.size())) {
-            return QStringList();
+        bool facetComplete = true;
+        QMap<QString, uint> values;
+
+        if (facet == QLatin1String("year")) {
+            const QMap<int, uint> years = tr->yearCounts(ids, remaining, &facetComplete);
+            for (auto it = years.constBegin(); it != years.constEnd(); ++it) {
+                values.insert(QString::number(it.key()), it.value());
+            }
         }
+        else if (facet == QLatin1String("type") || facet == QLatin1String("mimetype") ||
+                 facet == QLatin1String("tag"))
+        {
+            QByteArray prefix;
+            if (facet == QLatin1String("type")) {
+                prefix = "T";
+            } else if (facet == QLatin1String("mimetype")) {
+                prefix = "M";
+            } else {
+                prefix = "TAG-";
+            }
 
-        auto compFunc = [&tr](const quint64 lhs, const quint64 rhs) {
-            return tr.documentTimeInfo(lhs).mTime > tr.documentTimeInfo(rhs).mTime;
-        };
+            QVector<QByteArray> terms = tr->fetchTermsStartingWith(prefix);
+            if (facet == QLatin1String("type")) {
+                // The tag terms share the prefix of the types
+                auto isTag = [](const QByteArray& t) {
+                    bool ok;
+                    t.mid(1).toInt(&ok);
+                    return !ok;
+                };
+                terms.erase(std::remove_if(terms.begin(), terms.end(), isTag), terms.end());
+            }
 
-        std::sort(resultIds.begin(), resultIds.end(), compFunc);
-        if (limit < 0) {
-            limit = resultIds.size();
+            const QMap<QByteArray, uint> termCounts = tr->termCounts(ids, terms, remaining, &facetComplete);
+            for (auto it = termCounts.constBegin(); it != termCounts.constEnd(); ++it) {
+                const QByteArray value = it.key().mid(prefix.size());
+                if (facet == QLatin1String("type")) {
+                    const auto type = static_cast<KFileMetaData::Type::Type>(value.toInt());
+                    values.insert(KFileMetaData::TypeInfo(type).name(), it.value());
+                } else {
+                    values.insert(QString::fromUtf8(value), it.value());
+                }
+            }
+        }
+        else {
+            continue;
         }
 
-        QStringList results;
-        const uint end = qMin(static_cast<uint>(resultIds.size()), offset + static_cast<uint>(limit));
-        for (uint i = offset; i < end; i++) {
-            const quint64 id = resultIds[i];
-            const QString filePath = tr.documentUrl(id);
+        if (scale > 1.0) {
+            for (auto it = values.begin(); it != values.end(); ++it) {
+                it.value() = qRound(it.value() * scale);
+            }
+        }
+        counts.insert(facet, values);
 
-            results << filePath;
+        if (!facetComplete && complete) {
+            *complete = false;
         }
+    }
+
+    return counts;
+}
 
-        return results;
+QVariantMap SearchStore::propertyStatistics(Transaction* tr, const Term& term, const QString& property, int buckets)
+{
+    Q_ASSERT(tr);
+    Q_ASSERT(buckets > 0);
+
+    const quint32 prop = orderedProperty(property);
+    if (!prop) {
+        qDebug() << "Property" << property << "does not have numeric values";
+        return QVariantMap();
     }
-    else {
-        uint i = 0;
-        QStringList results;
-        const uint end = offset + static_cast<uint>(limit);
 
-        while (it->next() && (limit < 0 || i < end)) {
-            quint64 id = it->docId();
-            Q_ASSERT(id > 0);
+    const QVector<QPair<quint64, qint64> > values = tr->propertyValues(prop, fetchIds(tr, term));
+
+    QVariantMap stats;
+    stats.insert(QStringLiteral("count"), values.size());
+    if (values.isEmpty()) {
+        return stats;
+    }
+
+    qint64 minimum = values.first().second;
+    qint64 maximum = minimum;
+    for (const auto& value : values) {
+        minimum = qMin(minimum, value.second);
+        maximum = qMax(maximum, value.second);
+    }
+
+    // Doubles avoid overflowing for very large ranges
+    const double width = (static_cast<double>(maximum) - minimum + 1) / buckets;
+    QVector<uint> histogram(buckets, 0);
+    for (const auto& value : values) {
+        const int bucket = static_cast<int>((static_cast<double>(value.second) - minimum) / width);
+        histogram[qMin(bucket, buckets - 1)]++;
+    }
+
+    QVariantList histogramList;
+    histogramList.reserve(buckets);
+    for (uint count : histogram) {
+        histogramList << count;
+    }
+    stats.insert(QStringLiteral("histogram"), histogramList);
+
+    KFileMetaData::PropertyInfo pi = KFileMetaData::PropertyInfo::fromName(property);
+    if (pi.valueType() == QVariant::Date || pi.valueType() == QVariant::DateTime) {
+        stats.insert(QStringLiteral("minimum"), QDateTime::fromMSecsSinceEpoch(minimum * 1000, Qt::UTC));
+        stats.insert(QStringLiteral("maximum"), QDateTime::fromMSecsSinceEpoch(maximum * 1000, Qt::UTC));
+    } else {
+        stats.insert(QStringLiteral("minimum"), minimum);
+        stats.insert(QStringLiteral("maximum"), maximum);
+    }
+
+    return stats;
+}
+
+QVector<quint64> SearchStore::fetchIds(Transaction* tr, const Term& term)
+{
+    QVector<quint64> ids;
+    QueryCache* cache = QueryCache::instance();
+    if (!m_useCache || !cache->lookup(term, tr->generation(), &ids)) {
+        QScopedPointer<PostingIterator> it(constructQuery(tr, term));
+        if (it) {
+            readIds(it.data(), ids);
+        }
+        if (m_useCache) {
+            cache->insert(term, tr->generation(), ids);
+        }
+    }
+
+    return ids;
+}
+
+QVector<quint64> SearchStore::fetchIds(Transaction* tr, const Term& term, int msecs, uint* estimate)
+{
+    Q_ASSERT(estimate);
+
+    if (msecs < 0) {
+        const QVector<quint64> ids = fetchIds(tr, term);
+        *estimate = ids.size();
+        return ids;
+    }
+
+    QVector<quint64> ids;
+    QueryCache* cache = QueryCache::instance();
+    if (m_useCache && cache->lookup(term, tr->generation(), &ids)) {
+        *estimate = ids.size();
+        return ids;
+    }
+
+    QScopedPointer<PostingIterator> it(constructQuery(tr, term));
+    if (!it) {
+        *estimate = 0;
+        return ids;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Like in count, the clock is only checked once per block
+    const int blockSize = 1024;
+    int size;
+    do {
+        const int pos = ids.size();
+        ids.resize(pos + blockSize);
+        size = it->nextBlock(ids.data() + pos, blockSize);
+        ids.resize(pos + size);
+
+        if (size == blockSize && timer.elapsed() >= msecs) {
+            *estimate = qMax<uint>(ids.size(), it->estimateSize(tr->size()));
+            return ids;
+        }
+    } while (size == blockSize);
+
+    if (m_useCache) {
+        cache->insert(term, tr->generation(), ids);
+    }
+    *estimate = ids.size();
+    return ids;
+}
+
+// Return the result with-in [offset, offset + limit)
+QVector<quint64> SearchStore::sortedResults(Transaction* tr, PostingIterator* it, const Term& term,
+                                            uint offset, int limit, Query::SortingOption sortingOption,
+                                            const ContinuationToken& after, const QString& sortingProperty,
+                                            Qt::SortOrder order)
+{
+    Q_ASSERT(tr);
+    Q_ASSERT(it);
+
+    static MetricsHistogram* queryTime = Metrics::instance()->histogram(QStringLiteral("searchstore.query.usecs"));
+    MetricsTimer timer(queryTime);
+
+    if (after.isValid()) {
+        offset = after.position;
+    }
+
+    if (sortingOption == Query::SortRelevance) {
+        // The scores depend on the entire index, so the position is the best we can
+        // do. It is only valid for the generation the token was created in
+        const EngineQuery rankingQuery = constructRankingQuery(term);
+        const int count = limit < 0 ? -1 : static_cast<int>(offset) + limit;
+        const QVector<quint64> resultIds = tr->execRanked(rankingQuery, it, count);
+
+        return resultIds.mid(offset, limit);
+    }
+
+    const quint32 property = sortingOption == Query::SortProperty ? orderedProperty(sortingProperty) : 0;
+    if (property) {
+        QVector<quint64> ids;
+        readIds(it, ids);
+
+        // The values are read from their own column, in the order of the ids
+        typedef QPair<qint64, quint64> ValueKey;
+        QVector<ValueKey> values;
+        QVector<quint64> missing;
+        int pos = 0;
+        for (const auto& value : tr->propertyValues(property, ids)) {
+            while (ids[pos] != value.first) {
+                missing << ids[pos++];
+            }
+            pos++;
+            values << qMakePair(value.second, value.first);
+        }
+        missing += ids.mid(pos);
+
+        auto compFunc = [order](const ValueKey& lhs, const ValueKey& rhs) {
+            if (lhs.first != rhs.first) {
+                return order == Qt::AscendingOrder ? lhs.first < rhs.first : lhs.first > rhs.first;
+            }
+            return lhs.second < rhs.second;
+        };
+        std::sort(values.begin(), values.end(), compFunc);
 
-            if (i >= offset) {
-                results << tr.documentUrl(it->docId());
-                Q_ASSERT(!results.last().isEmpty());
+        QVector<quint64> sortedIds;
+        sortedIds.reserve(ids.size());
+        for (const ValueKey& value : values) {
+            sortedIds << value.second;
+        }
+        // The files without a value come last
+        sortedIds += missing;
+
+        int start = offset;
+        if (after.isValid() && after.sortingOption == Query::SortProperty) {
+            if (after.hasValue) {
+                const ValueKey key = qMakePair(after.value, after.docId);
+                start = std::upper_bound(values.constBegin(), values.constEnd(), key, compFunc) - values.constBegin();
+            } else {
+                // Only the files without a value can follow
+                start = values.size() + (std::upper_bound(missing.constBegin(), missing.constEnd(), after.docId)
+                                         - missing.constBegin());
             }
+        }
 
-            i++;
+        return sortedIds.mid(start, limit);
+    }
+
+    // Sorted by mtime, newest first. The id breaks ties so that the order is stable
+    typedef QPair<quint32, quint64> SortKey;
+    auto compFunc = [](const SortKey& lhs, const SortKey& rhs) {
+        if (lhs.first != rhs.first) {
+            return lhs.first > rhs.first;
         }
+        return lhs.second < rhs.second;
+    };
+
+    QVector<SortKey> results;
+    while (it->next()) {
+        quint64 id = it->docId();
+        Q_ASSERT(id > 0);
+
+        results << qMakePair(tr->documentTimeInfo(id).mTime, id);
+    }
+
+    std::sort(results.begin(), results.end(), compFunc);
+
+    int start = offset;
+    if (after.isValid() && after.sortingOption != Query::SortRelevance) {
+        const SortKey key = qMakePair(after.mTime, after.docId);
+        start = std::upper_bound(results.constBegin(), results.constEnd(), key, compFunc) - results.constBegin();
+    }
 
-        return results;
+    // No enough result within range
+    if (start >= results.size()) {
+        return QVector<quint64>();
     }
+
+    const int end = limit < 0 ? results.size() : qMin(results.size(), start + limit);
+
+    QVector<quint64> resultIds;
+    resultIds.reserve(end - start);
+    for (int i = start; i < end; i++) {
+        resultIds << results[i].second;
+    }
+
+    return resultIds;
 }
 
 QByteArray SearchStore::fetchPrefix(const QByteArray& property) const
@@ -150,28 +497,99 @@ QByteArray SearchStore::fetchPrefix(const QByteArray& property) const
 
 }
 
+QVariantMap SearchStore::explain(Transaction* tr, const Term& term)
+{
+    Q_ASSERT(tr);
+
+    QueryProfile profile;
+    tr->setProfile(&profile);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    uint count = 0;
+    QScopedPointer<PostingIterator> it(constructQuery(tr, term));
+    if (it) {
+        while (it->next()) {
+            count++;
+        }
+    }
+    const qint64 usecs = timer.nsecsElapsed() / 1000;
+
+    tr->setProfile(0);
+
+    QVariantMap map;
+    map.insert(QStringLiteral("count"), count);
+    map.insert(QStringLiteral("usecs"), usecs);
+    map.insert(QStringLiteral("documents"), tr->size());
+    if (it) {
+        map.insert(QStringLiteral("plan"), profile.toVariantMap());
+    }
+
+    return map;
+}
+
 PostingIterator* SearchStore::constructQuery(Transaction* tr, const Term& term)
+{
+    PostingIterator* it = buildQuery(tr, term);
+    if (!it || !tr->isProfiling()) {
+        return it;
+    }
+
+    QString name;
+    QDebug(&name).nospace() << term;
+    return tr->profiled(it, name);
+}
+
+PostingIterator* SearchStore::buildQuery(Transaction* tr, const Term& term)
 {
     Q_ASSERT(tr);
 
+    if (term.isNegated()) {
+        Term t(term);
+        t.setNegation(false);
+
+        return new AndNotPostingIterator(tr->allDocumentsIter(), {constructQuery(tr, t)});
+    }
+
     if (term.operation() == Term::And || term.operation() == Term::Or) {
         QList<Term> subTerms = term.subTerms();
         QVector<PostingIterator*> vec;
         vec.reserve(subTerms.size());
 
+        // The negated terms only filter the results of the others, so
+        // that they are never read completely
+        QVector<PostingIterator*> excluded;
         for (const Term& t : term.subTerms()) {
-            vec << constructQuery(tr, t);
+            if (term.operation() == Term::And && t.isNegated()) {
+                Term positive(t);
+                positive.setNegation(false);
+                excluded << constructQuery(tr, positive);
+            } else {
+                vec << constructQuery(tr, t);
+            }
         }
 
-        if (vec.isEmpty()) {
+        if (vec.isEmpty() && excluded.isEmpty()) {
             return 0;
         }
 
-        if (term.operation() == Term::And) {
+        if (term.operation() == Term::Or) {
+            return new OrPostingIterator(vec);
+        }
+        if (excluded.isEmpty()) {
             return new AndPostingIterator(vec);
+        }
+
+        PostingIterator* it;
+        if (vec.isEmpty()) {
+            it = tr->allDocumentsIter();
+        } else if (vec.size() == 1) {
+            it = vec.first();
         } else {
-            return new OrPostingIterator(vec);
+            it = new AndPostingIterator(vec);
         }
+        return new AndNotPostingIterator(it, excluded);
     }
 
     Q_ASSERT(term.value().isValid());
@@ -239,29 +657,7 @@ PostingIterator* SearchStore::constructQuery(Transaction* tr, const Term& term)
             return 0;
         }
 
-        PostingDB::Comparator pcom;
-        if (term.comparator() == Term::Greater || term.comparator() == Term::GreaterEqual) {
-            pcom = PostingDB::GreaterEqual;
-            if (term.comparator() == Term::Greater && rating)
-                rating++;
-        }
-        else if (term.comparator() == Term::Less || term.comparator() == Term::LessEqual) {
-            pcom = PostingDB::LessEqual;
-            if (term.comparator() == Term::Less)
-                rating--;
-        }
-        else if (term.comparator() == Term::Equal) {
-            EngineQuery q = constructEqualsQuery("R", value.toString());
-            return tr->postingIterator(q);
-        }
-        else {
-            Q_ASSERT(0);
-            return 0;
-        }
-
-        const QByteArray prefix = "R";
-        const QByteArray val = QByteArray::number(rating);
-        return tr->postingCompIterator(prefix, val, pcom);
+        return constructRangeQuery(tr, "R", rating, term.comparator());
     }
 
     QByteArray prefix;
@@ -273,9 +669,22 @@ PostingIterator* SearchStore::constructQuery(Transaction* tr, const Term& term)
     }
 
     auto com = term.comparator();
+    if (prefix.startsWith('X') && isOrdered(property) && value.type() != QVariant::String) {
+        return constructRangeQuery(tr, prefix, value, com);
+    }
+
     if (com == Term::Contains) {
         EngineQuery q = constructContainsQuery(prefix, value.toString());
-        return tr->postingIterator(q);
+        PostingIterator* it = tr->postingIterator(q);
+
+        // The words of the file names only match from their start
+        if (property == "filename") {
+            PostingIterator* substrings = tr->fileNameIter(value.toString());
+            if (substrings) {
+                return it ? new OrPostingIterator(QVector<PostingIterator*>{it, substrings}) : substrings;
+            }
+        }
+        return it;
     }
 
     if (com == Term::Equal) {
@@ -283,30 +692,214 @@ PostingIterator* SearchStore::constructQuery(Transaction* tr, const Term& term)
         return tr->postingIterator(q);
     }
 
-    QVariant val = term.value();
-    if (val.type() == QVariant::Int) {
-        int intVal = value.toInt();
+    return 0;
+}
+
+quint32 SearchStore::orderedProperty(const QString& property) const
+{
+    if (!isOrdered(property.toUtf8())) {
+        return 0;
+    }
+
+    KFileMetaData::PropertyInfo pi = KFileMetaData::PropertyInfo::fromName(property);
+    return static_cast<quint32>(pi.property());
+}
+
+bool SearchStore::isOrdered(const QByteArray& property) const
+{
+    KFileMetaData::PropertyInfo pi = KFileMetaData::PropertyInfo::fromName(QString::fromUtf8(property));
+    switch (pi.valueType()) {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+    case QVariant::Date:
+    case QVariant::DateTime:
+        return true;
+    default:
+        return false;
+    }
+}
 
-        PostingDB::Comparator pcom;
-        if (term.comparator() == Term::Greater || term.comparator() == Term::GreaterEqual) {
-            pcom = PostingDB::GreaterEqual;
-            if (term.comparator() == Term::Greater && intVal)
-                intVal++;
+PostingIterator* SearchStore::constructRangeQuery(Transaction* tr, const QByteArray& prefix, const QVariant& value,
+                                                  Term::Comparator com)
+{
+    // The range of values matching the value itself
+    qint64 lower;
+    qint64 upper;
+    if (value.type() == QVariant::Date) {
+        // A date matches every second of that day
+        lower = secondsSinceEpoch(value.toDate());
+        upper = lower + qMin<qint64>(24 * 60 * 60 - 1, std::numeric_limits<qint64>::max() - lower);
+    }
+    else if (value.type() == QVariant::DateTime) {
+        lower = upper = secondsSinceEpoch(value.toDateTime());
+    }
+    else {
+        bool okay = false;
+        lower = upper = value.toLongLong(&okay);
+        if (!okay) {
+            qDebug() << "Comparisons must be with a number, date or time" << value;
+            return 0;
         }
-        else if (term.comparator() == Term::Less || term.comparator() == Term::LessEqual) {
-            pcom = PostingDB::LessEqual;
-            if (term.comparator() == Term::Less)
-                intVal--;
+    }
+
+    QByteArray begin = minimumOrderedValue();
+    QByteArray end = maximumOrderedValue();
+    switch (com) {
+    case Term::Equal:
+    case Term::Contains:
+        begin = orderedValue(lower);
+        end = orderedValue(upper);
+        break;
+    case Term::Greater:
+        // Nothing is greater than the largest value, which cannot be incremented
+        if (upper == std::numeric_limits<qint64>::max()) {
+            return 0;
         }
-        else {
-            Q_ASSERT(0);
+        begin = orderedValue(upper + 1);
+        break;
+    case Term::GreaterEqual:
+        begin = orderedValue(lower);
+        break;
+    case Term::Less:
+        if (lower == std::numeric_limits<qint64>::min()) {
             return 0;
         }
+        end = orderedValue(lower - 1);
+        break;
+    case Term::LessEqual:
+        end = orderedValue(upper);
+        break;
+    case Term::Auto:
+        Q_ASSERT(0);
+        return 0;
+    }
 
-        return tr->postingCompIterator(prefix, QByteArray::number(intVal), pcom);
+    return tr->postingRangeIterator(prefix, begin, end);
+}
+
+bool SearchStore::toEngineQuery(const Term& term, EngineQuery& query)
+{
+    if (!term.isValid()) {
+        query = EngineQuery();
+        return true;
     }
 
-    return 0;
+    if (term.isNegated()) {
+        Term t(term);
+        t.setNegation(false);
+
+        EngineQuery q;
+        if (!toEngineQuery(t, q) || q.empty()) {
+            return false;
+        }
+
+        query = EngineQuery({q}, EngineQuery::Not);
+        return true;
+    }
+
+    if (term.operation() == Term::And || term.operation() == Term::Or) {
+        QVector<EngineQuery> queries;
+        for (const Term& t : term.subTerms()) {
+            EngineQuery q;
+            if (!toEngineQuery(t, q)) {
+                return false;
+            }
+            queries << q;
+        }
+
+        query = EngineQuery(queries, term.operation() == Term::And ? EngineQuery::And : EngineQuery::Or);
+        return true;
+    }
+
+    const QVariant value = term.value();
+    const QByteArray property = term.property().toLower().toUtf8();
+    if (value.type() != QVariant::String) {
+        return false;
+    }
+
+    if (property == "type" || property == "kind") {
+        query = constructTypeQuery(value.toString());
+        return !query.empty();
+    }
+    if (property == "includefolder" || property == "modified" || property == "mtime" || property == "rating") {
+        return false;
+    }
+
+    QByteArray prefix;
+    if (!property.isEmpty()) {
+        prefix = fetchPrefix(property);
+        if (prefix.isEmpty()) {
+            return false;
+        }
+    }
+
+    if (value.toString().isEmpty()) {
+        return false;
+    }
+
+    if (term.comparator() == Term::Contains) {
+        // File name substrings are not terms, so the results cannot be refined
+        if (property == "filename") {
+            return false;
+        }
+        query = constructContainsQuery(prefix, value.toString());
+        return !query.empty();
+    }
+    if (term.comparator() == Term::Equal) {
+        query = constructEqualsQuery(prefix, value.toString());
+        return !query.empty();
+    }
+
+    return false;
+}
+
+EngineQuery SearchStore::constructRankingQuery(const Term& term)
+{
+    // The documents matching it are not returned at all
+    if (term.isNegated()) {
+        return EngineQuery();
+    }
+
+    if (term.operation() == Term::And || term.operation() == Term::Or) {
+        QVector<EngineQuery> queries;
+        for (const Term& t : term.subTerms()) {
+            EngineQuery q = constructRankingQuery(t);
+            if (!q.empty()) {
+                queries << q;
+            }
+        }
+
+        return EngineQuery(queries, EngineQuery::Or);
+    }
+
+    const QByteArray property = term.property().toLower().toUtf8();
+    if (property == "type" || property == "kind" || property == "includefolder" ||
+        property == "modified" || property == "mtime" || property == "rating") {
+        return EngineQuery();
+    }
+
+    if (term.value().type() != QVariant::String) {
+        return EngineQuery();
+    }
+
+    QByteArray prefix;
+    if (!property.isEmpty()) {
+        prefix = fetchPrefix(property);
+        if (prefix.isEmpty()) {
+            return EngineQuery();
+        }
+    }
+
+    if (term.comparator() == Term::Contains) {
+        return constructContainsQuery(prefix, term.value().toString());
+    }
+    if (term.comparator() == Term::Equal) {
+        return constructEqualsQuery(prefix, term.value().toString());
+    }
+
+    return EngineQuery();
 }
 
 EngineQuery SearchStore::constructContainsQuery(const QByteArray& prefix, const QString& value)
@@ -26,7 +26,11 @@
 #include <QString>
 #include <QDateTime>
 #include <QHash>
+#include <QMap>
+#include <QStringList>
 #include "term.h"
+#include "query.h"
+#include "continuationtoken.h"
 
 namespace Baloo {
 
@@ -40,22 +44,136 @@ class SearchStore
 {
 public:
     SearchStore();
+
+    /**
+     * Searches \p db instead of the main index, e.g. one of the
+     * DatabaseShards. The QueryCache is not used, as it only knows
+     * about the main index.
+     */
+    explicit SearchStore(Database* db);
     ~SearchStore();
 
-    QStringList exec(const Term& term, uint offset, int limit, bool sortResults);
+    /**
+     * Starts a new read transaction on the database. Returns 0 if
+     * the database could not be opened. The caller owns the transaction.
+     */
+    Transaction* transaction();
+
+    PostingIterator* constructQuery(Transaction* tr, const Term& term);
+
+    /**
+     * Returns the number of documents matching \p term, without
+     * resolving or sorting any of them.
+     *
+     * If \p msecs is not negative, counting stops once it has taken about
+     * that long, and an estimate based on the size of the posting lists
+     * is returned instead. \p exact is set accordingly.
+     */
+    uint count(Transaction* tr, const Term& term, int msecs = -1, bool* exact = 0);
+
+    /**
+     * Counts the documents matching \p term for each value of the \p facets,
+     * which may be "type", "mimetype", "year" and "tag". The values are
+     * the ones which can be searched for, e.g. "Audio" for "type:Audio".
+     * The mimetypes are split into their words, like when searching.
+     *
+     * If \p msecs is not negative, counting stops once it has taken about
+     * that long, and \p complete is set to false. This includes reading
+     * the results, and if those are not all read in time, the counts of
+     * the ones which were are scaled up to the estimated number of results.
+     */
+    QMap<QString, QMap<QString, uint> > facetCounts(Transaction* tr, const Term& term, const QStringList& facets,
+                                                   int msecs = -1, bool* complete = 0);
+
+    /**
+     * Runs the query in \p it and returns the ids of the results within
+     * [offset, offset + limit) after sorting them based on \p sortingOption.
+     *
+     * If a valid \p after token is given, the results start after the
+     * result it was taken from, and the \p offset is ignored. For
+     * SortRelevance the token has to be from the same generation of
+     * the index.
+     *
+     * The \p sortingProperty and \p order are only used for SortProperty.
+     */
+    QVector<quint64> sortedResults(Transaction* tr, PostingIterator* it, const Term& term,
+                                   uint offset, int limit, Query::SortingOption sortingOption,
+                                   const ContinuationToken& after = ContinuationToken(),
+                                   const QString& sortingProperty = QString(),
+                                   Qt::SortOrder order = Qt::AscendingOrder);
+
+    /**
+     * Returns the count, minimum, maximum and a histogram with \p buckets
+     * buckets of the values of \p property of the documents matching
+     * \p term. See Query::propertyStatistics.
+     */
+    QVariantMap propertyStatistics(Transaction* tr, const Term& term, const QString& property, int buckets);
+
+    /**
+     * Runs \p term while profiling each of its posting iterators and
+     * returns the plan which was executed. See Query::explain.
+     */
+    QVariantMap explain(Transaction* tr, const Term& term);
+
+    /**
+     * Returns the KFileMetaData property with the name \p property, or 0
+     * if its values are not numbers, dates or times.
+     */
+    quint32 orderedProperty(const QString& property) const;
 
 private:
+    /**
+     * Builds the iterator for \p term. constructQuery adds the profiling
+     * of the result on top when the transaction is being profiled.
+     */
+    PostingIterator* buildQuery(Transaction* tr, const Term& term);
+
     QByteArray fetchPrefix(const QByteArray& property) const;
 
+    /**
+     * Returns the ids of all the documents matching \p term, from the
+     * QueryCache if possible
+     */
+    QVector<quint64> fetchIds(Transaction* tr, const Term& term);
+
+    /**
+     * Like fetchIds, but stops reading the ids after about \p msecs
+     * milliseconds, and then sets \p estimate to the estimated number
+     * of all of them. Otherwise \p estimate is the number of ids.
+     */
+    QVector<quint64> fetchIds(Transaction* tr, const Term& term, int msecs, uint* estimate);
+
+    void initPrefixes();
+
     Database* m_db;
+    bool m_useCache;
     QHash<QByteArray, QByteArray> m_prefixes;
 
-    PostingIterator* constructQuery(Transaction* tr, const Term& term);
+    /**
+     * Converts the text and type terms in \p term into an EngineQuery.
+     * Returns false if \p term contains anything else. An invalid \p term
+     * gives an empty query.
+     */
+    bool toEngineQuery(const Term& term, EngineQuery& query);
+
+    /**
+     * Returns a query with all the text terms of \p term, which are
+     * used for ranking the results by relevance
+     */
+    EngineQuery constructRankingQuery(const Term& term);
 
     EngineQuery constructContainsQuery(const QByteArray& prefix, const QString& value);
     EngineQuery constructEqualsQuery(const QByteArray& prefix, const QString& value);
     EngineQuery constructTypeQuery(const QString& type);
 
+    /**
+     * Returns true if the values of the \p property are indexed as
+     * numbers, dates or times. See orderedValue.
+     */
+    bool isOrdered(const QByteArray& property) const;
+
+    PostingIterator* constructRangeQuery(Transaction* tr, const QByteArray& prefix, const QVariant& value,
+                                         Term::Comparator com);
     PostingIterator* constructRatingQuery(Transaction* tr, int rating);
     PostingIterator* constructMTimeQuery(Transaction* tr, const QDateTime& dt, Term::Comparator com);
 };
@@ -0,0 +1,250 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "shardsearch.h"
+#include "searchstore.h"
+
+#include "database.h"
+#include "databaseshards.h"
+#include "transaction.h"
+#include "postingiterator.h"
+
+#include <KConfig>
+#include <KConfigGroup>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QSemaphore>
+#include <QThreadPool>
+
+using namespace Baloo;
+
+// Separate from the global pool, as the callers could be running in it and
+// waiting for the shards
+Q_GLOBAL_STATIC(QThreadPool, s_shardPool)
+
+class Baloo::ShardSearchTask {
+public:
+    QSharedPointer<Database> db;
+    QString mountPath;
+    Term term;
+    Query::SortingOption sortingOption;
+    QString sortingProperty;
+    Qt::SortOrder sortOrder;
+    int limit;
+    bool countOnly;
+    int msecs;
+
+    QVector<ShardResult> results;
+    uint count;
+    QSemaphore done;
+
+    void run();
+};
+
+namespace {
+class ShardSearchRunnable : public QRunnable
+{
+public:
+    explicit ShardSearchRunnable(const QSharedPointer<ShardSearchTask>& task)
+        : m_task(task)
+    {
+    }
+
+    void run() Q_DECL_OVERRIDE {
+        m_task->run();
+        m_task->done.release();
+    }
+
+private:
+    QSharedPointer<ShardSearchTask> m_task;
+};
+}
+
+void ShardSearchTask::run()
+{
+    SearchStore store(db.data());
+    QScopedPointer<Transaction> tr(store.transaction());
+    if (!tr) {
+        return;
+    }
+
+    if (countOnly) {
+        count = store.count(tr.data(), term, msecs);
+        return;
+    }
+
+    QScopedPointer<PostingIterator> it(store.constructQuery(tr.data(), term));
+    if (!it) {
+        return;
+    }
+
+    QVector<quint64> ids;
+    if (sortingOption == Query::SortNone) {
+        while ((limit < 0 || ids.size() < limit) && it->next()) {
+            ids << it->docId();
+        }
+    } else {
+        ids = store.sortedResults(tr.data(), it.data(), term, 0, limit, sortingOption,
+                                  ContinuationToken(), sortingProperty, sortOrder);
+    }
+
+    const quint32 property = sortingOption == Query::SortProperty ? store.orderedProperty(sortingProperty) : 0;
+    for (quint64 id : ids) {
+        const QByteArray url = tr->documentUrl(id);
+        if (url.isEmpty()) {
+            continue;
+        }
+
+        // Anyone with the device could have written its index, so it is
+        // not trusted with the files outside of the device
+        ShardResult result;
+        result.filePath = QDir::cleanPath(QFile::decodeName(url));
+        if (!result.filePath.startsWith(mountPath)) {
+            continue;
+        }
+        result.rank = results.size();
+        if (property) {
+            result.hasValue = tr->documentProperty(id, property, &result.value);
+        } else if (sortingOption == Query::SortAuto || sortingOption == Query::SortProperty) {
+            // Also used when the sorting property is unknown
+            result.mTime = tr->documentTimeInfo(id).mTime;
+        }
+        results << result;
+    }
+}
+
+ShardSearch::ShardSearch(const Term& term)
+    : m_term(term)
+    , m_sortingOption(Query::SortNone)
+    , m_sortOrder(Qt::AscendingOrder)
+    , m_limit(-1)
+{
+}
+
+ShardSearch::~ShardSearch()
+{
+    // The tasks which are still running keep what they need alive
+}
+
+void ShardSearch::setSortingOption(Query::SortingOption option, const QString& property, Qt::SortOrder order)
+{
+    m_sortingOption = option;
+    m_sortingProperty = property;
+    m_sortOrder = order;
+}
+
+void ShardSearch::setLimit(int limit)
+{
+    m_limit = limit;
+}
+
+bool ShardSearch::startResults()
+{
+    return start(false, -1);
+}
+
+bool ShardSearch::startCount(int msecs)
+{
+    return start(true, msecs);
+}
+
+bool ShardSearch::start(bool countOnly, int msecs)
+{
+    Q_ASSERT(m_tasks.isEmpty());
+    if (!m_term.isValid()) {
+        return false;
+    }
+
+    // Otherwise the indexer does not create any shards either
+    KConfig config(QStringLiteral("baloofilerc"), KConfig::NoGlobals);
+    if (!config.group("General").readEntry("index removable media", false)) {
+        return false;
+    }
+
+    for (const QSharedPointer<Database>& db : DatabaseShards::instance()->openMounted()) {
+        QSharedPointer<ShardSearchTask> task(new ShardSearchTask);
+        task->db = db;
+        task->mountPath = QFileInfo(db->path()).path();
+        if (!task->mountPath.endsWith(QLatin1Char('/'))) {
+            task->mountPath += QLatin1Char('/');
+        }
+        task->term = m_term;
+        task->sortingOption = m_sortingOption;
+        task->sortingProperty = m_sortingProperty;
+        task->sortOrder = m_sortOrder;
+        task->limit = m_limit;
+        task->countOnly = countOnly;
+        task->msecs = msecs;
+        task->count = 0;
+
+        s_shardPool->start(new ShardSearchRunnable(task));
+        m_tasks << task;
+    }
+
+    return !m_tasks.isEmpty();
+}
+
+QVector<QVector<ShardResult> > ShardSearch::results()
+{
+    QVector<QVector<ShardResult> > results;
+    for (const auto& task : m_tasks) {
+        task->done.acquire();
+        task->done.release();
+        results << task->results;
+    }
+
+    return results;
+}
+
+bool ShardSearch::lessThan(const ShardResult& lhs, const ShardResult& rhs) const
+{
+    if (m_sortingOption == Query::SortNone) {
+        return false;
+    }
+    if (m_sortingOption == Query::SortRelevance) {
+        return lhs.rank < rhs.rank;
+    }
+
+    // The files without a value come last, as in SearchStore::sortedResults
+    if (lhs.hasValue != rhs.hasValue) {
+        return lhs.hasValue;
+    }
+    if (lhs.hasValue && lhs.value != rhs.value) {
+        return m_sortOrder == Qt::AscendingOrder ? lhs.value < rhs.value : lhs.value > rhs.value;
+    }
+
+    // Newest first
+    return lhs.mTime > rhs.mTime;
+}
+
+uint ShardSearch::count()
+{
+    uint count = 0;
+    for (const auto& task : m_tasks) {
+        task->done.acquire();
+        task->done.release();
+        count += task->count;
+    }
+
+    return count;
+}
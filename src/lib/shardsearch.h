@@ -0,0 +1,130 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_SHARDSEARCH_H
+#define BALOO_SHARDSEARCH_H
+
+#include "term.h"
+#include "query.h"
+
+#include <QSharedPointer>
+#include <QStringList>
+#include <QVector>
+
+namespace Baloo {
+
+class ShardSearchTask;
+
+/**
+ * A result of a shard, along with what it is sorted by. The ids of the
+ * shards cannot be compared to the ones of the main index, so the results
+ * are merged by their file paths and sort keys instead.
+ */
+struct ShardResult {
+    ShardResult()
+        : rank(0), mTime(0), hasValue(false), value(0) {}
+
+    QString filePath;
+
+    // The position within the results of its shard
+    int rank;
+
+    // Only set when sorting by the modification time
+    quint32 mTime;
+
+    // Only set when sorting by a property
+    bool hasValue;
+    qint64 value;
+};
+
+/**
+ * Runs a query on the DatabaseShards of all the mounted devices. Each
+ * shard is searched in a thread of its own, while the caller goes through
+ * the results of the main index.
+ *
+ * The shards are only searched if removable media are indexed, and only
+ * return the files on their own device.
+ */
+class ShardSearch
+{
+public:
+    explicit ShardSearch(const Term& term);
+    ~ShardSearch();
+
+    /**
+     * Sorts the results of each shard, see SearchStore::sortedResults.
+     * The default is Query::SortNone.
+     */
+    void setSortingOption(Query::SortingOption option, const QString& property = QString(),
+                          Qt::SortOrder order = Qt::AscendingOrder);
+
+    /**
+     * Returns at most \p limit results from each shard. A negative
+     * \p limit returns all of them.
+     */
+    void setLimit(int limit);
+
+    /**
+     * Starts fetching the file paths of the results. Returns false if
+     * there are no shards.
+     */
+    bool startResults();
+
+    /**
+     * Starts counting the results, see SearchStore::count. Returns false
+     * if there are no shards.
+     */
+    bool startCount(int msecs = -1);
+
+    /**
+     * Waits for all the shards and returns the results of each of them,
+     * in the order they are sorted in
+     */
+    QVector<QVector<ShardResult> > results();
+
+    /**
+     * Returns true if \p lhs is sorted before \p rhs, which may come from
+     * different shards or from the main index.
+     *
+     * The relevance of results from different indexes cannot be compared,
+     * as the scores depend on the whole index, so these are interleaved
+     * by their rank. Without any order nothing comes before anything else.
+     */
+    bool lessThan(const ShardResult& lhs, const ShardResult& rhs) const;
+
+    /**
+     * Waits for all the shards and returns the sum of their counts
+     */
+    uint count();
+
+private:
+    bool start(bool countOnly, int msecs);
+
+    Term m_term;
+    Query::SortingOption m_sortingOption;
+    QString m_sortingProperty;
+    Qt::SortOrder m_sortOrder;
+    int m_limit;
+
+    QVector<QSharedPointer<ShardSearchTask> > m_tasks;
+};
+
+}
+
+#endif // BALOO_SHARDSEARCH_H
@@ -241,6 +241,14 @@ QVariant Term::userData(const QString& name) const
 QVariantMap Term::toVariantMap() const
 {
     QVariantMap map;
+    if (d->m_isNegated) {
+        Term term(*this);
+        term.setNegation(false);
+
+        map[QStringLiteral("$not")] = QVariant(term.toVariantMap());
+        return map;
+    }
+
     if (d->m_op != None) {
         QVariantList variantList;
         Q_FOREACH (const Term& term, d->m_subTerms) {
@@ -315,6 +323,12 @@ Term Term::fromVariantMap(const QVariantMap& map)
     if (map.size() != 1)
         return Term();
 
+    if (map.contains(QStringLiteral("$not"))) {
+        Term term = Term::fromVariantMap(map[QStringLiteral("$not")].toMap());
+        term.setNegation(!term.isNegated());
+        return term;
+    }
+
     Term term;
 
     QString andOrString;
@@ -441,6 +455,10 @@ namespace {
 
 QDebug operator <<(QDebug d, const Baloo::Term& t)
 {
+    if (t.isNegated()) {
+        d << "NOT";
+    }
+
     if (t.subTerms().isEmpty()) {
         d << QStringLiteral("(%1 %2 %3 (%4))").arg(t.property(),
                                                         comparatorToString(t.comparator()),
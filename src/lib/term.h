@@ -79,8 +79,8 @@ public:
     bool isValid() const;
 
     /**
-     * Negate this term. Negation only applies for Equal or Contains
-     * For other Comparators you must invert it yourself
+     * Negate this term, so that it matches the items which are not
+     * matched by it otherwise. This also applies to And and Or terms.
      */
     void setNegation(bool isNegated);
 
@@ -19,8 +19,11 @@
 
 #include "queryresultsmodel.h"
 #include "query.h"
+#include "querysession.h"
+#include "queryfacetsrunnable.h"
 
 #include <QMimeDatabase>
+#include <QThreadPool>
 #include <QUrl>
 
 Query::Query(QObject *parent)
@@ -65,7 +68,9 @@ int Query::limit() const
 
 QueryResultsModel::QueryResultsModel(QObject *parent)
     : QAbstractListModel(parent),
-      m_query(new Query(this))
+      m_query(new Query(this)),
+      m_session(new Baloo::QuerySession),
+      m_facetsRequest(0)
 {
     connect(m_query, &Query::searchStringChanged, this, &QueryResultsModel::populateModel);
     connect(m_query, &Query::limitChanged, this, &QueryResultsModel::populateModel);
@@ -73,6 +78,7 @@ QueryResultsModel::QueryResultsModel(QObject *parent)
 
 QueryResultsModel::~QueryResultsModel()
 {
+    delete m_session;
 }
 
 QHash<int, QByteArray> QueryResultsModel::roleNames() const
@@ -131,12 +137,17 @@ Query* QueryResultsModel::query() const
     return m_query;
 }
 
+QVariantMap QueryResultsModel::facets() const
+{
+    return m_facets;
+}
+
 void QueryResultsModel::populateModel()
 {
     Baloo::Query query;
     query.setSearchString(m_query->searchString());
     query.setLimit(m_query->limit());
-    Baloo::ResultIterator it = query.exec();
+    Baloo::ResultIterator it = m_session->exec(query);
 
     beginResetModel();
     m_balooEntryList.clear();
@@ -144,5 +155,22 @@ void QueryResultsModel::populateModel()
         m_balooEntryList << it.filePath();
     }
     endResetModel();
-}
 
+    // Rough counts are good enough for a sidebar. They are counted in the
+    // background, so that they do not hold up typing
+    Baloo::QueryFacetsRunnable* runnable = new Baloo::QueryFacetsRunnable(query);
+    runnable->setTimeLimit(100);
+
+    const int request = ++m_facetsRequest;
+    connect(runnable, &Baloo::QueryFacetsRunnable::finished, this,
+            [this, request](Baloo::QueryFacetsRunnable*, const QVariantMap& facets) {
+        // The query has changed in the meantime
+        if (request != m_facetsRequest) {
+            return;
+        }
+
+        m_facets = facets;
+        Q_EMIT facetsChanged();
+    });
+    QThreadPool::globalInstance()->start(runnable);
+}
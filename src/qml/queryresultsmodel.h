@@ -22,6 +22,11 @@
 
 #include <QAbstractListModel>
 #include <QString>
+#include <QVariantMap>
+
+namespace Baloo {
+class QuerySession;
+}
 
 class Query : public QObject
 {
@@ -53,6 +58,7 @@ class QueryResultsModel : public QAbstractListModel
 {
     Q_OBJECT
     Q_PROPERTY(Query* query READ query WRITE setQuery NOTIFY queryChanged)
+    Q_PROPERTY(QVariantMap facets READ facets NOTIFY facetsChanged)
 
 public:
     explicit QueryResultsModel(QObject *parent = nullptr);
@@ -70,15 +76,30 @@ public:
     void setQuery(Query *query);
     Query* query() const;
 
+    /**
+     * The number of results for each type, mimetype, year and tag,
+     * keyed by the name of the facet and then by its value. They are
+     * counted in the background after the results have changed.
+     */
+    QVariantMap facets() const;
+
 Q_SIGNALS:
     void queryChanged();
+    void facetsChanged();
 
 private Q_SLOTS:
     void populateModel();
 
 private:
     QStringList m_balooEntryList;
+    QVariantMap m_facets;
     Query *m_query;
+
+    // Successive search strings usually refine the previous one
+    Baloo::QuerySession *m_session;
+
+    // Only the facets of the latest query are kept
+    int m_facetsRequest;
 };
 
 #endif
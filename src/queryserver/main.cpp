@@ -0,0 +1,40 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "queryserver.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+
+int main(int argc, char** argv)
+{
+    // The queries of the server itself need to run in this process
+    qputenv("BALOO_QUERY_SERVER", "0");
+
+    QCoreApplication app(argc, argv);
+    app.setApplicationName(QStringLiteral("baloo_query"));
+
+    Baloo::QueryServer server;
+    if (!server.listen()) {
+        qWarning() << "Another query server is running";
+        return 1;
+    }
+
+    return app.exec();
+}
@@ -0,0 +1,258 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "queryserver.h"
+#include "queryprotocol.h"
+
+#include "query.h"
+#include "resultiterator.h"
+#include "metrics.h"
+
+#include <QBuffer>
+#include <QDataStream>
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalSocket>
+
+using namespace Baloo;
+
+// The results are sent in batches of this size
+static const int batchSize = 256;
+
+// Slow clients are not sent any more once this much is waiting to be written
+static const qint64 maxPendingBytes = 1024 * 1024;
+
+QueryServer::QueryServer(QObject* parent)
+    : QObject(parent)
+{
+    m_server.setSocketOptions(QLocalServer::UserAccessOption);
+    connect(&m_server, &QLocalServer::newConnection, this, &QueryServer::handleConnection);
+}
+
+QueryServer::~QueryServer()
+{
+    m_server.close();
+
+    // The connections go away along with the server, and their tasks
+    // need to be done by then
+    m_pool.waitForDone();
+}
+
+bool QueryServer::listen(const QString& path)
+{
+    const QString socketPath = path.isEmpty() ? QueryProtocol::socketPath() : path;
+
+    // A socket which is left over from a crash can be replaced
+    QLocalSocket socket;
+    socket.connectToServer(socketPath);
+    if (socket.waitForConnected(100)) {
+        return false;
+    }
+    QLocalServer::removeServer(socketPath);
+
+    if (!m_server.listen(socketPath)) {
+        qWarning() << "Could not listen on" << socketPath << m_server.errorString();
+        return false;
+    }
+    return true;
+}
+
+void QueryServer::handleConnection()
+{
+    while (QLocalSocket* socket = m_server.nextPendingConnection()) {
+        new QueryConnection(socket, &m_pool, this);
+    }
+}
+
+QueryTask::QueryTask(const QSharedPointer<QueryRequest>& request)
+    : m_request(request)
+{
+}
+
+void QueryTask::run()
+{
+    QByteArray frames;
+    QBuffer buffer(&frames);
+    buffer.open(QIODevice::WriteOnly);
+
+    if (m_request->type == QueryProtocol::Count) {
+        const int msecs = m_request->msecs;
+        const uint count = msecs < 0 ? m_request->query.count() : m_request->query.estimatedCount(msecs);
+
+        QByteArray frame;
+        QDataStream out(&frame, QIODevice::WriteOnly);
+        out.setVersion(QueryProtocol::streamVersion());
+        out << static_cast<quint8>(QueryProtocol::CountFrame) << static_cast<quint32>(count);
+        QueryProtocol::writeFrame(&buffer, frame);
+
+        Q_EMIT done(frames, true);
+        return;
+    }
+
+    if (!m_request->it) {
+        m_request->it.reset(new ResultIterator(m_request->query.exec()));
+    }
+    ResultIterator* it = m_request->it.data();
+
+    QStringList filePaths;
+    QVector<QByteArray> tokens;
+    bool finished = false;
+    while (filePaths.size() < batchSize) {
+        if (!it->next()) {
+            finished = true;
+            break;
+        }
+        filePaths << it->filePath();
+        tokens << it->continuationToken();
+    }
+
+    if (!filePaths.isEmpty()) {
+        QByteArray frame;
+        QDataStream out(&frame, QIODevice::WriteOnly);
+        out.setVersion(QueryProtocol::streamVersion());
+        out << static_cast<quint8>(QueryProtocol::ResultsFrame) << filePaths << tokens;
+        QueryProtocol::writeFrame(&buffer, frame);
+    }
+
+    if (finished) {
+        // Releases the read transaction right away
+        const QString error = it->errorString();
+        m_request->it.reset();
+
+        QByteArray frame;
+        QDataStream out(&frame, QIODevice::WriteOnly);
+        out.setVersion(QueryProtocol::streamVersion());
+        if (error.isEmpty()) {
+            out << static_cast<quint8>(QueryProtocol::EndFrame);
+        } else {
+            out << static_cast<quint8>(QueryProtocol::ErrorFrame) << error;
+        }
+        QueryProtocol::writeFrame(&buffer, frame);
+    }
+
+    Q_EMIT done(frames, finished);
+}
+
+QueryConnection::QueryConnection(QLocalSocket* socket, QThreadPool* pool, QObject* parent)
+    : QObject(parent)
+    , m_socket(socket)
+    , m_pool(pool)
+    , m_running(false)
+    , m_finished(false)
+{
+    m_socket->setParent(this);
+    connect(m_socket, &QLocalSocket::readyRead, this, &QueryConnection::readRequest);
+    connect(m_socket, &QLocalSocket::bytesWritten, this, &QueryConnection::runTask);
+    connect(m_socket, &QLocalSocket::disconnected, this, &QObject::deleteLater);
+
+    readRequest();
+}
+
+QueryConnection::~QueryConnection()
+{
+    // A task which is still running keeps the request alive until it is done
+}
+
+void QueryConnection::readRequest()
+{
+    m_buffer += m_socket->readAll();
+
+    QByteArray request;
+    if (m_request || !QueryProtocol::takeFrame(m_buffer, &request)) {
+        return;
+    }
+
+    QDataStream stream(request);
+    stream.setVersion(QueryProtocol::streamVersion());
+
+    quint32 version;
+    quint8 type;
+    qint32 msecs;
+    QByteArray json;
+    stream >> version >> type >> msecs >> json;
+    if (stream.status() != QDataStream::Ok || version != QueryProtocol::Version) {
+        qWarning() << "Ignoring an invalid request";
+        finish();
+        return;
+    }
+
+    if (type == QueryProtocol::Metrics) {
+        const QVariantMap metrics = Metrics::instance()->toVariantMap();
+
+        QByteArray frame;
+        QDataStream out(&frame, QIODevice::WriteOnly);
+        out.setVersion(QueryProtocol::streamVersion());
+        out << static_cast<quint8>(QueryProtocol::MetricsFrame)
+            << QJsonDocument(QJsonObject::fromVariantMap(metrics)).toJson(QJsonDocument::Compact);
+
+        QueryProtocol::writeFrame(m_socket, frame);
+        finish();
+        return;
+    }
+
+    if (type != QueryProtocol::Results && type != QueryProtocol::Count) {
+        finish();
+        return;
+    }
+
+    m_request.reset(new QueryRequest);
+    m_request->type = type;
+    m_request->msecs = msecs;
+    m_request->query = Query::fromJSON(json);
+    runTask();
+}
+
+void QueryConnection::runTask()
+{
+    // Continued once the client has caught up, see handleTaskDone
+    if (!m_request || m_running || m_finished || m_socket->bytesToWrite() > maxPendingBytes) {
+        return;
+    }
+
+    QueryTask* task = new QueryTask(m_request);
+    connect(task, &QueryTask::done, this, &QueryConnection::handleTaskDone);
+
+    m_running = true;
+    m_pool->start(task);
+}
+
+void QueryConnection::handleTaskDone(const QByteArray& frames, bool finished)
+{
+    m_running = false;
+    m_socket->write(frames);
+
+    if (finished) {
+        m_finished = true;
+        m_request.clear();
+        finish();
+        return;
+    }
+
+    // The other clients have had their turn meanwhile
+    runTask();
+}
+
+void QueryConnection::finish()
+{
+    m_socket->disconnectFromServer();
+    if (m_socket->state() == QLocalSocket::UnconnectedState) {
+        deleteLater();
+    }
+}
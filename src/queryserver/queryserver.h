@@ -0,0 +1,126 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BALOO_QUERYSERVER_H
+#define BALOO_QUERYSERVER_H
+
+#include <QObject>
+#include <QLocalServer>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QSharedPointer>
+#include <QThreadPool>
+
+#include "query.h"
+
+class QLocalSocket;
+
+namespace Baloo {
+
+class ResultIterator;
+
+/**
+ * Runs the queries of the clients, keeping the index open and the caches
+ * warm in between. See QueryProtocol.
+ */
+class QueryServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QueryServer(QObject* parent = 0);
+    ~QueryServer();
+
+    /**
+     * Starts listening on \p path, which defaults to QueryProtocol::socketPath.
+     * Returns false if another server is listening there already.
+     */
+    bool listen(const QString& path = QString());
+
+private Q_SLOTS:
+    void handleConnection();
+
+private:
+    QLocalServer m_server;
+
+    // The queries are run here, so that a slow one does not hold up the others
+    QThreadPool m_pool;
+};
+
+/**
+ * A request which is being answered, shared between its connection and
+ * the task which runs it
+ */
+struct QueryRequest {
+    quint8 type;
+    int msecs;
+    Query query;
+    QScopedPointer<ResultIterator> it;
+};
+
+/**
+ * Runs a request, or fetches the next batch of its results
+ */
+class QueryTask : public QObject, public QRunnable
+{
+    Q_OBJECT
+public:
+    explicit QueryTask(const QSharedPointer<QueryRequest>& request);
+
+    void run() Q_DECL_OVERRIDE;
+
+Q_SIGNALS:
+    /**
+     * Emitted with the \p frames to be sent to the client. Once \p finished,
+     * nothing more is sent.
+     */
+    void done(const QByteArray& frames, bool finished);
+
+private:
+    QSharedPointer<QueryRequest> m_request;
+};
+
+/**
+ * A single request of a client
+ */
+class QueryConnection : public QObject
+{
+    Q_OBJECT
+public:
+    QueryConnection(QLocalSocket* socket, QThreadPool* pool, QObject* parent);
+    ~QueryConnection();
+
+private Q_SLOTS:
+    void readRequest();
+    void runTask();
+    void handleTaskDone(const QByteArray& frames, bool finished);
+
+private:
+    void finish();
+
+    QLocalSocket* m_socket;
+    QThreadPool* m_pool;
+    QByteArray m_buffer;
+    QSharedPointer<QueryRequest> m_request;
+    bool m_running;
+    bool m_finished;
+};
+
+}
+
+#endif // BALOO_QUERYSERVER_H
@@ -37,6 +37,8 @@
 #include <QDBusMessage>
 #include <QDBusConnection>
 #include <QDBusConnectionInterface>
+#include <QEventLoop>
+#include <QThread>
 
 #include "global.h"
 #include "database.h"
@@ -47,12 +49,16 @@
 #include "indexerconfig.h"
 #include "idutils.h"
 #include "fileindexerconfig.h"
+#include "firstrunindexer.h"
+#include "indexwriter.h"
 #include "monitorcommand.h"
 #include "schedulerinterface.h"
 #include "maininterface.h"
 #include "indexerstate.h"
 #include "configcommand.h"
 #include "statuscommand.h"
+#include "metricscommand.h"
+#include "query.h"
 
 using namespace Baloo;
 
@@ -85,6 +91,12 @@ int main(int argc, char* argv[])
     parser.addPositionalArgument(QStringLiteral("index"), i18n("Index the specified files"));
     parser.addPositionalArgument(QStringLiteral("clear"), i18n("Forget the specified files"));
     parser.addPositionalArgument(QStringLiteral("config"), i18n("Modify the Baloo configuration"));
+    parser.addPositionalArgument(QStringLiteral("facets"), i18n("Count the results of a query by type, mimetype, year and tag"));
+    parser.addPositionalArgument(QStringLiteral("metrics"), i18n("Print the counters and latencies of the indexer and the query server"));
+    parser.addOption(QCommandLineOption(QStringLiteral("json"), i18n("Print the metrics as JSON")));
+    parser.addPositionalArgument(QStringLiteral("trace"), i18n("Write the last trace spans of the indexer to a file, as Chrome trace JSON"));
+    parser.addPositionalArgument(QStringLiteral("compact"), i18n("Reclaim the free space of the index"));
+    parser.addPositionalArgument(QStringLiteral("rebuild"), i18n("Throw away the index and build it again"));
     parser.addVersionOption();
     parser.addHelpOption();
 
@@ -116,6 +128,11 @@ int main(int argc, char* argv[])
         return command.exec(parser);
     }
 
+    if (command == QLatin1String("metrics")) {
+        MetricsCommand command;
+        return command.exec(parser);
+    }
+
     if (command == QLatin1String("enable") || command == QLatin1String("disable")) {
         bool isEnabled = false;
         if (command == QLatin1String("enable")) {
@@ -194,28 +211,33 @@ int main(int argc, char* argv[])
             return 1;
         }
 
-        Transaction tr(db, Transaction::ReadWrite);
-
-        for (int i = 1; i < parser.positionalArguments().size(); ++i) {
-            const QString url = QFileInfo(parser.positionalArguments().at(i)).absoluteFilePath();
-            quint64 id = filePathToId(QFile::encodeName(url));
-            if (id == 0) {
-                out << "Could not stat file: " << url << endl;
-                continue;
-            }
-            if (tr.inPhaseOne(id))  {
-                out << "Skipping: " << url << " Reason: Already scheduled for indexing\n";
-                continue;
+        // Run again if the index has to grow, so only the last run is reported
+        QString report;
+        db->write([&](Transaction* tr) {
+            report.clear();
+            QTextStream reportOut(&report);
+
+            for (int i = 1; i < parser.positionalArguments().size(); ++i) {
+                const QString url = QFileInfo(parser.positionalArguments().at(i)).absoluteFilePath();
+                quint64 id = filePathToId(QFile::encodeName(url));
+                if (id == 0) {
+                    reportOut << "Could not stat file: " << url << endl;
+                    continue;
+                }
+                if (tr->inPhaseOne(id))  {
+                    reportOut << "Skipping: " << url << " Reason: Already scheduled for indexing\n";
+                    continue;
+                }
+                if (!tr->documentData(id).isEmpty()) {
+                    reportOut << "Skipping: " << url << " Reason: Already indexed\n";
+                    continue;
+                }
+                Indexer indexer(url, tr);
+                reportOut << "Indexing " << url << endl;
+                indexer.index();
             }
-            if (!tr.documentData(id).isEmpty()) {
-                out << "Skipping: " << url << " Reason: Already indexed\n";
-                continue;
-            }
-            Indexer indexer(url, &tr);
-            out << "Indexing " << url << endl;
-            indexer.index();
-        }
-        tr.commit();
+        });
+        out << report;
         out << "File(s) indexed\n";
     }
 
@@ -231,29 +253,35 @@ int main(int argc, char* argv[])
             return 1;
         }
 
-        Transaction tr(db, Transaction::ReadWrite);
-
-        for (int i = 1; i < parser.positionalArguments().size(); ++i) {
-            const QString url = QFileInfo(parser.positionalArguments().at(i)).absoluteFilePath();
-            quint64 id = filePathToId(QFile::encodeName(url));
-            if (id == 0) {
-                out << "Could not stat file: " << url << endl;
-                continue;
-            }
-            if (tr.documentData(id).isEmpty()) {
-                out << "Skipping: " << url << " Reason: Not yet indexed\n";
-                continue;
+        QString report;
+        db->write([&](Transaction* tr) {
+            report.clear();
+            QTextStream reportOut(&report);
+
+            for (int i = 1; i < parser.positionalArguments().size(); ++i) {
+                const QString url = QFileInfo(parser.positionalArguments().at(i)).absoluteFilePath();
+                quint64 id = filePathToId(QFile::encodeName(url));
+                if (id == 0) {
+                    reportOut << "Could not stat file: " << url << endl;
+                    continue;
+                }
+                if (tr->documentData(id).isEmpty()) {
+                    reportOut << "Skipping: " << url << " Reason: Not yet indexed\n";
+                    continue;
+                }
+                Indexer indexer(url, tr);
+                reportOut << "Clearing " << url << endl;
+                tr->removeDocument(id);
             }
-            Indexer indexer(url, &tr);
-            out << "Clearing " << url << endl;
-            tr.removeDocument(id);
-        }
-        tr.commit();
+        });
+        out << report;
         out << "File(s) cleared\n";
     }
 
     if (command == QStringLiteral("indexSize")) {
+        FileIndexerConfig config;
         Database *db = globalDatabaseInstance();
+        db->setMapSizeLimits(config.initialIndexSize(), config.maximumIndexSize());
         if (!db->open(Database::OpenDatabase)) {
             out << "Baloo Index could not be opened\n";
             return 1;
@@ -281,7 +309,9 @@ int main(int argc, char* argv[])
 
         uint ts = size.expectedSize;
         out << "Actual Size: " << format.formatByteSize(size.actualSize, 2) << "\n";
-        out << "Expected Size: " << format.formatByteSize(size.expectedSize, 2) << "\n\n";
+        out << "Expected Size: " << format.formatByteSize(size.expectedSize, 2) << "\n";
+        out << "Map Size: " << format.formatByteSize(db->mapSize(), 2) << "\n";
+        out << "Maximum Map Size: " << format.formatByteSize(db->maximumMapSize(), 2) << "\n\n";
         prFunc(QStringLiteral("PostingDB"), size.postingDb, ts);
         prFunc(QStringLiteral("PosistionDB"), size.positionDb, ts);
         prFunc(QStringLiteral("DocTerms"), size.docTerms, ts);
@@ -294,7 +324,154 @@ int main(int argc, char* argv[])
         prFunc(QStringLiteral("ContentIndexingDB"), size.contentIndexingIds, ts);
         prFunc(QStringLiteral("FailedIdsDB"), size.failedIds, ts);
         prFunc(QStringLiteral("MTimeDB"), size.mtimeDb, ts);
+        prFunc(QStringLiteral("TermFrequencyDB"), size.termFrequencyDb, ts);
+        prFunc(QStringLiteral("DocLengthDB"), size.docLength, ts);
+        prFunc(QStringLiteral("DocPropertyDB"), size.docProperty, ts);
+        prFunc(QStringLiteral("PrefixDB"), size.prefixDb, ts);
+        prFunc(QStringLiteral("TrigramDB"), size.trigramDb, ts);
+
+        return 0;
+    }
+
+    if (command == QStringLiteral("facets")) {
+        if (parser.positionalArguments().size() < 2) {
+            out << "Please enter a query to count the results of\n";
+            return 1;
+        }
+
+        QStringList args = parser.positionalArguments();
+        args.removeFirst();
+
+        Query query;
+        query.setSearchString(args.join(QLatin1Char(' ')));
+
+        const QMap<QString, QMap<QString, uint> > facets = query.facetCounts();
+        for (auto it = facets.constBegin(); it != facets.constEnd(); ++it) {
+            out << it.key() << ":\n";
+
+            const QMap<QString, uint>& values = it.value();
+            for (auto vit = values.constBegin(); vit != values.constEnd(); ++vit) {
+                out.setFieldWidth(20);
+                out << vit.key();
+                out.setFieldWidth(0);
+                out << ": " << vit.value() << "\n";
+            }
+        }
+
+        return 0;
+    }
+
+    if (command == QStringLiteral("trace")) {
+        if (!mainInterface.isValid()) {
+            err << i18n("Baloo File Indexer is not running") << endl;
+            return 1;
+        }
+
+        QDBusPendingReply<QString> reply = mainInterface.trace();
+        reply.waitForFinished();
+        if (reply.isError()) {
+            err << reply.error().message() << endl;
+            return 1;
+        }
+
+        const QByteArray json = reply.value().toUtf8();
+        if (parser.positionalArguments().size() < 2) {
+            out << json << endl;
+            return 0;
+        }
+
+        QFile file(parser.positionalArguments().at(1));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            err << i18n("Could not write to %1", file.fileName()) << endl;
+            return 1;
+        }
+        file.write(json);
+        out << i18n("Trace written to %1. It can be opened in chrome://tracing or Perfetto", file.fileName()) << endl;
+        return 0;
+    }
+
+    if (command == QStringLiteral("compact")) {
+        qlonglong reclaimed = -1;
+        if (schedulerinterface.isValid()) {
+            // The indexer has to compact the index itself, as it would
+            // otherwise keep writing to the old file
+            if (schedulerinterface.state() == Suspended) {
+                err << i18n("The File Indexer is suspended") << endl;
+                return 1;
+            }
+
+            QEventLoop loop;
+            QObject::connect(&schedulerinterface, &org::kde::baloo::scheduler::compacted, &loop, [&](qlonglong bytes) {
+                reclaimed = bytes;
+                loop.quit();
+            });
+            schedulerinterface.compact();
+            out << i18n("Waiting for the File Indexer to compact the index") << endl;
+            loop.exec();
+        } else {
+            FileIndexerConfig config;
+            Database *db = globalDatabaseInstance();
+            db->setMapSizeLimits(config.initialIndexSize(), config.maximumIndexSize());
+            if (!db->open(Database::OpenDatabase)) {
+                out << "Baloo Index could not be opened\n";
+                return 1;
+            }
+            reclaimed = db->compact();
+        }
+
+        if (reclaimed < 0) {
+            err << i18n("The index could not be compacted") << endl;
+            return 1;
+        }
+
+        KFormat format(QLocale::system());
+        out << i18n("Reclaimed %1", format.formatByteSize(reclaimed, 2)) << endl;
+        return 0;
+    }
 
+    if (command == QStringLiteral("rebuild")) {
+        QDBusConnectionInterface* bus = QDBusConnection::sessionBus().interface();
+        if (bus->isServiceRegistered(QStringLiteral("org.kde.baloo"))) {
+            out << i18n("Stopping the File Indexer") << endl;
+            mainInterface.quit();
+            for (int i = 0; i < 300 && bus->isServiceRegistered(QStringLiteral("org.kde.baloo")); i++) {
+                QThread::msleep(100);
+            }
+            if (bus->isServiceRegistered(QStringLiteral("org.kde.baloo"))) {
+                err << i18n("The File Indexer could not be stopped") << endl;
+                return 1;
+            }
+        }
+
+        const QString path = fileIndexDbPath();
+        QFile(path + QStringLiteral("/index")).remove();
+        QFile(path + QStringLiteral("/index-lock")).remove();
+
+        FileIndexerConfig config;
+        Database *db = globalDatabaseInstance();
+        db->setMapSizeLimits(config.initialIndexSize(), config.maximumIndexSize());
+        db->setFileNameTrigrams(config.indexFileNameSubstrings());
+        if (!db->open(Database::CreateDatabase)) {
+            out << "Baloo Index could not be opened\n";
+            return 1;
+        }
+
+        config.setInitialRun(true);
+        const QStringList folders = config.includeFolders();
+        if (!folders.isEmpty()) {
+            out << i18n("Building the index") << endl;
+
+            // The indexer pauses the writer while building the index
+            IndexWriter writer(db);
+            writer.start();
+            FirstRunIndexer indexer(&writer, &config, folders);
+            indexer.run();
+            writer.stop();
+        }
+
+        if (IndexerConfig().fileIndexingEnabled()) {
+            start();
+        }
         return 0;
     }
 
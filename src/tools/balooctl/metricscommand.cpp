@@ -0,0 +1,119 @@
+/*
+ * This file is part of the KDE Baloo project.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "metricscommand.h"
+#include "maininterface.h"
+#include "queryclient.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QScopedPointer>
+#include <QTextStream>
+
+#include <KLocalizedString>
+
+using namespace Baloo;
+
+QString MetricsCommand::command()
+{
+    return QStringLiteral("metrics");
+}
+
+QString MetricsCommand::description()
+{
+    return i18n("Print the counters and latencies of the indexer and the query server");
+}
+
+static void printMetrics(QTextStream& out, const QVariantMap& map)
+{
+    out << i18n("Uptime: %1 seconds", map.value(QStringLiteral("uptime")).toULongLong()) << "\n\n";
+
+    const QVariantMap counters = map.value(QStringLiteral("counters")).toMap();
+    for (auto it = counters.constBegin(); it != counters.constEnd(); ++it) {
+        out.setFieldWidth(40);
+        out.setFieldAlignment(QTextStream::AlignLeft);
+        out << it.key();
+        out.setFieldWidth(0);
+        out << " " << it.value().toULongLong() << "\n";
+    }
+    out << "\n";
+
+    const QVariantMap histograms = map.value(QStringLiteral("histograms")).toMap();
+    for (auto it = histograms.constBegin(); it != histograms.constEnd(); ++it) {
+        const QVariantMap h = it.value().toMap();
+
+        out.setFieldWidth(40);
+        out.setFieldAlignment(QTextStream::AlignLeft);
+        out << it.key();
+        out.setFieldWidth(0);
+        out << " count " << h.value(QStringLiteral("count")).toULongLong()
+            << "  p50 " << h.value(QStringLiteral("p50")).toULongLong()
+            << "  p90 " << h.value(QStringLiteral("p90")).toULongLong()
+            << "  p99 " << h.value(QStringLiteral("p99")).toULongLong()
+            << "  max " << h.value(QStringLiteral("max")).toULongLong() << "\n";
+    }
+}
+
+int MetricsCommand::exec(const QCommandLineParser& parser)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    org::kde::baloo::main mainInterface(QStringLiteral("org.kde.baloo"),
+                                        QStringLiteral("/"),
+                                        QDBusConnection::sessionBus());
+    if (!mainInterface.isValid()) {
+        err << i18n("Baloo File Indexer is not running") << endl;
+        return 1;
+    }
+
+    QDBusPendingReply<QString> reply = mainInterface.metrics();
+    reply.waitForFinished();
+    if (reply.isError()) {
+        err << reply.error().message() << endl;
+        return 1;
+    }
+
+    QVariantMap map = QJsonDocument::fromJson(reply.value().toUtf8()).object().toVariantMap();
+
+    // The query caches are in the processes running the queries, which
+    // usually is the query server
+    QVariantMap serverMap;
+    QScopedPointer<QueryClient> client(QueryClient::connectToServer());
+    QByteArray serverJson;
+    if (client && client->metrics(&serverJson)) {
+        serverMap = QJsonDocument::fromJson(serverJson).object().toVariantMap();
+    }
+
+    if (parser.isSet(QStringLiteral("json"))) {
+        if (!serverMap.isEmpty()) {
+            map.insert(QStringLiteral("queryServer"), serverMap);
+        }
+        out << QJsonDocument(QJsonObject::fromVariantMap(map)).toJson(QJsonDocument::Indented);
+        return 0;
+    }
+
+    printMetrics(out, map);
+    if (!serverMap.isEmpty()) {
+        out << "\n" << i18n("Query server") << "\n";
+        printMetrics(out, serverMap);
+    }
+
+    return 0;
+}
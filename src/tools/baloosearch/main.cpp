@@ -33,6 +33,32 @@
 #include "query.h"
 #include "searchstore.h"
 
+#include <QJsonDocument>
+#include <QJsonObject>
+
+// Prints the \p node of the plan of Query::explain and its children as
+// an indented tree
+static void printPlan(QTextStream& out, const QVariantMap& node, const QString& indent, bool last, bool root)
+{
+    out << indent;
+    if (!root) {
+        out << (last ? "`- " : "|- ");
+    }
+    out << node.value(QStringLiteral("name")).toString()
+        << "  estimated " << node.value(QStringLiteral("estimated")).toULongLong()
+        << "  actual " << node.value(QStringLiteral("actual")).toULongLong()
+        << "  next " << node.value(QStringLiteral("next")).toULongLong()
+        << "  skipTo " << node.value(QStringLiteral("skipTo")).toULongLong()
+        << "  bytes " << node.value(QStringLiteral("bytes")).toULongLong()
+        << "  " << node.value(QStringLiteral("usecs")).toULongLong() / 1000.0 << " msecs" << endl;
+
+    const QString childIndent = root ? indent : indent + (last ? QStringLiteral("   ") : QStringLiteral("|  "));
+    const QVariantList children = node.value(QStringLiteral("children")).toList();
+    for (int i = 0; i < children.size(); i++) {
+        printPlan(out, children[i].toMap(), childIndent, i == children.size() - 1, false);
+    }
+}
+
 int main(int argc, char* argv[])
 {
     KAboutData aboutData(QStringLiteral("Baloo"),
@@ -58,6 +84,10 @@ int main(int argc, char* argv[])
     parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("d") << QStringLiteral("directory"),
                                         i18n("Limit search to specified directory"),
                                         i18n("directory")));
+    parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("e") << QStringLiteral("explain"),
+                                        i18n("Print how the query is run instead of its results")));
+    parser.addOption(QCommandLineOption(QStringLiteral("json"),
+                                        i18n("Print the explanation of the query as JSON")));
     parser.addPositionalArgument(i18n("query"), i18n("List of words to query for"));
     parser.addHelpOption();
     parser.addVersionOption();
@@ -94,6 +124,27 @@ int main(int argc, char* argv[])
         query.setIncludeFolder(QFileInfo(folderName).canonicalFilePath());
     }
 
+    if (parser.isSet(QStringLiteral("explain"))) {
+        const QByteArray json = query.explain();
+        if (parser.isSet(QStringLiteral("json"))) {
+            out << json;
+            return 0;
+        }
+
+        const QVariantMap map = QJsonDocument::fromJson(json).object().toVariantMap();
+        out << i18n("%1 results in %2 msecs, out of %3 documents",
+                    map.value(QStringLiteral("count")).toUInt(),
+                    map.value(QStringLiteral("usecs")).toLongLong() / 1000.0,
+                    map.value(QStringLiteral("documents")).toUInt()) << endl;
+
+        const QVariantMap plan = map.value(QStringLiteral("plan")).toMap();
+        if (!plan.isEmpty()) {
+            out << endl;
+            printPlan(out, plan, QString(), true, true);
+        }
+        return 0;
+    }
+
     QElapsedTimer timer;
     timer.start();
 
@@ -31,13 +31,11 @@
 #include <KAboutData>
 #include <KLocalizedString>
 
-#include <QJsonDocument>
-#include <QJsonObject>
-
 #include "global.h"
 #include "idutils.h"
 #include "database.h"
 #include "transaction.h"
+#include "documentdatacodec.h"
 
 #include <KFileMetaData/PropertyInfo>
 
@@ -151,10 +149,9 @@ int main(int argc, char* argv[])
             continue;
         }
 
-        const QJsonDocument jdoc = QJsonDocument::fromJson(tr.documentData(fid));
-        const QVariantMap varMap = jdoc.object().toVariantMap();
-        KFileMetaData::PropertyMap propMap = KFileMetaData::toPropertyMap(varMap);
-        KFileMetaData::PropertyMap::const_iterator it = propMap.constBegin();
+        Baloo::DocumentDataCodec codec;
+        const QMap<int, QVariant> propMap = codec.decode(tr.documentData(fid));
+        QMap<int, QVariant>::const_iterator it = propMap.constBegin();
         for (; it != propMap.constEnd(); ++it) {
             QString str;
             if (it.value().type() == QVariant::List) {
@@ -167,7 +164,7 @@ int main(int argc, char* argv[])
                 str = it.value().toString();
             }
 
-            KFileMetaData::PropertyInfo pi(it.key());
+            KFileMetaData::PropertyInfo pi(static_cast<KFileMetaData::Property::Property>(it.key()));
             stream << "\t" << pi.displayName() << ": " << str << endl;
         }
 